@@ -45,3 +45,33 @@ Identifier::Identifier(yyltype loc, const char *n) : Node(loc) {
 void Identifier::PrintChildren(int indentLevel) {
     printf("%s", name);
 }
+
+Decl *Node::FindDecl(const char *name) {
+    for (Node *n = this; n; n = n->parent) {
+        Decl *d = n->LookupInScope(name);
+        if (d) return d;
+    }
+    return NULL;
+}
+
+Decl *Node::FindGlobalDecl(const char *name) {
+    Node *root = this;
+    while (root->parent) root = root->parent;
+    return root->LookupInScope(name);
+}
+
+ClassDecl *Node::GetEnclosingClass() {
+    for (Node *n = parent; n; n = n->parent) {
+        ClassDecl *c = dynamic_cast<ClassDecl*>(n);
+        if (c) return c;
+    }
+    return NULL;
+}
+
+FnDecl *Node::GetEnclosingFn() {
+    for (Node *n = parent; n; n = n->parent) {
+        FnDecl *f = dynamic_cast<FnDecl*>(n);
+        if (f) return f;
+    }
+    return NULL;
+}
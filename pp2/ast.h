@@ -25,15 +25,34 @@
  * PrintChildren() and GetPrintNameForNode() methods. All the classes we 
  * provide already implement these methods, so your job is to construct the
  * nodes and wire them up during parsing. Once that's done, printing is a snap!
-
+ *
+ * Checking: To run a program, the tree is first checked (Program::Check).
+ * The check resolves every name to its declaration, works out the type
+ * of every expression, lays out classes and assigns variables their
+ * storage, reporting the errors it finds along the way. Names are looked
+ * up by walking the parent links outwards through the nodes that open a
+ * scope (see FindDecl below).
+ *
+ * Folding: The checked tree then has its constant expressions folded
+ * (Program::FoldConstants, Expr::Fold), so that whatever runs or
+ * translates it has a smaller tree to work on.
+ *
+ * Executing: A checked tree can be run as is by the tree-walking
+ * interpreter (see interp.h), in which statements execute and
+ * expressions evaluate themselves.
  */
 
 #ifndef _H_ast
 #define _H_ast
 
 #include <stdlib.h>   // for NULL
+#include <iostream>
 #include "location.h"
 
+class Decl;
+class ClassDecl;
+class FnDecl;
+
 class Node 
 {
   protected:
@@ -54,6 +73,20 @@ class Node
     // subclasses should override PrintChildren() instead
     void Print(int indentLevel, const char *label = NULL); 
     virtual void PrintChildren(int indentLevel)  {}
+
+    // Returns the declaration of name visible from this node: the one in
+    // the innermost enclosing scope that declares it, or NULL.
+    Decl *FindDecl(const char *name);
+
+    // Returns the top-level declaration of name, or NULL.
+    Decl *FindGlobalDecl(const char *name);
+
+    // Nodes that open a scope return the declaration of name made in it.
+    virtual Decl *LookupInScope(const char *name) { return NULL; }
+
+    // The class or function this node is part of, or NULL.
+    ClassDecl *GetEnclosingClass();
+    FnDecl *GetEnclosingFn();
 };
    
 
@@ -64,8 +97,11 @@ class Identifier : public Node
     
   public:
     Identifier(yyltype loc, const char *name);
+    const char *GetName()               { return name; }
     const char *GetPrintNameForNode()   { return "Identifier"; }
     void PrintChildren(int indentLevel);
+    friend std::ostream& operator<<(std::ostream& out, Identifier *id)
+        { return out << id->name; }
 };
 
 
@@ -5,6 +5,13 @@
 #include "ast_decl.h"
 #include "ast_type.h"
 #include "ast_stmt.h"
+#include "scope.h"
+#include "errors.h"
+#include "interp.h"
+#include "codegen.h"
+#include "cwriter.h"
+#include "tacgen.h"
+#include <string.h>
         
          
 Decl::Decl(Identifier *n) : Node(*n->GetLocation()) {
@@ -12,10 +19,16 @@ Decl::Decl(Identifier *n) : Node(*n->GetLocation()) {
     (id=n)->SetParent(this); 
 }
 
+const char *Decl::GetName() {
+    return id->GetName();
+}
+
 
 VarDecl::VarDecl(Identifier *n, Type *t) : Decl(n) {
     Assert(n != NULL && t != NULL);
     (type=t)->SetParent(this);
+    storage = GlobalVar;
+    offset = -1;
 }
   
 void VarDecl::PrintChildren(int indentLevel) { 
@@ -30,6 +43,12 @@ ClassDecl::ClassDecl(Identifier *n, NamedType *ex, List<NamedType*> *imp, List<D
     if (extends) extends->SetParent(this);
     (implements=imp)->SetParentAll(this);
     (members=m)->SetParentAll(this);
+    scope = NULL;
+    base = NULL;
+    fields = NULL;
+    vtable = NULL;
+    type = NULL;
+    layoutState = 0;
 }
 
 void ClassDecl::PrintChildren(int indentLevel) {
@@ -43,6 +62,7 @@ void ClassDecl::PrintChildren(int indentLevel) {
 InterfaceDecl::InterfaceDecl(Identifier *n, List<Decl*> *m) : Decl(n) {
     Assert(n != NULL && m != NULL);
     (members=m)->SetParentAll(this);
+    scope = NULL;
 }
 
 void InterfaceDecl::PrintChildren(int indentLevel) {
@@ -55,6 +75,11 @@ FnDecl::FnDecl(Identifier *n, Type *r, List<VarDecl*> *d) : Decl(n) {
     (returnType=r)->SetParent(this);
     (formals=d)->SetParentAll(this);
     body = NULL;
+    scope = NULL;
+    vtableIndex = -1;
+    slotTypes = NULL;
+    frameInit = NULL;
+    codeIndex = -1;
 }
 
 void FnDecl::SetFunctionBody(Stmt *b) { 
@@ -69,3 +94,266 @@ void FnDecl::PrintChildren(int indentLevel) {
 }
 
 
+void VarDecl::Check() {
+    type->Check(LookingForType);
+}
+
+
+void ClassDecl::DeclareMembers() {
+    scope = new Scope;
+    fields = new List<VarDecl*>;
+    vtable = new List<FnDecl*>;
+    base = NULL;
+    layoutState = 0;
+    for (int i = 0; i < members->NumElements(); i++)
+        scope->Declare(members->Nth(i));
+}
+
+bool ClassDecl::IsReadyForLayout() {
+    ClassDecl *ext = extends ? extends->GetClassDecl() : NULL;
+    return !ext || ext->IsLaidOut();
+}
+
+/* Fields are laid out after those inherited, and methods take over the
+ * vtable slot of the method they override or get a new one at the end.
+ * Once the layout is known the class can be checked against the
+ * interfaces it claims to implement. */
+void ClassDecl::Layout() {
+    layoutState = 1;
+    if (extends) {
+        extends->Check(LookingForClass);
+        base = extends->GetClassDecl();
+        if (base && !base->IsLaidOut()) {
+            ReportError::Formatted(extends->GetLocation(),
+                "Class '%s' cannot extend itself", GetName());
+            base = NULL;
+        }
+    }
+    if (base) {
+        for (int i = 0; i < base->NumFields(); i++)
+            fields->Append(base->GetField(i));
+        for (int i = 0; i < base->NumMethods(); i++)
+            vtable->Append(base->GetMethod(i));
+    }
+    for (int i = 0; i < members->NumElements(); i++) {
+        Decl *m = members->Nth(i);
+        if (scope->Lookup(m->GetName()) != m) continue; // conflict reported
+        Decl *inherited = base ? base->LookupInScope(m->GetName()) : NULL;
+        VarDecl *var = dynamic_cast<VarDecl*>(m);
+        FnDecl *fn = dynamic_cast<FnDecl*>(m);
+        FnDecl *overridden = dynamic_cast<FnDecl*>(inherited);
+        if (inherited && (var || !overridden))
+            ReportError::DeclConflict(m, inherited);
+        if (var) {
+            var->SetStorage(FieldVar, fields->NumElements());
+            fields->Append(var);
+        } else if (overridden) {
+            if (!fn->MatchesSignature(overridden))
+                ReportError::OverrideMismatch(fn);
+            int slot = overridden->GetVtableIndex();
+            fn->SetVtableIndex(slot);
+            vtable->RemoveAt(slot);
+            vtable->InsertAt(fn, slot);
+        } else {
+            fn->SetVtableIndex(vtable->NumElements());
+            vtable->Append(fn);
+        }
+    }
+    for (int i = 0; i < implements->NumElements(); i++) {
+        NamedType *nt = implements->Nth(i);
+        nt->Check(LookingForInterface);
+        InterfaceDecl *intf = dynamic_cast<InterfaceDecl*>(nt->GetDecl());
+        if (!intf) continue;
+        bool complete = true;
+        List<Decl*> *protos = intf->GetMembers();
+        for (int j = 0; j < protos->NumElements(); j++) {
+            FnDecl *proto = dynamic_cast<FnDecl*>(protos->Nth(j));
+            FnDecl *impl = dynamic_cast<FnDecl*>(LookupInScope(proto->GetName()));
+            if (!impl)
+                complete = false;
+            else if (!impl->MatchesSignature(proto))
+                ReportError::OverrideMismatch(impl);
+        }
+        if (!complete) ReportError::InterfaceNotImplemented(this, nt);
+    }
+    layoutState = 2;
+}
+
+void ClassDecl::Check() {
+    for (int i = 0; i < members->NumElements(); i++)
+        members->Nth(i)->Check();
+}
+
+void ClassDecl::Emit(CodeGenerator *cg) {
+    for (int i = 0; i < members->NumElements(); i++)
+        members->Nth(i)->Emit(cg);
+}
+
+void ClassDecl::EmitTac(TacBuilder *tb) {
+    for (int i = 0; i < members->NumElements(); i++)
+        members->Nth(i)->EmitTac(tb);
+}
+
+void ClassDecl::FoldConstants() {
+    for (int i = 0; i < members->NumElements(); i++)
+        members->Nth(i)->FoldConstants();
+}
+
+void ClassDecl::EmitCStruct(CWriter *w) {
+    w->Write("%s {\n    const dc_class *cls;\n", CWriter::StructName(this).c_str());
+    for (int i = 0; i < fields->NumElements(); i++)
+        w->Write("    %s;\n", CWriter::Declaration(fields->Nth(i)->GetType(),
+                                           CWriter::Field(fields->Nth(i))).c_str());
+    w->Write("};\n\n");
+}
+
+/* The lookup function maps the number of each method name called through
+ * interfaces that the class has a method by to the method, as
+ * LookupMethod would. A new instance is zeroed, which leaves only its
+ * strings to set. */
+void ClassDecl::EmitCClass(CWriter *w) {
+    const char *name = GetName();
+    w->Write("static const dc_fn vt_%s[] = {", name);
+    for (int i = 0; i < vtable->NumElements(); i++)
+        w->Write("%s\n    (dc_fn)%s", i > 0 ? "," : "",
+                 CWriter::FunctionName(vtable->Nth(i)).c_str());
+    w->Write("%s\n};\n\n", vtable->NumElements() == 0 ? " 0" : "");
+
+    w->Write("static dc_fn lookup_%s(int method)\n{\n    switch (method) {\n", name);
+    for (int i = 0; i < w->NumInterfaceMethods(); i++) {
+        FnDecl *fn = LookupMethod(w->GetInterfaceMethod(i));
+        if (fn) w->Write("      case %d: return vt_%s[%d];\n", i, name, fn->GetVtableIndex());
+    }
+    w->Write("    }\n    return NULL;\n}\n\n");
+    w->Write("static const dc_class cls_%s = { \"%s\", vt_%s, lookup_%s };\n\n",
+             name, name, name, name);
+
+    std::string s = CWriter::StructName(this);
+    w->Write("static dc_obj *new_%s(void)\n{\n", name);
+    w->Write("    %s *o = dc_alloc(sizeof(%s));\n    o->cls = &cls_%s;\n", s.c_str(), s.c_str(), name);
+    for (int i = 0; i < fields->NumElements(); i++)
+        if (fields->Nth(i)->GetType() == Type::stringType)
+            w->Write("    o->%s = \"\";\n", CWriter::Field(fields->Nth(i)).c_str());
+    w->Write("    return (dc_obj *)o;\n}\n\n");
+}
+
+void ClassDecl::EmitC(CWriter *w) {
+    for (int i = 0; i < members->NumElements(); i++)
+        members->Nth(i)->EmitC(w);
+}
+
+Decl *ClassDecl::LookupInScope(const char *name) {
+    Decl *d = scope ? scope->Lookup(name) : NULL;
+    if (!d && base) d = base->LookupInScope(name);
+    return d;
+}
+
+FnDecl *ClassDecl::LookupMethod(const char *name) {
+    for (int i = 0; i < vtable->NumElements(); i++)
+        if (!strcmp(vtable->Nth(i)->GetName(), name)) return vtable->Nth(i);
+    return NULL;
+}
+
+NamedType *ClassDecl::GetType() {
+    if (!type) {
+        type = new NamedType(new Identifier(*id->GetLocation(), id->GetName()));
+        type->SetParent(this);
+    }
+    return type;
+}
+
+bool ClassDecl::IsSubtypeOf(Decl *other) {
+    for (ClassDecl *c = this; c; c = c->base) {
+        if (c == other) return true;
+        for (int i = 0; i < c->implements->NumElements(); i++)
+            if (c->implements->Nth(i)->GetDecl() == other) return true;
+    }
+    return false;
+}
+
+
+void InterfaceDecl::DeclareMembers() {
+    scope = new Scope;
+    for (int i = 0; i < members->NumElements(); i++)
+        scope->Declare(members->Nth(i));
+}
+
+void InterfaceDecl::Check() {
+    for (int i = 0; i < members->NumElements(); i++)
+        members->Nth(i)->Check();
+}
+
+Decl *InterfaceDecl::LookupInScope(const char *name) {
+    return scope ? scope->Lookup(name) : NULL;
+}
+
+
+/* Checking a function declares its formals, gives them and the locals
+ * of its body their slots in the frame, and checks the body. The zero
+ * values of the slots' types are kept to initialize each new frame. */
+void FnDecl::Check() {
+    returnType->Check(LookingForType);
+    scope = new Scope;
+    slotTypes = new List<Type*>;
+    ClassDecl *cls = GetEnclosingClass();
+    if (cls) slotTypes->Append(cls->GetType());
+    for (int i = 0; i < formals->NumElements(); i++) {
+        VarDecl *formal = formals->Nth(i);
+        formal->Check();
+        scope->Declare(formal);
+        AllocateSlot(formal);
+    }
+    if (body) body->Check();
+    frameInit = new Value[GetFrameSize()];
+    for (int i = 0; i < GetFrameSize(); i++)
+        frameInit[i] = Interpreter::ZeroOf(slotTypes->Nth(i));
+}
+
+Decl *FnDecl::LookupInScope(const char *name) {
+    return scope ? scope->Lookup(name) : NULL;
+}
+
+bool FnDecl::MatchesSignature(FnDecl *other) {
+    if (!returnType->IsEquivalentTo(other->returnType)) return false;
+    if (formals->NumElements() != other->formals->NumElements()) return false;
+    for (int i = 0; i < formals->NumElements(); i++)
+        if (!formals->Nth(i)->GetType()->IsEquivalentTo(other->formals->Nth(i)->GetType()))
+            return false;
+    return true;
+}
+
+void FnDecl::AllocateSlot(VarDecl *local) {
+    local->SetStorage(LocalVar, slotTypes->NumElements());
+    slotTypes->Append(local->GetType());
+}
+
+/* The bytecode of a function goes into the program's functions at the
+ * index Program::Emit has given it beforehand, so that calls to functions
+ * not generated yet know where to find them. */
+void FnDecl::Emit(CodeGenerator *cg) {
+    if (!body) return;
+    cg->BeginFunction(this);
+    body->Emit(cg);
+    cg->Gen(OpReturnVoid);
+    BcProgram *program = cg->GetProgram();
+    Assert(codeIndex == program->functions.NumElements());
+    program->functions.Append(cg->EndFunction());
+}
+
+void FnDecl::EmitC(CWriter *w) {
+    if (!body) return;
+    w->BeginFunction(this);
+    body->EmitC(w);
+    w->EndFunction();
+}
+
+void FnDecl::EmitTac(TacBuilder *tb) {
+    if (!body) return;
+    tb->BeginFunction(this);
+    body->EmitTac(tb);
+    tb->GetProgram()->functions[codeIndex] = tb->EndFunction();
+}
+
+void FnDecl::FoldConstants() {
+    if (body) body->FoldConstants();
+}
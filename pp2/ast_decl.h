@@ -11,11 +11,17 @@
 
 #include "ast.h"
 #include "list.h"
+#include "value.h"
 
 class Type;
 class NamedType;
 class Identifier;
 class Stmt;
+class Scope;
+class InterfaceDecl;
+class CodeGenerator;
+class CWriter;
+class TacBuilder;
 
 class Decl : public Node 
 {
@@ -24,17 +30,45 @@ class Decl : public Node
   
   public:
     Decl(Identifier *name);
+    const char *GetName();
+    Identifier *GetId() { return id; }
+    friend std::ostream& operator<<(std::ostream& out, Decl *d)
+        { return out << d->id; }
+
+    // Checks the declaration and everything in it (see ast.h).
+    virtual void Check() {}
+    // Generates bytecode for the functions declared (see codegen.h).
+    virtual void Emit(CodeGenerator *cg) {}
+    // Writes C for the functions declared (see cwriter.h).
+    virtual void EmitC(CWriter *w) {}
+    // Lowers the functions declared to three-address code (see tacgen.h).
+    virtual void EmitTac(TacBuilder *tb) {}
+    // Folds the constants in the functions declared (see Expr::Fold).
+    virtual void FoldConstants() {}
 };
 
+/* Where a variable lives while the program runs: in the globals, in the
+ * frame of the function that declares it, or in the object it is a field
+ * of. The offset is the index in the respective one. */
+typedef enum { GlobalVar, LocalVar, FieldVar } storageT;
+
 class VarDecl : public Decl 
 {
   protected:
     Type *type;
+    storageT storage;
+    int offset;
     
   public:
     VarDecl(Identifier *name, Type *type);
     const char *GetPrintNameForNode() { return "VarDecl"; }
     void PrintChildren(int indentLevel);
+
+    Type *GetType() { return type; }
+    void Check();
+    void SetStorage(storageT s, int off) { storage = s; offset = off; }
+    storageT GetStorage() { return storage; }
+    int GetOffset() { return offset; }
 };
 
 class ClassDecl : public Decl 
@@ -43,23 +77,69 @@ class ClassDecl : public Decl
     List<Decl*> *members;
     NamedType *extends;
     List<NamedType*> *implements;
+    Scope *scope;               // the class's own members
+    ClassDecl *base;            // the class extended, if any
+    List<VarDecl*> *fields;     // all fields, inherited ones first
+    List<FnDecl*> *vtable;      // all methods, by vtable index
+    NamedType *type;            // the type of its instances
+    int layoutState;            // 0 = not laid out, 1 = being, 2 = done
 
   public:
     ClassDecl(Identifier *name, NamedType *extends, 
               List<NamedType*> *implements, List<Decl*> *members);
     const char *GetPrintNameForNode() { return "ClassDecl"; }
     void PrintChildren(int indentLevel);
+
+    // The check of a class is done in three steps, each for all classes
+    // before the next: declaring the members, laying out the fields and
+    // vtable, and checking the members themselves. A class is ready to be
+    // laid out once the class it extends has been.
+    void DeclareMembers();
+    bool IsReadyForLayout();
+    void Layout();
+    bool IsLaidOut() { return layoutState == 2; }
+    void Check();
+
+    // Looks name up among the class's own and inherited members.
+    Decl *LookupInScope(const char *name);
+    // Looks up a method by name, as for a call through an interface.
+    FnDecl *LookupMethod(const char *name);
+
+    ClassDecl *GetBase() { return base; }
+    List<Decl*> *GetMembers() { return members; }
+    NamedType *GetType();
+    bool IsSubtypeOf(Decl *classOrInterface);
+    int NumFields() { return fields->NumElements(); }
+    VarDecl *GetField(int n) { return fields->Nth(n); }
+    int NumMethods() { return vtable->NumElements(); }
+    FnDecl *GetMethod(int n) { return vtable->Nth(n); }
+
+    void Emit(CodeGenerator *cg);
+    // The struct of its instances, then, once all functions have been
+    // declared, its vtable, its descriptor and the function that makes
+    // an instance.
+    void EmitCStruct(CWriter *w);
+    void EmitCClass(CWriter *w);
+    void EmitC(CWriter *w);
+    void EmitTac(TacBuilder *tb);
+    void FoldConstants();
 };
 
 class InterfaceDecl : public Decl 
 {
   protected:
     List<Decl*> *members;
+    Scope *scope;
     
   public:
     InterfaceDecl(Identifier *name, List<Decl*> *members);
     const char *GetPrintNameForNode() { return "InterfaceDecl"; }
     void PrintChildren(int indentLevel);
+
+    void DeclareMembers();
+    void Check();
+    Decl *LookupInScope(const char *name);
+    List<Decl*> *GetMembers() { return members; }
 };
 
 class FnDecl : public Decl 
@@ -68,12 +148,43 @@ class FnDecl : public Decl
     List<VarDecl*> *formals;
     Type *returnType;
     Stmt *body;
+    Scope *scope;               // the formals
+    int vtableIndex;            // for methods; -1 for global functions
+    List<Type*> *slotTypes;     // the type of each slot of the frame
+    Value *frameInit;           // the zero value of each slot
+    int codeIndex;              // of its code in the BcProgram or TacProgram
     
   public:
     FnDecl(Identifier *name, Type *returnType, List<VarDecl*> *formals);
     void SetFunctionBody(Stmt *b);
     const char *GetPrintNameForNode() { return "FnDecl"; }
     void PrintChildren(int indentLevel);
+
+    void Check();
+    Decl *LookupInScope(const char *name);
+
+    Type *GetReturnType() { return returnType; }
+    List<VarDecl*> *GetFormals() { return formals; }
+    Stmt *GetBody() { return body; }
+    bool IsMethod() { return GetEnclosingClass() != NULL; }
+    bool MatchesSignature(FnDecl *other);
+    void SetVtableIndex(int n) { vtableIndex = n; }
+    int GetVtableIndex() { return vtableIndex; }
+
+    // Gives a local variable the next free slot of the frame. Slot 0 holds
+    // the receiver of a method, then come the formals, then the locals of
+    // the body's blocks in the order they are declared.
+    void AllocateSlot(VarDecl *local);
+    int GetFrameSize() { return slotTypes->NumElements(); }
+    Type *GetSlotType(int n) { return slotTypes->Nth(n); }
+    Value *GetFrameInit() { return frameInit; }
+
+    void SetCodeIndex(int n) { codeIndex = n; }
+    int GetCodeIndex() { return codeIndex; }
+    void Emit(CodeGenerator *cg);
+    void EmitC(CWriter *w);
+    void EmitTac(TacBuilder *tb);
+    void FoldConstants();
 };
 
 #endif
@@ -5,7 +5,15 @@
 #include "ast_expr.h"
 #include "ast_type.h"
 #include "ast_decl.h"
+#include "errors.h"
+#include "codegen.h"
+#include "cwriter.h"
+#include "tacgen.h"
+#include "dstring.h"
 #include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <vector>
 
 
 
@@ -33,14 +41,47 @@ void BoolConstant::PrintChildren(int indentLevel) {
 StringConstant::StringConstant(yyltype loc, const char *val) : Expr(loc) {
     Assert(val != NULL);
     value = strdup(val);
+    char *chars = UnescapeString(value);
+    text = Strings::Intern(chars);
+    delete[] chars;
 }
+
+/* Function: UnescapeString()
+ * --------------------------
+ * Returns the characters a string literal stands for: the text between
+ * its quotes, with the escapes \n, \t and \\ replaced by the characters
+ * they name, as the assembler of the original runtime did. Any other
+ * backslash stands for itself.
+ */
+char *StringConstant::UnescapeString(const char *literal) {
+    int len = strlen(literal) - 2;
+    char *result = new char[len + 1], *p = result;
+    for (const char *s = literal + 1; s < literal + 1 + len; s++) {
+        if (*s == '\\' && s + 1 < literal + 1 + len) {
+            switch (*++s) {
+              case 'n': *p++ = '\n'; continue;
+              case 't': *p++ = '\t'; continue;
+              case '\\': break;
+              default:  *p++ = '\\'; break;
+            }
+        }
+        *p++ = *s;
+    }
+    *p = '\0';
+    return result;
+}
+
 void StringConstant::PrintChildren(int indentLevel) { 
     printf("%s",value);
 }
 
 Operator::Operator(yyltype loc, const char *tok) : Node(loc) {
+    static const char *tokens[] = { "+", "-", "*", "/", "%", "<", "<=", ">", ">=",
+                                    "==", "!=", "&&", "||", "!", "=", "++", "--" };
     Assert(tok != NULL);
     strncpy(tokenString, tok, sizeof(tokenString));
+    for (int i = 0; i < sizeof(tokens)/sizeof(tokens[0]); i++)
+        if (!strcmp(tokens[i], tok)) code = (opCodeT)i;
 }
 
 void Operator::PrintChildren(int indentLevel) {
@@ -78,6 +119,15 @@ void CompoundExpr::PrintChildren(int indentLevel) {
 }
    
   
+AssignExpr::AssignExpr(Expr *l, Operator *o, Expr *r) : CompoundExpr(l, o, r) {
+    target = dynamic_cast<LValue*>(l);
+    Assert(target != NULL);
+}
+
+PostfixExpr::PostfixExpr(Expr *l, Operator *o) : CompoundExpr(l, o) {
+    target = dynamic_cast<LValue*>(l);
+}
+  
 ArrayAccess::ArrayAccess(yyltype loc, Expr *b, Expr *s) : LValue(loc) {
     (base=b)->SetParent(this); 
     (subscript=s)->SetParent(this);
@@ -94,6 +144,7 @@ FieldAccess::FieldAccess(Expr *b, Identifier *f)
     base = b; 
     if (base) base->SetParent(this); 
     (field=f)->SetParent(this);
+    var = NULL;
 }
 
 
@@ -108,6 +159,8 @@ Call::Call(yyltype loc, Expr *b, Identifier *f, List<Expr*> *a) : Expr(loc)  {
     if (base) base->SetParent(this);
     (field=f)->SetParent(this);
     (actuals=a)->SetParentAll(this);
+    kind = GlobalCall;
+    fn = NULL;
 }
 
  void Call::PrintChildren(int indentLevel) {
@@ -138,3 +191,1356 @@ void NewArrayExpr::PrintChildren(int indentLevel) {
 }
 
        
+
+
+/* Checking expressions
+ * --------------------
+ * Each expression checks its subexpressions, then works out its own type.
+ * An expression that is in error gets the error type, which is
+ * compatible with everything, so that the mistake is reported only once.
+ *
+ * Evaluating expressions
+ * ----------------------
+ * Evaluation relies on the check: an int expression is known to yield an
+ * int Value, a variable to have been given storage, and so on. Integer
+ * arithmetic wraps around on overflow.
+ */
+void EmptyExpr::Check()       { type = Type::voidType; }
+void IntConstant::Check()     { type = Type::intType; }
+void DoubleConstant::Check()  { type = Type::doubleType; }
+void BoolConstant::Check()    { type = Type::boolType; }
+void StringConstant::Check()  { type = Type::stringType; }
+void NullConstant::Check()    { type = Type::nullType; }
+void ReadIntegerExpr::Check() { type = Type::intType; }
+void ReadLineExpr::Check()    { type = Type::stringType; }
+
+
+void ArithmeticExpr::Check() {
+    Type *lt = NULL, *rt;
+    if (left) left->Check();
+    right->Check();
+    if (left) lt = left->GetType();
+    rt = right->GetType();
+    if (lt ? (lt->IsError() || rt->IsError()) : rt->IsError())
+        type = Type::errorType;
+    else if (rt->IsNumeric() && (!lt || lt->IsEquivalentTo(rt)))
+        type = rt;
+    else {
+        if (lt) ReportError::IncompatibleOperands(op, lt, rt);
+        else ReportError::IncompatibleOperand(op, rt);
+        type = Type::errorType;
+    }
+}
+
+Value ArithmeticExpr::Eval(Value *frame) {
+    if (!left) {
+        Value v = right->Eval(frame);
+        return type == Type::intType ? MakeInt(-(unsigned)v.i) : MakeDouble(-v.d);
+    }
+    Value l = left->Eval(frame), r = right->Eval(frame);
+    if (type == Type::doubleType) {
+        switch (op->GetCode()) {
+          case OpAdd:      return MakeDouble(l.d + r.d);
+          case OpSubtract: return MakeDouble(l.d - r.d);
+          case OpMultiply: return MakeDouble(l.d * r.d);
+          case OpDivide:   return MakeDouble(l.d / r.d);
+          default:         return MakeDouble(fmod(l.d, r.d));
+        }
+    }
+    unsigned a = l.i, b = r.i;
+    switch (op->GetCode()) {
+      case OpAdd:      return MakeInt(a + b);
+      case OpSubtract: return MakeInt(a - b);
+      case OpMultiply: return MakeInt(a * b);
+      case OpDivide:
+        if (r.i == 0) Interpreter::Halt("Division by zero");
+        return MakeInt(r.i == -1 ? -a : l.i / r.i);
+      default:
+        if (r.i == 0) Interpreter::Halt("Division by zero");
+        return MakeInt(r.i == -1 ? 0 : l.i % r.i);
+    }
+}
+
+void RelationalExpr::Check() {
+    left->Check();
+    right->Check();
+    Type *lt = left->GetType(), *rt = right->GetType();
+    if (!lt->IsError() && !rt->IsError() &&
+        !(lt->IsNumeric() && lt->IsEquivalentTo(rt)))
+        ReportError::IncompatibleOperands(op, lt, rt);
+    type = Type::boolType;
+}
+
+Value RelationalExpr::Eval(Value *frame) {
+    Value l = left->Eval(frame), r = right->Eval(frame);
+    if (l.kind == DoubleValue) {
+        switch (op->GetCode()) {
+          case OpLess:      return MakeBool(l.d < r.d);
+          case OpLessEqual: return MakeBool(l.d <= r.d);
+          case OpGreater:   return MakeBool(l.d > r.d);
+          default:          return MakeBool(l.d >= r.d);
+        }
+    }
+    switch (op->GetCode()) {
+      case OpLess:      return MakeBool(l.i < r.i);
+      case OpLessEqual: return MakeBool(l.i <= r.i);
+      case OpGreater:   return MakeBool(l.i > r.i);
+      default:          return MakeBool(l.i >= r.i);
+    }
+}
+
+void EqualityExpr::Check() {
+    left->Check();
+    right->Check();
+    Type *lt = left->GetType(), *rt = right->GetType();
+    if (lt == Type::voidType || rt == Type::voidType ||
+        !(lt->IsCompatibleWith(rt) || rt->IsCompatibleWith(lt)))
+        ReportError::IncompatibleOperands(op, lt, rt);
+    type = Type::boolType;
+}
+
+/* Strings are equal when their characters are (see dstring.h); objects
+ * and arrays only when they are the same one. */
+Value EqualityExpr::Eval(Value *frame) {
+    Value l = left->Eval(frame), r = right->Eval(frame);
+    bool equal;
+    switch (l.kind) {
+      case IntValue:    equal = l.i == r.i; break;
+      case DoubleValue: equal = l.d == r.d; break;
+      case BoolValue:   equal = l.b == r.b; break;
+      case StringValue: equal = Strings::Equal(l.s, r.s); break;
+      default:          equal = l.ref == r.ref; break;
+    }
+    return MakeBool(op->GetCode() == OpEqual ? equal : !equal);
+}
+
+void LogicalExpr::Check() {
+    if (left) left->Check();
+    right->Check();
+    Type *lt = left ? left->GetType() : Type::boolType, *rt = right->GetType();
+    if (!lt->IsCompatibleWith(Type::boolType) || !rt->IsCompatibleWith(Type::boolType)) {
+        if (left) ReportError::IncompatibleOperands(op, lt, rt);
+        else ReportError::IncompatibleOperand(op, rt);
+    }
+    type = Type::boolType;
+}
+
+Value LogicalExpr::Eval(Value *frame) {
+    switch (op->GetCode()) {
+      case OpAnd: return MakeBool(left->Eval(frame).b && right->Eval(frame).b);
+      case OpOr:  return MakeBool(left->Eval(frame).b || right->Eval(frame).b);
+      default:    return MakeBool(!right->Eval(frame).b);
+    }
+}
+
+void AssignExpr::Check() {
+    left->Check();
+    right->Check();
+    Type *lt = left->GetType(), *rt = right->GetType();
+    if (!rt->IsCompatibleWith(lt) || lt == Type::voidType)
+        ReportError::IncompatibleOperands(op, lt, rt);
+    type = lt;
+}
+
+Value AssignExpr::Eval(Value *frame) {
+    Value v = right->Eval(frame);
+    *target->Address(frame) = v;
+    return v;
+}
+
+void PostfixExpr::Check() {
+    left->Check();
+    type = left->GetType();
+    if (!target)
+        ReportError::PostfixNotVariable(op);
+    else if (!type->IsError() && !type->IsNumeric())
+        ReportError::IncompatibleOperand(op, type);
+}
+
+Value PostfixExpr::Eval(Value *frame) {
+    Value *p = target->Address(frame);
+    Value old = *p;
+    int delta = op->GetCode() == OpIncrement ? 1 : -1;
+    if (old.kind == DoubleValue) p->d += delta;
+    else p->i = (unsigned)old.i + delta;
+    return old;
+}
+
+void This::Check() {
+    ClassDecl *cls = GetEnclosingClass();
+    if (cls) {
+        type = cls->GetType();
+    } else {
+        ReportError::ThisOutsideClassScope(this);
+        type = Type::errorType;
+    }
+}
+
+void ArrayAccess::Check() {
+    base->Check();
+    subscript->Check();
+    ArrayType *at = dynamic_cast<ArrayType*>(base->GetType());
+    if (at) {
+        type = at->GetElemType();
+    } else {
+        if (!base->GetType()->IsError()) ReportError::BracketsOnNonArray(base);
+        type = Type::errorType;
+    }
+    if (!subscript->GetType()->IsCompatibleWith(Type::intType))
+        ReportError::SubscriptNotInteger(subscript);
+}
+
+Value *ArrayAccess::Address(Value *frame) {
+    ArrayObject *arr = base->Eval(frame).arr;
+    int i = subscript->Eval(frame).i;
+    if (!arr) Interpreter::Halt("Null object reference");
+    if (i < 0 || i >= arr->length) Interpreter::Halt("Array subscript out of bounds");
+    return &arr->elems[i];
+}
+
+/* Without a base, the name is looked up outwards from here and may be a
+ * local, a field of this object or a global. With one, it must be a field
+ * of the base's class, and the base must be of this class (or a subclass)
+ * for the field to be accessible, since Decaf fields are protected. */
+void FieldAccess::Check() {
+    var = NULL;
+    type = Type::errorType;
+    if (!base) {
+        var = dynamic_cast<VarDecl*>(FindDecl(field->GetName()));
+        if (var) type = var->GetType();
+        else ReportError::IdentifierNotDeclared(field, LookingForVariable);
+        return;
+    }
+    base->Check();
+    Type *bt = base->GetType();
+    if (bt->IsError()) return;
+    NamedType *nt = dynamic_cast<NamedType*>(bt);
+    ClassDecl *cls = nt ? nt->GetClassDecl() : NULL;
+    var = cls ? dynamic_cast<VarDecl*>(cls->LookupInScope(field->GetName())) : NULL;
+    ClassDecl *here = GetEnclosingClass();
+    if (!var)
+        ReportError::FieldNotFoundInBase(field, bt);
+    else if (!here || !bt->IsCompatibleWith(here->GetType()))
+        ReportError::InaccessibleField(field, bt);
+    else
+        type = var->GetType();
+    if (type->IsError()) var = NULL;
+}
+
+Value *FieldAccess::Address(Value *frame) {
+    switch (var->GetStorage()) {
+      case LocalVar:  return &frame[var->GetOffset()];
+      case GlobalVar: return &Interpreter::globals[var->GetOffset()];
+      default: break;
+    }
+    Object *obj = base ? base->Eval(frame).obj : frame[0].obj;
+    if (!obj) Interpreter::Halt("Null object reference");
+    return &obj->fields[var->GetOffset()];
+}
+
+void Call::Check() {
+    fn = NULL;
+    type = Type::errorType;
+    for (int i = 0; i < actuals->NumElements(); i++)
+        actuals->Nth(i)->Check();
+    if (!base) {
+        fn = dynamic_cast<FnDecl*>(FindDecl(field->GetName()));
+        if (!fn) {
+            ReportError::IdentifierNotDeclared(field, LookingForFunction);
+            return;
+        }
+        kind = fn->IsMethod() ? MethodCall : GlobalCall;
+        CheckActuals();
+        return;
+    }
+    base->Check();
+    Type *bt = base->GetType();
+    if (bt->IsError()) return;
+    if (dynamic_cast<ArrayType*>(bt) && !strcmp(field->GetName(), "length")) {
+        kind = ArrayLengthCall;
+        if (actuals->NumElements() != 0)
+            ReportError::NumArgsMismatch(field, 0, actuals->NumElements());
+        type = Type::intType;
+        return;
+    }
+    NamedType *nt = dynamic_cast<NamedType*>(bt);
+    Decl *d = nt ? nt->GetDecl() : NULL;
+    fn = d ? dynamic_cast<FnDecl*>(d->LookupInScope(field->GetName())) : NULL;
+    if (!fn) {
+        ReportError::FieldNotFoundInBase(field, bt);
+        return;
+    }
+    kind = dynamic_cast<InterfaceDecl*>(d) ? InterfaceCall : MethodCall;
+    CheckActuals();
+}
+
+void Call::CheckActuals() {
+    List<VarDecl*> *formals = fn->GetFormals();
+    type = fn->GetReturnType();
+    if (formals->NumElements() != actuals->NumElements()) {
+        ReportError::NumArgsMismatch(field, formals->NumElements(), actuals->NumElements());
+        return;
+    }
+    for (int i = 0; i < actuals->NumElements(); i++) {
+        Type *given = actuals->Nth(i)->GetType(), *expected = formals->Nth(i)->GetType();
+        if (!given->IsCompatibleWith(expected))
+            ReportError::ArgMismatch(actuals->Nth(i), i+1, given, expected);
+    }
+}
+
+/* The callee's frame is pushed before the actuals are evaluated, so they
+ * can be evaluated straight into its slots; calls made while evaluating
+ * them simply push their frames above it. */
+Value Call::Eval(Value *frame) {
+    FnDecl *target = fn;
+    Value receiver;
+    if (kind == ArrayLengthCall) {
+        ArrayObject *arr = base->Eval(frame).arr;
+        if (!arr) Interpreter::Halt("Null object reference");
+        return MakeInt(arr->length);
+    }
+    if (kind != GlobalCall) {
+        receiver = base ? base->Eval(frame) : frame[0];
+        if (!receiver.obj) Interpreter::Halt("Null object reference");
+        ClassDecl *cls = receiver.obj->cls;
+        if (kind == MethodCall)
+            target = cls->GetMethod(fn->GetVtableIndex());
+        else
+            target = cls->LookupMethod(fn->GetName());
+    }
+    Value *callee = Interpreter::PushFrame(target);
+    int slot = 0;
+    if (kind != GlobalCall) callee[slot++] = receiver;
+    for (int i = 0; i < actuals->NumElements(); i++)
+        callee[slot++] = actuals->Nth(i)->Eval(frame);
+    Value result;
+    if (target->GetBody()->Exec(callee) == ExecReturn)
+        result = Interpreter::returnValue;
+    else
+        result = Interpreter::ZeroOf(target->GetReturnType());
+    Interpreter::PopFrame(callee);
+    return result;
+}
+
+void NewExpr::Check() {
+    cType->Check(LookingForClass);
+    type = cType->IsError() ? Type::errorType : cType;
+}
+
+Value NewExpr::Eval(Value *frame) {
+    return Interpreter::NewObject(cType->GetClassDecl());
+}
+
+void NewArrayExpr::Check() {
+    size->Check();
+    if (!size->GetType()->IsCompatibleWith(Type::intType))
+        ReportError::NewArraySizeNotInteger(size);
+    elemType->Check(LookingForType);
+    type = new ArrayType(elemType);
+}
+
+Value NewArrayExpr::Eval(Value *frame) {
+    return Interpreter::NewArray(size->Eval(frame).i, elemType);
+}
+
+
+/* Folding constants
+ * -----------------
+ * Once the tree is checked, an operator whose operands are all literals
+ * is replaced by the literal of its value, which Eval() computes just as
+ * the interpreter would at runtime (int arithmetic wrapping around), and
+ * identities drop operations that leave an operand as it is: x + 0,
+ * x - 0, x * 1, x / 1, -(-x), !!b, && and || with a literal on the left,
+ * or with one on the right that leaves the result to the left. Nothing
+ * with an effect is dropped. A division by a literal 0 stays, for the
+ * runtime error, and so does a double that comes out infinite or NaN,
+ * which no literal can stand for.
+ */
+static Expr *MakeLiteral(yyltype *loc, Value v) {
+    Expr *literal;
+    switch (v.kind) {
+      case IntValue:    literal = new IntConstant(*loc, v.i); break;
+      case DoubleValue: literal = new DoubleConstant(*loc, v.d); break;
+      default:          literal = new BoolConstant(*loc, v.b); break;
+    }
+    literal->Check();
+    return literal;
+}
+
+static bool IsIntLiteral(Expr *e, int value) {
+    return e->IsConstant() && e->GetType() == Type::intType && e->Eval(NULL).i == value;
+}
+
+static bool IsDoubleLiteral(Expr *e, double value) {
+    return e->IsConstant() && e->GetType() == Type::doubleType && e->Eval(NULL).d == value;
+}
+
+Expr *Expr::FoldInto(Node *parent) {
+    Expr *folded = Fold();
+    folded->SetParent(parent);
+    return folded;
+}
+
+void Expr::FoldAll(List<Expr*> *exprs, Node *parent) {
+    for (int i = 0; i < exprs->NumElements(); i++) {
+        Expr *e = exprs->Nth(i), *folded = e->FoldInto(parent);
+        if (folded == e) continue;
+        exprs->RemoveAt(i);
+        exprs->InsertAt(folded, i);
+    }
+}
+
+/* Adding or subtracting literals in a row, as in i + 1 - 1, is adding
+ * their sum once: ints wrap around, so order does not matter. */
+Expr *ArithmeticExpr::Fold() {
+    if (left) left = left->FoldInto(this);
+    right = right->FoldInto(this);
+    bool isInt = type == Type::intType;
+    opCodeT code = op->GetCode();
+    if ((!left || left->IsConstant()) && right->IsConstant()) {
+        if (isInt && left && (code == OpDivide || code == OpModulo) && IsIntLiteral(right, 0))
+            return this;
+        Value v = Eval(NULL);
+        return isInt || isfinite(v.d) ? MakeLiteral(location, v) : this;
+    }
+    if (!left) {
+        ArithmeticExpr *negated = dynamic_cast<ArithmeticExpr*>(right);
+        return isInt && negated && !negated->left ? negated->right : this;
+    }
+    if (!isInt) {
+        if ((code == OpMultiply || code == OpDivide) && IsDoubleLiteral(right, 1)) return left;
+        if (code == OpMultiply && IsDoubleLiteral(left, 1)) return right;
+        return this;
+    }
+    switch (code) {
+      case OpAdd:
+        if (IsIntLiteral(left, 0)) return right;
+        // fall through
+      case OpSubtract:
+        if (IsIntLiteral(right, 0)) return left;
+        break;
+      case OpMultiply:
+        if (IsIntLiteral(left, 1)) return right;
+        // fall through
+      case OpDivide:
+        if (IsIntLiteral(right, 1)) return left;
+        break;
+      default:
+        break;
+    }
+
+    ArithmeticExpr *inner = dynamic_cast<ArithmeticExpr*>(left);
+    if ((code != OpAdd && code != OpSubtract) || !right->IsConstant() || !inner ||
+        !inner->left || !inner->right->IsConstant())
+        return this;
+    opCodeT innerCode = inner->op->GetCode();
+    if (innerCode != OpAdd && innerCode != OpSubtract) return this;
+    unsigned a = inner->right->Eval(NULL).i, b = right->Eval(NULL).i;
+    unsigned sum = (innerCode == OpAdd ? a : -a) + (code == OpAdd ? b : -b);
+    if (sum == 0) return inner->left;
+    (inner->op = new Operator(*op->GetLocation(), "+"))->SetParent(inner);
+    (inner->right = MakeLiteral(right->GetLocation(), MakeInt(sum)))->SetParent(inner);
+    return inner;
+}
+
+Expr *RelationalExpr::Fold() {
+    left = left->FoldInto(this);
+    right = right->FoldInto(this);
+    if (left->IsConstant() && right->IsConstant()) return MakeLiteral(location, Eval(NULL));
+    return this;
+}
+
+Expr *EqualityExpr::Fold() {
+    left = left->FoldInto(this);
+    right = right->FoldInto(this);
+    if (left->IsConstant() && right->IsConstant()) return MakeLiteral(location, Eval(NULL));
+    return this;
+}
+
+/* true && x is x and false && x is false, the other way round for ||;
+ * x && true and x || false are x. */
+Expr *LogicalExpr::Fold() {
+    if (left) left = left->FoldInto(this);
+    right = right->FoldInto(this);
+    bool isAnd = op->GetCode() == OpAnd;
+    if (!left) {
+        if (right->IsConstant()) return MakeLiteral(location, Eval(NULL));
+        LogicalExpr *negated = dynamic_cast<LogicalExpr*>(right);
+        return negated && !negated->left ? negated->right : this;
+    }
+    if (left->IsConstant()) return left->Eval(NULL).b == isAnd ? right : left;
+    if (right->IsConstant() && right->Eval(NULL).b == isAnd) return left;
+    return this;
+}
+
+Expr *AssignExpr::Fold() {
+    left->Fold();
+    right = right->FoldInto(this);
+    return this;
+}
+
+Expr *PostfixExpr::Fold() {
+    left->Fold();
+    return this;
+}
+
+Expr *ArrayAccess::Fold() {
+    base = base->FoldInto(this);
+    subscript = subscript->FoldInto(this);
+    return this;
+}
+
+Expr *FieldAccess::Fold() {
+    if (base) base = base->FoldInto(this);
+    return this;
+}
+
+Expr *Call::Fold() {
+    if (base) base = base->FoldInto(this);
+    FoldAll(actuals, this);
+    return this;
+}
+
+Expr *NewArrayExpr::Fold() {
+    size = size->FoldInto(this);
+    return this;
+}
+
+
+/* Generating code
+ * ---------------
+ * Each expression computes its value into a fresh temporary, except that
+ * local variables are used in place, in their own registers. The opcode
+ * for an operator is picked by the type the check found for its
+ * operands, so the VM never looks at the kind of a Value.
+ */
+int EmptyExpr::EmitValue(CodeGenerator *cg) {
+    return cg->NewTemp();
+}
+
+int IntConstant::EmitValue(CodeGenerator *cg) {
+    int reg = cg->NewTemp();
+    cg->GenLoadInt(reg, value);
+    return reg;
+}
+
+int DoubleConstant::EmitValue(CodeGenerator *cg) {
+    int reg = cg->NewTemp();
+    cg->GenLoadConst(reg, MakeDouble(value));
+    return reg;
+}
+
+int BoolConstant::EmitValue(CodeGenerator *cg) {
+    int reg = cg->NewTemp();
+    cg->GenLoadConst(reg, MakeBool(value));
+    return reg;
+}
+
+int StringConstant::EmitValue(CodeGenerator *cg) {
+    int reg = cg->NewTemp();
+    cg->GenLoadConst(reg, MakeString(text));
+    return reg;
+}
+
+int NullConstant::EmitValue(CodeGenerator *cg) {
+    int reg = cg->NewTemp();
+    cg->GenLoadConst(reg, MakeObject(NULL));
+    return reg;
+}
+
+int ReadIntegerExpr::EmitValue(CodeGenerator *cg) {
+    int reg = cg->NewTemp();
+    cg->Gen(OpReadInteger, reg);
+    return reg;
+}
+
+int ReadLineExpr::EmitValue(CodeGenerator *cg) {
+    int reg = cg->NewTemp();
+    cg->Gen(OpReadLine, reg);
+    return reg;
+}
+
+int This::EmitValue(CodeGenerator *cg) {
+    return 0;
+}
+
+
+bool CompoundExpr::HasAssignment() {
+    return (left && left->HasAssignment()) || right->HasAssignment();
+}
+
+void CompoundExpr::EmitOperands(CodeGenerator *cg, int *l, int *r) {
+    *l = left->EmitValue(cg);
+    if (!cg->IsTemp(*l) && right->HasAssignment()) {
+        int copy = cg->NewTemp();
+        cg->GenMove(copy, *l);
+        *l = copy;
+    }
+    *r = right->EmitValue(cg);
+}
+
+int ArithmeticExpr::EmitValue(CodeGenerator *cg) {
+    static const opcodeT intOps[] = { OpAddInt, OpSubInt, OpMulInt, OpDivInt, OpModInt };
+    static const opcodeT doubleOps[] = { OpAddDouble, OpSubDouble, OpMulDouble,
+                                         OpDivDouble, OpModDouble };
+    bool isInt = type == Type::intType;
+    int result, l, r;
+    if (!left) {
+        r = right->EmitValue(cg);
+        result = cg->NewTemp();
+        cg->Gen(isInt ? OpNegate : OpNegateDouble, result, r);
+        return result;
+    }
+    IntConstant *k = dynamic_cast<IntConstant*>(right);
+    opCodeT code = op->GetCode();
+    if (isInt && k && (code == OpAdd || code == OpSubtract)) {
+        int n = code == OpAdd ? k->GetValue() : -k->GetValue();
+        if (CodeGenerator::FitsImmediate(n)) {
+            l = left->EmitValue(cg);
+            result = cg->NewTemp();
+            cg->Gen(OpAddIntImm, result, l, (unsigned short)n);
+            return result;
+        }
+    }
+    EmitOperands(cg, &l, &r);
+    result = cg->NewTemp();
+    cg->Gen((isInt ? intOps : doubleOps)[code - OpAdd], result, l, r);
+    return result;
+}
+
+int RelationalExpr::EmitValue(CodeGenerator *cg) {
+    static const opcodeT intOps[] = { OpLessInt, OpLessEqualInt, OpGreaterInt,
+                                      OpGreaterEqualInt };
+    static const opcodeT doubleOps[] = { OpLessDouble, OpLessEqualDouble,
+                                         OpGreaterDouble, OpGreaterEqualDouble };
+    bool isInt = left->GetType() == Type::intType;
+    int l, r;
+    EmitOperands(cg, &l, &r);
+    int result = cg->NewTemp();
+    cg->Gen((isInt ? intOps : doubleOps)[op->GetCode() - OpLess], result, l, r);
+    return result;
+}
+
+int EqualityExpr::EmitValue(CodeGenerator *cg) {
+    Type *t = left->GetType();
+    bool equal = op->GetCode() == OpEqual;
+    opcodeT opcode;
+    if (t == Type::intType) opcode = equal ? OpEqualInt : OpNotEqualInt;
+    else if (t == Type::doubleType) opcode = equal ? OpEqualDouble : OpNotEqualDouble;
+    else if (t == Type::boolType) opcode = equal ? OpEqualBool : OpNotEqualBool;
+    else if (t == Type::stringType) opcode = equal ? OpEqualString : OpNotEqualString;
+    else opcode = equal ? OpEqualRef : OpNotEqualRef;
+    int l, r;
+    EmitOperands(cg, &l, &r);
+    int result = cg->NewTemp();
+    cg->Gen(opcode, result, l, r);
+    return result;
+}
+
+/* && and || evaluate their right operand only if the left does not
+ * already decide the result. */
+int LogicalExpr::EmitValue(CodeGenerator *cg) {
+    int result = cg->NewTemp();
+    if (!left) {
+        cg->Gen(OpNotBool, result, right->EmitValue(cg));
+        return result;
+    }
+    int end = cg->NewLabel();
+    cg->GenMoveResult(result, left->EmitValue(cg));
+    cg->GenJump(op->GetCode() == OpAnd ? OpJumpIfNot : OpJumpIf, end, result);
+    cg->GenMoveResult(result, right->EmitValue(cg));
+    cg->PlaceLabel(end);
+    return result;
+}
+
+int AssignExpr::EmitValue(CodeGenerator *cg) {
+    int value = right->EmitValue(cg);
+    if (!cg->IsTemp(value) && target->HasAssignment()) {
+        int copy = cg->NewTemp();
+        cg->GenMove(copy, value);
+        value = copy;
+    }
+    target->EmitAddress(cg);
+    target->EmitStore(cg, value);
+    return value;
+}
+
+/* Used for its effect only, the value can be computed straight into a
+ * local variable being assigned, and a constant stored into an array
+ * element without a register. */
+void AssignExpr::Emit(CodeGenerator *cg) {
+    int reg = target->GetLocalRegister();
+    ArrayAccess *elem = dynamic_cast<ArrayAccess*>(target);
+    if (reg >= 0) {
+        cg->GenMoveResult(reg, right->EmitValue(cg));
+    } else if (elem && right->IsConstant()) {
+        elem->EmitAddress(cg);
+        elem->EmitStoreConstant(cg, right->Eval(NULL));
+    } else {
+        EmitValue(cg);
+    }
+}
+
+/* Used for its effect only, as in the step of a for loop, incrementing a
+ * local int is a single instruction. */
+void PostfixExpr::Emit(CodeGenerator *cg) {
+    int reg = target->GetLocalRegister();
+    if (reg >= 0 && type == Type::intType)
+        cg->Gen(OpAddIntImm, reg, reg, (unsigned short)(op->GetCode() == OpIncrement ? 1 : -1));
+    else
+        EmitValue(cg);
+}
+
+int PostfixExpr::EmitValue(CodeGenerator *cg) {
+    int delta = op->GetCode() == OpIncrement ? 1 : -1;
+    target->EmitAddress(cg);
+    int old = cg->NewTemp(), updated = cg->NewTemp();
+    cg->GenMoveResult(old, target->EmitLoad(cg));
+    if (type == Type::intType) {
+        cg->Gen(OpAddIntImm, updated, old, (unsigned short)delta);
+    } else {
+        cg->GenLoadConst(updated, MakeDouble(delta));
+        cg->Gen(OpAddDouble, updated, old, updated);
+    }
+    target->EmitStore(cg, updated);
+    return old;
+}
+
+
+bool ArrayAccess::HasAssignment() {
+    return base->HasAssignment() || subscript->HasAssignment();
+}
+
+void ArrayAccess::EmitAddress(CodeGenerator *cg) {
+    baseReg = base->EmitValue(cg);
+    if (!cg->IsTemp(baseReg) && subscript->HasAssignment()) {
+        int copy = cg->NewTemp();
+        cg->GenMove(copy, baseReg);
+        baseReg = copy;
+    }
+    subscriptReg = subscript->EmitValue(cg);
+}
+
+int ArrayAccess::EmitLoad(CodeGenerator *cg) {
+    int result = cg->NewTemp();
+    cg->Gen(OpGetElem, result, baseReg, subscriptReg);
+    return result;
+}
+
+void ArrayAccess::EmitStore(CodeGenerator *cg, int src) {
+    cg->Gen(OpSetElem, baseReg, subscriptReg, src);
+}
+
+void ArrayAccess::EmitStoreConstant(CodeGenerator *cg, Value v) {
+    cg->Gen(OpSetElemConst, baseReg, subscriptReg, cg->GetProgram()->AddConstant(v));
+}
+
+int FieldAccess::GetLocalRegister() {
+    return var->GetStorage() == LocalVar ? var->GetOffset() : -1;
+}
+
+void FieldAccess::EmitAddress(CodeGenerator *cg) {
+    if (var->GetStorage() == FieldVar)
+        baseReg = base ? base->EmitValue(cg) : 0;
+}
+
+int FieldAccess::EmitLoad(CodeGenerator *cg) {
+    if (var->GetStorage() == LocalVar) return var->GetOffset();
+    int result = cg->NewTemp();
+    if (var->GetStorage() == GlobalVar)
+        cg->Gen(OpLoadGlobal, result, var->GetOffset());
+    else
+        cg->Gen(OpGetField, result, baseReg, var->GetOffset());
+    return result;
+}
+
+void FieldAccess::EmitStore(CodeGenerator *cg, int src) {
+    switch (var->GetStorage()) {
+      case LocalVar:  cg->GenMove(var->GetOffset(), src); break;
+      case GlobalVar: cg->Gen(OpStoreGlobal, var->GetOffset(), src); break;
+      default:        cg->Gen(OpSetField, baseReg, var->GetOffset(), src); break;
+    }
+}
+
+
+bool Call::HasAssignment() {
+    if (base && base->HasAssignment()) return true;
+    for (int i = 0; i < actuals->NumElements(); i++)
+        if (actuals->Nth(i)->HasAssignment()) return true;
+    return false;
+}
+
+/* The receiver and arguments are put in consecutive registers, which
+ * become the first registers of the callee; the result comes back in the
+ * first of them. */
+int Call::EmitValue(CodeGenerator *cg) {
+    if (kind == ArrayLengthCall) {
+        int arr = base->EmitValue(cg), result = cg->NewTemp();
+        cg->Gen(OpLength, result, arr);
+        return result;
+    }
+    int n = actuals->NumElements() + (kind == GlobalCall ? 0 : 1);
+    int args = cg->NewTemps(n > 0 ? n : 1), next = args;
+    if (kind != GlobalCall)
+        cg->GenMoveResult(next++, base ? base->EmitValue(cg) : 0);
+    for (int i = 0; i < actuals->NumElements(); i++)
+        cg->GenMoveResult(next++, actuals->Nth(i)->EmitValue(cg));
+    switch (kind) {
+      case GlobalCall:
+        cg->Gen(OpCall, args, fn->GetCodeIndex(), args);
+        break;
+      case MethodCall:
+        cg->Gen(OpCallVirtual, args, fn->GetVtableIndex(), args);
+        break;
+      default:
+        cg->Gen(OpCallInterface, args,
+                cg->GetProgram()->AddConstant(MakeString(Strings::Intern(fn->GetName()))), args);
+        break;
+    }
+    cg->FreeTemps(args + 1);
+    return args;
+}
+
+int NewExpr::EmitValue(CodeGenerator *cg) {
+    int result = cg->NewTemp();
+    cg->Gen(OpNewObject, result, cg->GetProgram()->AddClass(cType->GetClassDecl()));
+    return result;
+}
+
+int NewArrayExpr::EmitValue(CodeGenerator *cg) {
+    int n = size->EmitValue(cg), result = cg->NewTemp();
+    cg->Gen(OpNewArray, result, n, cg->GetProgram()->AddType(elemType));
+    return result;
+}
+
+
+/* Generating C
+ * ------------
+ * Each expression computes its value into a fresh temporary, as for
+ * bytecode, except that literals are used as they are. The order things
+ * are evaluated and checked in is the interpreter's, so a program stops
+ * at the same runtime error having printed the same output.
+ */
+std::string EmptyExpr::EmitCValue(CWriter *w) {
+    return "";
+}
+
+std::string IntConstant::EmitCValue(CWriter *w) {
+    if (value == INT_MIN) return "(-2147483647 - 1)";
+    return CWriter::Format(value < 0 ? "(%d)" : "%d", value);
+}
+
+std::string DoubleConstant::EmitCValue(CWriter *w) {
+    if (isinf(value)) return "HUGE_VAL";
+    std::string s = CWriter::Format("%.17g", value);
+    if (s.find_first_of(".e") == std::string::npos) s += ".0";
+    return s;
+}
+
+std::string BoolConstant::EmitCValue(CWriter *w) {
+    return value ? "true" : "false";
+}
+
+std::string StringConstant::EmitCValue(CWriter *w) {
+    return CWriter::Quote(text);
+}
+
+std::string NullConstant::EmitCValue(CWriter *w) {
+    return "NULL";
+}
+
+std::string ReadIntegerExpr::EmitCValue(CWriter *w) {
+    std::string result = w->NewTemp(type);
+    w->Line("%s = dc_read_integer();", result.c_str());
+    return result;
+}
+
+std::string ReadLineExpr::EmitCValue(CWriter *w) {
+    std::string result = w->NewTemp(type);
+    w->Line("%s = dc_read_line();", result.c_str());
+    return result;
+}
+
+std::string This::EmitCValue(CWriter *w) {
+    return "self";
+}
+
+
+void CompoundExpr::EmitCOperands(CWriter *w, std::string *l, std::string *r) {
+    *l = w->Protect(left->EmitCValue(w), left->GetType(), right->HasAssignment());
+    *r = right->EmitCValue(w);
+}
+
+/* Int arithmetic is done unsigned, to wrap around rather than overflow;
+ * division goes through the runtime, for its checks. */
+std::string ArithmeticExpr::EmitCValue(CWriter *w) {
+    static const char *ops[] = { "+", "-", "*", "/" };
+    bool isInt = type == Type::intType;
+    std::string l, r, result;
+    if (!left) {
+        r = right->EmitCValue(w);
+        result = w->NewTemp(type);
+        w->Line(isInt ? "%s = (int)-(unsigned)%s;" : "%s = -%s;", result.c_str(), r.c_str());
+        return result;
+    }
+    EmitCOperands(w, &l, &r);
+    result = w->NewTemp(type);
+    opCodeT code = op->GetCode();
+    if (code == OpModulo)
+        w->Line(isInt ? "%s = dc_mod(%s, %s);" : "%s = fmod(%s, %s);",
+                result.c_str(), l.c_str(), r.c_str());
+    else if (isInt && code == OpDivide)
+        w->Line("%s = dc_div(%s, %s);", result.c_str(), l.c_str(), r.c_str());
+    else if (isInt)
+        w->Line("%s = (int)((unsigned)%s %s (unsigned)%s);", result.c_str(), l.c_str(),
+                ops[code - OpAdd], r.c_str());
+    else
+        w->Line("%s = %s %s %s;", result.c_str(), l.c_str(), ops[code - OpAdd], r.c_str());
+    return result;
+}
+
+std::string RelationalExpr::EmitCValue(CWriter *w) {
+    static const char *ops[] = { "<", "<=", ">", ">=" };
+    std::string l, r;
+    EmitCOperands(w, &l, &r);
+    std::string result = w->NewTemp(type);
+    w->Line("%s = %s %s %s;", result.c_str(), l.c_str(), ops[op->GetCode() - OpLess], r.c_str());
+    return result;
+}
+
+std::string EqualityExpr::EmitCValue(CWriter *w) {
+    Type *t = left->GetType();
+    const char *cmp = op->GetCode() == OpEqual ? "==" : "!=";
+    std::string l, r;
+    EmitCOperands(w, &l, &r);
+    std::string result = w->NewTemp(type);
+    if (t == Type::stringType)
+        w->Line("%s = %s(%s == %s || !strcmp(%s, %s));", result.c_str(),
+                op->GetCode() == OpEqual ? "" : "!", l.c_str(), r.c_str(), l.c_str(), r.c_str());
+    else if (t == Type::intType || t == Type::doubleType || t == Type::boolType)
+        w->Line("%s = %s %s %s;", result.c_str(), l.c_str(), cmp, r.c_str());
+    else
+        w->Line("%s = (void *)%s %s (void *)%s;", result.c_str(), l.c_str(), cmp, r.c_str());
+    return result;
+}
+
+std::string LogicalExpr::EmitCValue(CWriter *w) {
+    std::string result = w->NewTemp(type);
+    if (!left) {
+        std::string r = right->EmitCValue(w);
+        w->Line("%s = !%s;", result.c_str(), r.c_str());
+        return result;
+    }
+    std::string l = left->EmitCValue(w);
+    w->Line("%s = %s;", result.c_str(), l.c_str());
+    w->Line(op->GetCode() == OpAnd ? "if (%s) {" : "if (!%s) {", result.c_str());
+    w->Indent();
+    std::string r = right->EmitCValue(w);
+    w->Line("%s = %s;", result.c_str(), r.c_str());
+    w->Outdent();
+    w->Line("}");
+    return result;
+}
+
+std::string AssignExpr::EmitCValue(CWriter *w) {
+    std::string value = w->Protect(right->EmitCValue(w), type, target->HasAssignment());
+    std::string address = target->EmitCAddress(w);
+    w->Line("%s = %s;", address.c_str(), value.c_str());
+    return value;
+}
+
+std::string PostfixExpr::EmitCValue(CWriter *w) {
+    const char *delta = op->GetCode() == OpIncrement ? "+" : "-";
+    std::string address = target->EmitCAddress(w);
+    std::string old = w->NewTemp(type);
+    w->Line("%s = %s;", old.c_str(), address.c_str());
+    if (type == Type::intType)
+        w->Line("%s = (int)((unsigned)%s %s 1u);", address.c_str(), old.c_str(), delta);
+    else
+        w->Line("%s = %s %s 1.0;", address.c_str(), old.c_str(), delta);
+    return old;
+}
+
+
+std::string LValue::EmitCValue(CWriter *w) {
+    std::string address = EmitCAddress(w);
+    std::string result = w->NewTemp(type);
+    w->Line("%s = %s;", result.c_str(), address.c_str());
+    return result;
+}
+
+/* The element is checked for wherever the address is used, which is
+ * just after the array and subscript are evaluated. */
+std::string ArrayAccess::EmitCAddress(CWriter *w) {
+    std::string arr = w->Protect(base->EmitCValue(w), base->GetType(), subscript->HasAssignment());
+    std::string index = subscript->EmitCValue(w);
+    return CWriter::Format("DC_ELEM(%s, %s, %s)", CWriter::TypeName(type).c_str(),
+                           arr.c_str(), index.c_str());
+}
+
+/* A field is reached through the struct of the class declaring it, which
+ * is a prefix of the struct of any subclass. */
+std::string FieldAccess::EmitCAddress(CWriter *w) {
+    switch (var->GetStorage()) {
+      case LocalVar:  return CWriter::Local(var->GetOffset());
+      case GlobalVar: return CWriter::Global(var);
+      default: break;
+    }
+    ClassDecl *cls = dynamic_cast<ClassDecl*>(var->GetParent());
+    std::string s = CWriter::StructName(cls), f = CWriter::Field(var);
+    if (!base)
+        return CWriter::Format("((%s *)self)->%s", s.c_str(), f.c_str());
+    std::string obj = base->EmitCValue(w);
+    return CWriter::Format("((%s *)dc_check(%s))->%s", s.c_str(), obj.c_str(), f.c_str());
+}
+
+std::string FieldAccess::EmitCValue(CWriter *w) {
+    if (var->GetStorage() == LocalVar) return CWriter::Local(var->GetOffset());
+    return LValue::EmitCValue(w);
+}
+
+
+/* As in the interpreter, the receiver is checked before the arguments
+ * are evaluated. Methods are called through the receiver's vtable, or
+ * found by the number of their name for a call through an interface. */
+std::string Call::EmitCValue(CWriter *w) {
+    if (kind == ArrayLengthCall) {
+        std::string arr = base->EmitCValue(w), result = w->NewTemp(type);
+        w->Line("%s = dc_length(%s);", result.c_str(), arr.c_str());
+        return result;
+    }
+    int n = actuals->NumElements();
+    std::vector<bool> assignsAfter(n + 1, false);
+    for (int i = n - 1; i >= 0; i--)
+        assignsAfter[i] = assignsAfter[i+1] || actuals->Nth(i)->HasAssignment();
+
+    std::string receiver = "self", args;
+    if (kind != GlobalCall && base) {
+        receiver = w->Protect(base->EmitCValue(w), base->GetType(), assignsAfter[0]);
+        w->Line("dc_check(%s);", receiver.c_str());
+    }
+    if (kind != GlobalCall) args = receiver;
+    for (int i = 0; i < n; i++) {
+        Expr *actual = actuals->Nth(i);
+        if (!args.empty()) args += ", ";
+        args += w->Protect(actual->EmitCValue(w), actual->GetType(), assignsAfter[i+1]);
+    }
+
+    std::string callee;
+    if (kind == GlobalCall)
+        callee = CWriter::FunctionName(fn);
+    else if (kind == MethodCall)
+        callee = CWriter::Format("((%s)%s->cls->vtable[%d])", CWriter::FunctionType(fn, true).c_str(),
+                                 receiver.c_str(), fn->GetVtableIndex());
+    else
+        callee = CWriter::Format("((%s)dc_lookup(%s, %d))", CWriter::FunctionType(fn, true).c_str(),
+                                 receiver.c_str(), w->InterfaceMethod(fn->GetName()));
+    if (type == Type::voidType) {
+        w->Line("%s(%s);", callee.c_str(), args.c_str());
+        return "";
+    }
+    std::string result = w->NewTemp(type);
+    w->Line("%s = %s(%s);", result.c_str(), callee.c_str(), args.c_str());
+    return result;
+}
+
+std::string NewExpr::EmitCValue(CWriter *w) {
+    std::string result = w->NewTemp(type);
+    w->Line("%s = new_%s();", result.c_str(), cType->GetClassDecl()->GetName());
+    return result;
+}
+
+std::string NewArrayExpr::EmitCValue(CWriter *w) {
+    std::string n = size->EmitCValue(w), result = w->NewTemp(type);
+    w->Line("%s = dc_new_array(%s, sizeof(%s), %s);", result.c_str(), n.c_str(),
+            CWriter::TypeName(elemType).c_str(), elemType == Type::stringType ? "true" : "false");
+    return result;
+}
+
+
+/* Lowering to three-address code
+ * -------------------------------
+ * As for bytecode, each expression computes its value into a fresh
+ * temporary and local variables are used in their own registers. Tests
+ * are lowered to branches, && and || jumping straight to where control
+ * goes once the result is known.
+ */
+void Expr::EmitTacBranch(TacBuilder *tb, int ifTrue, int ifFalse) {
+    tb->GenBranch(EmitTacValue(tb), ifTrue, ifFalse);
+}
+
+int EmptyExpr::EmitTacValue(TacBuilder *tb) {
+    return -1;
+}
+
+int IntConstant::EmitTacValue(TacBuilder *tb) {
+    int reg = tb->NewTemp(type);
+    tb->GenConst(reg, MakeInt(value));
+    return reg;
+}
+
+int DoubleConstant::EmitTacValue(TacBuilder *tb) {
+    int reg = tb->NewTemp(type);
+    tb->GenConst(reg, MakeDouble(value));
+    return reg;
+}
+
+int BoolConstant::EmitTacValue(TacBuilder *tb) {
+    int reg = tb->NewTemp(type);
+    tb->GenConst(reg, MakeBool(value));
+    return reg;
+}
+
+void BoolConstant::EmitTacBranch(TacBuilder *tb, int ifTrue, int ifFalse) {
+    tb->GenJump(value ? ifTrue : ifFalse);
+}
+
+int StringConstant::EmitTacValue(TacBuilder *tb) {
+    int reg = tb->NewTemp(type);
+    tb->GenConst(reg, MakeString(text));
+    return reg;
+}
+
+int NullConstant::EmitTacValue(TacBuilder *tb) {
+    int reg = tb->NewTemp(type);
+    tb->GenConst(reg, MakeObject(NULL));
+    return reg;
+}
+
+int ReadIntegerExpr::EmitTacValue(TacBuilder *tb) {
+    int reg = tb->NewTemp(type);
+    tb->Gen(TacReadInteger, reg);
+    return reg;
+}
+
+int ReadLineExpr::EmitTacValue(TacBuilder *tb) {
+    int reg = tb->NewTemp(type);
+    tb->Gen(TacReadLine, reg);
+    return reg;
+}
+
+int This::EmitTacValue(TacBuilder *tb) {
+    return 0;
+}
+
+
+void CompoundExpr::EmitTacOperands(TacBuilder *tb, int *l, int *r) {
+    *l = tb->Protect(left->EmitTacValue(tb), left->GetType(), right->HasAssignment());
+    *r = right->EmitTacValue(tb);
+}
+
+int ArithmeticExpr::EmitTacValue(TacBuilder *tb) {
+    static const tacOpcodeT intOps[] = { TacAddInt, TacSubInt, TacMulInt, TacDivInt, TacModInt };
+    static const tacOpcodeT doubleOps[] = { TacAddDouble, TacSubDouble, TacMulDouble,
+                                            TacDivDouble, TacModDouble };
+    bool isInt = type == Type::intType;
+    int result, l, r;
+    if (!left) {
+        r = right->EmitTacValue(tb);
+        result = tb->NewTemp(type);
+        tb->Gen(isInt ? TacNegInt : TacNegDouble, result, r);
+        return result;
+    }
+    EmitTacOperands(tb, &l, &r);
+    result = tb->NewTemp(type);
+    tb->Gen((isInt ? intOps : doubleOps)[op->GetCode() - OpAdd], result, l, r);
+    return result;
+}
+
+int RelationalExpr::EmitTacValue(TacBuilder *tb) {
+    static const tacOpcodeT intOps[] = { TacLessInt, TacLessEqualInt, TacGreaterInt,
+                                         TacGreaterEqualInt };
+    static const tacOpcodeT doubleOps[] = { TacLessDouble, TacLessEqualDouble,
+                                            TacGreaterDouble, TacGreaterEqualDouble };
+    bool isInt = left->GetType() == Type::intType;
+    int l, r;
+    EmitTacOperands(tb, &l, &r);
+    int result = tb->NewTemp(type);
+    tb->Gen((isInt ? intOps : doubleOps)[op->GetCode() - OpLess], result, l, r);
+    return result;
+}
+
+int EqualityExpr::EmitTacValue(TacBuilder *tb) {
+    Type *t = left->GetType();
+    bool equal = op->GetCode() == OpEqual;
+    tacOpcodeT opcode;
+    if (t == Type::intType) opcode = equal ? TacEqualInt : TacNotEqualInt;
+    else if (t == Type::doubleType) opcode = equal ? TacEqualDouble : TacNotEqualDouble;
+    else if (t == Type::boolType) opcode = equal ? TacEqualBool : TacNotEqualBool;
+    else if (t == Type::stringType) opcode = equal ? TacEqualString : TacNotEqualString;
+    else opcode = equal ? TacEqualRef : TacNotEqualRef;
+    int l, r;
+    EmitTacOperands(tb, &l, &r);
+    int result = tb->NewTemp(type);
+    tb->Gen(opcode, result, l, r);
+    return result;
+}
+
+/* As a value, the result of && or || is assigned in two blocks: with
+ * the left operand's value, and with the right's if that is needed. */
+int LogicalExpr::EmitTacValue(TacBuilder *tb) {
+    int result = tb->NewTemp(type);
+    if (!left) {
+        tb->Gen(TacNotBool, result, right->EmitTacValue(tb));
+        return result;
+    }
+    int rest = tb->NewBlock(), end = tb->NewBlock();
+    tb->GenMoveResult(result, left->EmitTacValue(tb));
+    if (op->GetCode() == OpAnd)
+        tb->GenBranch(result, rest, end);
+    else
+        tb->GenBranch(result, end, rest);
+    tb->SetBlock(rest);
+    tb->GenMoveResult(result, right->EmitTacValue(tb));
+    tb->GenJump(end);
+    tb->SetBlock(end);
+    return result;
+}
+
+void LogicalExpr::EmitTacBranch(TacBuilder *tb, int ifTrue, int ifFalse) {
+    if (!left) {
+        right->EmitTacBranch(tb, ifFalse, ifTrue);
+        return;
+    }
+    int rest = tb->NewBlock();
+    if (op->GetCode() == OpAnd)
+        left->EmitTacBranch(tb, rest, ifFalse);
+    else
+        left->EmitTacBranch(tb, ifTrue, rest);
+    tb->SetBlock(rest);
+    right->EmitTacBranch(tb, ifTrue, ifFalse);
+}
+
+int AssignExpr::EmitTacValue(TacBuilder *tb) {
+    int value = tb->Protect(right->EmitTacValue(tb), type, target->HasAssignment());
+    target->EmitTacAddress(tb);
+    target->EmitTacStore(tb, value);
+    return value;
+}
+
+void AssignExpr::EmitTac(TacBuilder *tb) {
+    int reg = target->GetLocalRegister();
+    if (reg >= 0)
+        tb->GenMoveResult(reg, right->EmitTacValue(tb));
+    else
+        EmitTacValue(tb);
+}
+
+void PostfixExpr::EmitTac(TacBuilder *tb) {
+    int reg = target->GetLocalRegister();
+    if (reg < 0) {
+        EmitTacValue(tb);
+        return;
+    }
+    int delta = tb->NewTemp(type);
+    if (type == Type::intType) {
+        tb->GenConst(delta, MakeInt(1));
+        tb->Gen(op->GetCode() == OpIncrement ? TacAddInt : TacSubInt, reg, reg, delta);
+    } else {
+        tb->GenConst(delta, MakeDouble(1));
+        tb->Gen(op->GetCode() == OpIncrement ? TacAddDouble : TacSubDouble, reg, reg, delta);
+    }
+}
+
+int PostfixExpr::EmitTacValue(TacBuilder *tb) {
+    bool isInt = type == Type::intType;
+    target->EmitTacAddress(tb);
+    int old = tb->NewTemp(type), delta = tb->NewTemp(type), updated = tb->NewTemp(type);
+    tb->GenMoveResult(old, target->EmitTacLoad(tb));
+    tb->GenConst(delta, isInt ? MakeInt(1) : MakeDouble(1));
+    if (op->GetCode() == OpIncrement)
+        tb->Gen(isInt ? TacAddInt : TacAddDouble, updated, old, delta);
+    else
+        tb->Gen(isInt ? TacSubInt : TacSubDouble, updated, old, delta);
+    target->EmitTacStore(tb, updated);
+    return old;
+}
+
+
+void ArrayAccess::EmitTacAddress(TacBuilder *tb) {
+    baseReg = tb->Protect(base->EmitTacValue(tb), base->GetType(), subscript->HasAssignment());
+    subscriptReg = subscript->EmitTacValue(tb);
+}
+
+int ArrayAccess::EmitTacLoad(TacBuilder *tb) {
+    int result = tb->NewTemp(type);
+    tb->Gen(TacGetElem, result, baseReg, subscriptReg);
+    return result;
+}
+
+void ArrayAccess::EmitTacStore(TacBuilder *tb, int src) {
+    tb->Gen(TacSetElem, -1, baseReg, subscriptReg, src);
+}
+
+void FieldAccess::EmitTacAddress(TacBuilder *tb) {
+    if (var->GetStorage() == FieldVar)
+        baseReg = base ? base->EmitTacValue(tb) : 0;
+}
+
+int FieldAccess::EmitTacLoad(TacBuilder *tb) {
+    if (var->GetStorage() == LocalVar) return var->GetOffset();
+    int result = tb->NewTemp(type);
+    if (var->GetStorage() == GlobalVar)
+        tb->Gen(TacLoadGlobal, result, var->GetOffset());
+    else
+        tb->Gen(TacGetField, result, baseReg, var->GetOffset());
+    return result;
+}
+
+void FieldAccess::EmitTacStore(TacBuilder *tb, int src) {
+    switch (var->GetStorage()) {
+      case LocalVar:  tb->Gen(TacCopy, var->GetOffset(), src); break;
+      case GlobalVar: tb->Gen(TacStoreGlobal, -1, var->GetOffset(), src); break;
+      default:        tb->Gen(TacSetField, -1, baseReg, var->GetOffset(), src); break;
+    }
+}
+
+
+/* The receiver and arguments are the registers their values are in,
+ * copied where a later argument could assign them before the call. */
+int Call::EmitTacValue(TacBuilder *tb) {
+    if (kind == ArrayLengthCall) {
+        int arr = base->EmitTacValue(tb), result = tb->NewTemp(type);
+        tb->Gen(TacLength, result, arr);
+        return result;
+    }
+    int n = actuals->NumElements();
+    std::vector<bool> assignsAfter(n + 1, false);
+    for (int i = n - 1; i >= 0; i--)
+        assignsAfter[i] = assignsAfter[i+1] || actuals->Nth(i)->HasAssignment();
+
+    std::vector<int> args;
+    if (kind != GlobalCall)
+        args.push_back(base ? tb->Protect(base->EmitTacValue(tb), base->GetType(), assignsAfter[0])
+                            : 0);
+    for (int i = 0; i < n; i++) {
+        Expr *actual = actuals->Nth(i);
+        args.push_back(tb->Protect(actual->EmitTacValue(tb), actual->GetType(), assignsAfter[i+1]));
+    }
+    int result = type == Type::voidType ? -1 : tb->NewTemp(type);
+    switch (kind) {
+      case GlobalCall:
+        tb->GenCall(TacCall, result, fn->GetCodeIndex(), args);
+        break;
+      case MethodCall:
+        tb->GenCall(TacCallVirtual, result, fn->GetVtableIndex(), args);
+        break;
+      default:
+        tb->GenCall(TacCallInterface, result,
+                    tb->GetProgram()->AddConstant(MakeString(Strings::Intern(fn->GetName()))), args);
+        break;
+    }
+    return result;
+}
+
+int NewExpr::EmitTacValue(TacBuilder *tb) {
+    int result = tb->NewTemp(type);
+    tb->Gen(TacNewObject, result, tb->GetProgram()->AddClass(cType->GetClassDecl()));
+    return result;
+}
+
+int NewArrayExpr::EmitTacValue(TacBuilder *tb) {
+    int n = size->EmitTacValue(tb), result = tb->NewTemp(type);
+    tb->Gen(TacNewArray, result, n, tb->GetProgram()->AddType(elemType));
+    return result;
+}
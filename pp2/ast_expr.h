@@ -10,19 +10,65 @@
 #ifndef _H_ast_expr
 #define _H_ast_expr
 
+#include <string>
 #include "ast.h"
 #include "ast_stmt.h"
 #include "list.h"
 
 class NamedType; // for new
 class Type; // for NewArray
+class VarDecl;
+class FnDecl;
+class CodeGenerator;
+class CWriter;
+class TacBuilder;
 
 
 class Expr : public Stmt 
 {
+  protected:
+    Type *type;     // set by Check()
+
   public:
-    Expr(yyltype loc) : Stmt(loc) {}
-    Expr() : Stmt() {}
+    Expr(yyltype loc) : Stmt(loc) { type = NULL; }
+    Expr() : Stmt() { type = NULL; }
+
+    Type *GetType() { return type; }
+    virtual Value Eval(Value *frame) = 0;
+    execResultT Exec(Value *frame) { Eval(frame); return ExecNormal; }
+
+    // Generates code for the expression and returns the register holding
+    // its value. For a local variable that is the variable's own
+    // register, so the value must be used before anything else can
+    // assign the variable (see HasAssignment).
+    virtual int EmitValue(CodeGenerator *cg) = 0;
+    void Emit(CodeGenerator *cg) { EmitValue(cg); }
+    // Writes C computing the expression and returns the operand holding
+    // its value (see cwriter.h), or "" if it has none.
+    virtual std::string EmitCValue(CWriter *w) = 0;
+    void EmitC(CWriter *w) { EmitCValue(w); }
+    // Lowers the expression to three-address code (see tacgen.h) and
+    // returns the register holding its value, with the same caveat as
+    // for EmitValue.
+    virtual int EmitTacValue(TacBuilder *tb) = 0;
+    void EmitTac(TacBuilder *tb) { EmitTacValue(tb); }
+    // Lowers a boolean expression used as a test, going on to block
+    // ifTrue if it is true and to ifFalse if not.
+    virtual void EmitTacBranch(TacBuilder *tb, int ifTrue, int ifFalse);
+    // Returns the expression with its constant parts folded, for the
+    // caller to put in its place: itself, its operands folded, or a
+    // simpler expression that computes the same value with the same
+    // effects, down to a literal.
+    virtual Expr *Fold() { return this; }
+    // Fold(), with the result made a child of parent; FoldAll does so
+    // for each of a list.
+    Expr *FoldInto(Node *parent);
+    static void FoldAll(List<Expr*> *exprs, Node *parent);
+    void FoldConstants() { Fold(); }
+    // Whether evaluating the expression may assign a variable.
+    virtual bool HasAssignment() { return false; }
+    // Whether it is a literal, whose value Eval() gives without a frame.
+    virtual bool IsConstant() { return false; }
 };
 
 /* This node type is used for those places where an expression is optional.
@@ -32,6 +78,11 @@ class EmptyExpr : public Expr
 {
   public:
     const char *GetPrintNameForNode() { return "Empty"; }
+    void Check();
+    Value Eval(Value *frame) { return MakeVoid(); }
+    int EmitValue(CodeGenerator *cg);
+    std::string EmitCValue(CWriter *w);
+    int EmitTacValue(TacBuilder *tb);
 };
 
 class IntConstant : public Expr 
@@ -43,6 +94,13 @@ class IntConstant : public Expr
     IntConstant(yyltype loc, int val);
     const char *GetPrintNameForNode() { return "IntConstant"; }
     void PrintChildren(int indentLevel);
+    int GetValue() { return value; }
+    void Check();
+    Value Eval(Value *frame) { return MakeInt(value); }
+    bool IsConstant() { return true; }
+    int EmitValue(CodeGenerator *cg);
+    std::string EmitCValue(CWriter *w);
+    int EmitTacValue(TacBuilder *tb);
 };
 
 class DoubleConstant : public Expr 
@@ -54,6 +112,12 @@ class DoubleConstant : public Expr
     DoubleConstant(yyltype loc, double val);
     const char *GetPrintNameForNode() { return "DoubleConstant"; }
     void PrintChildren(int indentLevel);
+    void Check();
+    Value Eval(Value *frame) { return MakeDouble(value); }
+    bool IsConstant() { return true; }
+    int EmitValue(CodeGenerator *cg);
+    std::string EmitCValue(CWriter *w);
+    int EmitTacValue(TacBuilder *tb);
 };
 
 class BoolConstant : public Expr 
@@ -65,17 +129,33 @@ class BoolConstant : public Expr
     BoolConstant(yyltype loc, bool val);
     const char *GetPrintNameForNode() { return "BoolConstant"; }
     void PrintChildren(int indentLevel);
+    void Check();
+    Value Eval(Value *frame) { return MakeBool(value); }
+    bool IsConstant() { return true; }
+    int EmitValue(CodeGenerator *cg);
+    std::string EmitCValue(CWriter *w);
+    int EmitTacValue(TacBuilder *tb);
+    void EmitTacBranch(TacBuilder *tb, int ifTrue, int ifFalse);
 };
 
 class StringConstant : public Expr 
 { 
   protected:
-    char *value;
+    char *value;    // as written, quotes included
+    const char *text;   // without the quotes, escapes replaced; interned
+
+    static char *UnescapeString(const char *literal);
     
   public:
     StringConstant(yyltype loc, const char *val);
     const char *GetPrintNameForNode() { return "StringConstant"; }
     void PrintChildren(int indentLevel);
+    void Check();
+    Value Eval(Value *frame) { return MakeString(text); }
+    bool IsConstant() { return true; }
+    int EmitValue(CodeGenerator *cg);
+    std::string EmitCValue(CWriter *w);
+    int EmitTacValue(TacBuilder *tb);
 };
 
 class NullConstant: public Expr 
@@ -83,17 +163,32 @@ class NullConstant: public Expr
   public: 
     NullConstant(yyltype loc) : Expr(loc) {}
     const char *GetPrintNameForNode() { return "NullConstant"; }
+    void Check();
+    Value Eval(Value *frame) { return MakeObject(NULL); }
+    bool IsConstant() { return true; }
+    int EmitValue(CodeGenerator *cg);
+    std::string EmitCValue(CWriter *w);
+    int EmitTacValue(TacBuilder *tb);
 };
 
+typedef enum { OpAdd, OpSubtract, OpMultiply, OpDivide, OpModulo,
+               OpLess, OpLessEqual, OpGreater, OpGreaterEqual,
+               OpEqual, OpNotEqual, OpAnd, OpOr, OpNot, OpAssign,
+               OpIncrement, OpDecrement } opCodeT;
+
 class Operator : public Node 
 {
   protected:
     char tokenString[4];
+    opCodeT code;
     
   public:
     Operator(yyltype loc, const char *tok);
     const char *GetPrintNameForNode() { return "Operator"; }
     void PrintChildren(int indentLevel);
+    opCodeT GetCode() { return code; }
+    friend std::ostream& operator<<(std::ostream& out, Operator *o)
+        { return out << o->tokenString; }
  };
  
 class CompoundExpr : public Expr
@@ -107,6 +202,13 @@ class CompoundExpr : public Expr
     CompoundExpr(Operator *op, Expr *rhs);             // for unary
     CompoundExpr(Expr *lhs, Operator *op); //For increments
     void PrintChildren(int indentLevel);
+    bool HasAssignment();
+
+    // Generates code for both operands; the value of the left is copied
+    // if evaluating the right could change it.
+    void EmitOperands(CodeGenerator *cg, int *l, int *r);
+    void EmitCOperands(CWriter *w, std::string *l, std::string *r);
+    void EmitTacOperands(TacBuilder *tb, int *l, int *r);
 };
 
 class ArithmeticExpr : public CompoundExpr 
@@ -115,6 +217,12 @@ class ArithmeticExpr : public CompoundExpr
     ArithmeticExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(lhs,op,rhs) {}
     ArithmeticExpr(Operator *op, Expr *rhs) : CompoundExpr(op,rhs) {}
     const char *GetPrintNameForNode() { return "ArithmeticExpr"; }
+    void Check();
+    Value Eval(Value *frame);
+    int EmitValue(CodeGenerator *cg);
+    std::string EmitCValue(CWriter *w);
+    int EmitTacValue(TacBuilder *tb);
+    Expr *Fold();
 };
 
 class RelationalExpr : public CompoundExpr 
@@ -122,6 +230,12 @@ class RelationalExpr : public CompoundExpr
   public:
     RelationalExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(lhs,op,rhs) {}
     const char *GetPrintNameForNode() { return "RelationalExpr"; }
+    void Check();
+    Value Eval(Value *frame);
+    int EmitValue(CodeGenerator *cg);
+    std::string EmitCValue(CWriter *w);
+    int EmitTacValue(TacBuilder *tb);
+    Expr *Fold();
 };
 
 class EqualityExpr : public CompoundExpr 
@@ -129,6 +243,12 @@ class EqualityExpr : public CompoundExpr
   public:
     EqualityExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(lhs,op,rhs) {}
     const char *GetPrintNameForNode() { return "EqualityExpr"; }
+    void Check();
+    Value Eval(Value *frame);
+    int EmitValue(CodeGenerator *cg);
+    std::string EmitCValue(CWriter *w);
+    int EmitTacValue(TacBuilder *tb);
+    Expr *Fold();
 };
 
 class LogicalExpr : public CompoundExpr 
@@ -137,26 +257,84 @@ class LogicalExpr : public CompoundExpr
     LogicalExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(lhs,op,rhs) {}
     LogicalExpr(Operator *op, Expr *rhs) : CompoundExpr(op,rhs) {}
     const char *GetPrintNameForNode() { return "LogicalExpr"; }
+    void Check();
+    Value Eval(Value *frame);
+    int EmitValue(CodeGenerator *cg);
+    std::string EmitCValue(CWriter *w);
+    int EmitTacValue(TacBuilder *tb);
+    Expr *Fold();
+    void EmitTacBranch(TacBuilder *tb, int ifTrue, int ifFalse);
 };
 
+class LValue;
+
+/* The right side of an assignment is evaluated before the parts of the
+ * left side (an array and subscript, or the object of a field). */
 class AssignExpr : public CompoundExpr 
 {
+  protected:
+    LValue *target;     // left, as an LValue
+    
   public:
-    AssignExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(lhs,op,rhs) {}
+    AssignExpr(Expr *lhs, Operator *op, Expr *rhs);
     const char *GetPrintNameForNode() { return "AssignExpr"; }
+    void Check();
+    Value Eval(Value *frame);
+    int EmitValue(CodeGenerator *cg);
+    std::string EmitCValue(CWriter *w);
+    int EmitTacValue(TacBuilder *tb);
+    Expr *Fold();
+    void Emit(CodeGenerator *cg);
+    void EmitTac(TacBuilder *tb);
+    bool HasAssignment() { return true; }
 };
 
 class PostfixExpr : public CompoundExpr 
 {
+  protected:
+    LValue *target;     // left, as an LValue; NULL if it is not one
+    
   public:
-    PostfixExpr(Expr *lhs, Operator *op) : CompoundExpr(lhs,op) {}
+    PostfixExpr(Expr *lhs, Operator *op);
     const char *GetPrintNameForNode() { return "PostfixExpr"; }
+    void Check();
+    Value Eval(Value *frame);
+    int EmitValue(CodeGenerator *cg);
+    std::string EmitCValue(CWriter *w);
+    int EmitTacValue(TacBuilder *tb);
+    Expr *Fold();
+    void Emit(CodeGenerator *cg);
+    void EmitTac(TacBuilder *tb);
+    bool HasAssignment() { return true; }
 };
 
+/* An LValue can also give the address of the storage it denotes, so
+ * that it can be assigned to or updated in place. Code for an update is
+ * generated in two steps, so that the parts of the address (an array and
+ * subscript, or an object) are evaluated only once: EmitAddress()
+ * generates code for them, after which EmitLoad() and EmitStore() can be
+ * used any number of times. */
 class LValue : public Expr 
 {
   public:
     LValue(yyltype loc) : Expr(loc) {}
+    virtual Value *Address(Value *frame) = 0;
+    Value Eval(Value *frame) { return *Address(frame); }
+
+    virtual void EmitAddress(CodeGenerator *cg) = 0;
+    virtual int EmitLoad(CodeGenerator *cg) = 0;
+    virtual void EmitStore(CodeGenerator *cg, int src) = 0;
+    int EmitValue(CodeGenerator *cg) { EmitAddress(cg); return EmitLoad(cg); }
+    // Writes C for the parts of the address and returns a C lvalue for
+    // the storage, which may be used any number of times.
+    virtual std::string EmitCAddress(CWriter *w) = 0;
+    std::string EmitCValue(CWriter *w);
+    virtual void EmitTacAddress(TacBuilder *tb) = 0;
+    virtual int EmitTacLoad(TacBuilder *tb) = 0;
+    virtual void EmitTacStore(TacBuilder *tb, int src) = 0;
+    int EmitTacValue(TacBuilder *tb) { EmitTacAddress(tb); return EmitTacLoad(tb); }
+    // The register of a local variable, or -1 for any other lvalue.
+    virtual int GetLocalRegister() { return -1; }
 };
 
 class This : public Expr 
@@ -164,17 +342,35 @@ class This : public Expr
   public:
     This(yyltype loc) : Expr(loc) {}
     const char *GetPrintNameForNode() { return "This"; }
+    void Check();
+    Value Eval(Value *frame) { return frame[0]; }
+    int EmitValue(CodeGenerator *cg);
+    std::string EmitCValue(CWriter *w);
+    int EmitTacValue(TacBuilder *tb);
 };
 
 class ArrayAccess : public LValue 
 {
   protected:
     Expr *base, *subscript;
+    int baseReg, subscriptReg;  // set by EmitAddress() or EmitTacAddress()
     
   public:
     ArrayAccess(yyltype loc, Expr *base, Expr *subscript);
     const char *GetPrintNameForNode() { return "ArrayAccess"; }
     void PrintChildren(int indentLevel);
+    void Check();
+    Value *Address(Value *frame);
+    void EmitAddress(CodeGenerator *cg);
+    int EmitLoad(CodeGenerator *cg);
+    void EmitStore(CodeGenerator *cg, int src);
+    void EmitStoreConstant(CodeGenerator *cg, Value v);
+    std::string EmitCAddress(CWriter *w);
+    void EmitTacAddress(TacBuilder *tb);
+    int EmitTacLoad(TacBuilder *tb);
+    void EmitTacStore(TacBuilder *tb, int src);
+    Expr *Fold();
+    bool HasAssignment();
 };
 
 /* Note that field access is used both for qualified names
@@ -187,28 +383,61 @@ class FieldAccess : public LValue
   protected:
     Expr *base;	// will be NULL if no explicit base
     Identifier *field;
+    VarDecl *var;       // the variable accessed, set by Check()
+    int baseReg;        // the object of a field, set by EmitAddress()
+                        // or EmitTacAddress()
     
   public:
     FieldAccess(Expr *base, Identifier *field); //ok to pass NULL base
     const char *GetPrintNameForNode() { return "FieldAccess"; }
     void PrintChildren(int indentLevel);
+    void Check();
+    Value *Address(Value *frame);
+    void EmitAddress(CodeGenerator *cg);
+    int EmitLoad(CodeGenerator *cg);
+    void EmitStore(CodeGenerator *cg, int src);
+    int GetLocalRegister();
+    std::string EmitCAddress(CWriter *w);
+    std::string EmitCValue(CWriter *w);
+    void EmitTacAddress(TacBuilder *tb);
+    int EmitTacLoad(TacBuilder *tb);
+    void EmitTacStore(TacBuilder *tb, int src);
+    Expr *Fold();
+    bool HasAssignment() { return base && base->HasAssignment(); }
 };
 
 /* Like field access, call is used both for qualified base.field()
  * and unqualified field().  We won't figure out until later
  * whether we need implicit "this." so we use one node type for either
  * and sort it out later. */
+/* How a call finds the function it calls: global functions are called
+ * directly, methods through the vtable of the receiver's class, methods
+ * of an interface by name in the receiver's class, and length() is the
+ * built-in method of arrays. */
+typedef enum { GlobalCall, MethodCall, InterfaceCall, ArrayLengthCall } callKindT;
+
 class Call : public Expr 
 {
   protected:
     Expr *base;	// will be NULL if no explicit base
     Identifier *field;
     List<Expr*> *actuals;
+    callKindT kind;     // these two are set by Check()
+    FnDecl *fn;         // the function or method as declared
+
+    void CheckActuals();
     
   public:
     Call(yyltype loc, Expr *base, Identifier *field, List<Expr*> *args);
     const char *GetPrintNameForNode() { return "Call"; }
     void PrintChildren(int indentLevel);
+    void Check();
+    Value Eval(Value *frame);
+    int EmitValue(CodeGenerator *cg);
+    std::string EmitCValue(CWriter *w);
+    int EmitTacValue(TacBuilder *tb);
+    Expr *Fold();
+    bool HasAssignment();
 };
 
 class NewExpr : public Expr
@@ -220,6 +449,11 @@ class NewExpr : public Expr
     NewExpr(yyltype loc, NamedType *clsType);
     const char *GetPrintNameForNode() { return "NewExpr"; }
     void PrintChildren(int indentLevel);
+    void Check();
+    Value Eval(Value *frame);
+    int EmitValue(CodeGenerator *cg);
+    std::string EmitCValue(CWriter *w);
+    int EmitTacValue(TacBuilder *tb);
 };
 
 class NewArrayExpr : public Expr
@@ -232,6 +466,13 @@ class NewArrayExpr : public Expr
     NewArrayExpr(yyltype loc, Expr *sizeExpr, Type *elemType);
     const char *GetPrintNameForNode() { return "NewArrayExpr"; }
     void PrintChildren(int indentLevel);
+    void Check();
+    Value Eval(Value *frame);
+    int EmitValue(CodeGenerator *cg);
+    std::string EmitCValue(CWriter *w);
+    int EmitTacValue(TacBuilder *tb);
+    Expr *Fold();
+    bool HasAssignment() { return size->HasAssignment(); }
 };
 
 class ReadIntegerExpr : public Expr
@@ -239,6 +480,11 @@ class ReadIntegerExpr : public Expr
   public:
     ReadIntegerExpr(yyltype loc) : Expr(loc) {}
     const char *GetPrintNameForNode() { return "ReadIntegerExpr"; }
+    void Check();
+    Value Eval(Value *frame) { return Interpreter::ReadInteger(); }
+    int EmitValue(CodeGenerator *cg);
+    std::string EmitCValue(CWriter *w);
+    int EmitTacValue(TacBuilder *tb);
 };
 
 class ReadLineExpr : public Expr
@@ -246,6 +492,11 @@ class ReadLineExpr : public Expr
   public:
     ReadLineExpr(yyltype loc) : Expr (loc) {}
     const char *GetPrintNameForNode() { return "ReadLineExpr"; }
+    void Check();
+    Value Eval(Value *frame) { return Interpreter::ReadLine(); }
+    int EmitValue(CodeGenerator *cg);
+    std::string EmitCValue(CWriter *w);
+    int EmitTacValue(TacBuilder *tb);
 };
 
     
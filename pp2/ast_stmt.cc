@@ -6,11 +6,22 @@
 #include "ast_type.h"
 #include "ast_decl.h"
 #include "ast_expr.h"
+#include "scope.h"
+#include "errors.h"
+#include "codegen.h"
+#include "cwriter.h"
+#include "tacgen.h"
+#include "vm.h"
+#include <algorithm>
 
 
 Program::Program(List<Decl*> *d) {
     Assert(d != NULL);
     (decls=d)->SetParentAll(this);
+    sources = declSources = NULL;
+    scope = NULL;
+    globals = NULL;
+    mainFn = NULL;
 }
 
 void Program::PrintChildren(int indentLevel) {
@@ -22,6 +33,7 @@ StmtBlock::StmtBlock(List<VarDecl*> *d, List<Stmt*> *s) {
     Assert(d != NULL && s != NULL);
     (decls=d)->SetParentAll(this);
     (stmts=s)->SetParentAll(this);
+    scope = NULL;
 }
 
 void StmtBlock::PrintChildren(int indentLevel) {
@@ -69,6 +81,10 @@ SwitchStmt::SwitchStmt(Expr *t, List<Stmt*> *b) {
 	Assert(t != NULL && b != NULL);
 	(stmtList=b)->SetParentAll(this);
 	(test=t)->SetParent(this);
+	numCases = 0;
+	labels = NULL;
+	hasDefault = false;
+	byLabel = NULL;
 }
 
 void SwitchStmt::PrintChildren(int indentLevel) {
@@ -114,3 +130,873 @@ void PrintStmt::PrintChildren(int indentLevel) {
 }
 
 
+
+
+/* Checking the program
+ * --------------------
+ * The top-level declarations are checked in several sweeps, so that any
+ * declaration may refer to any other regardless of the order they come
+ * in: first all names are declared, then the members of classes and
+ * interfaces, then classes are laid out (each after the class it
+ * extends), and last everything is checked in depth.
+ */
+void Program::Check() {
+    scope = new Scope;
+    globals = new List<VarDecl*>;
+    mainFn = NULL;
+    declSources = NULL;
+    if (sources) {
+        declSources = new List<SourceFile*>;
+        for (int f = 0; f < sources->NumElements(); f++)
+            for (int i = 0; i < sources->Nth(f)->numDecls; i++)
+                declSources->Append(sources->Nth(f));
+    }
+
+    for (int i = 0; i < decls->NumElements(); i++) {
+        SelectSource(i);
+        scope->Declare(decls->Nth(i));
+    }
+    for (int i = 0; i < decls->NumElements(); i++) {
+        SelectSource(i);
+        ClassDecl *cd = dynamic_cast<ClassDecl*>(decls->Nth(i));
+        InterfaceDecl *id = dynamic_cast<InterfaceDecl*>(decls->Nth(i));
+        if (cd) cd->DeclareMembers();
+        if (id) id->DeclareMembers();
+    }
+    bool progress;
+    do {
+        progress = false;
+        for (int i = 0; i < decls->NumElements(); i++) {
+            ClassDecl *cd = dynamic_cast<ClassDecl*>(decls->Nth(i));
+            if (cd && !cd->IsLaidOut() && cd->IsReadyForLayout()) {
+                SelectSource(i);
+                cd->Layout();
+                progress = true;
+            }
+        }
+    } while (progress);
+    for (int i = 0; i < decls->NumElements(); i++) {
+        ClassDecl *cd = dynamic_cast<ClassDecl*>(decls->Nth(i));
+        if (cd && !cd->IsLaidOut()) { // part of a cycle of extends
+            SelectSource(i);
+            cd->Layout();
+        }
+    }
+    for (int i = 0; i < decls->NumElements(); i++) {
+        SelectSource(i);
+        Decl *d = decls->Nth(i);
+        d->Check();
+        VarDecl *var = dynamic_cast<VarDecl*>(d);
+        if (var) {
+            var->SetStorage(GlobalVar, globals->NumElements());
+            globals->Append(var);
+        }
+    }
+
+    mainFn = dynamic_cast<FnDecl*>(scope->Lookup("main"));
+    if (!mainFn) ReportError::NoMainFound();
+    ReportError::SetCurrentFile(NULL);
+}
+
+void Program::SelectSource(int declIndex) {
+    if (declSources && declIndex < declSources->NumElements()) {
+        SourceFile *sf = declSources->Nth(declIndex);
+        ReportError::SetCurrentFile(sf->name, sf->lines);
+    }
+}
+
+Decl *Program::LookupInScope(const char *name) {
+    return scope ? scope->Lookup(name) : NULL;
+}
+
+int Program::Execute(FILE *input) {
+    Assert(mainFn != NULL);
+    return Interpreter::Run(mainFn, globals, input);
+}
+
+/* Every function is given its index in the program before any code is
+ * generated, so that calls can refer to functions further down. Returns
+ * the number of functions. */
+int Program::NumberFunctions() {
+    int numFunctions = 0;
+    for (int i = 0; i < decls->NumElements(); i++) {
+        FnDecl *fn = dynamic_cast<FnDecl*>(decls->Nth(i));
+        ClassDecl *cls = dynamic_cast<ClassDecl*>(decls->Nth(i));
+        if (fn) fn->SetCodeIndex(numFunctions++);
+        if (!cls) continue;
+        List<Decl*> *members = cls->GetMembers();
+        for (int j = 0; j < members->NumElements(); j++) {
+            fn = dynamic_cast<FnDecl*>(members->Nth(j));
+            if (fn) fn->SetCodeIndex(numFunctions++);
+        }
+    }
+    return numFunctions;
+}
+
+BcProgram *Program::Emit() {
+    BcProgram *program = new BcProgram;
+    CodeGenerator cg(program);
+    NumberFunctions();
+    for (int i = 0; i < decls->NumElements(); i++)
+        decls->Nth(i)->Emit(&cg);
+    program->main = program->functions.Nth(mainFn->GetCodeIndex());
+    return program;
+}
+
+TacProgram *Program::EmitTac() {
+    TacProgram *program = new TacProgram;
+    TacBuilder tb(program);
+    program->functions.resize(NumberFunctions(), NULL);
+    for (int i = 0; i < decls->NumElements(); i++)
+        decls->Nth(i)->EmitTac(&tb);
+    program->main = program->functions[mainFn->GetCodeIndex()];
+    return program;
+}
+
+void Program::FoldConstants() {
+    for (int i = 0; i < decls->NumElements(); i++)
+        decls->Nth(i)->FoldConstants();
+}
+
+int Program::Run(BcProgram *code, FILE *input) {
+    return VM::Run(code, globals, input);
+}
+
+/* The C comes in the order C needs it: the runtime, the structs of the
+ * classes, prototypes of all functions, the globals, the classes'
+ * vtables, which refer to their methods, and then the functions, which
+ * refer to the rest. Methods called through interfaces are numbered
+ * first, for each class's lookup function to know them. */
+void Program::EmitC(FILE *out) {
+    CWriter w(out);
+    NumberFunctions();
+    w.WriteRuntime();
+    for (int i = 0; i < decls->NumElements(); i++) {
+        InterfaceDecl *iface = dynamic_cast<InterfaceDecl*>(decls->Nth(i));
+        if (!iface) continue;
+        for (int j = 0; j < iface->GetMembers()->NumElements(); j++)
+            w.InterfaceMethod(iface->GetMembers()->Nth(j)->GetName());
+    }
+    for (int i = 0; i < decls->NumElements(); i++) {
+        ClassDecl *cls = dynamic_cast<ClassDecl*>(decls->Nth(i));
+        if (cls) cls->EmitCStruct(&w);
+    }
+    for (int i = 0; i < decls->NumElements(); i++) {
+        FnDecl *fn = dynamic_cast<FnDecl*>(decls->Nth(i));
+        ClassDecl *cls = dynamic_cast<ClassDecl*>(decls->Nth(i));
+        if (fn) w.Write("%s;\n", CWriter::Prototype(fn).c_str());
+        if (!cls) continue;
+        for (int j = 0; j < cls->GetMembers()->NumElements(); j++) {
+            fn = dynamic_cast<FnDecl*>(cls->GetMembers()->Nth(j));
+            if (fn) w.Write("%s;\n", CWriter::Prototype(fn).c_str());
+        }
+    }
+    w.Write("\n");
+    for (int i = 0; i < globals->NumElements(); i++) {
+        VarDecl *var = globals->Nth(i);
+        w.Write("static %s = %s;\n", CWriter::Declaration(var->GetType(), CWriter::Global(var)).c_str(),
+                CWriter::ZeroOf(var->GetType()).c_str());
+    }
+    w.Write("\n");
+    for (int i = 0; i < decls->NumElements(); i++) {
+        ClassDecl *cls = dynamic_cast<ClassDecl*>(decls->Nth(i));
+        if (cls) cls->EmitCClass(&w);
+    }
+    for (int i = 0; i < decls->NumElements(); i++)
+        decls->Nth(i)->EmitC(&w);
+    w.Write("int main(void)\n{\n    %s();\n    return 0;\n}\n",
+            CWriter::FunctionName(mainFn).c_str());
+}
+
+
+void StmtBlock::Check() {
+    FnDecl *fn = GetEnclosingFn();
+    scope = new Scope;
+    for (int i = 0; i < decls->NumElements(); i++) {
+        VarDecl *var = decls->Nth(i);
+        var->Check();
+        scope->Declare(var);
+        fn->AllocateSlot(var);
+    }
+    for (int i = 0; i < stmts->NumElements(); i++)
+        stmts->Nth(i)->Check();
+}
+
+Decl *StmtBlock::LookupInScope(const char *name) {
+    return scope ? scope->Lookup(name) : NULL;
+}
+
+execResultT StmtBlock::Exec(Value *frame) {
+    for (int i = 0; i < stmts->NumElements(); i++) {
+        execResultT result = stmts->Nth(i)->Exec(frame);
+        if (result != ExecNormal) return result;
+    }
+    return ExecNormal;
+}
+
+/* Function: EmitStmts()
+ * ---------------------
+ * Generates code for a list of statements, giving back the temporaries of
+ * each once it is done with them.
+ */
+static void EmitStmts(CodeGenerator *cg, List<Stmt*> *stmts) {
+    for (int i = 0; i < stmts->NumElements(); i++) {
+        int mark = cg->GetTempMark();
+        stmts->Nth(i)->Emit(cg);
+        cg->FreeTemps(mark);
+    }
+}
+
+void StmtBlock::Emit(CodeGenerator *cg) {
+    EmitStmts(cg, stmts);
+}
+
+void StmtBlock::EmitC(CWriter *w) {
+    for (int i = 0; i < stmts->NumElements(); i++)
+        stmts->Nth(i)->EmitC(w);
+}
+
+void StmtBlock::EmitTac(TacBuilder *tb) {
+    for (int i = 0; i < stmts->NumElements(); i++)
+        stmts->Nth(i)->EmitTac(tb);
+}
+
+void StmtBlock::FoldConstants() {
+    for (int i = 0; i < stmts->NumElements(); i++)
+        stmts->Nth(i)->FoldConstants();
+}
+
+
+void ConditionalStmt::CheckTest() {
+    test->Check();
+    if (!test->GetType()->IsCompatibleWith(Type::boolType))
+        ReportError::TestNotBoolean(test);
+}
+
+void ConditionalStmt::FoldConstants() {
+    test = test->FoldInto(this);
+    body->FoldConstants();
+}
+
+void ForStmt::Check() {
+    init->Check();
+    CheckTest();
+    step->Check();
+    body->Check();
+}
+
+execResultT ForStmt::Exec(Value *frame) {
+    for (init->Eval(frame); test->Eval(frame).b; step->Eval(frame)) {
+        execResultT result = body->Exec(frame);
+        if (result == ExecBreak) break;
+        if (result == ExecReturn) return result;
+    }
+    return ExecNormal;
+}
+
+/* Loops are laid out with the test at the bottom, so each iteration takes
+ * a single conditional jump:
+ *
+ *        init
+ *        Jump test
+ *    top:
+ *        body
+ *        step
+ *    test:
+ *        JumpIf test -> top        (or JumpIfLessInt i n -> top, etc.)
+ *    end:
+ */
+void ForStmt::Emit(CodeGenerator *cg) {
+    int top = cg->NewLabel(), testLabel = cg->NewLabel(), end = cg->NewLabel();
+    int mark = cg->GetTempMark();
+    init->Emit(cg);
+    cg->FreeTemps(mark);
+    cg->GenJump(OpJump, testLabel);
+    cg->PlaceLabel(top);
+    cg->PushBreakLabel(end);
+    body->Emit(cg);
+    cg->PopBreakLabel();
+    cg->FreeTemps(mark);
+    step->Emit(cg);
+    cg->FreeTemps(mark);
+    cg->PlaceLabel(testLabel);
+    cg->GenBranch(OpJumpIf, top, test->EmitValue(cg));
+    cg->FreeTemps(mark);
+    cg->PlaceLabel(end);
+}
+
+/* A Decaf break leaves the innermost loop or switch, as a C break does,
+ * so loops and switches become C's own. */
+void ForStmt::EmitC(CWriter *w) {
+    init->EmitC(w);
+    w->Line("for (;;) {");
+    w->Indent();
+    std::string t = test->EmitCValue(w);
+    w->Line("if (!%s) break;", t.c_str());
+    body->EmitC(w);
+    step->EmitC(w);
+    w->Outdent();
+    w->Line("}");
+}
+
+/* The test heads the loop, in a block of its own that the body jumps
+ * back to, so a loop is a natural loop with that block as its header. */
+void ForStmt::EmitTac(TacBuilder *tb) {
+    int top = tb->NewBlock(), bodyBlock = tb->NewBlock(), end = tb->NewBlock();
+    init->EmitTac(tb);
+    tb->GenJump(top);
+    tb->SetBlock(top);
+    test->EmitTacBranch(tb, bodyBlock, end);
+    tb->SetBlock(bodyBlock);
+    tb->PushBreakTarget(end);
+    body->EmitTac(tb);
+    tb->PopBreakTarget();
+    step->EmitTac(tb);
+    tb->GenJump(top);
+    tb->SetBlock(end);
+}
+
+void ForStmt::FoldConstants() {
+    init = init->FoldInto(this);
+    ConditionalStmt::FoldConstants();
+    step = step->FoldInto(this);
+}
+
+void WhileStmt::Check() {
+    CheckTest();
+    body->Check();
+}
+
+execResultT WhileStmt::Exec(Value *frame) {
+    while (test->Eval(frame).b) {
+        execResultT result = body->Exec(frame);
+        if (result == ExecBreak) break;
+        if (result == ExecReturn) return result;
+    }
+    return ExecNormal;
+}
+
+void WhileStmt::Emit(CodeGenerator *cg) {
+    int top = cg->NewLabel(), testLabel = cg->NewLabel(), end = cg->NewLabel();
+    int mark = cg->GetTempMark();
+    cg->GenJump(OpJump, testLabel);
+    cg->PlaceLabel(top);
+    cg->PushBreakLabel(end);
+    body->Emit(cg);
+    cg->PopBreakLabel();
+    cg->FreeTemps(mark);
+    cg->PlaceLabel(testLabel);
+    cg->GenBranch(OpJumpIf, top, test->EmitValue(cg));
+    cg->FreeTemps(mark);
+    cg->PlaceLabel(end);
+}
+
+void WhileStmt::EmitC(CWriter *w) {
+    w->Line("for (;;) {");
+    w->Indent();
+    std::string t = test->EmitCValue(w);
+    w->Line("if (!%s) break;", t.c_str());
+    body->EmitC(w);
+    w->Outdent();
+    w->Line("}");
+}
+
+void WhileStmt::EmitTac(TacBuilder *tb) {
+    int top = tb->NewBlock(), bodyBlock = tb->NewBlock(), end = tb->NewBlock();
+    tb->GenJump(top);
+    tb->SetBlock(top);
+    test->EmitTacBranch(tb, bodyBlock, end);
+    tb->SetBlock(bodyBlock);
+    tb->PushBreakTarget(end);
+    body->EmitTac(tb);
+    tb->PopBreakTarget();
+    tb->GenJump(top);
+    tb->SetBlock(end);
+}
+
+void IfStmt::Check() {
+    CheckTest();
+    body->Check();
+    if (elseBody) elseBody->Check();
+}
+
+execResultT IfStmt::Exec(Value *frame) {
+    if (test->Eval(frame).b)
+        return body->Exec(frame);
+    return elseBody ? elseBody->Exec(frame) : ExecNormal;
+}
+
+void IfStmt::Emit(CodeGenerator *cg) {
+    int elseLabel = cg->NewLabel(), end = cg->NewLabel();
+    int mark = cg->GetTempMark();
+    cg->GenBranch(OpJumpIfNot, elseLabel, test->EmitValue(cg));
+    cg->FreeTemps(mark);
+    body->Emit(cg);
+    cg->FreeTemps(mark);
+    if (elseBody) cg->GenJump(OpJump, end);
+    cg->PlaceLabel(elseLabel);
+    if (elseBody) {
+        elseBody->Emit(cg);
+        cg->FreeTemps(mark);
+    }
+    cg->PlaceLabel(end);
+}
+
+void IfStmt::EmitC(CWriter *w) {
+    std::string t = test->EmitCValue(w);
+    w->Line("if (%s) {", t.c_str());
+    w->Indent();
+    body->EmitC(w);
+    w->Outdent();
+    if (elseBody) {
+        w->Line("} else {");
+        w->Indent();
+        elseBody->EmitC(w);
+        w->Outdent();
+    }
+    w->Line("}");
+}
+
+void IfStmt::EmitTac(TacBuilder *tb) {
+    int then = tb->NewBlock(), elseBlock = elseBody ? tb->NewBlock() : -1;
+    int end = tb->NewBlock();
+    test->EmitTacBranch(tb, then, elseBody ? elseBlock : end);
+    tb->SetBlock(then);
+    body->EmitTac(tb);
+    tb->GenJump(end);
+    if (elseBody) {
+        tb->SetBlock(elseBlock);
+        elseBody->EmitTac(tb);
+        tb->GenJump(end);
+    }
+    tb->SetBlock(end);
+}
+
+void IfStmt::FoldConstants() {
+    ConditionalStmt::FoldConstants();
+    if (elseBody) elseBody->FoldConstants();
+}
+
+void BreakStmt::Check() {
+    for (Node *n = GetParent(); n && !dynamic_cast<FnDecl*>(n); n = n->GetParent())
+        if (dynamic_cast<LoopStmt*>(n) || dynamic_cast<SwitchStmt*>(n)) return;
+    ReportError::BreakOutsideLoop(this);
+}
+
+void BreakStmt::Emit(CodeGenerator *cg) {
+    cg->GenJump(OpJump, cg->GetBreakLabel());
+}
+
+void BreakStmt::EmitC(CWriter *w) {
+    w->Line("break;");
+}
+
+void BreakStmt::EmitTac(TacBuilder *tb) {
+    tb->GenJump(tb->GetBreakTarget());
+}
+
+// Orders the indices of cases by their labels.
+struct LabelOrder {
+	const int *labels;
+	LabelOrder(const int *l) : labels(l) {}
+	bool operator()(int i, int j) const { return labels[i] < labels[j]; }
+};
+
+void SwitchStmt::Check() {
+	test->Check();
+	if (!test->GetType()->IsCompatibleWith(Type::intType))
+		ReportError::SwitchNotInteger(test);
+	numCases = 0;
+	hasDefault = false;
+	labels = new int[stmtList->NumElements()];
+	for (int i = 0; i < stmtList->NumElements(); i++) {
+		Stmt *s = stmtList->Nth(i);
+		s->Check();
+		CaseStmt *c = dynamic_cast<CaseStmt*>(s);
+		if (c) labels[numCases++] = c->GetLabel();
+		else hasDefault = true;
+	}
+
+	// sorted, cases with the same label end up side by side
+	byLabel = new int[numCases];
+	for (int i = 0; i < numCases; i++)
+		byLabel[i] = i;
+	std::stable_sort(byLabel, byLabel + numCases, LabelOrder(labels));
+	std::vector<bool> duplicate(numCases, false);
+	for (int i = 1; i < numCases; i++)
+		if (labels[byLabel[i]] == labels[byLabel[i-1]]) duplicate[byLabel[i]] = true;
+	for (int i = 0; i < numCases; i++) {
+		if (!duplicate[i]) continue;
+		CaseStmt *c = dynamic_cast<CaseStmt*>(stmtList->Nth(i));
+		ReportError::DuplicateCase(c->GetLabelExpr(), labels[i]);
+	}
+}
+
+/* Function: FindCase()
+ * --------------------
+ * The index of the case labeled value, or -1 if there is none: a binary
+ * search of the cases in order of their labels.
+ */
+int SwitchStmt::FindCase(int value) {
+	int lo = 0, hi = numCases;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		if (labels[byLabel[mid]] < value) lo = mid + 1;
+		else hi = mid;
+	}
+	return lo < numCases && labels[byLabel[lo]] == value ? byLabel[lo] : -1;
+}
+
+/* Function: FindClusters()
+ * ------------------------
+ * Splits the cases, in order of their labels, into the clusters the code
+ * for the switch dispatches to. A run of cases becomes a jump table if
+ * it is dense enough, its labels covering at least 40% of the range from
+ * the first to the last (at most 64K), and long enough, MinTableCases
+ * cases at least; fewer are as quickly compared with one by one. Going
+ * from the lowest label up, each run is taken as long as it can be, and
+ * a case that starts no run is a cluster of its own.
+ */
+void SwitchStmt::FindClusters(std::vector<CaseCluster> *clusters) {
+	const int MinTableCases = 4, MaxTableSize = 1 << 16;
+	for (int i = 0; i < numCases; ) {
+		int low = labels[byLabel[i]], end = i + 1;
+		for (int k = i + 1; k < numCases; k++) {
+			long long range = (long long)labels[byLabel[k]] - low + 1;
+			if (range > MaxTableSize) break;
+			if ((k - i + 1) * 100LL >= range * 40) end = k + 1;
+		}
+		if (end - i < MinTableCases) end = i + 1;
+		CaseCluster c = { low, labels[byLabel[end-1]], i, end - i };
+		clusters->push_back(c);
+		i = end;
+	}
+}
+
+/* Control enters at the case whose label matches (or the default) and
+ * falls through the cases after it until a break. */
+execResultT SwitchStmt::Exec(Value *frame) {
+	int start = FindCase(test->Eval(frame).i);
+	if (start < 0) start = hasDefault ? numCases : stmtList->NumElements();
+	for (int i = start; i < stmtList->NumElements(); i++) {
+		execResultT result = stmtList->Nth(i)->Exec(frame);
+		if (result == ExecBreak) break;
+		if (result == ExecReturn) return result;
+	}
+	return ExecNormal;
+}
+
+/* The value finds its case by a binary search of the clusters of cases
+ * (see FindClusters), down to a jump table or a few labels compared with
+ * in turn; the cases' code follows, in order, so control falls from one
+ * into the next. */
+void SwitchStmt::Emit(CodeGenerator *cg) {
+	int end = cg->NewLabel();
+	int mark = cg->GetTempMark();
+	int value = test->EmitValue(cg);
+	int *caseLabels = new int[stmtList->NumElements()];
+	for (int i = 0; i < stmtList->NumElements(); i++)
+		caseLabels[i] = cg->NewLabel();
+	std::vector<CaseCluster> clusters;
+	FindClusters(&clusters);
+	EmitSearch(cg, value, clusters, 0, clusters.size(), caseLabels,
+	           hasDefault ? caseLabels[numCases] : end);
+	cg->FreeTemps(mark);
+	cg->PushBreakLabel(end);
+	for (int i = 0; i < stmtList->NumElements(); i++) {
+		cg->PlaceLabel(caseLabels[i]);
+		stmtList->Nth(i)->Emit(cg);
+	}
+	cg->PopBreakLabel();
+	cg->PlaceLabel(end);
+	delete[] caseLabels;
+}
+
+/* Function: EmitSearch()
+ * ----------------------
+ * Jumps to the case labeled value among the clusters from lo up to hi,
+ * or to otherwise if there is none. Up to MaxCompares single labels are
+ * compared with in turn; more clusters are halved by comparing with the
+ * low label of the middle one.
+ */
+void SwitchStmt::EmitSearch(CodeGenerator *cg, int value, const std::vector<CaseCluster> &clusters,
+                            int lo, int hi, const int *caseLabels, int otherwise) {
+	const int MaxCompares = 3;
+	int mark = cg->GetTempMark();
+	bool compare = hi - lo <= MaxCompares;
+	for (int i = lo; i < hi; i++)
+		if (clusters[i].count > 1) compare = false;
+	if (compare) {
+		int label = cg->NewTemp(), equal = cg->NewTemp();
+		for (int i = lo; i < hi; i++) {
+			cg->GenLoadInt(label, clusters[i].low);
+			cg->Gen(OpEqualInt, equal, value, label);
+			cg->GenBranch(OpJumpIf, caseLabels[byLabel[clusters[i].first]], equal);
+		}
+		cg->GenJump(OpJump, otherwise);
+	} else if (hi - lo == 1) {
+		const CaseCluster &c = clusters[lo];
+		std::vector<int> targets(c.high - c.low + 1, otherwise);
+		for (int i = c.first; i < c.first + c.count; i++)
+			targets[labels[byLabel[i]] - c.low] = caseLabels[byLabel[i]];
+		cg->GenJumpTable(value, c.low, targets);
+		cg->GenJump(OpJump, otherwise);
+	} else {
+		int mid = (lo + hi) / 2, right = cg->NewLabel();
+		int label = cg->NewTemp(), less = cg->NewTemp();
+		cg->GenLoadInt(label, clusters[mid].low);
+		cg->Gen(OpLessInt, less, value, label);
+		cg->GenBranch(OpJumpIfNot, right, less);
+		cg->FreeTemps(mark);
+		EmitSearch(cg, value, clusters, lo, mid, caseLabels, otherwise);
+		cg->PlaceLabel(right);
+		EmitSearch(cg, value, clusters, mid, hi, caseLabels, otherwise);
+	}
+	cg->FreeTemps(mark);
+}
+
+/* Each case's statements are braced under its label; the C compiler
+ * picks how to dispatch. */
+void SwitchStmt::EmitC(CWriter *w) {
+	std::string value = test->EmitCValue(w);
+	w->Line("switch (%s) {", value.c_str());
+	for (int i = 0; i < stmtList->NumElements(); i++) {
+		if (i == numCases) w->Line("default: {");
+		else w->Line("case %d: {", labels[i]);
+		w->Indent();
+		stmtList->Nth(i)->EmitC(w);
+		w->Outdent();
+		w->Line("}");
+	}
+	w->Line("}");
+}
+
+/* As for bytecode, with a Switch for a jump table. Each case's code has
+ * a block of its own, which the one before jumps to. */
+void SwitchStmt::EmitTac(TacBuilder *tb) {
+	int end = tb->NewBlock();
+	int value = test->EmitTacValue(tb);
+	std::vector<int> caseBlocks(stmtList->NumElements());
+	for (int i = 0; i < stmtList->NumElements(); i++)
+		caseBlocks[i] = tb->NewBlock();
+	std::vector<CaseCluster> clusters;
+	FindClusters(&clusters);
+	EmitTacSearch(tb, value, clusters, 0, clusters.size(), caseBlocks,
+	              hasDefault ? caseBlocks[numCases] : end);
+	tb->PushBreakTarget(end);
+	for (int i = 0; i < stmtList->NumElements(); i++) {
+		tb->SetBlock(caseBlocks[i]);
+		stmtList->Nth(i)->EmitTac(tb);
+		tb->GenJump(i + 1 < stmtList->NumElements() ? caseBlocks[i+1] : end);
+	}
+	tb->PopBreakTarget();
+	tb->SetBlock(end);
+}
+
+// The same search as EmitSearch, in blocks.
+void SwitchStmt::EmitTacSearch(TacBuilder *tb, int value, const std::vector<CaseCluster> &clusters,
+                               int lo, int hi, const std::vector<int> &caseBlocks, int otherwise) {
+	const int MaxCompares = 3;
+	bool compare = hi - lo <= MaxCompares;
+	for (int i = lo; i < hi; i++)
+		if (clusters[i].count > 1) compare = false;
+	if (compare) {
+		for (int i = lo; i < hi; i++) {
+			int label = tb->NewTemp(Type::intType), equal = tb->NewTemp(Type::boolType);
+			int next = tb->NewBlock();
+			tb->GenConst(label, MakeInt(clusters[i].low));
+			tb->Gen(TacEqualInt, equal, value, label);
+			tb->GenBranch(equal, caseBlocks[byLabel[clusters[i].first]], next);
+			tb->SetBlock(next);
+		}
+		tb->GenJump(otherwise);
+	} else if (hi - lo == 1) {
+		const CaseCluster &c = clusters[lo];
+		std::vector<int> targets(c.high - c.low + 1, otherwise);
+		for (int i = c.first; i < c.first + c.count; i++)
+			targets[labels[byLabel[i]] - c.low] = caseBlocks[byLabel[i]];
+		tb->GenSwitch(value, c.low, targets, otherwise);
+	} else {
+		int mid = (lo + hi) / 2, left = tb->NewBlock(), right = tb->NewBlock();
+		int label = tb->NewTemp(Type::intType), less = tb->NewTemp(Type::boolType);
+		tb->GenConst(label, MakeInt(clusters[mid].low));
+		tb->Gen(TacLessInt, less, value, label);
+		tb->GenBranch(less, left, right);
+		tb->SetBlock(left);
+		EmitTacSearch(tb, value, clusters, lo, mid, caseBlocks, otherwise);
+		tb->SetBlock(right);
+		EmitTacSearch(tb, value, clusters, mid, hi, caseBlocks, otherwise);
+	}
+}
+
+void SwitchStmt::FoldConstants() {
+	test = test->FoldInto(this);
+	for (int i = 0; i < stmtList->NumElements(); i++)
+		stmtList->Nth(i)->FoldConstants();
+}
+
+int CaseStmt::GetLabel() {
+	IntConstant *c = dynamic_cast<IntConstant*>(value);
+	Assert(c != NULL);
+	return c->GetValue();
+}
+
+void CaseStmt::Check() {
+	for (int i = 0; i < body->NumElements(); i++)
+		body->Nth(i)->Check();
+}
+
+execResultT CaseStmt::Exec(Value *frame) {
+	for (int i = 0; i < body->NumElements(); i++) {
+		execResultT result = body->Nth(i)->Exec(frame);
+		if (result != ExecNormal) return result;
+	}
+	return ExecNormal;
+}
+
+void CaseStmt::Emit(CodeGenerator *cg) {
+	EmitStmts(cg, body);
+}
+
+void CaseStmt::EmitC(CWriter *w) {
+	for (int i = 0; i < body->NumElements(); i++)
+		body->Nth(i)->EmitC(w);
+}
+
+void CaseStmt::EmitTac(TacBuilder *tb) {
+	for (int i = 0; i < body->NumElements(); i++)
+		body->Nth(i)->EmitTac(tb);
+}
+
+void CaseStmt::FoldConstants() {
+	for (int i = 0; i < body->NumElements(); i++)
+		body->Nth(i)->FoldConstants();
+}
+
+void Default::Check() {
+	for (int i = 0; i < body->NumElements(); i++)
+		body->Nth(i)->Check();
+}
+
+execResultT Default::Exec(Value *frame) {
+	for (int i = 0; i < body->NumElements(); i++) {
+		execResultT result = body->Nth(i)->Exec(frame);
+		if (result != ExecNormal) return result;
+	}
+	return ExecNormal;
+}
+
+void Default::Emit(CodeGenerator *cg) {
+	EmitStmts(cg, body);
+}
+
+void Default::EmitC(CWriter *w) {
+	for (int i = 0; i < body->NumElements(); i++)
+		body->Nth(i)->EmitC(w);
+}
+
+void Default::EmitTac(TacBuilder *tb) {
+	for (int i = 0; i < body->NumElements(); i++)
+		body->Nth(i)->EmitTac(tb);
+}
+
+void Default::FoldConstants() {
+	for (int i = 0; i < body->NumElements(); i++)
+		body->Nth(i)->FoldConstants();
+}
+
+void ReturnStmt::Check() {
+    expr->Check();
+    Type *expected = GetEnclosingFn()->GetReturnType();
+    if (!expr->GetType()->IsCompatibleWith(expected))
+        ReportError::ReturnMismatch(this, expr->GetType(), expected);
+}
+
+execResultT ReturnStmt::Exec(Value *frame) {
+    Interpreter::returnValue = expr->Eval(frame);
+    return ExecReturn;
+}
+
+void ReturnStmt::Emit(CodeGenerator *cg) {
+    if (expr->GetType() == Type::voidType)
+        cg->Gen(OpReturnVoid);
+    else
+        cg->Gen(OpReturn, expr->EmitValue(cg));
+}
+
+void ReturnStmt::EmitC(CWriter *w) {
+    std::string value = expr->EmitCValue(w);
+    w->Line("dc_depth--;");
+    if (expr->GetType() == Type::voidType)
+        w->Line("return;");
+    else
+        w->Line("return %s;", value.c_str());
+}
+
+void ReturnStmt::EmitTac(TacBuilder *tb) {
+    int value = expr->EmitTacValue(tb);
+    if (expr->GetType() == Type::voidType)
+        tb->Gen(TacReturnVoid, -1);
+    else
+        tb->Gen(TacReturn, -1, value);
+}
+
+void ReturnStmt::FoldConstants() {
+    expr = expr->FoldInto(this);
+}
+
+void PrintStmt::Check() {
+    for (int i = 0; i < args->NumElements(); i++) {
+        Expr *arg = args->Nth(i);
+        arg->Check();
+        Type *t = arg->GetType();
+        if (!t->IsError() && t != Type::intType && t != Type::boolType &&
+            t != Type::stringType)
+            ReportError::PrintArgMismatch(arg, i+1, t);
+    }
+}
+
+execResultT PrintStmt::Exec(Value *frame) {
+    for (int i = 0; i < args->NumElements(); i++)
+        Interpreter::Print(args->Nth(i)->Eval(frame));
+    return ExecNormal;
+}
+
+void PrintStmt::Emit(CodeGenerator *cg) {
+    for (int i = 0; i < args->NumElements(); i++) {
+        Expr *arg = args->Nth(i);
+        int mark = cg->GetTempMark();
+        int reg = arg->EmitValue(cg);
+        if (arg->GetType() == Type::intType) cg->Gen(OpPrintInt, reg);
+        else if (arg->GetType() == Type::boolType) cg->Gen(OpPrintBool, reg);
+        else cg->Gen(OpPrintString, reg);
+        cg->FreeTemps(mark);
+    }
+}
+
+void PrintStmt::EmitC(CWriter *w) {
+    for (int i = 0; i < args->NumElements(); i++) {
+        Expr *arg = args->Nth(i);
+        std::string value = arg->EmitCValue(w);
+        if (arg->GetType() == Type::intType)
+            w->Line("printf(\"%%d\", %s);", value.c_str());
+        else if (arg->GetType() == Type::boolType)
+            w->Line("fputs(%s ? \"true\" : \"false\", stdout);", value.c_str());
+        else
+            w->Line("fputs(%s, stdout);", value.c_str());
+    }
+}
+
+void PrintStmt::EmitTac(TacBuilder *tb) {
+    for (int i = 0; i < args->NumElements(); i++) {
+        Expr *arg = args->Nth(i);
+        int reg = arg->EmitTacValue(tb);
+        if (arg->GetType() == Type::intType) tb->Gen(TacPrintInt, -1, reg);
+        else if (arg->GetType() == Type::boolType) tb->Gen(TacPrintBool, -1, reg);
+        else tb->Gen(TacPrintString, -1, reg);
+    }
+}
+
+void PrintStmt::FoldConstants() {
+    Expr::FoldAll(args, this);
+}
@@ -13,22 +13,76 @@
 #ifndef _H_ast_stmt
 #define _H_ast_stmt
 
+#include <stdio.h>
+#include <vector>
 #include "list.h"
 #include "ast.h"
+#include "interp.h"
 
 class Decl;
 class VarDecl;
 class Expr;
+class Scope;
+class CodeGenerator;
+class CWriter;
+class TacBuilder;
+class BcProgram;
+class TacProgram;
+
+/* Struct: SourceFile
+ * ------------------
+ * One of the input files a program was put together from, with its lines
+ * for quoting in error messages and the number of the program's top-level
+ * declarations (which are in file order) that came from it.
+ */
+struct SourceFile {
+    const char *name;
+    const List<const char*> *lines;
+    int numDecls;
+};
   
 class Program : public Node
 {
   protected:
      List<Decl*> *decls;
+     List<SourceFile*> *sources;     // NULL when read from stdin
+     List<SourceFile*> *declSources; // the file of each decl
+     Scope *scope;
+     List<VarDecl*> *globals;
+     FnDecl *mainFn;
+
+     void SelectSource(int declIndex);
+     int NumberFunctions();
      
   public:
      Program(List<Decl*> *declList);
      const char *GetPrintNameForNode() { return "Program"; }
      void PrintChildren(int indentLevel);
+
+     void SetSourceFiles(List<SourceFile*> *files) { sources = files; }
+     void Check();
+     Decl *LookupInScope(const char *name);
+
+     // Runs the checked program with the tree-walking interpreter,
+     // reading its input from the given file. Returns 0 if it ran to
+     // completion and 1 if it stopped with a runtime error.
+     int Execute(FILE *input);
+
+     // Lowers the checked program to bytecode for the VM (see vm.h), and
+     // runs the bytecode as Execute runs the program.
+     BcProgram *Emit();
+     int Run(BcProgram *code, FILE *input);
+
+     // Translates the checked program to a C program that behaves the
+     // same (see cwriter.h).
+     void EmitC(FILE *out);
+
+     // Lowers the checked program to three-address code (see tac.h).
+     TacProgram *EmitTac();
+
+     // Folds the constant parts of the checked program's expressions
+     // (see Expr::Fold), for every later phase to work on.
+     void FoldConstants();
 };
 
 class Stmt : public Node
@@ -36,6 +90,17 @@ class Stmt : public Node
   public:
      Stmt() : Node() {}
      Stmt(yyltype loc) : Node(loc) {}
+
+     virtual void Check() {}
+     virtual execResultT Exec(Value *frame) { return ExecNormal; }
+     // Generates bytecode for the statement (see codegen.h).
+     virtual void Emit(CodeGenerator *cg) {}
+     // Writes C for the statement (see cwriter.h).
+     virtual void EmitC(CWriter *w) {}
+     // Lowers the statement to three-address code (see tacgen.h).
+     virtual void EmitTac(TacBuilder *tb) {}
+     // Folds the constant parts of the statement's expressions.
+     virtual void FoldConstants() {}
 };
 
 class StmtBlock : public Stmt 
@@ -43,11 +108,20 @@ class StmtBlock : public Stmt
   protected:
     List<VarDecl*> *decls;
     List<Stmt*> *stmts;
+    Scope *scope;
     
   public:
     StmtBlock(List<VarDecl*> *variableDeclarations, List<Stmt*> *statements);
     const char *GetPrintNameForNode() { return "StmtBlock"; }
     void PrintChildren(int indentLevel);
+
+    void Check();
+    Decl *LookupInScope(const char *name);
+    execResultT Exec(Value *frame);
+    void Emit(CodeGenerator *cg);
+    void EmitC(CWriter *w);
+    void EmitTac(TacBuilder *tb);
+    void FoldConstants();
 };
 
   
@@ -56,9 +130,12 @@ class ConditionalStmt : public Stmt
   protected:
     Expr *test;
     Stmt *body;
+
+    void CheckTest();
   
   public:
     ConditionalStmt(Expr *testExpr, Stmt *body);
+    void FoldConstants();
 };
 
 class LoopStmt : public ConditionalStmt 
@@ -77,6 +154,12 @@ class ForStmt : public LoopStmt
     ForStmt(Expr *init, Expr *test, Expr *step, Stmt *body);
     const char *GetPrintNameForNode() { return "ForStmt"; }
     void PrintChildren(int indentLevel);
+    void Check();
+    execResultT Exec(Value *frame);
+    void Emit(CodeGenerator *cg);
+    void EmitC(CWriter *w);
+    void EmitTac(TacBuilder *tb);
+    void FoldConstants();
 };
 
 class WhileStmt : public LoopStmt 
@@ -85,6 +168,11 @@ class WhileStmt : public LoopStmt
     WhileStmt(Expr *test, Stmt *body) : LoopStmt(test, body) {}
     const char *GetPrintNameForNode() { return "WhileStmt"; }
     void PrintChildren(int indentLevel);
+    void Check();
+    execResultT Exec(Value *frame);
+    void Emit(CodeGenerator *cg);
+    void EmitC(CWriter *w);
+    void EmitTac(TacBuilder *tb);
 };
 
 class IfStmt : public ConditionalStmt 
@@ -96,6 +184,12 @@ class IfStmt : public ConditionalStmt
     IfStmt(Expr *test, Stmt *thenBody, Stmt *elseBody);
     const char *GetPrintNameForNode() { return "IfStmt"; }
     void PrintChildren(int indentLevel);
+    void Check();
+    execResultT Exec(Value *frame);
+    void Emit(CodeGenerator *cg);
+    void EmitC(CWriter *w);
+    void EmitTac(TacBuilder *tb);
+    void FoldConstants();
 };
 
 class BreakStmt : public Stmt 
@@ -103,6 +197,23 @@ class BreakStmt : public Stmt
   public:
     BreakStmt(yyltype loc) : Stmt(loc) {}
     const char *GetPrintNameForNode() { return "BreakStmt"; }
+    void Check();
+    execResultT Exec(Value *frame) { return ExecBreak; }
+    void Emit(CodeGenerator *cg);
+    void EmitC(CWriter *w);
+    void EmitTac(TacBuilder *tb);
+};
+
+/* Struct: CaseCluster
+ * -------------------
+ * The count cases of a switch from first on, in order of their labels,
+ * which run from low to high. The code for the switch dispatches to them
+ * together: through a jump table if there are several, and otherwise by
+ * comparing with the one label (see SwitchStmt::FindClusters).
+ */
+struct CaseCluster {
+	int low, high;
+	int first, count;
 };
 
 class SwitchStmt: public Stmt
@@ -110,11 +221,28 @@ class SwitchStmt: public Stmt
 	protected:
 	Expr *test;
 	List<Stmt*> *stmtList;
+	int numCases;		// the cases come first in stmtList,
+	int *labels;		// with these labels,
+	bool hasDefault;	// then the default, if any
+	int *byLabel;		// the cases in order of their labels
+
+	int FindCase(int value);
+	void FindClusters(std::vector<CaseCluster> *clusters);
+	void EmitSearch(CodeGenerator *cg, int value, const std::vector<CaseCluster> &clusters,
+	                int lo, int hi, const int *caseLabels, int otherwise);
+	void EmitTacSearch(TacBuilder *tb, int value, const std::vector<CaseCluster> &clusters,
+	                   int lo, int hi, const std::vector<int> &caseBlocks, int otherwise);
 
 	public:
 	SwitchStmt(Expr *t, List<Stmt*> *b);
 	const char *GetPrintNameForNode() { return "SwitchStmt"; }
 	void PrintChildren(int indentLevel);
+	void Check();
+	execResultT Exec(Value *frame);
+	void Emit(CodeGenerator *cg);
+	void EmitC(CWriter *w);
+	void EmitTac(TacBuilder *tb);
+	void FoldConstants();
 };
 
 class CaseStmt: public Stmt
@@ -127,6 +255,14 @@ class CaseStmt: public Stmt
 	CaseStmt(Expr *v, List<Stmt*> *b);
 	const char *GetPrintNameForNode() { return "Case"; }
 	void PrintChildren(int indentLevel);
+	int GetLabel();
+	Expr *GetLabelExpr() { return value; }
+	void Check();
+	execResultT Exec(Value *frame);
+	void Emit(CodeGenerator *cg);
+	void EmitC(CWriter *w);
+	void EmitTac(TacBuilder *tb);
+	void FoldConstants();
 };
 
 class Default: public Stmt
@@ -138,6 +274,12 @@ class Default: public Stmt
 	Default(List<Stmt*> *body);
 	const char *GetPrintNameForNode() {return "Default"; }
 	void PrintChildren(int indentLevel);
+	void Check();
+	execResultT Exec(Value *frame);
+	void Emit(CodeGenerator *cg);
+	void EmitC(CWriter *w);
+	void EmitTac(TacBuilder *tb);
+	void FoldConstants();
 };
 class ReturnStmt : public Stmt  
 {
@@ -148,6 +290,12 @@ class ReturnStmt : public Stmt
     ReturnStmt(yyltype loc, Expr *expr);
     const char *GetPrintNameForNode() { return "ReturnStmt"; }
     void PrintChildren(int indentLevel);
+    void Check();
+    execResultT Exec(Value *frame);
+    void Emit(CodeGenerator *cg);
+    void EmitC(CWriter *w);
+    void EmitTac(TacBuilder *tb);
+    void FoldConstants();
 };
 
 class PrintStmt : public Stmt
@@ -159,6 +307,12 @@ class PrintStmt : public Stmt
     PrintStmt(List<Expr*> *arguments);
     const char *GetPrintNameForNode() { return "PrintStmt"; }
     void PrintChildren(int indentLevel);
+    void Check();
+    execResultT Exec(Value *frame);
+    void Emit(CodeGenerator *cg);
+    void EmitC(CWriter *w);
+    void EmitTac(TacBuilder *tb);
+    void FoldConstants();
 };
 
 
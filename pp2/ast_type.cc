@@ -36,6 +36,7 @@ void Type::PrintChildren(int indentLevel) {
 NamedType::NamedType(Identifier *i) : Type(*i->GetLocation()) {
     Assert(i != NULL);
     (id=i)->SetParent(this);
+    decl = NULL;
 } 
 
 void NamedType::PrintChildren(int indentLevel) {
@@ -46,8 +47,67 @@ ArrayType::ArrayType(yyltype loc, Type *et) : Type(loc) {
     Assert(et != NULL);
     (elemType=et)->SetParent(this);
 }
+
+/* This one is for array types made up during checking, such as the type
+ * of a NewArray expression. The element type is shared, not adopted. */
+ArrayType::ArrayType(Type *et) : Type() {
+    elemType = et;
+}
+
 void ArrayType::PrintChildren(int indentLevel) {
     elemType->Print(indentLevel+1);
 }
 
 
+bool Type::IsCompatibleWith(Type *other) {
+    if (IsError() || other->IsError()) return true;
+    if (this == nullType) return dynamic_cast<NamedType*>(other) != NULL;
+    return IsEquivalentTo(other);
+}
+
+void NamedType::Check(reasonT whyNeeded) {
+    decl = FindGlobalDecl(id->GetName());
+    if (whyNeeded == LookingForClass && !dynamic_cast<ClassDecl*>(decl))
+        decl = NULL;
+    else if (whyNeeded == LookingForInterface && !dynamic_cast<InterfaceDecl*>(decl))
+        decl = NULL;
+    else if (!dynamic_cast<ClassDecl*>(decl) && !dynamic_cast<InterfaceDecl*>(decl))
+        decl = NULL;
+    if (!decl) ReportError::IdentifierNotDeclared(id, whyNeeded);
+}
+
+Decl *NamedType::GetDecl() {
+    if (!decl) {
+        Decl *d = FindGlobalDecl(id->GetName());
+        if (dynamic_cast<ClassDecl*>(d) || dynamic_cast<InterfaceDecl*>(d))
+            decl = d;
+    }
+    return decl;
+}
+
+ClassDecl *NamedType::GetClassDecl() {
+    return dynamic_cast<ClassDecl*>(GetDecl());
+}
+
+bool NamedType::IsEquivalentTo(Type *other) {
+    NamedType *nt = dynamic_cast<NamedType*>(other);
+    return nt && !strcmp(GetName(), nt->GetName());
+}
+
+bool NamedType::IsCompatibleWith(Type *other) {
+    if (IsError() || other->IsError() || IsEquivalentTo(other)) return true;
+    NamedType *nt = dynamic_cast<NamedType*>(other);
+    ClassDecl *cd = GetClassDecl();
+    return nt && cd && cd->IsSubtypeOf(nt->GetDecl());
+}
+
+void ArrayType::Check(reasonT whyNeeded) {
+    elemType->Check(whyNeeded);
+}
+
+bool ArrayType::IsEquivalentTo(Type *other) {
+    ArrayType *at = dynamic_cast<ArrayType*>(other);
+    return at && elemType->IsEquivalentTo(at->elemType);
+}
+
+
@@ -11,6 +11,7 @@
 
 #include "ast.h"
 #include "list.h"
+#include "errors.h"
 
 
 class Type : public Node 
@@ -22,23 +23,53 @@ class Type : public Node
     static Type *intType, *doubleType, *boolType, *voidType,
                 *nullType, *stringType, *errorType;
 
+    Type() : Node() { typeName = NULL; }
     Type(yyltype loc) : Node(loc) {}
     Type(const char *str);
     
     const char *GetPrintNameForNode() { return "Type"; }
     void PrintChildren(int indentLevel);
+
+    virtual void PrintToStream(std::ostream& out) { out << typeName; }
+    friend std::ostream& operator<<(std::ostream& out, Type *t)
+        { t->PrintToStream(out); return out; }
+
+    // Reports any names in the type that are not declared, saying they
+    // were needed as the given kind of thing.
+    virtual void Check(reasonT whyNeeded) {}
+
+    // Types are equivalent when they are the same type; a value of one
+    // type is compatible with another if it may be used (assigned,
+    // passed, returned) where the other is expected. Erroneous types are
+    // compatible with everything, so that one mistake is reported once.
+    virtual bool IsEquivalentTo(Type *other) { return this == other; }
+    virtual bool IsCompatibleWith(Type *other);
+    virtual bool IsError() { return this == errorType; }
+    bool IsNumeric() { return this == intType || this == doubleType; }
 };
 
 class NamedType : public Type 
 {
   protected:
     Identifier *id;
+    Decl *decl;     // the class or interface named, NULL if none
     
   public:
     NamedType(Identifier *i);
     
     const char *GetPrintNameForNode() { return "NamedType"; }
     void PrintChildren(int indentLevel);
+
+    void PrintToStream(std::ostream& out) { out << id; }
+    const char *GetName() { return id->GetName(); }
+    void Check(reasonT whyNeeded);
+    bool IsEquivalentTo(Type *other);
+    bool IsCompatibleWith(Type *other);
+    bool IsError() { return GetDecl() == NULL; }
+
+    // The ClassDecl or InterfaceDecl the type names, or NULL.
+    Decl *GetDecl();
+    ClassDecl *GetClassDecl();
 };
 
 class ArrayType : public Type 
@@ -48,9 +79,16 @@ class ArrayType : public Type
 
   public:
     ArrayType(yyltype loc, Type *elemType);
+    ArrayType(Type *elemType);
     
     const char *GetPrintNameForNode() { return "ArrayType"; }
     void PrintChildren(int indentLevel);
+
+    void PrintToStream(std::ostream& out) { out << elemType << "[]"; }
+    Type *GetElemType() { return elemType; }
+    void Check(reasonT whyNeeded);
+    bool IsEquivalentTo(Type *other);
+    bool IsError() { return elemType->IsError(); }
 };
 
  
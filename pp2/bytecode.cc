@@ -0,0 +1,152 @@
+/* File: bytecode.cc
+ * -----------------
+ * Implementation of the bytecode program and its listing.
+ */
+
+#include "bytecode.h"
+#include "ast_decl.h"
+#include "ast_type.h"
+#include <sstream>
+
+#define OPCODE_NAME(name) #name,
+const char *opcodeNames[NumOpcodes] = { OPCODES(OPCODE_NAME) };
+#undef OPCODE_NAME
+
+
+int BcProgram::AddConstant(Value v)
+{
+    constants.Append(v);
+    return constants.NumElements() - 1;
+}
+
+int BcProgram::AddClass(ClassDecl *cls)
+{
+    for (int i = 0; i < classes.NumElements(); i++)
+        if (classes.Nth(i) == cls) return i;
+    classes.Append(cls);
+    return classes.NumElements() - 1;
+}
+
+int BcProgram::AddType(Type *t)
+{
+    types.Append(t);
+    return types.NumElements() - 1;
+}
+
+
+void BcProgram::Print(FILE *fp)
+{
+    for (int i = 0; i < functions.NumElements(); i++) {
+        BcFunction *f = functions.Nth(i);
+        if (!f) continue;
+        fprintf(fp, "%s: %d params, %d registers\n", f->name, f->numParams, f->numRegs);
+        for (int pc = 0; pc < f->codeSize; pc++) {
+            fprintf(fp, "%6d  ", pc);
+            PrintInstr(fp, f, f->code[pc]);
+        }
+        for (int t = 0; t < f->numTables; t += 2 + f->tables[t+1]) {
+            fprintf(fp, "  table %d: from %d ->", t, f->tables[t]);
+            for (int i = 0; i < f->tables[t+1]; i++)
+                fprintf(fp, " %d", f->tables[t+2+i]);
+            fprintf(fp, "\n");
+        }
+    }
+}
+
+void BcProgram::PrintInstr(FILE *fp, BcFunction *fn, const Instr &in)
+{
+    fprintf(fp, "%-18s", opcodeNames[in.op]);
+    switch (in.op) {
+      case OpJump:
+        fprintf(fp, "-> %d\n", in.Target());
+        return;
+      case OpJumpIf: case OpJumpIfNot:
+        fprintf(fp, "r%d -> %d\n", in.a, in.Target());
+        return;
+      case OpJumpTable:
+        fprintf(fp, "r%d table %d\n", in.a, in.Target());
+        return;
+      case OpJumpIfLessInt: case OpJumpIfLessEqualInt: case OpJumpIfGreaterInt:
+      case OpJumpIfGreaterEqualInt: case OpJumpIfEqualInt: case OpJumpIfNotEqualInt:
+        fprintf(fp, "r%d r%d -> %d\n", in.a, in.b, in.c);
+        return;
+      case OpLoadInt:
+        fprintf(fp, "r%d %d\n", in.a, (short)in.b);
+        return;
+      case OpAddIntImm:
+        fprintf(fp, "r%d r%d %d\n", in.a, in.b, (short)in.c);
+        return;
+      case OpLoadConst:
+        fprintf(fp, "r%d ", in.a);
+        PrintConstant(fp, in.b);
+        return;
+      case OpSetElemConst: case OpSetElemConstUnchecked:
+        fprintf(fp, "r%d r%d ", in.a, in.b);
+        PrintConstant(fp, in.c);
+        return;
+      case OpCall: case OpCallMethod:
+        fprintf(fp, "r%d %s r%d\n", in.a, functions.Nth(in.b)->name, in.c);
+        return;
+      case OpCallInterface:
+        fprintf(fp, "r%d %s r%d\n", in.a, constants.Nth(fn->caches[in.b].method).s, in.c);
+        return;
+      case OpNewObject:
+        fprintf(fp, "r%d %s\n", in.a, classes.Nth(in.b)->GetName());
+        return;
+      case OpLoadGlobal:
+        fprintf(fp, "r%d g%d\n", in.a, in.b);
+        return;
+      case OpStoreGlobal:
+        fprintf(fp, "g%d r%d\n", in.a, in.b);
+        return;
+      case OpGetField:
+        fprintf(fp, "r%d r%d %d\n", in.a, in.b, in.c);
+        return;
+      case OpCallVirtual:
+        fprintf(fp, "r%d #%d r%d\n", in.a, fn->caches[in.b].method, in.c);
+        return;
+      case OpNewArray: {
+        std::ostringstream type;
+        type << types.Nth(in.c);
+        fprintf(fp, "r%d r%d %s\n", in.a, in.b, type.str().c_str());
+        return;
+      }
+      case OpSetField:
+        fprintf(fp, "r%d %d r%d\n", in.a, in.b, in.c);
+        return;
+      case OpMapElems:
+        if (in.b == OpNewArray) {
+            std::ostringstream type;
+            type << types.Nth(in.c);
+            fprintf(fp, "r%d %s %s\n", in.a, opcodeNames[in.b], type.str().c_str());
+        } else {
+            fprintf(fp, "r%d %s %d\n", in.a, opcodeNames[in.b], in.c);
+        }
+        return;
+      case OpReturnVoid:
+        fprintf(fp, "\n");
+        return;
+      case OpReturn: case OpPrintInt: case OpPrintBool: case OpPrintString:
+      case OpReadInteger: case OpReadLine:
+        fprintf(fp, "r%d\n", in.a);
+        return;
+      case OpMove: case OpLength: case OpNegate: case OpNegateDouble: case OpNotBool:
+        fprintf(fp, "r%d r%d\n", in.a, in.b);
+        return;
+      default:
+        fprintf(fp, "r%d r%d r%d\n", in.a, in.b, in.c);
+        return;
+    }
+}
+
+void BcProgram::PrintConstant(FILE *fp, int index)
+{
+    Value v = constants.Nth(index);
+    switch (v.kind) {
+      case IntValue:    fprintf(fp, "%d\n", v.i); break;
+      case DoubleValue: fprintf(fp, "%g\n", v.d); break;
+      case BoolValue:   fprintf(fp, "%s\n", v.b ? "true" : "false"); break;
+      case StringValue: fprintf(fp, "\"%s\"\n", v.s); break;
+      default:          fprintf(fp, "null\n"); break;
+    }
+}
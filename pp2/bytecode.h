@@ -0,0 +1,198 @@
+/* File: bytecode.h
+ * ----------------
+ * The compact bytecode a checked program is lowered to for the VM (see
+ * codegen.h for the lowering and vm.h for running it).
+ *
+ * The code is register-based: every instruction names the registers it
+ * reads and writes, so "x = y + 1" is one or two instructions rather than
+ * the four pushes and pops of a stack machine. Each function has its own
+ * registers. The first ones are the slots of its frame as the semantic
+ * check assigned them (receiver, formals, locals; see FnDecl), and the
+ * temporaries the lowering needs come after them.
+ *
+ * Instructions are fixed-width: an opcode and three 16-bit operands a, b
+ * and c. Jump targets, which can need more than 16 bits, are spread over
+ * b and c (see Target()). Constants that do not fit an operand (doubles,
+ * strings and large ints) live in the program's constant pool.
+ *
+ * Some instructions do the work of a common pair of simpler ones, to
+ * save the VM a dispatch: SetElemConst stores a constant without loading
+ * it into a register first, and the JumpIf...Int instructions compare
+ * and branch at once, as the test of nearly every loop does. They were
+ * picked from the pairs "dcc --run -op-profile" counts in loop-heavy
+ * programs (see VM::PrintProfile).
+ *
+ * Operands are registers unless noted:
+ *
+ *    Move a b          a = b
+ *    LoadInt a b       a = b, taken as a signed 16-bit int
+ *    LoadConst a b     a = constant b
+ *    LoadGlobal a b    a = global b
+ *    StoreGlobal a b   global a = b
+ *    GetField a b c    a = field c of object b
+ *    SetField a b c    field b of object a = c
+ *    GetElem a b c     a = element c of array b
+ *    SetElem a b c     element b of array a = c
+ *    SetElemConst a b c  element b of array a = constant c
+ *    GetElemUnchecked a b c  and SetElemUnchecked, SetElemConstUnchecked:
+ *                      the same, without the checks for null and bounds,
+ *                      where the optimizer has proved them unneeded
+ *    Length a b        a = length of array b
+ *    NewObject a b     a = new instance of class b
+ *    NewArray a b c    a = new array of b elements of type c (see types)
+ *    AddInt a b c      a = b + c, etc., for the arithmetic and comparison
+ *                      operators on ints, doubles, bools and strings,
+ *                      and for references (EqualRef, NotEqualRef)
+ *    AddIntImm a b c   a = b + c, with c taken as a signed 16-bit int
+ *    Negate a b        a = -b (NegateDouble for doubles)
+ *    NotBool a b       a = !b
+ *    Jump t            continue at t
+ *    JumpIf a t        continue at t if a is true
+ *    JumpIfNot a t     continue at t if a is false
+ *    JumpIfLessInt a b t  continue at t if a < b, and likewise for the
+ *                      other int comparisons; t is operand c alone
+ *    JumpTable a t     continue at entry a - low of jump table t if
+ *                      there is one, else at the next instruction;
+ *                      t is an index into the function's tables
+ *    Call a b c        a = function b called with the arguments in
+ *                      registers c, c+1, ..., which become its first
+ *                      registers (see vm.h)
+ *    CallMethod a b c  the same for method b, once the object in c (the
+ *                      receiver) is checked not to be null
+ *    CallVirtual a b c a = a method of the vtable of the object in c,
+ *                      called the same way; b is the call's inline
+ *                      cache, which holds the method's vtable index
+ *    CallInterface a b c  the same, but the cache holds the index of
+ *                      the string constant naming the method
+ *    Return a          return the value of a
+ *    ReturnVoid        return the zero value of the return type
+ *    PrintInt a        and PrintBool, PrintString: print the value of a
+ *    ReadInteger a     a = a line of input read as an int
+ *    ReadLine a        a = a line of input
+ *    MapElems a b c    the loop of a TAC MapElems (see tac.h), with its
+ *                      five operands in registers a, a+1, ..., a+4 and
+ *                      the operation on elements b given as the opcode
+ *                      (Move for a copy); c says which operands are
+ *                      values rather than arrays, as s does there, or
+ *                      for NewArray is the type of the rows' elements
+ */
+
+#ifndef _H_bytecode
+#define _H_bytecode
+
+#include <stdio.h>
+#include "list.h"
+#include "value.h"
+
+class FnDecl;
+class ClassDecl;
+class Type;
+
+#define OPCODES(X) \
+    X(Move) X(LoadInt) X(LoadConst) X(LoadGlobal) X(StoreGlobal) \
+    X(GetField) X(SetField) X(GetElem) X(SetElem) X(SetElemConst) \
+    X(GetElemUnchecked) X(SetElemUnchecked) X(SetElemConstUnchecked) X(Length) \
+    X(NewObject) X(NewArray) \
+    X(AddInt) X(SubInt) X(MulInt) X(DivInt) X(ModInt) X(AddIntImm) X(Negate) \
+    X(AddDouble) X(SubDouble) X(MulDouble) X(DivDouble) X(ModDouble) \
+    X(NegateDouble) \
+    X(LessInt) X(LessEqualInt) X(GreaterInt) X(GreaterEqualInt) \
+    X(EqualInt) X(NotEqualInt) \
+    X(LessDouble) X(LessEqualDouble) X(GreaterDouble) X(GreaterEqualDouble) \
+    X(EqualDouble) X(NotEqualDouble) \
+    X(EqualBool) X(NotEqualBool) X(EqualString) X(NotEqualString) \
+    X(EqualRef) X(NotEqualRef) X(NotBool) \
+    X(Jump) X(JumpIf) X(JumpIfNot) \
+    X(JumpIfLessInt) X(JumpIfLessEqualInt) X(JumpIfGreaterInt) \
+    X(JumpIfGreaterEqualInt) X(JumpIfEqualInt) X(JumpIfNotEqualInt) X(JumpTable) \
+    X(Call) X(CallMethod) X(CallVirtual) X(CallInterface) X(Return) X(ReturnVoid) \
+    X(PrintInt) X(PrintBool) X(PrintString) X(ReadInteger) X(ReadLine) \
+    X(MapElems)
+
+#define OPCODE_ENUM(name) Op##name,
+typedef enum { OPCODES(OPCODE_ENUM) NumOpcodes } opcodeT;
+#undef OPCODE_ENUM
+
+struct Instr {
+    unsigned short op, a, b, c;
+
+    int Target() const { return b | (c << 16); }
+    void SetTarget(int t) { b = t & 0xffff; c = t >> 16; }
+};
+
+// Whether op is one of the JumpIf...Int instructions, whose target is c.
+inline bool IsCompareJump(int op) { return op >= OpJumpIfLessInt && op <= OpJumpIfNotEqualInt; }
+
+/* Struct: InlineCache
+ * -------------------
+ * What a CallVirtual or CallInterface found last time: the class of the
+ * receiver and the method it had. A call on an object of the same class
+ * goes to the same method without looking it up. Each such call has its
+ * own, which also says what method it calls (see CodeGenerator's
+ * EndFunction).
+ */
+struct BcFunction;
+
+struct InlineCache {
+    ClassDecl *cls;
+    BcFunction *callee;
+    int method;                 // vtable index, or constant naming it
+};
+
+/* Struct: BcFunction
+ * ------------------
+ * The bytecode of one function or method. Its registers start out as
+ * regInit: the zero value of the type of each slot of the frame, and
+ * whatever for the temporaries. Code lowered from TAC (see taclower.h)
+ * keeps ints, doubles and the rest in registers apart, and says which
+ * in regKinds, for the JIT's register allocator.
+ *
+ * The VM counts calls and loop iterations in hotness, and once that
+ * crosses JIT::HotThreshold has the function compiled to machine code
+ * (see jit.h), which it runs from then on.
+ */
+struct BcFunction {
+    FnDecl *decl;
+    const char *name;
+    int numParams;              // including the receiver of a method
+    int numRegs;
+    Value *regInit;
+    ValueKind *regKinds;        // of each register, the one kind of value
+                                // it ever holds, or VoidValue; NULL if
+                                // not known
+    Value returnZero;           // returned by ReturnVoid
+    Instr *code;
+    int codeSize;
+    int *tables;                // of JumpTable: low, n, then n positions
+    int numTables;              // the ints in tables
+    InlineCache *caches;        // of the calls that look up their method,
+                                // in order; NULL if there are none
+    int hotness;
+    unsigned char *native;      // the machine code, or NULL
+    int *nativeOffsets;         // where the code of each instruction starts
+};
+
+class BcProgram
+{
+  public:
+    List<BcFunction*> functions;     // indexed by FnDecl::GetCodeIndex()
+    List<Value> constants;
+    List<ClassDecl*> classes;        // for NewObject
+    List<Type*> types;               // element types for NewArray
+    BcFunction *main;
+
+    BcProgram() : main(NULL) {}
+
+    int AddConstant(Value v);
+    int AddClass(ClassDecl *cls);
+    int AddType(Type *t);
+
+    // Prints the code of every function, for -d bytecode.
+    void Print(FILE *fp);
+    void PrintInstr(FILE *fp, BcFunction *fn, const Instr &in);
+    void PrintConstant(FILE *fp, int index);
+};
+
+extern const char *opcodeNames[NumOpcodes];
+
+#endif
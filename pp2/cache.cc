@@ -0,0 +1,261 @@
+/* File: cache.cc
+ * --------------
+ * Implementation of the on-disk compilation cache.
+ */
+
+#include "cache.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <vector>
+#include "utility.h"
+
+// Bump whenever the entry format or what goes into a key changes.
+static const char *const CacheFormat = "dcc-cache 1";
+
+// Temporary files older than this were left behind by a writer that died.
+static const int StaleTempSeconds = 3600;
+
+// Entries are spread over 16 subdirectories, named by the first hex digit
+// of their keys, and each may use this share of the size cap.
+static const int NumSubdirs = 16;
+
+
+/* Class: Hasher
+ * -------------
+ * 128-bit FNV-1a. Each string is added together with its length, so the
+ * boundaries between the pieces of a key are part of the hash.
+ */
+class Hasher
+{
+  private:
+    unsigned __int128 h;
+
+    void AddBytes(const void *data, size_t len) {
+        const unsigned __int128 prime =
+            ((unsigned __int128)1 << 88) + ((unsigned __int128)1 << 8) + 0x3b;
+        const unsigned char *p = (const unsigned char *)data;
+        for (size_t i = 0; i < len; i++) {
+            h ^= p[i];
+            h *= prime;
+        }
+    }
+
+  public:
+    Hasher() {
+        h = ((unsigned __int128)0x6c62272e07bb0142ULL << 64) | 0x62b821756295c58dULL;
+    }
+    void Add(const std::string &s) {
+        unsigned long long len = s.size();
+        AddBytes(&len, sizeof(len));
+        AddBytes(s.data(), s.size());
+    }
+    std::string HexDigest() {
+        char buf[33];
+        sprintf(buf, "%016llx%016llx", (unsigned long long)(h >> 64),
+                (unsigned long long)h);
+        return buf;
+    }
+};
+
+
+static bool ReadFile(const char *name, std::string *contents)
+{
+    FILE *fp = fopen(name, "rb");
+    if (!fp) return false;
+    char buf[8192];
+    size_t n;
+    contents->clear();
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+        contents->append(buf, n);
+    bool ok = !ferror(fp);
+    fclose(fp);
+    return ok;
+}
+
+static bool WriteFile(int fd, const std::string &contents)
+{
+    size_t done = 0;
+    while (done < contents.size()) {
+        ssize_t n = write(fd, contents.data() + done, contents.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += n;
+    }
+    return true;
+}
+
+
+CompileCache::CompileCache(const char *d, long long max) : dir(d), maxSize(max) {
+    Assert(d != NULL && max > 0);
+}
+
+long long CompileCache::ParseSize(const char *str)
+{
+    char *end;
+    long long size = strtoll(str, &end, 10);
+    switch (*end) {
+      case 'G': case 'g': size *= 1024;  // fall through
+      case 'M': case 'm': size *= 1024;  // fall through
+      case 'K': case 'k': size *= 1024; end++; break;
+      case '\0': break;
+      default: return -1;
+    }
+    return (*end == '\0' && size > 0) ? size : -1;
+}
+
+std::string CompileCache::KeyForCompilation(const std::string &stdinText)
+{
+    Hasher hasher;
+    char buf[64];
+    struct stat st;
+
+    hasher.Add(CacheFormat);
+    // the compiler itself: a rebuilt dcc must not reuse old results
+    if (stat("/proc/self/exe", &st) == 0) {
+        sprintf(buf, "%lld %lld.%09ld", (long long)st.st_size,
+                (long long)st.st_mtim.tv_sec, st.st_mtim.tv_nsec);
+        hasher.Add(buf);
+    }
+    for (int i = 0; i < NumFlagArguments(); i++) {
+        const char *arg = GetFlagArgument(i);
+        if (!strcmp(arg, "--cache-dir") || !strcmp(arg, "--cache-size")) {
+            i++; // where the results go does not change them
+            continue;
+        }
+        if (!strncmp(arg, "-time-phases", 12))
+            continue; // the timing report is never cached
+        if (!strcmp(arg, "-trace")) {
+            i++;      // nor is the trace
+            continue;
+        }
+        hasher.Add(arg);
+    }
+    if (NumInputFiles() == 0) {
+        hasher.Add("<stdin>");
+        hasher.Add(stdinText);
+    }
+    for (int i = 0; i < NumInputFiles(); i++) {
+        std::string contents;
+        if (!ReadFile(GetInputFile(i), &contents)) return "";
+        hasher.Add(GetInputFile(i));
+        hasher.Add(contents);
+    }
+    return hasher.HexDigest();
+}
+
+std::string CompileCache::PathForKey(const std::string &key, std::string *subdir)
+{
+    *subdir = dir + "/" + key.substr(0, 1);
+    return *subdir + "/" + key.substr(1);
+}
+
+bool CompileCache::Lookup(const std::string &key, CompileResult *result)
+{
+    std::string subdir, path = PathForKey(key, &subdir), entry;
+    if (!ReadFile(path.c_str(), &entry)) return false;
+
+    // header: format, status, stdout length, stderr length
+    size_t headerEnd = entry.find('\n');
+    int status;
+    size_t outLen, errLen;
+    char format[32];
+    if (headerEnd == std::string::npos ||
+        sscanf(entry.c_str(), "%31[^:]: %d %zu %zu", format, &status, &outLen, &errLen) != 4 ||
+        strcmp(format, CacheFormat) != 0 ||
+        entry.size() != headerEnd + 1 + outLen + errLen)
+        return false;
+
+    result->status = status;
+    result->out = entry.substr(headerEnd + 1, outLen);
+    result->err = entry.substr(headerEnd + 1 + outLen, errLen);
+    utimensat(AT_FDCWD, path.c_str(), NULL, 0); // mark as recently used
+    return true;
+}
+
+void CompileCache::Store(const std::string &key, const CompileResult &result)
+{
+    std::string subdir, path = PathForKey(key, &subdir);
+    mkdir(dir.c_str(), 0777);
+    mkdir(subdir.c_str(), 0777);
+
+    char header[128];
+    sprintf(header, "%s: %d %zu %zu\n", CacheFormat, result.status,
+            result.out.size(), result.err.size());
+    static int numStores = 0;
+    char temp[64];
+    sprintf(temp, "/.tmp.%d.%d", (int)getpid(), numStores++);
+    std::string tempPath = subdir + temp;
+    int fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+    if (fd < 0) return; // the cache is only an optimization
+    bool ok = WriteFile(fd, header) && WriteFile(fd, result.out) &&
+              WriteFile(fd, result.err);
+    ok = (close(fd) == 0) && ok;
+    if (!ok || rename(tempPath.c_str(), path.c_str()) != 0) {
+        unlink(tempPath.c_str());
+        return;
+    }
+    PrintDebug("cache", "Stored %s", key.c_str());
+    Trim(subdir, path);
+}
+
+/* Method: Trim
+ * ------------
+ * Removes least recently used entries from one subdirectory until it is
+ * back under 80% of its share of the cap, sparing the entry just stored.
+ * Other processes may be trimming the same subdirectory, so files that
+ * have already gone are ignored.
+ */
+void CompileCache::Trim(const std::string &subdir, const std::string &keep)
+{
+    struct Entry {
+        std::string path;
+        struct timespec mtime;
+        long long size;
+        bool operator<(const Entry &other) const {
+            if (mtime.tv_sec != other.mtime.tv_sec) return mtime.tv_sec < other.mtime.tv_sec;
+            return mtime.tv_nsec < other.mtime.tv_nsec;
+        }
+    };
+    const long long limit = maxSize / NumSubdirs;
+    std::vector<Entry> entries;
+    long long total = 0;
+    time_t now = time(NULL);
+
+    DIR *d = opendir(subdir.c_str());
+    if (!d) return;
+    struct dirent *de;
+    while ((de = readdir(d)) != NULL) {
+        if (de->d_name[0] == '.' && strncmp(de->d_name, ".tmp.", 5) != 0) continue;
+        Entry e;
+        struct stat st;
+        e.path = subdir + "/" + de->d_name;
+        if (stat(e.path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        if (de->d_name[0] == '.') {
+            if (now - st.st_mtime > StaleTempSeconds) unlink(e.path.c_str());
+            continue;
+        }
+        e.mtime = st.st_mtim;
+        e.size = st.st_size;
+        total += e.size;
+        entries.push_back(e);
+    }
+    closedir(d);
+    if (total <= limit) return;
+
+    std::sort(entries.begin(), entries.end());
+    for (size_t i = 0; i < entries.size() && total > limit * 8 / 10; i++) {
+        if (entries[i].path == keep) continue;
+        if (unlink(entries[i].path.c_str()) == 0 || errno == ENOENT) {
+            total -= entries[i].size;
+            PrintDebug("cache", "Evicted %s", entries[i].path.c_str());
+        }
+    }
+}
@@ -0,0 +1,58 @@
+/* File: cache.h
+ * -------------
+ * The compilation cache remembers the result of compiling a given input
+ * so that the same compilation can later be answered without running the
+ * front end at all, much like ccache does for C. A result is the exit
+ * status together with everything the compilation wrote to stdout (the
+ * printed tree or generated code) and stderr (the diagnostics).
+ *
+ * Results are content-addressed: the key is a hash of the source text of
+ * every input, the names the inputs were given under (they appear in
+ * diagnostics), the command-line flags and the identity of the compiler
+ * executable itself. Turned on with --cache-dir <dir>; --cache-size caps
+ * the total size of the directory (default 100M).
+ *
+ * The store is a plain directory that any number of dcc processes may
+ * share. Each entry is one file under a subdirectory named by the first
+ * hex digit of its key. Entries are written to a temporary file and
+ * renamed into place, so readers never see a partial entry. Every hit
+ * refreshes the entry's modification time, and when a subdirectory grows
+ * past its share of the size cap the least recently used entries in it
+ * are removed.
+ */
+
+#ifndef _H_cache
+#define _H_cache
+
+#include <string>
+
+struct CompileResult {
+    int status;
+    std::string out, err;
+};
+
+class CompileCache
+{
+  protected:
+    std::string dir;
+    long long maxSize;
+
+    std::string PathForKey(const std::string &key, std::string *subdir);
+    void Trim(const std::string &subdir, const std::string &keep);
+
+  public:
+    CompileCache(const char *dir, long long maxSize);
+
+    // Returns the key for compiling the current command line's inputs
+    // (or the given stdin text when there are none) with its flags, or
+    // the empty string if some input cannot be read.
+    std::string KeyForCompilation(const std::string &stdinText);
+
+    bool Lookup(const std::string &key, CompileResult *result);
+    void Store(const std::string &key, const CompileResult &result);
+
+    // Parses sizes such as "500K", "100M" or "2G"; returns -1 if invalid.
+    static long long ParseSize(const char *str);
+};
+
+#endif
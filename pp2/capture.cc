@@ -0,0 +1,39 @@
+/* File: capture.cc
+ * ----------------
+ * Implementation of output capture.
+ */
+
+#include "capture.h"
+#include <unistd.h>
+#include "wire.h"    // for ReadAll
+#include "utility.h" // for Assert
+
+OutputCapture::OutputCapture()
+{
+    fflush(stdout);
+    fflush(stderr);
+    for (int fd = 1; fd <= 2; fd++) {
+        files[fd-1] = tmpfile();
+        savedFds[fd-1] = dup(fd);
+        Assert(files[fd-1] != NULL && savedFds[fd-1] >= 0);
+        dup2(fileno(files[fd-1]), fd);
+    }
+}
+
+void OutputCapture::Finish(std::string *out, std::string *err)
+{
+    std::string *results[2] = { out, err };
+    if (!files[0]) return;
+    fflush(stdout);
+    fflush(stderr);
+    for (int fd = 1; fd <= 2; fd++) {
+        dup2(savedFds[fd-1], fd);
+        close(savedFds[fd-1]);
+        if (results[fd-1]) {
+            lseek(fileno(files[fd-1]), 0, SEEK_SET);
+            ReadAll(fileno(files[fd-1]), results[fd-1]);
+        }
+        fclose(files[fd-1]);
+        files[fd-1] = NULL;
+    }
+}
@@ -0,0 +1,35 @@
+/* File: capture.h
+ * ---------------
+ * Support for collecting everything a compilation prints. Used by the
+ * compile server to send the output back to its client and by the
+ * compilation cache to store it.
+ */
+
+#ifndef _H_capture
+#define _H_capture
+
+#include <stdio.h>
+#include <string>
+
+/* Class: OutputCapture
+ * --------------------
+ * Redirects file descriptors 1 and 2 into temporary files for the
+ * lifetime of the object, so that everything written to stdout and stderr
+ * (with printf, cerr or otherwise) is collected. Captures may be nested;
+ * each one restores the descriptors that were in place when it started.
+ */
+class OutputCapture
+{
+  private:
+    FILE *files[2];
+    int savedFds[2];
+
+  public:
+    OutputCapture();
+    ~OutputCapture() { Finish(NULL, NULL); }
+
+    // Restores the original descriptors and returns what was captured.
+    void Finish(std::string *out, std::string *err);
+};
+
+#endif
@@ -0,0 +1,117 @@
+/* File: client.cc
+ * ---------------
+ * The dcc-client program is a drop-in replacement for dcc that hands the
+ * compilation to a running compile server (see server.h). It takes the
+ * same arguments as dcc, finds the server through the DCC_SERVER
+ * environment variable, and reproduces the server's stdout, stderr and
+ * exit status as its own. Its stdin goes along with the request when the
+ * server needs it: as the source when no file is named, and as the
+ * program's input when it is run. If DCC_SERVER is not set or no server
+ * answers, it runs the dcc found next to itself instead, so builds keep
+ * working without a server.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <string>
+#include "wire.h"
+
+
+/* Function: ConnectToServer()
+ * ---------------------------
+ * Returns a socket connected to the server named by DCC_SERVER, or -1.
+ */
+static int ConnectToServer()
+{
+    const char *path = getenv("DCC_SERVER");
+    struct sockaddr_un addr;
+    if (!path || strlen(path) >= sizeof(addr.sun_path)) return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+
+/* Function: RunLocalCompiler()
+ * ----------------------------
+ * Replaces this process with the dcc that lives in the same directory
+ * as the client.
+ */
+static void RunLocalCompiler(char *argv[])
+{
+    std::string dir = ".";
+    const char *slash = strrchr(argv[0], '/');
+    if (slash) dir.assign(argv[0], slash - argv[0]);
+    std::string compiler = dir + "/dcc";
+    argv[0] = (char *)"dcc";
+    execv(compiler.c_str(), argv);
+    fprintf(stderr, "dcc-client: cannot run %s\n", compiler.c_str());
+    exit(2);
+}
+
+
+/* Function: NamesInputFile()
+ * --------------------------
+ * Mirrors the rule dcc uses to tell input files from other arguments.
+ */
+static bool NamesInputFile(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++) {
+        size_t len = strlen(argv[i]);
+        if (len > 6 && !strcmp(argv[i] + len - 6, ".decaf")) return true;
+    }
+    return false;
+}
+
+
+/* Function: RunsProgram()
+ * -----------------------
+ * Whether the command line asks for the program to be run, with
+ * --interpret or --run, in which case it reads its input from stdin.
+ */
+static bool RunsProgram(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++)
+        if (!strcmp(argv[i], "--interpret") || !strcmp(argv[i], "--run")) return true;
+    return false;
+}
+
+
+int main(int argc, char *argv[])
+{
+    int fd = ConnectToServer();
+    if (fd < 0) RunLocalCompiler(argv);
+
+    char cwd[PATH_MAX];
+    std::string input;
+    if (!getcwd(cwd, sizeof(cwd))) RunLocalCompiler(argv);
+    if (!NamesInputFile(argc, argv) || RunsProgram(argc, argv)) ReadAll(0, &input);
+
+    bool sent = WriteField(fd, cwd) && WriteField(fd, input);
+    for (int i = 1; sent && i < argc; i++)
+        sent = WriteField(fd, argv[i]);
+    sent = sent && WriteField(fd, "");
+
+    std::string status, out, err;
+    if (!sent || !ReadField(fd, &status) || !ReadField(fd, &out) ||
+        !ReadField(fd, &err)) {
+        fprintf(stderr, "dcc-client: lost connection to the compile server\n");
+        return 2;
+    }
+    fwrite(out.data(), 1, out.size(), stdout);
+    fflush(stdout);
+    fwrite(err.data(), 1, err.size(), stderr);
+    return atoi(status.c_str());
+}
@@ -0,0 +1,275 @@
+/* File: codegen.cc
+ * ----------------
+ * Implementation of the CodeGenerator class.
+ */
+
+#include "codegen.h"
+#include <string.h>
+#include "ast_decl.h"
+#include "ast_type.h"
+#include "errors.h"
+#include "interp.h"
+#include "utility.h"
+
+static const int MaxRegs = 65536;     // registers are 16-bit operands
+static const int MaxShortTarget = 65535;
+
+
+CodeGenerator::CodeGenerator(BcProgram *p)
+{
+    program = p;
+    fn = NULL;
+    firstTemp = nextTemp = maxTemp = 0;
+    lastLabelPos = -1;
+}
+
+void CodeGenerator::BeginFunction(FnDecl *decl)
+{
+    BeginFunction(decl, decl->GetFrameSize());
+}
+
+void CodeGenerator::BeginFunction(FnDecl *decl, int numRegs)
+{
+    Assert(fn == NULL);
+    fn = new BcFunction;
+    fn->decl = decl;
+    fn->name = decl->GetName();
+    fn->numParams = decl->GetFormals()->NumElements() + (decl->IsMethod() ? 1 : 0);
+    fn->returnZero = Interpreter::ZeroOf(decl->GetReturnType());
+    firstTemp = nextTemp = maxTemp = numRegs;
+    code.clear();
+    labels.clear();
+    jumps.clear();
+    breakLabels.clear();
+    tables.clear();
+    lastLabelPos = -1;
+}
+
+/* Function: EndFunction()
+ * -----------------------
+ * Patches the jumps and jump tables now that all labels are placed, and
+ * completes the function with its code and registers. Each call that
+ * looks up its method is given an inline cache of its own, numbered in
+ * order: the method moves from operand b into the cache, and b becomes
+ * the cache's number. A function too big for the bytecode to express is
+ * reported as an error, and its code must not be run.
+ */
+BcFunction *CodeGenerator::EndFunction()
+{
+    for (size_t i = 0; i < jumps.size(); i++) {
+        Instr &in = code[jumps[i]];
+        if (IsCompareJump(in.op)) {
+            Assert(labels[in.c] >= 0);
+            if (labels[in.c] > MaxShortTarget) {
+                // nor this; a Decaf function would need 64K instructions
+                ReportError::Formatted(NULL, "Function %s is too long", fn->name);
+                continue;
+            }
+            in.c = labels[in.c];
+        } else {
+            Assert(labels[in.Target()] >= 0);
+            in.SetTarget(labels[in.Target()]);
+        }
+    }
+    for (size_t t = 0; t < tables.size(); t += 2 + tables[t+1]) {
+        for (int i = 0; i < tables[t+1]; i++) {
+            int &entry = tables[t+2+i];
+            Assert(labels[entry] >= 0);
+            entry = labels[entry];
+        }
+    }
+    fn->numTables = tables.size();
+    fn->tables = NULL;
+    if (!tables.empty()) {
+        fn->tables = new int[tables.size()];
+        memcpy(fn->tables, &tables[0], tables.size() * sizeof(int));
+    }
+    int numCaches = 0;
+    for (size_t i = 0; i < code.size(); i++) {
+        if (code[i].op == OpCallVirtual || code[i].op == OpCallInterface)
+            numCaches++;
+    }
+    fn->caches = NULL;
+    if (numCaches > 0x10000) {      // numbered in 16-bit operands
+        ReportError::Formatted(NULL, "Function %s makes too many calls", fn->name);
+    } else if (numCaches > 0) {
+        fn->caches = new InlineCache[numCaches]();
+        for (size_t i = 0, n = 0; i < code.size(); i++) {
+            if (code[i].op == OpCallVirtual || code[i].op == OpCallInterface) {
+                fn->caches[n].method = code[i].b;
+                code[i].b = n++;
+            }
+        }
+    }
+    fn->codeSize = code.size();
+    fn->hotness = 0;
+    fn->native = NULL;
+    fn->nativeOffsets = NULL;
+    fn->code = new Instr[code.size()];
+    memcpy(fn->code, &code[0], code.size() * sizeof(Instr));
+
+    FnDecl *decl = fn->decl;
+    if (maxTemp > MaxRegs) {
+        // a function this big cannot be expressed; it should never happen
+        ReportError::Formatted(NULL, "Function %s needs too many registers", fn->name);
+    }
+    fn->numRegs = maxTemp;
+    fn->regInit = new Value[maxTemp + 1];
+    int numInit = decl->GetFrameSize() < maxTemp ? decl->GetFrameSize() : maxTemp;
+    memcpy(fn->regInit, decl->GetFrameInit(), numInit * sizeof(Value));
+    for (int i = numInit; i < maxTemp; i++)
+        fn->regInit[i] = MakeVoid();
+    fn->regKinds = NULL;
+
+    BcFunction *result = fn;
+    fn = NULL;
+    return result;
+}
+
+
+int CodeGenerator::NewTemp()
+{
+    return NewTemps(1);
+}
+
+int CodeGenerator::NewTemps(int n)
+{
+    int first = nextTemp;
+    nextTemp += n;
+    if (nextTemp > maxTemp) maxTemp = nextTemp;
+    return first;
+}
+
+
+int CodeGenerator::NewLabel()
+{
+    labels.push_back(-1);
+    return labels.size() - 1;
+}
+
+void CodeGenerator::PlaceLabel(int label)
+{
+    labels[label] = code.size();
+    lastLabelPos = code.size();
+}
+
+
+void CodeGenerator::Gen(opcodeT op, int a, int b, int c)
+{
+    Instr in;
+    in.op = op;
+    in.a = a;
+    in.b = b;
+    in.c = c;
+    code.push_back(in);
+}
+
+/* Until EndFunction, a jump's target holds the label rather than the
+ * position it stands for. */
+void CodeGenerator::GenJump(opcodeT op, int label, int reg)
+{
+    Instr in;
+    in.op = op;
+    in.a = reg;
+    in.SetTarget(label);
+    jumps.push_back(code.size());
+    code.push_back(in);
+}
+
+/* Until EndFunction, the table's entries hold labels rather than the
+ * positions they stand for. */
+void CodeGenerator::GenJumpTable(int reg, int low, const std::vector<int> &targets)
+{
+    Instr in;
+    in.op = OpJumpTable;
+    in.a = reg;
+    in.SetTarget(tables.size());
+    code.push_back(in);
+    tables.push_back(low);
+    tables.push_back(targets.size());
+    tables.insert(tables.end(), targets.begin(), targets.end());
+}
+
+/* Function: GenBranch()
+ * ---------------------
+ * A negation is dropped by testing its operand the other way round, and
+ * an int comparison and the jump on its result become a single JumpIf
+ * ...Int, its operands in a and b and the label in c (which is why
+ * EndFunction checks that every such target fits 16 bits). Comparing
+ * ints, "not less than" is exactly "greater or equal".
+ */
+void CodeGenerator::GenBranch(opcodeT op, int label, int cond)
+{
+    static const struct { opcodeT compare, ifTrue, ifFalse; } fused[] = {
+        { OpLessInt, OpJumpIfLessInt, OpJumpIfGreaterEqualInt },
+        { OpLessEqualInt, OpJumpIfLessEqualInt, OpJumpIfGreaterInt },
+        { OpGreaterInt, OpJumpIfGreaterInt, OpJumpIfLessEqualInt },
+        { OpGreaterEqualInt, OpJumpIfGreaterEqualInt, OpJumpIfLessInt },
+        { OpEqualInt, OpJumpIfEqualInt, OpJumpIfNotEqualInt },
+        { OpNotEqualInt, OpJumpIfNotEqualInt, OpJumpIfEqualInt },
+    };
+    Assert(op == OpJumpIf || op == OpJumpIfNot);
+    while (CanRewriteLast(cond) && code.back().op == OpNotBool) {
+        cond = code.back().b;
+        op = op == OpJumpIf ? OpJumpIfNot : OpJumpIf;
+        code.pop_back();
+    }
+    if (CanRewriteLast(cond) && label <= MaxShortTarget) {
+        Instr last = code.back();
+        for (size_t i = 0; i < sizeof(fused) / sizeof(fused[0]); i++) {
+            if (last.op == fused[i].compare) {
+                code.pop_back();
+                jumps.push_back(code.size());
+                Gen(op == OpJumpIf ? fused[i].ifTrue : fused[i].ifFalse, last.b, last.c, label);
+                return;
+            }
+        }
+    }
+    GenJump(op, label, cond);
+}
+
+void CodeGenerator::GenLoadInt(int dst, int value)
+{
+    if (FitsImmediate(value))
+        Gen(OpLoadInt, dst, (unsigned short)value);
+    else
+        GenLoadConst(dst, MakeInt(value));
+}
+
+void CodeGenerator::GenLoadConst(int dst, Value v)
+{
+    Gen(OpLoadConst, dst, program->AddConstant(v));
+}
+
+/* Function: CanRewriteLast()
+ * ---------------------------
+ * Whether the last instruction computed the temporary reg, and so can be
+ * changed to compute something else, or dropped, when reg is not needed
+ * afterwards. It cannot be if control can also arrive after it by a
+ * jump, or if it does not write its operand a.
+ */
+bool CodeGenerator::CanRewriteLast(int reg)
+{
+    if (!IsTemp(reg) || code.empty() || lastLabelPos == (int)code.size())
+        return false;
+    const Instr &last = code.back();
+    switch (last.op) {
+      case OpStoreGlobal: case OpSetField: case OpSetElem: case OpSetElemConst:
+      case OpSetElemUnchecked: case OpSetElemConstUnchecked:
+      case OpJump: case OpJumpIf: case OpJumpIfNot: case OpJumpTable:
+      case OpReturn: case OpReturnVoid:
+      case OpPrintInt: case OpPrintBool: case OpPrintString: case OpMapElems:
+        return false;
+      default:
+        return !IsCompareJump(last.op) && last.a == reg;
+    }
+}
+
+void CodeGenerator::GenMoveResult(int dst, int src)
+{
+    if (dst == src) return;
+    if (CanRewriteLast(src))
+        code.back().a = dst;
+    else
+        Gen(OpMove, dst, src);
+}
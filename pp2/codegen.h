@@ -0,0 +1,85 @@
+/* File: codegen.h
+ * ---------------
+ * The CodeGenerator is the helper the Emit methods of the AST nodes use
+ * to lower a checked program to bytecode (see bytecode.h). It collects
+ * the code of the function being generated, hands out registers for
+ * temporaries, and resolves jumps to labels once their targets are known.
+ *
+ * Temporaries are handed out like a stack, above the registers of the
+ * frame's slots: an expression gets the next free register for each
+ * value it computes, and a statement gives back all the temporaries its
+ * expressions took once it is done. So a function needs only as many
+ * registers as its most demanding statement.
+ */
+
+#ifndef _H_codegen
+#define _H_codegen
+
+#include <vector>
+#include "bytecode.h"
+
+class FnDecl;
+
+class CodeGenerator
+{
+  private:
+    BcProgram *program;
+    BcFunction *fn;                 // the function being generated
+    std::vector<Instr> code;
+    int firstTemp, nextTemp, maxTemp;
+    std::vector<int> labels;        // the position of each label, or -1
+    std::vector<int> jumps;         // positions of jumps to labels
+    std::vector<int> breakLabels;   // innermost loop or switch last
+    std::vector<int> tables;        // of JumpTables, labels for positions
+    int lastLabelPos;               // where a label was last placed
+
+    bool CanRewriteLast(int reg);
+
+  public:
+    CodeGenerator(BcProgram *program);
+    BcProgram *GetProgram() { return program; }
+
+    void BeginFunction(FnDecl *decl);
+    // The same, for code that has already assigned the function's
+    // registers below numRegs itself (see taclower.h); temporaries are
+    // handed out above them.
+    void BeginFunction(FnDecl *decl, int numRegs);
+    BcFunction *EndFunction();
+
+    // A fresh register for a temporary.
+    int NewTemp();
+    // n consecutive fresh registers, e.g. for the arguments of a call;
+    // returns the first.
+    int NewTemps(int n);
+    bool IsTemp(int reg) { return reg >= firstTemp; }
+    // Temporaries are given back by resetting to an earlier mark.
+    int GetTempMark() { return nextTemp; }
+    void FreeTemps(int mark) { nextTemp = mark; }
+
+    int NewLabel();
+    void PlaceLabel(int label);
+    void PushBreakLabel(int label) { breakLabels.push_back(label); }
+    void PopBreakLabel() { breakLabels.pop_back(); }
+    int GetBreakLabel() { return breakLabels.back(); }
+
+    void Gen(opcodeT op, int a = 0, int b = 0, int c = 0);
+    void GenJump(opcodeT op, int label, int reg = 0);
+    // Jumps to label if cond is true (op JumpIf) or false (JumpIfNot),
+    // for a test whose value is not needed afterwards: a negation or an
+    // int comparison just computed into cond is folded into the jump.
+    void GenBranch(opcodeT op, int label, int cond);
+    // Jumps to the label targets[v - low] if reg holds a value v with
+    // such an entry, and otherwise on to the next instruction.
+    void GenJumpTable(int reg, int low, const std::vector<int> &targets);
+    void GenMove(int dst, int src) { if (dst != src) Gen(OpMove, dst, src); }
+    // Moves the value an expression has just computed into dst, when src
+    // is not needed afterwards. If the last instruction computed it into
+    // a temporary, that instruction is made to compute it into dst.
+    void GenMoveResult(int dst, int src);
+    // Loads an int into dst, from the constant pool if it must be.
+    void GenLoadInt(int dst, int value);
+    void GenLoadConst(int dst, Value v);
+    static bool FitsImmediate(int value) { return value >= -32768 && value < 32768; }
+};
+
+#endif
@@ -0,0 +1,342 @@
+/* File: cwriter.cc
+ * ----------------
+ * Implementation of the CWriter class.
+ */
+
+#include "cwriter.h"
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+#include "ast_decl.h"
+#include "ast_type.h"
+#include "interp.h"
+#include "utility.h"
+
+
+/* The runtime
+ * -----------
+ * Runtime errors, the checks that raise them, and the built-ins, all
+ * behaving as their counterparts in interp.cc do.
+ */
+static const char *runtime[] = {
+    "#define _POSIX_C_SOURCE 200809L",
+    "#include <stdio.h>",
+    "#include <stdlib.h>",
+    "#include <string.h>",
+    "#include <stdbool.h>",
+    "#include <math.h>",
+    "",
+    "typedef void (*dc_fn)(void);",
+    "typedef struct dc_class {",
+    "    const char *name;",
+    "    const dc_fn *vtable;",
+    "    dc_fn (*lookup)(int method);",
+    "} dc_class;",
+    "typedef struct dc_obj { const dc_class *cls; } dc_obj;",
+    "typedef struct dc_arr { int length; double data[]; } dc_arr;",
+    "",
+    "static int dc_depth;",
+    "",
+    "static void dc_halt(const char *msg)",
+    "{",
+    "    printf(\"Decaf runtime error: %s\\n\", msg);",
+    "    exit(1);",
+    "}",
+    "",
+    "static void dc_enter(void)",
+    "{",
+    "    if (++dc_depth > DC_MAX_DEPTH) dc_halt(\"Stack overflow\");",
+    "}",
+    "",
+    "static void *dc_check(void *p)",
+    "{",
+    "    if (!p) dc_halt(\"Null object reference\");",
+    "    return p;",
+    "}",
+    "",
+    "static dc_arr *dc_index(dc_arr *a, int i)",
+    "{",
+    "    if (!a) dc_halt(\"Null object reference\");",
+    "    if (i < 0 || i >= a->length) dc_halt(\"Array subscript out of bounds\");",
+    "    return a;",
+    "}",
+    "#define DC_ELEM(T, a, i) (((T *)dc_index(a, i)->data)[i])",
+    "",
+    "static int dc_length(dc_arr *a)",
+    "{",
+    "    return ((dc_arr *)dc_check(a))->length;",
+    "}",
+    "",
+    "static void *dc_alloc(size_t size)",
+    "{",
+    "    void *p = calloc(1, size);",
+    "    if (!p) dc_halt(\"Out of memory\");",
+    "    return p;",
+    "}",
+    "",
+    "static dc_arr *dc_new_array(int length, size_t elemSize, bool isString)",
+    "{",
+    "    if (length <= 0) dc_halt(\"Array size is <= 0\");",
+    "    dc_arr *a = dc_alloc(sizeof(dc_arr) + (size_t)length * elemSize);",
+    "    a->length = length;",
+    "    if (isString)",
+    "        for (int i = 0; i < length; i++) ((const char **)a->data)[i] = \"\";",
+    "    return a;",
+    "}",
+    "",
+    "static dc_fn dc_lookup(dc_obj *o, int method)",
+    "{",
+    "    return o->cls->lookup(method);",
+    "}",
+    "",
+    "static int dc_div(int a, int b)",
+    "{",
+    "    if (b == 0) dc_halt(\"Division by zero\");",
+    "    return b == -1 ? (int)-(unsigned)a : a / b;",
+    "}",
+    "",
+    "static int dc_mod(int a, int b)",
+    "{",
+    "    if (b == 0) dc_halt(\"Division by zero\");",
+    "    return b == -1 ? 0 : a % b;",
+    "}",
+    "",
+    "static const char *dc_read_line(void)",
+    "{",
+    "    char *buf = NULL;",
+    "    size_t cap = 0;",
+    "    ssize_t n = getline(&buf, &cap, stdin);",
+    "    if (n <= 0) {",
+    "        free(buf);",
+    "        return \"\";",
+    "    }",
+    "    if (buf[n-1] == '\\n') buf[n-1] = '\\0';",
+    "    return buf;",
+    "}",
+    "",
+    "static int dc_read_integer(void)",
+    "{",
+    "    return (int)strtol(dc_read_line(), NULL, 10);",
+    "}",
+    "",
+};
+
+
+CWriter::CWriter(FILE *o)
+{
+    out = o;
+    fn = NULL;
+    indent = 0;
+}
+
+void CWriter::Write(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vfprintf(out, format, args);
+    va_end(args);
+}
+
+void CWriter::WriteRuntime()
+{
+    Write("#define DC_MAX_DEPTH %d\n", Interpreter::MaxDepth);
+    for (size_t i = 0; i < sizeof(runtime) / sizeof(runtime[0]); i++)
+        Write("%s\n", runtime[i]);
+}
+
+
+void CWriter::BeginFunction(FnDecl *decl)
+{
+    Assert(fn == NULL);
+    fn = decl;
+    body.clear();
+    tempTypes.clear();
+    indent = 1;
+}
+
+/* Function: EndFunction()
+ * -----------------------
+ * Writes out the function, declaring its locals, which start out with
+ * their types' zero values, and the temporaries the body needed, and
+ * making it return the zero value if control falls off the end.
+ */
+void CWriter::EndFunction()
+{
+    Write("%s\n{\n", Prototype(fn).c_str());
+    int first = fn->IsMethod() ? 1 : 0;
+    for (int i = first + fn->GetFormals()->NumElements(); i < fn->GetFrameSize(); i++) {
+        Type *t = fn->GetSlotType(i);
+        Write("    %s = %s;\n", Declaration(t, Local(i)).c_str(), ZeroOf(t).c_str());
+    }
+    for (size_t i = 0; i < tempTypes.size(); i++)
+        Write("    %s;\n", Declaration(tempTypes[i], Format("t%d", (int)i)).c_str());
+    Write("    dc_enter();\n%s", body.c_str());
+    Type *rt = fn->GetReturnType();
+    if (rt == Type::voidType)
+        Write("    dc_depth--;\n}\n\n");
+    else
+        Write("    dc_depth--;\n    return %s;\n}\n\n", ZeroOf(rt).c_str());
+    fn = NULL;
+}
+
+
+void CWriter::Line(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    std::vector<char> buf(n + 1);
+    va_start(args, format);
+    vsnprintf(&buf[0], n + 1, format, args);
+    va_end(args);
+    body.append(4 * indent, ' ');
+    body.append(&buf[0], n);
+    body.push_back('\n');
+}
+
+
+std::string CWriter::NewTemp(Type *type)
+{
+    tempTypes.push_back(type);
+    return Format("t%d", (int)tempTypes.size() - 1);
+}
+
+bool CWriter::IsVariable(const std::string &operand)
+{
+    return operand.size() > 1 && operand[0] == 'v' && isdigit(operand[1]);
+}
+
+std::string CWriter::Protect(const std::string &operand, Type *type, bool mustCopy)
+{
+    if (!mustCopy || !IsVariable(operand)) return operand;
+    std::string copy = NewTemp(type);
+    Line("%s = %s;", copy.c_str(), operand.c_str());
+    return copy;
+}
+
+
+int CWriter::InterfaceMethod(const char *name)
+{
+    for (size_t i = 0; i < interfaceMethods.size(); i++)
+        if (!strcmp(interfaceMethods[i], name)) return i;
+    interfaceMethods.push_back(name);
+    return interfaceMethods.size() - 1;
+}
+
+
+/* Objects of every class, and of interfaces, are handled as dc_obj, and
+ * arrays of every type as dc_arr. */
+std::string CWriter::TypeName(Type *type)
+{
+    if (type == Type::intType) return "int";
+    if (type == Type::doubleType) return "double";
+    if (type == Type::boolType) return "bool";
+    if (type == Type::stringType) return "const char *";
+    if (type == Type::voidType) return "void";
+    if (dynamic_cast<ArrayType*>(type)) return "dc_arr *";
+    return "dc_obj *";
+}
+
+std::string CWriter::Declaration(Type *type, const std::string &name)
+{
+    std::string s = TypeName(type);
+    return s[s.size() - 1] == '*' ? s + name : s + " " + name;
+}
+
+std::string CWriter::ZeroOf(Type *type)
+{
+    if (type == Type::intType) return "0";
+    if (type == Type::doubleType) return "0.0";
+    if (type == Type::boolType) return "false";
+    if (type == Type::stringType) return "\"\"";
+    return "NULL";
+}
+
+std::string CWriter::FunctionName(FnDecl *decl)
+{
+    return Format("F%d_%s", decl->GetCodeIndex(), decl->GetName());
+}
+
+std::string CWriter::FunctionType(FnDecl *decl, bool method)
+{
+    std::string s = TypeName(decl->GetReturnType()) + " (*)(";
+    List<VarDecl*> *formals = decl->GetFormals();
+    if (method) s += "dc_obj *";
+    for (int i = 0; i < formals->NumElements(); i++) {
+        if (i > 0 || method) s += ", ";
+        s += TypeName(formals->Nth(i)->GetType());
+    }
+    if (!method && formals->NumElements() == 0) s += "void";
+    return s + ")";
+}
+
+/* The receiver of a method is self; the formals are locals, named by
+ * their slots like the rest. */
+std::string CWriter::Prototype(FnDecl *decl)
+{
+    std::string s = "static " + Declaration(decl->GetReturnType(), FunctionName(decl)) + "(";
+    List<VarDecl*> *formals = decl->GetFormals();
+    if (decl->IsMethod()) s += "dc_obj *self";
+    for (int i = 0; i < formals->NumElements(); i++) {
+        VarDecl *formal = formals->Nth(i);
+        if (i > 0 || decl->IsMethod()) s += ", ";
+        s += Declaration(formal->GetType(), Local(formal->GetOffset()));
+    }
+    if (!decl->IsMethod() && formals->NumElements() == 0) s += "void";
+    return s + ")";
+}
+
+std::string CWriter::StructName(ClassDecl *cls)
+{
+    return Format("struct C_%s", cls->GetName());
+}
+
+std::string CWriter::Local(int slot)
+{
+    return Format("v%d", slot);
+}
+
+std::string CWriter::Global(VarDecl *var)
+{
+    return Format("g_%s", var->GetName());
+}
+
+std::string CWriter::Field(VarDecl *var)
+{
+    return Format("f%d_%s", var->GetOffset(), var->GetName());
+}
+
+/* Characters other than printable ASCII are written as three-digit octal
+ * escapes, which cannot run on into a digit following them. */
+std::string CWriter::Quote(const char *text)
+{
+    std::string s = "\"";
+    for (const unsigned char *p = (const unsigned char *)text; *p; p++) {
+        switch (*p) {
+          case '"':  s += "\\\""; break;
+          case '\\': s += "\\\\"; break;
+          case '\n': s += "\\n"; break;
+          case '\t': s += "\\t"; break;
+          case '?':  s += "\\?"; break;    // no trigraphs
+          default:
+            if (*p >= ' ' && *p < 0x7f) s += *p;
+            else s += Format("\\%03o", *p);
+            break;
+        }
+    }
+    return s + "\"";
+}
+
+std::string CWriter::Format(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    std::vector<char> buf(n + 1);
+    va_start(args, format);
+    vsnprintf(&buf[0], n + 1, format, args);
+    va_end(args);
+    return std::string(&buf[0], n);
+}
@@ -0,0 +1,105 @@
+/* File: cwriter.h
+ * ---------------
+ * The CWriter is the helper the EmitC methods of the AST nodes use to
+ * translate a checked program to C, for the system's C compiler to turn
+ * into an executable (dcc -emit-c and dcc -o). It plays the part the
+ * CodeGenerator (codegen.h) plays for bytecode: it collects the code of
+ * the function being written and hands out its temporaries.
+ *
+ * The C follows the interpreter's semantics exactly, runtime errors
+ * included, with the help of a small runtime written out at the top of
+ * every translation unit:
+ *
+ *  - ints, doubles and bools are C's; int arithmetic is done unsigned,
+ *    so that it wraps as it does in the interpreter. Strings are
+ *    const char *, never NULL.
+ *  - An object is a struct of its class (C_<name>) holding a pointer to
+ *    the class's descriptor, then its fields, inherited ones first, so a
+ *    pointer to it can be used as one to any of its superclasses. The
+ *    descriptor has the vtable, and a function that finds a method
+ *    called through an interface by its name's number.
+ *  - An array is a length followed by its elements.
+ *
+ * Every expression is lowered to a sequence of statements, each
+ * computing a value into a temporary (t<n>), and EmitCValue gives back
+ * the operand holding the value: a temporary, a literal, or a local
+ * variable (v<slot>), which the same caveat applies to as to registers
+ * in codegen.h. All of a function's locals and temporaries are declared
+ * at its top, since a Decaf local keeps its value across the iterations
+ * of the loop it is declared in.
+ */
+
+#ifndef _H_cwriter
+#define _H_cwriter
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+class FnDecl;
+class ClassDecl;
+class VarDecl;
+class Type;
+
+class CWriter
+{
+  private:
+    FILE *out;
+    FnDecl *fn;                     // the function being written
+    std::string body;
+    std::vector<Type*> tempTypes;
+    int indent;
+    std::vector<const char*> interfaceMethods;  // by number
+
+  public:
+    CWriter(FILE *out);
+
+    // Writes text outside any function.
+    void Write(const char *format, ...) __attribute__((format(printf, 2, 3)));
+    // Writes the runtime every program starts with.
+    void WriteRuntime();
+
+    void BeginFunction(FnDecl *decl);
+    void EndFunction();
+
+    // Adds a statement to the function being written, at the current
+    // depth of nesting, which Indent and Outdent change.
+    void Line(const char *format, ...) __attribute__((format(printf, 2, 3)));
+    void Indent() { indent++; }
+    void Outdent() { indent--; }
+
+    // A fresh temporary of the given type.
+    std::string NewTemp(Type *type);
+    // Whether the operand names a local variable, whose value can change
+    // before it is used (see HasAssignment in ast_expr.h).
+    static bool IsVariable(const std::string &operand);
+    // The operand itself, or a copy of it if it is a variable and
+    // mustCopy is set.
+    std::string Protect(const std::string &operand, Type *type, bool mustCopy);
+
+    // The number of a method name called through interfaces, by which a
+    // class's lookup function finds its method.
+    int InterfaceMethod(const char *name);
+    int NumInterfaceMethods() { return interfaceMethods.size(); }
+    const char *GetInterfaceMethod(int n) { return interfaceMethods[n]; }
+
+    // Names and types as they appear in the C.
+    static std::string TypeName(Type *type);
+    // A declaration of name as being of the type.
+    static std::string Declaration(Type *type, const std::string &name);
+    static std::string ZeroOf(Type *type);
+    static std::string FunctionName(FnDecl *decl);
+    // The type of a pointer to the function, with a receiver if it is
+    // called as a method.
+    static std::string FunctionType(FnDecl *decl, bool method);
+    static std::string Prototype(FnDecl *decl);
+    static std::string StructName(ClassDecl *cls);
+    static std::string Local(int slot);
+    static std::string Global(VarDecl *var);
+    static std::string Field(VarDecl *var);
+    // A C string literal for the text.
+    static std::string Quote(const char *text);
+    static std::string Format(const char *format, ...) __attribute__((format(printf, 1, 2)));
+};
+
+#endif
@@ -0,0 +1,492 @@
+/* File: driver.cc
+ * ---------------
+ * Implementation of the compilation driver.
+ */
+
+#include "driver.h"
+#include <string.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "utility.h"
+#include "errors.h"
+#include "parser.h"
+#include "cache.h"
+#include "capture.h"
+#include "timer.h"
+#include "bytecode.h"
+#include "vm.h"
+#include "gc.h"
+#include "tac.h"
+#include "opt.h"
+#include "taclower.h"
+
+extern List<const char*> savedLines;   // the scanner's copy of the input
+
+
+/* Parse cache
+ * -----------
+ * Parse trees of error-free files, keyed by the file's absolute path and
+ * validated against its size and modification time. The cached trees are
+ * handed out again as is; Program re-parents the declarations each time
+ * it is built from them. A tree that goes on to be checked is dropped
+ * from the cache, as the check and constant folding change it in place
+ * (see ForgetParsesInUse).
+ */
+struct ParsedFile {
+    const char *path;
+    off_t size;
+    struct timespec mtime;
+    List<Decl*> *decls;
+    List<const char*> *lines;
+};
+
+static bool parseCacheEnabled = false;
+static List<ParsedFile*> parseCache;
+static List<ParsedFile*> parsesInUse;     // by the current compilation
+
+void SetParseCacheEnabled(bool enabled)
+{
+    parseCacheEnabled = enabled;
+}
+
+static ParsedFile *LookupParsedFile(const char *path)
+{
+    for (int i = 0; i < parseCache.NumElements(); i++)
+        if (!strcmp(parseCache.Nth(i)->path, path)) return parseCache.Nth(i);
+    return NULL;
+}
+
+/* Function: ForgetParsesInUse()
+ * ------------------------------
+ * Drops the trees the current compilation took from the cache or put
+ * in it, once it is about to change them: a later compilation must
+ * parse those files again rather than see a checked and folded tree.
+ */
+static void ForgetParsesInUse()
+{
+    for (int i = 0; i < parsesInUse.NumElements(); i++) {
+        ParsedFile *pf = parsesInUse.Nth(i);
+        for (int j = 0; j < parseCache.NumElements(); j++) {
+            if (parseCache.Nth(j) == pf) {
+                parseCache.RemoveAt(j);
+                free((char *)pf->path);
+                delete pf;
+                break;
+            }
+        }
+    }
+    parsesInUse = List<ParsedFile*>();
+}
+
+static bool IsUnchanged(ParsedFile *pf, const struct stat &st)
+{
+    return pf->size == st.st_size &&
+           pf->mtime.tv_sec == st.st_mtim.tv_sec &&
+           pf->mtime.tv_nsec == st.st_mtim.tv_nsec;
+}
+
+
+/* Function: AppendDecls()
+ * -----------------------
+ * Adds all elements of one declaration list to the end of another.
+ */
+static void AppendDecls(List<Decl*> *decls, List<Decl*> *more)
+{
+    for (int i = 0; i < more->NumElements(); i++)
+        decls->Append(more->Nth(i));
+}
+
+
+/* Function: ParseStream()
+ * -----------------------
+ * Scans and parses one input and returns its top-level declarations, or
+ * NULL if the parse did not complete. Inputs are parsed one at a time,
+ * on the calling thread, each from a freshly reset scanner: the scanner
+ * and parser generated by lex and yacc keep their state in globals (the
+ * flex buffer stack, yytext, yylval, yylloc, the saved lines), as do the
+ * error count and the pool string literals are interned in, so they
+ * cannot be run on several threads at once. Parsing takes time linear
+ * in the input, about a third of -emit-tac's on a large program, and
+ * diagnostics come out grouped by file, in command-line order.
+ */
+static List<Decl*> *ParseStream(FILE *fp)
+{
+    PhaseScope scope("parse");
+    yyrestart(fp);
+    InitScanner();
+    InitParser();
+    {
+        TRACE_ZONE("yyparse");
+        yyparse();
+    }
+    return parsedDecls;
+}
+
+
+/* Function: AddSourceFile()
+ * -------------------------
+ * Records that the last numDecls declarations came from the named file,
+ * so that the semantic check can quote the right file in its errors.
+ */
+static void AddSourceFile(List<SourceFile*> *sources, const char *name,
+                          List<const char*> *lines, int numDecls)
+{
+    SourceFile *sf = new SourceFile;
+    sf->name = name;
+    sf->lines = lines;
+    sf->numDecls = numDecls;
+    sources->Append(sf);
+}
+
+
+/* Function: ParseFile()
+ * ---------------------
+ * Parses the named input file and appends its declarations to the given
+ * list, consulting the parse cache first when it is turned on.
+ */
+static void ParseFile(const char *name, List<Decl*> *decls,
+                      List<SourceFile*> *sources)
+{
+    struct stat st;
+    char path[PATH_MAX];
+    FILE *fp;
+
+    ReportError::SetCurrentFile(name);
+    if (stat(name, &st) != 0 || (fp = fopen(name, "r")) == NULL) {
+        ReportError::Formatted(NULL, "Cannot open file %s", name);
+        return;
+    }
+    ParsedFile *pf = NULL;
+    if (parseCacheEnabled && realpath(name, path)) {
+        pf = LookupParsedFile(path);
+        if (pf && IsUnchanged(pf, st)) {
+            PrintDebug("driver", "Reusing parse of %s", name);
+            AppendDecls(decls, pf->decls);
+            AddSourceFile(sources, name, pf->lines, pf->decls->NumElements());
+            parsesInUse.Append(pf);
+            fclose(fp);
+            return;
+        }
+    }
+
+    PrintDebug("driver", "Parsing %s", name);
+    int errorsBefore = ReportError::NumErrors();
+    List<Decl*> *parsed = ParseStream(fp);
+    fclose(fp);
+    if (!parsed) return;
+    AppendDecls(decls, parsed);
+    List<const char*> *lines = new List<const char*>(savedLines);
+    AddSourceFile(sources, name, lines, parsed->NumElements());
+
+    if (parseCacheEnabled && ReportError::NumErrors() == errorsBefore &&
+        realpath(name, path)) {
+        if (!pf) {
+            pf = new ParsedFile;
+            pf->path = strdup(path);
+            parseCache.Append(pf);
+        }
+        pf->size = st.st_size;
+        pf->mtime = st.st_mtim;
+        pf->decls = parsed;
+        pf->lines = lines;
+        parsesInUse.Append(pf);
+    }
+}
+
+
+/* Function: IsExecuting()
+ * -----------------------
+ * Whether the program is to be run (with --interpret or --run) rather
+ * than compiled.
+ */
+static bool IsExecuting()
+{
+    return IsOptionOn("--interpret") || IsOptionOn("--run");
+}
+
+
+/* Function: IsTranslating()
+ * -------------------------
+ * Whether the program is to be translated to C (with -emit-c, or -o to
+ * have the C compiled as well) or to three-address code (-emit-tac)
+ * rather than have its parse tree printed.
+ */
+static bool IsTranslating()
+{
+    return IsOptionOn("-emit-c") || IsOptionOn("-o") || IsOptionOn("-emit-tac");
+}
+
+
+/* Function: OptimizationLevel()
+ * -------------------------------
+ * The level of optimization asked for with -O0, -O1 or -O2 (see opt.h),
+ * 0 by default.
+ */
+static int OptimizationLevel()
+{
+    if (IsOptionOn("-O2")) return 2;
+    if (IsOptionOn("-O1")) return 1;
+    return 0;
+}
+
+
+/* Function: EmitOptimizedTac()
+ * ----------------------------
+ * The program's three-address code, optimized at the given level and
+ * verified. Returns NULL if the verifier finds it is not well formed,
+ * after the optimizer or (with -d tac) after any one of its passes.
+ */
+static TacProgram *EmitOptimizedTac(Program *program, int level)
+{
+    TacProgram *tac;
+    {
+        PhaseScope scope("emit-tac");
+        tac = program->EmitTac();
+    }
+    if (level > 0 && !Optimizer::Run(tac, level)) return NULL;
+    PhaseScope scope("verify-tac");
+    return tac->Verify() ? tac : NULL;
+}
+
+
+/* Function: RunCCompiler()
+ * ------------------------
+ * Compiles the C file into the named executable with the system's C
+ * compiler ($CC, or cc), optimizing. Returns whether it succeeded.
+ */
+static bool RunCCompiler(const char *source, const char *executable)
+{
+    const char *cc = getenv("CC");
+    if (!cc || !*cc) cc = "cc";
+    pid_t pid = fork();
+    if (pid == 0) {
+        execlp(cc, cc, "-O2", "-fno-strict-aliasing", "-o", executable, source,
+               "-lm", (char *)NULL);
+        fprintf(stderr, "dcc: cannot run %s\n", cc);
+        _exit(127);
+    }
+    int status;
+    if (pid < 0 || waitpid(pid, &status, 0) != pid) return false;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+
+/* Function: Translate()
+ * ---------------------
+ * Writes the checked program as C to stdout for -emit-c, or for -o to a
+ * temporary file, which is then compiled into the executable named. For
+ * -emit-tac, its three-address code is written to stdout, optimized as
+ * -O asks, once the verifier has found it well formed.
+ */
+static int Translate(Program *program)
+{
+    if (IsOptionOn("-emit-tac")) {
+        TacProgram *tac = EmitOptimizedTac(program, OptimizationLevel());
+        if (!tac) return 2;
+        tac->Print(stdout);
+        fflush(stdout);
+        return 0;
+    }
+    const char *executable = GetOptionValue("-o");
+    if (!executable) {
+        PhaseScope scope("emit-c");
+        program->EmitC(stdout);
+        fflush(stdout);
+        return 0;
+    }
+    char path[] = "/tmp/dccXXXXXX.c";
+    int fd = mkstemps(path, 2);
+    FILE *fp = fd >= 0 ? fdopen(fd, "w") : NULL;
+    if (!fp) {
+        fprintf(stderr, "dcc: cannot create %s\n", path);
+        return 2;
+    }
+    {
+        PhaseScope scope("emit-c");
+        program->EmitC(fp);
+    }
+    fclose(fp);
+    bool ok;
+    {
+        PhaseScope scope("cc");
+        ok = RunCCompiler(path, executable);
+    }
+    unlink(path);
+    if (ok) return 0;
+    fprintf(stderr, "dcc: compiling %s failed\n", executable);
+    return 2;
+}
+
+
+/* Function: CompileUncached()
+ * ---------------------------
+ * Runs the front end and the later phases over the inputs. With
+ * --interpret or --run, the program is checked and then run, reading its
+ * input from stdinSource, instead of having its parse tree printed:
+ * --interpret walks the tree, --run lowers it to bytecode for the VM,
+ * by way of optimized three-address code with -O1 or -O2. -op-profile
+ * adds a listing of the opcodes the VM ran to stderr, and -no-jit keeps
+ * the VM from compiling hot functions to machine code. -gc-stats adds a
+ * report on the garbage collector, and -nursery sets the size of its
+ * nursery (see gc.h). With -emit-c or -o, the checked program is
+ * translated to C instead, and with -emit-tac to three-address code.
+ */
+static int CompileUncached(FILE *stdinSource)
+{
+    List<Decl*> *decls = new List<Decl*>;
+    List<SourceFile*> *sources = NULL;
+
+    ReportError::ResetErrorCount();
+    parsesInUse = List<ParsedFile*>();
+    if (NumInputFiles() == 0) {
+        ReportError::SetCurrentFile(NULL);
+        PrintDebug("driver", "Parsing <stdin>");
+        List<Decl*> *parsed = ParseStream(stdinSource);
+        if (parsed) AppendDecls(decls, parsed);
+    }
+    if (NumInputFiles() > 0) sources = new List<SourceFile*>;
+    for (int i = 0; i < NumInputFiles(); i++)
+        ParseFile(GetInputFile(i), decls, sources);
+
+    // if no errors, advance to next phase
+    if (ReportError::NumErrors() == 0 && (IsExecuting() || IsTranslating())) {
+        ForgetParsesInUse();
+        Program *program = new Program(decls);
+        program->SetSourceFiles(sources);
+        {
+            PhaseScope scope("check");
+            program->Check();
+        }
+        if (ReportError::NumErrors() != 0) return -1;
+        {
+            PhaseScope scope("fold");
+            program->FoldConstants();
+        }
+        if (IsTranslating()) return Translate(program);
+        if (IsOptionOn("--interpret")) {
+            PhaseScope scope("interpret");
+            return program->Execute(stdinSource);
+        }
+        BcProgram *code;
+        if (OptimizationLevel() > 0) {
+            TacProgram *tac = EmitOptimizedTac(program, OptimizationLevel());
+            if (!tac) return 2;
+            PhaseScope scope("lower");
+            code = TacLowering::Lower(tac);
+        } else {
+            PhaseScope scope("codegen");
+            code = program->Emit();
+        }
+        if (ReportError::NumErrors() != 0) return -1;
+        if (IsDebugOn("bytecode")) code->Print(stderr);
+        VM::profiling = IsOptionOn("-op-profile");
+        VM::jit = !IsOptionOn("-no-jit");
+        const char *nurseryArg = GetOptionValue("-nursery");
+        Heap::nurserySize = nurseryArg ? CompileCache::ParseSize(nurseryArg) : 4 << 20;
+        if (Heap::nurserySize <= 0) {
+            fprintf(stderr, "dcc: bad nursery size %s\n", nurseryArg);
+            return 2;
+        }
+        int status;
+        {
+            PhaseScope scope("run");
+            status = program->Run(code, stdinSource);
+        }
+        if (VM::profiling) VM::PrintProfile(stderr);
+        if (IsOptionOn("-gc-stats")) Heap::PrintStats(stderr);
+        return status;
+    }
+    if (ReportError::NumErrors() == 0) {
+        Program *program = new Program(decls);
+        PhaseScope scope("print");
+        program->Print(0);
+    }
+    fflush(stdout);
+    return (ReportError::NumErrors() == 0? 0 : -1);
+}
+
+
+/* Function: CompileCached()
+ * -------------------------
+ * Answers the compilation from the compilation cache if it has been done
+ * before, and otherwise runs it with its output captured and stores the
+ * result. Either way the output is then written to stdout and stderr.
+ */
+static int CompileCached(FILE *stdinSource)
+{
+    const char *sizeArg = GetOptionValue("--cache-size");
+    long long maxSize = sizeArg ? CompileCache::ParseSize(sizeArg) : 100 << 20;
+    if (maxSize <= 0) {
+        fprintf(stderr, "dcc: bad cache size %s\n", sizeArg);
+        return 2;
+    }
+    CompileCache cache(GetOptionValue("--cache-dir"), maxSize);
+
+    // stdin can only be read once, so keep its text to hash and to compile
+    std::string stdinText;
+    if (NumInputFiles() == 0) {
+        char buf[8192];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), stdinSource)) > 0)
+            stdinText.append(buf, n);
+    }
+    std::string key;
+    CompileResult result;
+    bool hit;
+    {
+        PhaseScope scope("cache");
+        key = cache.KeyForCompilation(stdinText);
+        hit = !key.empty() && cache.Lookup(key, &result);
+    }
+    if (!hit) {
+        FILE *in = tmpfile();
+        Assert(in != NULL);
+        fwrite(stdinText.data(), 1, stdinText.size(), in);
+        rewind(in);
+        {
+            OutputCapture capture;
+            result.status = CompileUncached(in);
+            capture.Finish(&result.out, &result.err);
+        }
+        fclose(in);
+        PhaseScope scope("cache");
+        if (!key.empty()) cache.Store(key, result);
+    } else {
+        PrintDebug("cache", "Hit %s", key.c_str());
+    }
+    fwrite(result.out.data(), 1, result.out.size(), stdout);
+    fflush(stdout);
+    fwrite(result.err.data(), 1, result.err.size(), stderr);
+    return result.status;
+}
+
+
+int CompileProgram(FILE *stdinSource)
+{
+    bool json = IsOptionOn("-time-phases=json");
+    PhaseTimer::Reset(json || IsOptionOn("-time-phases"));
+    Tracer::Reset(IsOptionOn("-trace"));
+
+    // a run depends on its input as well as the source, and an executable
+    // is written to a file of its own, so neither is ever cached
+    int status;
+    if (IsOptionOn("--cache-dir") && !IsExecuting() && !IsOptionOn("-o"))
+        status = CompileCached(stdinSource);
+    else
+        status = CompileUncached(stdinSource);
+
+    if (PhaseTimer::enabled) {
+        fflush(stdout);
+        PhaseTimer::PrintReport(stderr, json);
+        PhaseTimer::Reset(false);
+    }
+    if (Tracer::enabled) {
+        if (!Tracer::Write(GetOptionValue("-trace")))
+            fprintf(stderr, "dcc: cannot write trace to %s\n", GetOptionValue("-trace"));
+        Tracer::Reset(false);
+    }
+    return status;
+}
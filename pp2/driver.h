@@ -0,0 +1,54 @@
+/* File: driver.h
+ * --------------
+ * The driver runs one compilation: it scans and parses each input file
+ * named on the command line (or stdin), merges their declarations into a
+ * single Program and runs the later phases over it. It is used both by
+ * main() for an ordinary invocation and by the compile server for each
+ * request it receives.
+ */
+
+#ifndef _H_driver
+#define _H_driver
+
+#include <stdio.h>
+
+/* Function: CompileProgram()
+ * Usage: int status = CompileProgram(stdin);
+ * ------------------------------------------
+ * Compiles the input files from the current command line, reading the
+ * program from the given stream instead when no files were named. Output
+ * and diagnostics go to stdout and stderr. Returns the exit status for
+ * the compilation (0 if no errors were reported). With --interpret or
+ * --run, the program is checked and run instead (by the tree-walking
+ * interpreter or the bytecode VM), reading its input from the same
+ * stream once the source has been read; a runtime error gives status 1.
+ * -O1 and -O2 have the code for the VM optimized first (see opt.h).
+ * -op-profile adds the opcode counts of the VM's run (see vm.h), and
+ * -no-jit runs it without compiling anything to machine code.
+ *
+ * The VM's heap is garbage collected: -gc-stats reports on its
+ * collections, and -nursery <n> sets the size of the nursery they start
+ * from (see gc.h).
+ *
+ * With -emit-c, the checked program is translated to C on stdout
+ * instead, and with -o <prog> the C is compiled into the executable prog
+ * by the system's C compiler (see cwriter.h). -emit-tac writes its
+ * three-address code instead (see tac.h), optimized with -O1 or -O2.
+ * Otherwise, with --cache-dir, the result may come from the compilation
+ * cache (see cache.h). With -time-phases, a report on the phases of
+ * compilation follows on stderr (see timer.h); with -trace <file>, a
+ * timeline of the compilation is written to the file (see trace.h).
+ */
+int CompileProgram(FILE *stdinSource);
+
+
+/* Function: SetParseCacheEnabled()
+ * --------------------------------
+ * Turns on reuse of parse trees across calls to CompileProgram. A file
+ * that parsed without errors is remembered along with its size and
+ * modification time, and is not scanned or parsed again until it changes.
+ * Only worthwhile in a long-running process such as the compile server.
+ */
+void SetParseCacheEnabled(bool enabled);
+
+#endif
@@ -0,0 +1,115 @@
+/* File: dstring.cc
+ * ----------------
+ * Implementation of strings and their interning.
+ */
+
+#include "dstring.h"
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <vector>
+#include "interp.h"
+#include "utility.h"
+
+static const int ChunkSize = 64 << 10;      // of the pool, mapped at a time
+
+/* The empty string is there from the start, in read-only data like the
+ * rest of the pool. 2166136261 is the hash of no characters. */
+static const struct { StringHeader header; char chars[8]; } emptyString = { { 0, 2166136261u }, "" };
+const char *const Strings::empty = emptyString.chars;
+
+static std::vector<const char *> table;     // open addressing; NULL is free
+static int numInterned;
+static char *chunk, *chunkTop, *chunkLimit;
+
+
+/* Function: Hash()
+ * ----------------
+ * FNV-1a, over the characters.
+ */
+static unsigned Hash(const char *chars, int length)
+{
+    unsigned h = 2166136261u;
+    for (int i = 0; i < length; i++)
+        h = (h ^ (unsigned char)chars[i]) * 16777619u;
+    return h;
+}
+
+/* Writes a string to dst: its header, then its characters and the NUL.
+ * Returns where the characters went. */
+static char *Fill(char *dst, const char *chars, int length, unsigned hash)
+{
+    StringHeader *header = (StringHeader *)dst;
+    header->length = length;
+    header->hash = hash;
+    char *s = (char *)(header + 1);
+    memcpy(s, chars, length);
+    s[length] = '\0';
+    return s;
+}
+
+/* Function: AddToPool()
+ * ---------------------
+ * Copies a string into the read-only pool, opening it for writing just
+ * long enough. A string that does not fit what is left of the chunk
+ * starts a new one, as big as it needs.
+ */
+static const char *AddToPool(const char *chars, int length, unsigned hash)
+{
+    size_t size = (sizeof(StringHeader) + length + 1 + 7) & ~(size_t)7;
+    if (!chunk || size > (size_t)(chunkLimit - chunkTop)) {
+        size_t chunkSize = size > (size_t)ChunkSize ? (size + 4095) & ~(size_t)4095 : ChunkSize;
+        void *p = mmap(NULL, chunkSize, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) Failure("Out of memory for strings");
+        chunk = chunkTop = (char *)p;
+        chunkLimit = chunk + chunkSize;
+    }
+    mprotect(chunk, chunkLimit - chunk, PROT_READ | PROT_WRITE);
+    const char *s = Fill(chunkTop, chars, length, hash);
+    mprotect(chunk, chunkLimit - chunk, PROT_READ);
+    chunkTop += size;
+    return s;
+}
+
+static void Insert(const char *s)
+{
+    size_t mask = table.size() - 1;
+    size_t i = Strings::HeaderOf(s)->hash & mask;
+    while (table[i]) i = (i + 1) & mask;
+    table[i] = s;
+}
+
+const char *Strings::Intern(const char *chars, int length)
+{
+    if (table.empty()) {
+        table.assign(256, (const char *)NULL);
+        Insert(empty);
+        numInterned = 1;
+    }
+    unsigned hash = Hash(chars, length);
+    size_t mask = table.size() - 1;
+    for (size_t i = hash & mask; table[i]; i = (i + 1) & mask) {
+        const StringHeader *header = HeaderOf(table[i]);
+        if (header->hash == hash && header->length == length &&
+            !memcmp(table[i], chars, length))
+            return table[i];
+    }
+    if (4 * (numInterned + 1) > 3 * (int)table.size()) {
+        std::vector<const char *> old;
+        old.swap(table);
+        table.assign(old.size() * 2, (const char *)NULL);
+        for (size_t i = 0; i < old.size(); i++)
+            if (old[i]) Insert(old[i]);
+    }
+    const char *s = AddToPool(chars, length, hash);
+    Insert(s);
+    numInterned++;
+    return s;
+}
+
+const char *Strings::New(const char *chars, int length)
+{
+    if (length == 0) return empty;
+    char *block = (char *)malloc(sizeof(StringHeader) + length + 1);
+    if (!block) Interpreter::Halt("Out of memory");
+    return Fill(block, chars, length, Hash(chars, length));
+}
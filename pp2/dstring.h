@@ -0,0 +1,54 @@
+/* File: dstring.h
+ * ---------------
+ * The strings a Decaf program computes with. A string is immutable: its
+ * characters, NUL-terminated so they can go straight to stdio, preceded
+ * by a StringHeader giving their length and hash. A Value of kind
+ * StringValue points at the characters (see value.h), so the header is
+ * found just before them.
+ *
+ * String literals are interned as they are parsed: each distinct text
+ * is kept once, for the whole program (and for any compiled after it by
+ * the same process), in a pool that is read-only except while a string
+ * is being added. Equal literals are therefore the same pointer, and
+ * Equal() tries that first, then the hashes and lengths, and only then
+ * the characters. A line read by ReadLine is a new string of its own.
+ */
+
+#ifndef _H_dstring
+#define _H_dstring
+
+#include <string.h>
+
+struct StringHeader {
+    int length;
+    unsigned hash;
+};
+
+class Strings
+{
+  public:
+    // The empty string, interned.
+    static const char *const empty;
+
+    // The interned string with the given characters, added to the pool
+    // if it is not there yet.
+    static const char *Intern(const char *chars, int length);
+    static const char *Intern(const char *chars) { return Intern(chars, strlen(chars)); }
+
+    // A new string with the given characters, from malloc.
+    static const char *New(const char *chars, int length);
+
+    static const StringHeader *HeaderOf(const char *s) {
+        return (const StringHeader *)s - 1;
+    }
+    static int Length(const char *s) { return HeaderOf(s)->length; }
+
+    static bool Equal(const char *a, const char *b) {
+        if (a == b) return true;
+        const StringHeader *ha = HeaderOf(a), *hb = HeaderOf(b);
+        return ha->hash == hb->hash && ha->length == hb->length &&
+               !memcmp(a, b, ha->length);
+    }
+};
+
+#endif
@@ -11,8 +11,14 @@
 using namespace std;
 
 #include "scanner.h" // for GetLineNumbered
+#include "ast_type.h"
+#include "ast_expr.h"
+#include "ast_stmt.h"
+#include "ast_decl.h"
 
 int ReportError::numErrors = 0;
+const char *ReportError::currentFile = NULL;
+const List<const char*> *ReportError::currentLines = NULL;
 
 void ReportError::UnderlineErrorInLine(const char *line, yyltype *pos) {
     if (!line) return;
@@ -28,9 +34,17 @@ void ReportError::OutputError(yyltype *loc, string msg) {
     numErrors++;
     fflush(stdout); // make sure any buffered text has been output
     if (loc) {
-        cerr << endl << "*** Error line " << loc->first_line << "." << endl;
-        UnderlineErrorInLine(GetLineNumbered(loc->first_line), loc);
-    } else
+        cerr << endl << "*** Error line " << loc->first_line;
+        if (currentFile) cerr << " of " << currentFile;
+        cerr << "." << endl;
+        int n = loc->first_line;
+        if (!currentLines)
+            UnderlineErrorInLine(GetLineNumbered(n), loc);
+        else if (n > 0 && n <= currentLines->NumElements())
+            UnderlineErrorInLine(currentLines->Nth(n-1), loc);
+    } else if (currentFile)
+        cerr << endl << "*** Error in " << currentFile << "." << endl;
+    else
         cerr << endl << "*** Error." << endl;
     cerr << "*** " << msg << endl << endl;
 }
@@ -73,6 +87,128 @@ void ReportError::UnrecogChar(yyltype *loc, char ch) {
     OutputError(loc, s.str());
 }
   
+void ReportError::DeclConflict(Decl *decl, Decl *prevDecl) {
+    stringstream s;
+    s << "Declaration of '" << decl << "' here conflicts with declaration on line " 
+      << prevDecl->GetLocation()->first_line;
+    OutputError(decl->GetLocation(), s.str());
+}
+  
+void ReportError::OverrideMismatch(Decl *fnDecl) {
+    stringstream s;
+    s << "Method '" << fnDecl << "' must match inherited type signature";
+    OutputError(fnDecl->GetLocation(), s.str());
+}
+
+void ReportError::InterfaceNotImplemented(Decl *cd, Type *interfaceType) {
+    stringstream s;
+    s << "Class '" << cd << "' does not implement entire interface '" << interfaceType << "'";
+    OutputError(interfaceType->GetLocation(), s.str());
+}
+
+void ReportError::IdentifierNotDeclared(Identifier *ident, reasonT whyNeeded) {
+    stringstream s;
+    static const char *names[] =  {"type", "class", "interface", "variable", "function"};
+    Assert(whyNeeded >= 0 && whyNeeded <= sizeof(names)/sizeof(names[0]));
+    s << "No declaration found for "<< names[whyNeeded] << " '" << ident << "'";
+    OutputError(ident->GetLocation(), s.str());
+}
+
+void ReportError::IncompatibleOperands(Operator *op, Type *lhs, Type *rhs) {
+    stringstream s;
+    s << "Incompatible operands: " << lhs << " " << op << " " << rhs;
+    OutputError(op->GetLocation(), s.str());
+}
+     
+void ReportError::IncompatibleOperand(Operator *op, Type *rhs) {
+    stringstream s;
+    s << "Incompatible operand: " << op << " " << rhs;
+    OutputError(op->GetLocation(), s.str());
+}
+
+void ReportError::ThisOutsideClassScope(This *th) {
+    OutputError(th->GetLocation(), "'this' is only valid within class scope");
+}
+
+void ReportError::PostfixNotVariable(Operator *op) {
+    stringstream s;
+    s << "Operand of " << op << " must be a variable";
+    OutputError(op->GetLocation(), s.str());
+}
+
+void ReportError::BracketsOnNonArray(Expr *baseExpr) {
+    OutputError(baseExpr->GetLocation(), "[] can only be applied to arrays");
+}
+
+void ReportError::SubscriptNotInteger(Expr *subscriptExpr) {
+    OutputError(subscriptExpr->GetLocation(), "Array subscript must be an integer");
+}
+
+void ReportError::NewArraySizeNotInteger(Expr *sizeExpr) {
+    OutputError(sizeExpr->GetLocation(), "Size for NewArray must be an integer");
+}
+
+void ReportError::NumArgsMismatch(Identifier *fnIdent, int numExpected, int numGiven) {
+    stringstream s;
+    s << "Function '"<< fnIdent << "' expects " << numExpected << " argument" << (numExpected==1?"":"s") 
+      << " but " << numGiven << " given";
+    OutputError(fnIdent->GetLocation(), s.str());
+}
+
+void ReportError::ArgMismatch(Expr *arg, int argIndex, Type *given, Type *expected) {
+  stringstream s;
+  s << "Incompatible argument " << argIndex << ": " << given << " given, " << expected << " expected";
+  OutputError(arg->GetLocation(), s.str());
+}
+
+void ReportError::PrintArgMismatch(Expr *arg, int argIndex, Type *given) {
+    stringstream s;
+    s << "Incompatible argument " << argIndex << ": " << given
+        << " given, int/bool/string expected";
+    OutputError(arg->GetLocation(), s.str());
+}
+
+void ReportError::FieldNotFoundInBase(Identifier *field, Type *base) {
+    stringstream s;
+    s << base << " has no such field '" << field <<"'";
+    OutputError(field->GetLocation(), s.str());
+}
+     
+void ReportError::InaccessibleField(Identifier *field, Type *base) {
+    stringstream s;
+    s  << base << " field '" << field << "' only accessible within class scope";
+    OutputError(field->GetLocation(), s.str());
+}
+
+void ReportError::TestNotBoolean(Expr *expr) {
+    OutputError(expr->GetLocation(), "Test expression must have boolean type");
+}
+
+void ReportError::SwitchNotInteger(Expr *expr) {
+    OutputError(expr->GetLocation(), "Switch expression must have integer type");
+}
+
+void ReportError::DuplicateCase(Expr *label, int value) {
+    stringstream s;
+    s << "Duplicate case " << value << " in switch";
+    OutputError(label->GetLocation(), s.str());
+}
+
+void ReportError::ReturnMismatch(ReturnStmt *rStmt, Type *given, Type *expected) {
+    stringstream s;
+    s << "Incompatible return: " << given << " given, " << expected << " expected";
+    OutputError(rStmt->GetLocation(), s.str());
+}
+
+void ReportError::BreakOutsideLoop(BreakStmt *bStmt) {
+    OutputError(bStmt->GetLocation(), "break is only allowed inside a loop or switch");
+}
+
+void ReportError::NoMainFound() {
+    SetCurrentFile(NULL);
+    OutputError(NULL, "Linker: function 'main' not defined");
+}
+
 /* Function: yyerror()
  * -------------------
  * Standard error-reporting function expected by yacc. Our version merely
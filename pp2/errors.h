@@ -15,6 +15,16 @@
 #include <string>
 using std::string;
 #include "location.h"
+#include "list.h"
+
+class Type;
+class Identifier;
+class Expr;
+class BreakStmt;
+class ReturnStmt;
+class This;
+class Decl;
+class Operator;
 
 /* General notes on using this class
  * ----------------------------------
@@ -52,18 +62,78 @@ class ReportError
   static void UntermString(yyltype *loc, const char *str);
   static void UnrecogChar(yyltype *loc, char ch);
 
+  // Errors used by semantic analyzer for declarations
+  static void DeclConflict(Decl *newDecl, Decl *prevDecl);
+  static void OverrideMismatch(Decl *fnDecl);
+  static void InterfaceNotImplemented(Decl *classDecl, Type *intfType);
+
+
+  // Errors used by semantic analyzer for identifiers
+  static void IdentifierNotDeclared(Identifier *ident, reasonT whyNeeded);
+
+
+  // Errors used by semantic analyzer for expressions
+  static void IncompatibleOperand(Operator *op, Type *rhs); // unary
+  static void IncompatibleOperands(Operator *op, Type *lhs, Type *rhs); // binary
+  static void ThisOutsideClassScope(This *th);
+  static void PostfixNotVariable(Operator *op);
+
+
+  // Errors used by semantic analyzer for array acesss & NewArray
+  static void BracketsOnNonArray(Expr *baseExpr); 
+  static void SubscriptNotInteger(Expr *subscriptExpr);
+  static void NewArraySizeNotInteger(Expr *sizeExpr);
+
+
+  // Errors used by semantic analyzer for function/method calls
+  static void NumArgsMismatch(Identifier *fnIdentifier, int numExpected, int numGiven);
+  static void ArgMismatch(Expr *arg, int argIndex, Type *given, Type *expected);
+  static void PrintArgMismatch(Expr *arg, int argIndex, Type *given);
+
+
+  // Errors used by semantic analyzer for field access
+  static void FieldNotFoundInBase(Identifier *field, Type *base);
+  static void InaccessibleField(Identifier *field, Type *base);
+
+
+  // Errors used by semantic analyzer for control structures
+  static void TestNotBoolean(Expr *testExpr);
+  static void SwitchNotInteger(Expr *testExpr);
+  static void DuplicateCase(Expr *label, int value);
+  static void ReturnMismatch(ReturnStmt *rStmt, Type *given, Type *expected);
+  static void BreakOutsideLoop(BreakStmt *bStmt);
+
+
+  // Errors used by the interpreter and code generators
+  static void NoMainFound();
+
+
   // Generic method to report a printf-style error message
   static void Formatted(yyltype *loc, const char *format, ...);
 
 
   // Returns number of error messages printed
   static int NumErrors() { return numErrors; }
+
+  // Forgets the errors counted so far, for processes that compile
+  // more than one program
+  static void ResetErrorCount() { numErrors = 0; }
+
+  // Names the input file being compiled so that messages can say which
+  // file they refer to when several are compiled together. NULL (the
+  // default) means a single program read from stdin. Messages quote the
+  // offending line from the given lines of the file, or, if they are
+  // NULL, from the lines the scanner saved from the last file it read.
+  static void SetCurrentFile(const char *name, const List<const char*> *lines = NULL)
+      { currentFile = name; currentLines = lines; }
   
  private:
 
   static void UnderlineErrorInLine(const char *line, yyltype *pos);
   static void OutputError(yyltype *loc, string msg);
   static int numErrors;
+  static const char *currentFile;
+  static const List<const char*> *currentLines;
   
 };
 
@@ -0,0 +1,402 @@
+/* File: gc.cc
+ * -----------
+ * Implementation of the heap and its collector.
+ */
+
+#include "gc.h"
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <vector>
+#include "interp.h"
+#include "ast_decl.h"
+#include "timer.h"
+#include "utility.h"
+
+/* The header of a block: its flags, and once a collection has given the
+ * block a new place, the address of that, whose low four bits are free
+ * for them. HeaderBit keeps the header from ever reading as a Value's
+ * kind of object or array. */
+enum { ArrayBit = 1, MarkBit = 2, ForwardBit = 4, HeaderBit = 8, FlagMask = 15 };
+static const int HeaderSize = 8;
+static const size_t CardSize = (size_t)1 << Heap::CardShift;
+static const size_t MinMajorSize = 16 << 20;   // the old generation first collected at
+
+unsigned char *Heap::cards = NULL;
+long long Heap::nurserySize = 4 << 20;
+
+static char *heapBase;          // the reservation: nursery, then old generation
+static size_t reserved;
+static unsigned char *cardTable;
+static char *highWater;         // beyond all the runs have touched
+
+static RootWalker walker;
+static char *nurseryTop, *nurseryLimit;
+static char *oldBase, *oldTop, *oldLimit;
+static size_t largeSize;        // what is bigger goes straight to the old generation
+static size_t majorSize;        // the old generation next collected at
+
+static struct {
+    int minors, majors;
+    double minorMs, majorMs, maxMinorMs, maxMajorMs;
+    long long allocated, promoted, peakOld;
+    struct timespec start, finish;
+} stats;
+
+
+static double ElapsedMs(const struct timespec &from, const struct timespec &to)
+{
+    return (to.tv_sec - from.tv_sec) * 1e3 + (to.tv_nsec - from.tv_nsec) / 1e6;
+}
+
+static inline uintptr_t *HeaderOf(void *ref)
+{
+    return (uintptr_t *)((char *)ref - HeaderSize);
+}
+
+static inline bool IsReference(const Value *v)
+{
+    return (v->kind == ObjectValue || v->kind == ArrayValue) && v->ref;
+}
+
+// The size of the block at p, which still has its class or length.
+static inline size_t BlockSize(const char *p)
+{
+    const char *body = p + HeaderSize;
+    if (*(const uintptr_t *)p & ArrayBit)
+        return HeaderSize + offsetof(ArrayObject, elems) +
+               (size_t)((const ArrayObject *)body)->length * sizeof(Value);
+    return HeaderSize + offsetof(Object, fields) +
+           (size_t)((const Object *)body)->cls->NumFields() * sizeof(Value);
+}
+
+// The Values of the block at p, and how many a block of the size has.
+static inline Value *ValuesOf(char *p)
+{
+    return (Value *)(p + 2 * HeaderSize);
+}
+
+static inline int NumValues(size_t size)
+{
+    return (size - 2 * HeaderSize) / sizeof(Value);
+}
+
+
+/* Function: Reserve()
+ * -------------------
+ * Reserves the address space of the heap and its card table once, as
+ * much as the system allows up to 64G; pages are only backed by memory
+ * once touched.
+ */
+static void Reserve()
+{
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+    for (reserved = (size_t)64 << 30; reserved >= (size_t)256 << 20; reserved /= 2) {
+        void *heap = mmap(NULL, reserved, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (heap == MAP_FAILED) continue;
+        void *table = mmap(NULL, reserved >> Heap::CardShift, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (table == MAP_FAILED) {
+            munmap(heap, reserved);
+            continue;
+        }
+        heapBase = highWater = (char *)heap;
+        cardTable = (unsigned char *)table;
+        Heap::cards = cardTable - ((size_t)heapBase >> Heap::CardShift);
+        return;
+    }
+    Failure("Cannot reserve the heap");
+}
+
+void Heap::Start(RootWalker w)
+{
+    Assert(offsetof(Object, fields) == HeaderSize && offsetof(ArrayObject, elems) == HeaderSize);
+    if (!heapBase) Reserve();
+
+    // what the last run left is given back, and reads as zeros again
+    size_t used = highWater - heapBase;
+    madvise(heapBase, used, MADV_DONTNEED);
+    madvise(cardTable, (used >> CardShift) + 1, MADV_DONTNEED);
+
+    walker = w;
+    size_t size = nurserySize < (long long)CardSize ? CardSize : (size_t)nurserySize;
+    if (size > reserved / 4) size = reserved / 4;
+    size = (size + 4095) & ~(size_t)4095;
+    nurseryTop = heapBase;
+    nurseryLimit = oldBase = oldTop = heapBase + size;
+    oldLimit = heapBase + reserved;
+    largeSize = size / 4;
+    majorSize = MinMajorSize > 2 * size ? MinMajorSize : 2 * size;
+
+    memset(&stats, 0, sizeof(stats));
+    clock_gettime(CLOCK_MONOTONIC, &stats.start);
+}
+
+void Heap::Finish()
+{
+    clock_gettime(CLOCK_MONOTONIC, &stats.finish);
+    stats.allocated += nurseryTop - heapBase;
+    if (oldTop > highWater) highWater = oldTop;
+    if (nurseryTop > highWater) highWater = nurseryTop;
+}
+
+
+/* Minor collection
+ * ----------------
+ * What the roots and the dirty cards refer to in the nursery is copied
+ * to the end of the old generation, leaving behind the address it went
+ * to, and then what the copies refer to, and so on: the copies are
+ * scanned in order until the scan catches up with the end. */
+static inline void Forward(Value *v)
+{
+    if (v->kind != ObjectValue && v->kind != ArrayValue) return;
+    char *p = (char *)v->ref;
+    if ((size_t)p - (size_t)heapBase >= (size_t)(nurseryLimit - heapBase)) return;  // null too
+    uintptr_t *header = HeaderOf(p);
+    if (!(*header & ForwardBit)) {
+        char *from = (char *)header, *to = oldTop;
+        size_t size = BlockSize(from);
+        oldTop += size;
+        memcpy(to, from, size);
+        *header = (uintptr_t)to | ForwardBit | HeaderBit;
+    }
+    v->ref = (char *)(*header & ~(uintptr_t)FlagMask) + HeaderSize;
+}
+
+static void ForwardValues(Value *values, int n)
+{
+    for (int i = 0; i < n; i++)
+        Forward(&values[i]);
+}
+
+// Forwards what the dirty cards between from and to refer to.
+static void ScanCards(char *from, char *to)
+{
+    size_t card = (size_t)from >> Heap::CardShift;
+    size_t end = ((size_t)to + CardSize - 1) >> Heap::CardShift;
+    while (card < end) {
+        uint64_t eight;
+        if (card + 8 <= end) {
+            memcpy(&eight, &Heap::cards[card], sizeof(eight));
+            if (!eight) {
+                card += 8;
+                continue;
+            }
+        }
+        if (Heap::cards[card]) {
+            Heap::cards[card] = 0;
+            Value *v = (Value *)(card << Heap::CardShift);
+            Value *last = (Value *)((card + 1) << Heap::CardShift);
+            if ((char *)last > to) last = (Value *)to;
+            for (; v < last; v++)
+                Forward(v);
+        }
+        card++;
+    }
+}
+
+static void Minor()
+{
+    char *promoted = oldTop;
+    if ((size_t)(oldLimit - oldTop) < (size_t)(nurseryTop - heapBase))
+        Interpreter::Halt("Out of memory");
+    walker(ForwardValues);
+    ScanCards(oldBase, promoted);
+    for (Value *scan = (Value *)promoted; scan < (Value *)oldTop; scan++)
+        Forward(scan);
+    stats.allocated += nurseryTop - heapBase;
+    stats.promoted += oldTop - promoted;
+    nurseryTop = heapBase;
+}
+
+
+/* Major collection
+ * ----------------
+ * With the nursery empty, everything is in the old generation. What is
+ * reachable is marked, from a stack of blocks still to scan; then each
+ * marked block is given its place, in order from the bottom; then every
+ * reference is changed to the place of what it refers to; and then the
+ * blocks are moved there, each down over what was dead below it. */
+static std::vector<char *> markStack;
+
+static void MarkValues(Value *values, int n)
+{
+    for (int i = 0; i < n; i++) {
+        if (!IsReference(&values[i])) continue;
+        uintptr_t *header = HeaderOf(values[i].ref);
+        if (*header & MarkBit) continue;
+        *header |= MarkBit;
+        markStack.push_back((char *)header);
+    }
+}
+
+static void UpdateValues(Value *values, int n)
+{
+    for (int i = 0; i < n; i++)
+        if (IsReference(&values[i]))
+            values[i].ref = (char *)(*HeaderOf(values[i].ref) & ~(uintptr_t)FlagMask) + HeaderSize;
+}
+
+static void Major()
+{
+    walker(MarkValues);
+    while (!markStack.empty()) {
+        char *p = markStack.back();
+        markStack.pop_back();
+        MarkValues(ValuesOf(p), NumValues(BlockSize(p)));
+    }
+
+    char *free = oldBase;
+    for (char *p = oldBase; p < oldTop; ) {
+        size_t size = BlockSize(p);
+        uintptr_t *header = (uintptr_t *)p;
+        if (*header & MarkBit) {
+            *header = (uintptr_t)free | (*header & FlagMask);
+            free += size;
+        }
+        p += size;
+    }
+
+    walker(UpdateValues);
+    for (char *p = oldBase; p < oldTop; ) {
+        size_t size = BlockSize(p);
+        if (*(uintptr_t *)p & MarkBit) UpdateValues(ValuesOf(p), NumValues(size));
+        p += size;
+    }
+
+    for (char *p = oldBase; p < oldTop; ) {
+        size_t size = BlockSize(p);
+        uintptr_t header = *(uintptr_t *)p;
+        if (header & MarkBit) {
+            char *to = (char *)(header & ~(uintptr_t)FlagMask);
+            *(uintptr_t *)p = HeaderBit | (header & ArrayBit);
+            memmove(to, p, size);
+        }
+        p += size;
+    }
+
+    // nothing old refers to the nursery now; what is free goes back
+    if (oldTop > highWater) highWater = oldTop;
+    memset(&Heap::cards[(size_t)oldBase >> Heap::CardShift], 0,
+           ((oldTop - oldBase) >> Heap::CardShift) + 1);
+    char *page = (char *)(((size_t)free + 4095) & ~(size_t)4095);
+    if (page < oldTop) madvise(page, oldTop - page, MADV_DONTNEED);
+    oldTop = free;
+    size_t live = oldTop - oldBase;
+    majorSize = 2 * live > MinMajorSize ? 2 * live : MinMajorSize;
+}
+
+
+/* Function: Collect()
+ * -------------------
+ * A minor collection, and a major one after it if the old generation
+ * has grown enough or full is set. Either is a pause of the program,
+ * which the statistics count as minor or major.
+ */
+static void Collect(bool full)
+{
+    PhaseScope scope("gc");
+    struct timespec start, finish;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    Minor();
+    bool major = full || (size_t)(oldTop - oldBase) > majorSize;
+    if (oldTop - oldBase > stats.peakOld) stats.peakOld = oldTop - oldBase;
+    if (major) Major();
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+
+    double ms = ElapsedMs(start, finish);
+    if (major) {
+        stats.majors++;
+        stats.majorMs += ms;
+        if (ms > stats.maxMajorMs) stats.maxMajorMs = ms;
+    } else {
+        stats.minors++;
+        stats.minorMs += ms;
+        if (ms > stats.maxMinorMs) stats.maxMinorMs = ms;
+    }
+}
+
+// A block of the given size in the old generation, collecting first if
+// that has grown enough.
+static char *AllocateOld(size_t size)
+{
+    if (walker && (size_t)(oldTop - oldBase) + size > majorSize) Collect(true);
+    if ((size_t)(oldLimit - oldTop) < size) Interpreter::Halt("Out of memory");
+    char *p = oldTop;
+    oldTop += size;
+    stats.allocated += size;
+    if (oldTop - oldBase > stats.peakOld) stats.peakOld = oldTop - oldBase;
+    return p;
+}
+
+// Room for blocks of the given total size, in the nursery if they are
+// small enough.
+static inline char *Reserve(size_t size)
+{
+    if (walker && size <= largeSize) {
+        if ((size_t)(nurseryLimit - nurseryTop) < size) Collect(false);
+        char *p = nurseryTop;
+        nurseryTop += size;
+        return p;
+    }
+    return AllocateOld(size);
+}
+
+static inline char *Allocate(size_t size, uintptr_t flags)
+{
+    char *p = Reserve(size);
+    *(uintptr_t *)p = HeaderBit | flags;
+    return p + HeaderSize;
+}
+
+Object *Heap::NewObject(int numFields)
+{
+    return (Object *)Allocate(HeaderSize + offsetof(Object, fields) +
+                              (size_t)numFields * sizeof(Value), 0);
+}
+
+ArrayObject *Heap::NewArray(int length)
+{
+    return (ArrayObject *)Allocate(HeaderSize + offsetof(ArrayObject, elems) +
+                                   (size_t)length * sizeof(Value), ArrayBit);
+}
+
+size_t Heap::ArrayStride(int length)
+{
+    return HeaderSize + offsetof(ArrayObject, elems) + (size_t)length * sizeof(Value);
+}
+
+ArrayObject *Heap::NewArrays(int count, int length)
+{
+    size_t stride = ArrayStride(length);
+    char *p = Reserve(stride * count);
+    for (int i = 0; i < count; i++)
+        *(uintptr_t *)(p + i * stride) = HeaderBit | ArrayBit;
+    return (ArrayObject *)(p + HeaderSize);
+}
+
+void Heap::WriteBarrier(Value *slots, int n)
+{
+    if (n <= 0) return;
+    size_t first = (size_t)slots >> CardShift, last = (size_t)(slots + n - 1) >> CardShift;
+    memset(&cards[first], 1, last - first + 1);
+}
+
+
+void Heap::PrintStats(FILE *fp)
+{
+    double runMs = ElapsedMs(stats.start, stats.finish);
+    double gcMs = stats.minorMs + stats.majorMs;
+    fprintf(fp, "%-22s %11s %11s %11s %11s\n", "Collections", "Count", "Total ms",
+            "Mean ms", "Max ms");
+    fprintf(fp, "%-22s %11d %11.2f %11.3f %11.3f\n", "minor", stats.minors, stats.minorMs,
+            stats.minors ? stats.minorMs / stats.minors : 0.0, stats.maxMinorMs);
+    fprintf(fp, "%-22s %11d %11.2f %11.3f %11.3f\n", "major", stats.majors, stats.majorMs,
+            stats.majors ? stats.majorMs / stats.majors : 0.0, stats.maxMajorMs);
+    fprintf(fp, "\n%-22s %11.1f MB\n", "allocated", stats.allocated / 1048576.0);
+    fprintf(fp, "%-22s %11.1f MB\n", "promoted", stats.promoted / 1048576.0);
+    fprintf(fp, "%-22s %11.1f MB\n", "old generation peak", stats.peakOld / 1048576.0);
+    fprintf(fp, "%-22s %11.1f KB\n", "nursery", (nurseryLimit - heapBase) / 1024.0);
+    fprintf(fp, "%-22s %11.2f ms of %.2f ms run, throughput %.1f%%\n", "time in gc", gcMs,
+            runMs, runMs > 0 ? 100.0 * (runMs - gcMs) / runMs : 100.0);
+}
@@ -0,0 +1,98 @@
+/* File: gc.h
+ * ----------
+ * The heap objects and arrays are allocated in, and its generational
+ * garbage collector, for a run by the VM (see vm.h).
+ *
+ * The heap is one reservation of address space: the nursery, then the
+ * old generation. New objects go in the nursery, by bumping a pointer.
+ * When it is full, a minor collection copies what in it is still
+ * reachable to the end of the old generation, Cheney style, and starts
+ * the nursery over. When the old generation has grown to twice what was
+ * live in it after the last major collection, a major collection marks
+ * what is reachable there and slides it down over the rest (LISP2
+ * mark-compact). Arrays too big for the nursery go straight to the old
+ * generation.
+ *
+ * Every block in the heap is an eight-byte header before the Object or
+ * ArrayObject, so a block is sixteen-byte aligned and so is every Value
+ * in it. Read as a Value's kind, the header is never an object or an
+ * array. That lets the collector go through a run of old objects
+ * sixteen bytes at a time, taking what looks like a reference for one,
+ * with no need to know where each object starts.
+ *
+ * The roots are found by a RootWalker that the runner of the program
+ * supplies. The walker visits each Value that may refer to the heap
+ * exactly once. The VM's walker visits its globals and the windows of
+ * its active calls (see vm.cc). Values carry their kind, so a window is
+ * scanned precisely without a stack map. The tree-walking interpreter
+ * (interp.h) supplies no walker, so nothing is collected when it runs:
+ * its Eval methods hold Values on the C stack where nothing could find
+ * them. Its objects simply fill the old generation.
+ *
+ * A minor collection also needs the references from old objects to the
+ * nursery. The write barrier finds them: a store of a reference into
+ * an object marks the 512-byte card of the heap that it lands in. A
+ * minor collection goes through the dirty cards of the old generation
+ * only, and clears them.
+ *
+ * The runtime is single-threaded, so the nursery's bump pointer is just
+ * a static variable. -gc-stats reports the collections and their pauses
+ * on stderr after the run, and -nursery <n>[K|M] sets the size of the
+ * nursery.
+ */
+
+#ifndef _H_gc
+#define _H_gc
+
+#include <stdio.h>
+#include <stddef.h>
+#include "value.h"
+
+// A run of n Values, some of which may refer to the heap.
+typedef void (*ValueVisitor)(Value *values, int n);
+
+// Calls visit on each of the roots, once each.
+typedef void (*RootWalker)(ValueVisitor visit);
+
+class Heap
+{
+  public:
+    static const int CardShift = 9;         // a card is 512 bytes
+
+    // The card table, biased so that the card of address p is
+    // cards[(size_t)p >> CardShift].
+    static unsigned char *cards;
+
+    // In bytes, for the next run (4M by default).
+    static long long nurserySize;
+
+    // Empties the heap for a run and starts its statistics. walker finds
+    // the roots; with none, nothing is ever collected.
+    static void Start(RootWalker walker);
+    static void Finish();
+
+    // Room for a new object of n fields, or a new array of n elements,
+    // with nothing set in it. Either may collect garbage first.
+    static Object *NewObject(int numFields);
+    static ArrayObject *NewArray(int length);
+
+    // Room for count new arrays of length elements, one after another in
+    // a single block: the first is returned, and each of the others is
+    // ArrayStride(length) bytes after the one before.
+    static ArrayObject *NewArrays(int count, int length);
+    static size_t ArrayStride(int length);
+
+    // To follow the store of a Value into an object or array at slot:
+    // remembers it if the Value is a reference, for the next minor
+    // collection. The second form covers n Values stored from slots on,
+    // whatever they are.
+    static void WriteBarrier(Value *slot) {
+        if (slot->kind >= ObjectValue) cards[(size_t)slot >> CardShift] = 1;
+    }
+    static void WriteBarrier(Value *slots, int n);
+
+    // The statistics of the last run, for -gc-stats.
+    static void PrintStats(FILE *fp);
+};
+
+#endif
@@ -0,0 +1,55 @@
+/* File: hashtable.h
+ * -----------------
+ * This is a simple table for storing values associated with a string
+ * key, supporting simple operations for enter and lookup. It is not much
+ * more than a thin cover over the STL map class, in the same spirit as
+ * List (list.h) is a cover over deque.
+ *
+ * The keys are C strings. The table does not copy them, so they must
+ * stay valid while they are in the table (the names of Identifiers, for
+ * example, are never freed).
+ *
+ * Here is some sample code illustrating use of a Hashtable of ints:
+ *
+ *    Hashtable<int> *table = new Hashtable<int>;
+ *    table->Enter("Julie", 10);
+ *    int val = table->Lookup("Julie");   // 0 if not present
+ */
+
+#ifndef _H_hashtable
+#define _H_hashtable
+
+#include <map>
+#include <string.h>
+
+struct ltstr {
+  bool operator()(const char *s1, const char *s2) const
+    { return strcmp(s1, s2) < 0; }
+};
+
+template <class Value> class Hashtable {
+
+  private:
+    std::map<const char*, Value, ltstr> table;
+
+  public:
+           // Create a new empty table
+    Hashtable() {}
+
+           // Returns number of entries currently in table
+    int NumEntries() const
+        { return table.size(); }
+
+           // Associates value with key, replacing any previous value
+    void Enter(const char *key, Value value)
+        { table[key] = value; }
+
+           // Returns the value for key, or a zero Value (NULL for pointer
+           // types) if key is not in the table
+    Value Lookup(const char *key) const
+        { typename std::map<const char*, Value, ltstr>::const_iterator it =
+              table.find(key);
+          return it == table.end() ? Value() : it->second; }
+};
+
+#endif
@@ -0,0 +1,144 @@
+/* File: interp.cc
+ * ---------------
+ * Implementation of the interpreter's runtime support.
+ */
+
+#include "interp.h"
+#include <stdlib.h>
+#include <string.h>
+#include "gc.h"
+#include "dstring.h"
+#include "io.h"
+#include "ast_decl.h"
+#include "ast_type.h"
+#include "ast_stmt.h"
+#include "list.h"
+#include "utility.h"
+
+static const int StackSize = 1 << 20;     // in Values
+
+Value *Interpreter::stack = NULL;
+Value *Interpreter::stackLimit = NULL;
+Value *Interpreter::sp = NULL;
+int Interpreter::depth = 0;
+Value *Interpreter::globals = NULL;
+Value Interpreter::returnValue;
+jmp_buf Interpreter::halted;
+
+
+void Interpreter::Start(List<VarDecl*> *globalVars, FILE *in)
+{
+    IO::Start(in);
+    delete[] globals;
+    globals = new Value[globalVars->NumElements() + 1];
+    for (int i = 0; i < globalVars->NumElements(); i++)
+        globals[i] = ZeroOf(globalVars->Nth(i)->GetType());
+}
+
+int Interpreter::Run(FnDecl *main, List<VarDecl*> *globalVars, FILE *in)
+{
+    if (!stack) {
+        stack = new Value[StackSize];
+        stackLimit = stack + StackSize;
+    }
+    sp = stack;
+    depth = 0;
+    Start(globalVars, in);
+    Heap::Start(NULL);
+
+    int status = 0;
+    if (setjmp(halted) == 0) {
+        Value *frame = PushFrame(main);
+        main->GetBody()->Exec(frame);
+        PopFrame(frame);
+    } else {
+        status = 1;
+    }
+    Heap::Finish();
+    IO::Flush();
+    fflush(stdout);
+    return status;
+}
+
+Value *Interpreter::PushFrame(FnDecl *fn)
+{
+    int size = fn->GetFrameSize();
+    if (++depth > MaxDepth || sp + size > stackLimit)
+        Halt("Stack overflow");
+    Value *frame = sp;
+    memcpy(frame, fn->GetFrameInit(), size * sizeof(Value));
+    sp += size;
+    return frame;
+}
+
+void Interpreter::Halt(const char *msg)
+{
+    IO::Flush();
+    printf("Decaf runtime error: %s\n", msg);
+    longjmp(halted, 1);
+}
+
+
+/* Function: ZeroOf()
+ * ------------------
+ * The value a variable of the given type starts out with: 0, 0.0, false,
+ * the empty string, or null.
+ */
+Value Interpreter::ZeroOf(Type *type)
+{
+    if (type == Type::intType) return MakeInt(0);
+    if (type == Type::doubleType) return MakeDouble(0);
+    if (type == Type::boolType) return MakeBool(false);
+    if (type == Type::stringType) return MakeString(Strings::empty);
+    if (dynamic_cast<ArrayType*>(type)) return MakeArray(NULL);
+    if (type == Type::voidType) return MakeVoid();
+    return MakeObject(NULL);
+}
+
+Value Interpreter::NewObject(ClassDecl *cls)
+{
+    int n = cls->NumFields();
+    Object *obj = Heap::NewObject(n);
+    obj->cls = cls;
+    for (int i = 0; i < n; i++)
+        obj->fields[i] = ZeroOf(cls->GetField(i)->GetType());
+    return MakeObject(obj);
+}
+
+Value Interpreter::NewArray(int length, Type *elemType)
+{
+    if (length <= 0) Halt("Array size is <= 0");
+    ArrayObject *arr = Heap::NewArray(length);
+    arr->length = length;
+    Value zero = ZeroOf(elemType);
+    for (int i = 0; i < length; i++)
+        arr->elems[i] = zero;
+    return MakeArray(arr);
+}
+
+
+void Interpreter::Print(Value v)
+{
+    switch (v.kind) {
+      case IntValue:    IO::PrintInt(v.i); break;
+      case BoolValue:   IO::PrintBool(v.b); break;
+      case StringValue: IO::PrintString(v.s); break;
+      default:          Assert(0);
+    }
+}
+
+/* Function: ReadInteger()
+ * -----------------------
+ * Reads a line of input and converts its leading integer, the way the
+ * Decaf library's ReadInteger does; a line without one, or end of input,
+ * reads as 0.
+ */
+Value Interpreter::ReadInteger()
+{
+    return MakeInt(IO::ReadInteger());
+}
+
+Value Interpreter::ReadLine()
+{
+    return MakeString(IO::ReadLine());
+}
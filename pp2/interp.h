@@ -0,0 +1,80 @@
+/* File: interp.h
+ * --------------
+ * Support for running a checked program with the tree-walking
+ * interpreter. The interpreting itself is done by the nodes: statements
+ * Exec() and expressions Eval() themselves against the frame of the
+ * function they are in (see ast_stmt.h and ast_expr.h). This class holds
+ * what they share: the globals, the stack of frames, the heap, and
+ * input and output (see io.h).
+ *
+ * A frame is a run of Values holding a function's receiver (for
+ * methods), formals and locals, in the slots the semantic check assigned
+ * them (see FnDecl::AllocateSlot). Frames are carved out of one stack
+ * that is allocated once and reused by every call and every run, so a
+ * call costs no allocation. Objects and arrays come from the heap (see
+ * gc.h), which collects nothing while the tree is walked: the Values the
+ * Eval methods keep on the C stack are roots no collector could find.
+ *
+ * A runtime error prints its message and abandons the run with a
+ * longjmp back to Run, which is why the Eval and Exec methods must not
+ * keep anything on the C stack that needs destroying.
+ */
+
+#ifndef _H_interp
+#define _H_interp
+
+#include <stdio.h>
+#include <setjmp.h>
+#include "value.h"
+
+class FnDecl;
+class ClassDecl;
+class VarDecl;
+class Type;
+template <class Element> class List;
+
+typedef enum { ExecNormal, ExecBreak, ExecReturn } execResultT;
+
+class Interpreter
+{
+  private:
+    static Value *stack, *stackLimit, *sp;
+    static int depth;
+
+  public:
+    static Value *globals;
+
+    // Where Halt returns to; set up by whoever runs the program.
+    static jmp_buf halted;
+
+    // The value of the last return statement executed.
+    static Value returnValue;
+
+    // Runs main (with the given globals zeroed) reading input from in.
+    // Returns 0 if the program ran to completion and 1 if it stopped
+    // with a runtime error.
+    static int Run(FnDecl *main, List<VarDecl*> *globalVars, FILE *in);
+
+    // Sets up the globals and input for a run. Run does this itself; the
+    // VM (vm.h), which shares this runtime, calls it before its own run.
+    static void Start(List<VarDecl*> *globalVars, FILE *in);
+
+    // Reserves a frame for a call to fn, with every slot holding the
+    // zero value of its type, and gives it back when the call is done.
+    static Value *PushFrame(FnDecl *fn);
+    static void PopFrame(Value *frame) { sp = frame; depth--; }
+    static const int MaxDepth = 10000;     // calls deep, not counting inlined ones
+
+    // Reports a runtime error and abandons the run.
+    static void Halt(const char *msg) __attribute__((noreturn));
+
+    static Value ZeroOf(Type *type);
+    static Value NewObject(ClassDecl *cls);
+    static Value NewArray(int length, Type *elemType);
+
+    static void Print(Value v);
+    static Value ReadInteger();
+    static Value ReadLine();
+};
+
+#endif
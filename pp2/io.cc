@@ -0,0 +1,143 @@
+/* File: io.cc
+ * -----------
+ * Implementation of a running program's input and output.
+ */
+
+#include "io.h"
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include "interp.h"
+#include "utility.h"
+
+static const int OutSize = 256 << 10;
+static const int InSize = 256 << 10;   // to start with; a longer line grows it
+
+static char outBuf[OutSize];
+char *IO::outTop = outBuf;
+char *IO::outLimit = outBuf + OutSize;
+
+static FILE *input;
+static bool interactive;
+static char *inBuf;
+static size_t inSize;
+static char *inPos, *inEnd;    // what has been read but not yet taken
+
+
+void IO::Start(FILE *in)
+{
+    input = in;
+    int fd = fileno(in);
+    interactive = fd >= 0 && isatty(fd);
+    if (!inBuf) {
+        inSize = InSize;
+        inBuf = (char *)malloc(inSize);
+        if (!inBuf) Failure("Out of memory");
+    }
+    inPos = inEnd = inBuf;
+    outTop = outBuf;
+}
+
+void IO::Flush()
+{
+    if (outTop > outBuf) fwrite(outBuf, 1, outTop - outBuf, stdout);
+    outTop = outBuf;
+}
+
+void IO::PutSlow(const char *chars, int n)
+{
+    Flush();
+    if (n >= OutSize) {
+        fwrite(chars, 1, n, stdout);
+        return;
+    }
+    memcpy(outTop, chars, n);
+    outTop += n;
+}
+
+void IO::PrintInt(int i)
+{
+    char digits[12], *p = digits + sizeof(digits);
+    unsigned u = i < 0 ? 0u - (unsigned)i : (unsigned)i;
+    do {
+        *--p = '0' + u % 10;
+        u /= 10;
+    } while (u);
+    if (i < 0) *--p = '-';
+    Put(p, digits + sizeof(digits) - p);
+}
+
+/* Function: Fill()
+ * ----------------
+ * Reads more input after what is in the buffer and not yet taken,
+ * which is first moved to the front; a full buffer is doubled. From a
+ * terminal, output is flushed first and only a line is read. Returns
+ * false at end of input.
+ */
+static bool Fill()
+{
+    size_t left = inEnd - inPos;
+    memmove(inBuf, inPos, left);
+    inPos = inBuf;
+    inEnd = inBuf + left;
+    if (inSize - left < 2) {
+        inSize *= 2;
+        inBuf = (char *)realloc(inBuf, inSize);
+        if (!inBuf) Interpreter::Halt("Out of memory");
+        inPos = inBuf;
+        inEnd = inBuf + left;
+    }
+    size_t n;
+    if (interactive) {
+        IO::Flush();
+        fflush(stdout);
+        n = fgets(inEnd, inSize - left, input) ? strlen(inEnd) : 0;
+    } else {
+        n = fread(inEnd, 1, inSize - left, input);
+    }
+    inEnd += n;
+    return n > 0;
+}
+
+/* Makes sure the whole of the next line is in the buffer, and returns
+ * where it ends: at its newline, or at the end of input. */
+static char *LineEnd()
+{
+    size_t scanned = 0;
+    for (;;) {
+        char *nl = (char *)memchr(inPos + scanned, '\n', inEnd - inPos - scanned);
+        if (nl) return nl;
+        scanned = inEnd - inPos;
+        if (!Fill()) return inEnd;
+    }
+}
+
+const char *IO::ReadLine()
+{
+    char *end = LineEnd();
+    const char *line = Strings::New(inPos, end - inPos);
+    inPos = end < inEnd ? end + 1 : end;
+    return line;
+}
+
+/* Function: ReadInteger()
+ * -----------------------
+ * Takes a line and converts the int its text begins with, exactly as
+ * (int)strtol(line, NULL, 10) would: after any white space and a sign,
+ * as many digits as there are, the long they make clamped to the range
+ * of a long, then truncated to an int.
+ */
+int IO::ReadInteger()
+{
+    char *end = LineEnd(), *p = inPos;
+    while (p < end && (*p == ' ' || (*p >= '\t' && *p <= '\r'))) p++;
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-')) negative = *p++ == '-';
+    unsigned long limit = negative ? (unsigned long)LONG_MAX + 1 : LONG_MAX, value = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        unsigned digit = *p - '0';
+        value = value > (limit - digit) / 10 ? limit : value * 10 + digit;
+    }
+    inPos = end < inEnd ? end + 1 : end;
+    return (int)(long)(negative ? 0 - value : value);
+}
@@ -0,0 +1,58 @@
+/* File: io.h
+ * ----------
+ * The input and output of a running Decaf program, shared by the
+ * tree-walking interpreter and the VM: Print, ReadInteger and ReadLine.
+ *
+ * Output collects in a large buffer, with ints formatted by hand rather
+ * than by printf, and goes to stdout only when the buffer fills, when
+ * the run ends or halts, or before a read from a terminal, so that a
+ * prompt shows before the program waits on its answer.
+ *
+ * Input is read in bulk into a buffer of its own, and lines are cut out
+ * of it there; ReadInteger parses its line in place, as strtol would,
+ * without making a string of it. Only from a terminal is input read a
+ * line at a time, so as not to wait on more than the program asked for.
+ * Either way, whatever of the input stream a run has read ahead of its
+ * last read is gone when it ends.
+ */
+
+#ifndef _H_io
+#define _H_io
+
+#include <stdio.h>
+#include <string.h>
+#include "dstring.h"
+
+class IO
+{
+  public:
+    // Starts a run: input is read from in, output written to stdout.
+    static void Start(FILE *in);
+
+    // Writes what output is buffered to stdout (which is not flushed).
+    static void Flush();
+
+    static void PrintInt(int i);
+    static void PrintBool(bool b) { if (b) Put("true", 4); else Put("false", 5); }
+    static void PrintString(const char *s) { Put(s, Strings::Length(s)); }
+
+    // A line of input, or the int its text begins with (0 if none); end
+    // of input reads as an empty line.
+    static int ReadInteger();
+    static const char *ReadLine();
+
+  private:
+    static char *outTop, *outLimit;
+
+    static void Put(const char *chars, int n) {
+        if (n > outLimit - outTop) {
+            PutSlow(chars, n);
+            return;
+        }
+        memcpy(outTop, chars, n);
+        outTop += n;
+    }
+    static void PutSlow(const char *chars, int n);
+};
+
+#endif
@@ -0,0 +1,1296 @@
+/* File: jit.cc
+ * ------------
+ * Implementation of the JIT: a small x86-64 assembler, and a template in
+ * it for each opcode.
+ *
+ * The code for a function works on its registers in memory, addressed
+ * from rbx, which holds the function's window, but for those the
+ * RegisterAllocator puts in rbp, rsi, rdi, r8-r11, r14, r15 and xmm1 to
+ * xmm15; r12 holds the constant pool and r13 the globals. rax, rcx, rdx
+ * and xmm0 are scratch within a template.
+ *
+ * Instructions that are rare in loops or need the runtime (allocation,
+ * strings, division with its check for zero, input and output) call
+ * Slow(), which executes the one instruction in C; a JumpTable asks C
+ * where to go on, too. Slow() records where the VM's calls stand before
+ * an allocation, so the garbage collector can find their windows (see
+ * gc.h), and a store of a reference into an object or array marks its
+ * card for the write barrier. A call goes through VM::Enter, which runs the
+ * callee by machine code or by the VM as it can; a method that has to be
+ * looked up is taken from the call's inline cache when it can be. A runtime error calls
+ * Interpreter::Halt, whose longjmp abandons the machine code's frames
+ * along with the rest.
+ */
+
+#include "jit.h"
+
+#if defined(__x86_64__) && defined(__linux__)
+
+#include <string.h>
+#include <math.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <vector>
+#include <algorithm>
+#include "vm.h"
+#include "interp.h"
+#include "gc.h"
+#include "dstring.h"
+#include "io.h"
+#include "ast_decl.h"
+#include "ast_type.h"
+#include "utility.h"
+
+enum { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+
+// condition codes, as in the low bits of jcc and setcc
+enum { CondB = 0x2, CondAE = 0x3, CondE = 0x4, CondNE = 0x5, CondBE = 0x6,
+       CondA = 0x7, CondP = 0xa, CondNP = 0xb, CondL = 0xc, CondGE = 0xd,
+       CondLE = 0xe, CondG = 0xf };
+
+static BcProgram *program;
+static Value *constants, *globals;
+
+struct Region {
+    void *start;
+    size_t size;
+};
+static std::vector<Region> regions;
+
+
+/* Class: Assembler
+ * ----------------
+ * Encodes the few instructions the templates use. Memory operands are
+ * always [base + disp32]; opcodes above 0xff are two bytes (0x0f and
+ * the opcode proper).
+ */
+class Assembler
+{
+  public:
+    std::vector<unsigned char> code;
+
+    int Size() { return code.size(); }
+    void Byte(int b) { code.push_back(b); }
+    void Int32(int v) {
+        for (int i = 0; i < 32; i += 8) Byte((v >> i) & 0xff);
+    }
+    void Int64(unsigned long long v) {
+        for (int i = 0; i < 64; i += 8) Byte((v >> i) & 0xff);
+    }
+    void Patch32(int pos, int v) {
+        for (int i = 0; i < 4; i++) code[pos + i] = (v >> (8 * i)) & 0xff;
+    }
+
+    void Rex(bool w, int reg, int base) {
+        int rex = 0x40 | (w << 3) | ((reg >> 3) << 2) | (base >> 3);
+        if (rex != 0x40) Byte(rex);
+    }
+    void Opcode(int op) {
+        if (op > 0xff) Byte(op >> 8);
+        Byte(op & 0xff);
+    }
+    // op reg, [base + disp]
+    void OpMem(int prefix, bool w, int op, int reg, int base, int disp) {
+        if (prefix) Byte(prefix);
+        Rex(w, reg, base);
+        Opcode(op);
+        Byte(0x80 | ((reg & 7) << 3) | (base & 7));
+        if ((base & 7) == RSP) Byte(0x24);      // rsp and r12 need a SIB byte
+        Int32(disp);
+    }
+    // op reg, rm with both registers
+    void OpReg(bool w, int op, int reg, int rm) {
+        Rex(w, reg, rm);
+        Opcode(op);
+        Byte(0xc0 | ((reg & 7) << 3) | (rm & 7));
+    }
+
+    void Load32(int r, int base, int disp)  { OpMem(0, false, 0x8b, r, base, disp); }
+    void Store32(int r, int base, int disp) { OpMem(0, false, 0x89, r, base, disp); }
+    void Load64(int r, int base, int disp)  { OpMem(0, true, 0x8b, r, base, disp); }
+    void Store64(int r, int base, int disp) { OpMem(0, true, 0x89, r, base, disp); }
+    void Load8(int r, int base, int disp)   { OpMem(0, false, 0x8a, r, base, disp); }
+    void Store8(int r, int base, int disp)  { OpMem(0, false, 0x88, r, base, disp); }
+    void Store32Imm(int base, int disp, int imm) {
+        OpMem(0, false, 0xc7, 0, base, disp);
+        Int32(imm);
+    }
+    void Cmp8Imm(int base, int disp, int imm) {
+        OpMem(0, false, 0x80, 7, base, disp);
+        Byte(imm);
+    }
+    // movsd, addsd and the like, and ucomisd (prefix 0x66)
+    void Sse(int prefix, int op, int xmm, int base, int disp) {
+        OpMem(prefix, false, 0x0f00 | op, xmm, base, disp);
+    }
+    // the same with a register for the second operand
+    void SseReg(int prefix, bool w, int op, int xmm, int rm) {
+        Byte(prefix);
+        OpReg(w, 0x0f00 | op, xmm, rm);
+    }
+    void Mov64(int dst, int src) { OpReg(true, 0x89, src, dst); }
+    void Mov32(int dst, int src) { OpReg(false, 0x89, src, dst); }
+    void MovImm32(int r, int imm) {
+        Rex(false, 0, r);
+        Byte(0xb8 | (r & 7));
+        Int32(imm);
+    }
+    void MovImm64(int r, unsigned long long imm) {
+        Rex(true, 0, r);
+        Byte(0xb8 | (r & 7));
+        Int64(imm);
+    }
+    void MovImm64(int r, const void *p) { MovImm64(r, (unsigned long long)p); }
+    void Lea(int r, int base, int disp) { OpMem(0, true, 0x8d, r, base, disp); }
+    void Setcc(int cond, int r) { OpReg(false, 0x0f90 | cond, 0, r); }
+    void Push(int r) { Rex(false, 0, r); Byte(0x50 | (r & 7)); }
+    void Pop(int r)  { Rex(false, 0, r); Byte(0x58 | (r & 7)); }
+    void Ret() { Byte(0xc3); }
+    void JmpReg(int r) { OpReg(false, 0xff, 4, r); }
+    void Call(const void *fn) {
+        MovImm64(RAX, fn);
+        OpReg(false, 0xff, 2, RAX);
+    }
+    // Jumps return where their rel32 is, for Patch32 once the target is known.
+    int Jmp() { Byte(0xe9); Int32(0); return Size() - 4; }
+    int Jcc(int cond) { Opcode(0x0f80 | cond); Int32(0); return Size() - 4; }
+    void PatchJump(int pos, int target) { Patch32(pos, target - (pos + 4)); }
+};
+
+
+static int KindOf(int reg)  { return reg * sizeof(Value) + offsetof(Value, kind); }
+static int ValueOf(int reg) { return reg * sizeof(Value) + offsetof(Value, i); }
+
+/* Function: Slow()
+ * ----------------
+ * Executes one of the instructions the machine code leaves to C, as the
+ * VM would.
+ */
+static void Slow(Value *regs, const Instr *in)
+{
+    Value *a = &regs[in->a], *b = &regs[in->b], *c = &regs[in->c];
+    switch (in->op) {
+      case OpDivInt:
+        if (c->i == 0) Interpreter::Halt("Division by zero");
+        *a = MakeInt(c->i == -1 ? -(unsigned)b->i : b->i / c->i);
+        break;
+      case OpModInt:
+        if (c->i == 0) Interpreter::Halt("Division by zero");
+        *a = MakeInt(c->i == -1 ? 0 : b->i % c->i);
+        break;
+      case OpModDouble:    *a = MakeDouble(fmod(b->d, c->d)); break;
+      case OpEqualString:  *a = MakeBool(Strings::Equal(b->s, c->s)); break;
+      case OpNotEqualString: *a = MakeBool(!Strings::Equal(b->s, c->s)); break;
+      case OpNewObject:
+        VM::NativeSafepoint();
+        *a = Interpreter::NewObject(program->classes.Nth(in->b));
+        break;
+      case OpNewArray:
+        VM::NativeSafepoint();
+        *a = Interpreter::NewArray(b->i, program->types.Nth(in->c));
+        break;
+      case OpPrintInt:     IO::PrintInt(a->i); break;
+      case OpPrintBool:    IO::PrintBool(a->b); break;
+      case OpPrintString:  IO::PrintString(a->s); break;
+      case OpReadInteger:  *a = Interpreter::ReadInteger(); break;
+      case OpReadLine:     *a = Interpreter::ReadLine(); break;
+      default: Assert(0);
+    }
+}
+
+/* The write barrier for a MapElems copy, whose operands are in ops. */
+static void CopyBarrier(Value *ops)
+{
+    int from = ops[1].i, to = ops[2].i;
+    if (from < to) Heap::WriteBarrier(ops[0].arr->elems + from, to - from);
+}
+
+/* A MapElems of NewArray, whose operands are in ops. */
+static void NewRows(Value *ops, Type *elemType)
+{
+    VM::NativeSafepoint();
+    VM::NewRows(ops, elemType);
+}
+
+/* Where the machine code of a JumpTable goes on: the code of the entry
+ * for the value, or of the instruction after it. */
+static unsigned char *TableEntry(Value *regs, const Instr *in, BcFunction *fn)
+{
+    const int *table = fn->tables + in->Target();
+    unsigned index = (unsigned)regs[in->a].i - (unsigned)table[0];
+    int pc = index < (unsigned)table[1] ? table[2 + index] : in - fn->code + 1;
+    return fn->native + fn->nativeOffsets[pc];
+}
+
+/* The method a call's receiver has, for when its inline cache holds
+ * another class, which the cache then remembers in its place. */
+static BcFunction *LookupVirtual(Object *obj, int index, InlineCache *cache)
+{
+    cache->cls = obj->cls;
+    return cache->callee = program->functions.Nth(obj->cls->GetMethod(index)->GetCodeIndex());
+}
+
+static BcFunction *LookupInterface(Object *obj, const char *name, InlineCache *cache)
+{
+    cache->cls = obj->cls;
+    return cache->callee = program->functions.Nth(obj->cls->LookupMethod(name)->GetCodeIndex());
+}
+
+
+/* The instructions the machine code leaves to Slow(). */
+static bool IsSlow(int op)
+{
+    switch (op) {
+      case OpDivInt: case OpModInt: case OpModDouble:
+      case OpEqualString: case OpNotEqualString: case OpNewObject: case OpNewArray:
+      case OpPrintInt: case OpPrintBool: case OpPrintString:
+      case OpReadInteger: case OpReadLine:
+        return true;
+      default:
+        return false;
+    }
+}
+
+// Whether the code of op calls out to C (or to another function).
+static bool CallsOut(int op)
+{
+    return IsSlow(op) || op == OpJumpTable || op == OpMapElems ||
+           op == OpCall || op == OpCallMethod || op == OpCallVirtual || op == OpCallInterface;
+}
+
+/* The registers an instruction reads, but for the arguments of a call,
+ * and the one it writes, or -1. */
+static void GetOperands(const Instr &in, std::vector<int> *uses, int *def)
+{
+    *def = -1;
+    switch (in.op) {
+      case OpMove: case OpLength: case OpNegate: case OpNegateDouble: case OpNotBool:
+      case OpGetField: case OpNewArray: case OpAddIntImm:
+        *def = in.a;
+        uses->push_back(in.b);
+        return;
+      case OpLoadInt: case OpLoadConst: case OpLoadGlobal: case OpNewObject:
+      case OpReadInteger: case OpReadLine:
+      case OpCall: case OpCallMethod: case OpCallVirtual: case OpCallInterface:
+        *def = in.a;
+        return;
+      case OpStoreGlobal:
+        uses->push_back(in.b);
+        return;
+      case OpSetField:
+        uses->push_back(in.a);
+        uses->push_back(in.c);
+        return;
+      case OpSetElem: case OpSetElemUnchecked:
+        uses->push_back(in.c);
+        // fall through
+      case OpSetElemConst: case OpSetElemConstUnchecked:
+      case OpJumpIfLessInt: case OpJumpIfLessEqualInt: case OpJumpIfGreaterInt:
+      case OpJumpIfGreaterEqualInt: case OpJumpIfEqualInt: case OpJumpIfNotEqualInt:
+        uses->push_back(in.a);
+        uses->push_back(in.b);
+        return;
+      case OpJumpIf: case OpJumpIfNot: case OpJumpTable: case OpReturn:
+      case OpPrintInt: case OpPrintBool: case OpPrintString:
+        uses->push_back(in.a);
+        return;
+      case OpJump: case OpReturnVoid:
+        return;
+      case OpMapElems:
+        for (int i = 0; i < (in.b == OpMove || in.b == OpNewArray ? 4 : 5); i++)
+            uses->push_back(in.a + i);
+        return;
+      default:          // the rest of the arithmetic and comparisons, GetElem
+        *def = in.a;
+        uses->push_back(in.b);
+        uses->push_back(in.c);
+        return;
+    }
+}
+
+// The instructions control can go on to after the one at pc.
+static void GetSuccessors(BcFunction *fn, int pc, std::vector<int> *succs)
+{
+    const Instr &in = fn->code[pc];
+    switch (in.op) {
+      case OpJump:
+        succs->push_back(in.Target());
+        return;
+      case OpJumpIf: case OpJumpIfNot:
+        succs->push_back(in.Target());
+        break;
+      case OpJumpTable: {
+        const int *table = fn->tables + in.Target();
+        for (int i = 0; i < table[1]; i++)
+            succs->push_back(table[2 + i]);
+        break;
+      }
+      case OpReturn: case OpReturnVoid:
+        return;
+      default:
+        if (IsCompareJump(in.op)) succs->push_back(in.c);
+        break;
+    }
+    succs->push_back(pc + 1);
+}
+
+// The kind of value an instruction writes, if it is always an int or a
+// double; VoidValue if not (a Move is up to its source).
+static int ResultKind(const Instr &in)
+{
+    switch (in.op) {
+      case OpLoadInt: case OpAddInt: case OpSubInt: case OpMulInt: case OpDivInt:
+      case OpModInt: case OpAddIntImm: case OpNegate: case OpLength: case OpReadInteger:
+        return IntValue;
+      case OpAddDouble: case OpSubDouble: case OpMulDouble: case OpDivDouble:
+      case OpModDouble: case OpNegateDouble:
+        return DoubleValue;
+      case OpLoadConst:
+        return constants[in.b].kind == IntValue || constants[in.b].kind == DoubleValue ?
+               constants[in.b].kind : VoidValue;
+      default:
+        return VoidValue;
+    }
+}
+
+// What is known of the kinds a register holds: none yet, one, or several.
+enum { NoKind = -2, MixedKinds = -1 };
+
+static void MergeKind(int *kind, int k)
+{
+    if (k == NoKind) return;
+    if (*kind == NoKind) *kind = k;
+    else if (*kind != k) *kind = MixedKinds;
+}
+
+
+/* Class: RegisterAllocator
+ * ------------------------
+ * Linear scan (Poletto and Sarkar), over the instructions in order,
+ * puts the registers of a function that are busiest in loops into
+ * machine registers.
+ *
+ * A register can live in a machine register only if it holds nothing
+ * but ints, or nothing but doubles, so that the kind of its value is
+ * known when it has to go back to the window. For code lowered from TAC
+ * the function's regKinds says which registers those are; otherwise it
+ * is those where every instruction writing it makes one (or moves one
+ * from a register that is also such), and if its value on entry is
+ * read, that is one too, by the type of the parameter or regInit. The
+ * registers from the first call's window up are left where they are, as
+ * the callee's.
+ *
+ * A register's live interval runs from the first instruction where it
+ * is live or assigned to the last, by liveness over the function's
+ * control flow. In order of their start, each interval gets a machine
+ * register that is free, or takes the one of the active interval ending
+ * last if that ends after it, which then stays in memory. Ints go in
+ * rbp, r14 and r15, which calls preserve (the intervals live across a
+ * call have first pick of these), and in rsi, rdi and r8-r11, which they
+ * do not; doubles in xmm1 to xmm15, which they do not either. An
+ * interval in a register a call does not preserve is split around each
+ * call it is live across: the value goes to its place in the window
+ * before the call and comes back after.
+ */
+class RegisterAllocator
+{
+  public:
+    std::vector<int> home;              // of each register: its machine register, or -1
+    std::vector<bool> isDouble;         // of each register: whether that is an xmm register
+    std::vector<int> kind;              // of each register below the first call's window:
+                                        // IntValue or DoubleValue if it holds only those
+    int allocated;
+
+    RegisterAllocator(BcFunction *fn);
+    // The registers in machine registers live into and out of pc.
+    void GetLiveIn(int pc, std::vector<int> *regs);
+    void GetLiveOut(int pc, std::vector<int> *regs);
+    static bool IsPreserved(int r) { return r == RBP || r == R14 || r == R15; }
+
+  private:
+    BcFunction *fn;
+    int limit;                          // the registers below it can be allocated
+    std::vector<std::vector<bool> > liveIn, liveOut;    // by instruction, by register
+
+    void ComputeLiveness();
+    void InferKinds();
+    void ChooseRegisters();
+};
+
+RegisterAllocator::RegisterAllocator(BcFunction *f)
+    : home(f->numRegs, -1), isDouble(f->numRegs, false), allocated(0), fn(f)
+{
+    limit = fn->numRegs;
+    for (int pc = 0; pc < fn->codeSize; pc++) {
+        const Instr &in = fn->code[pc];
+        if (in.op >= OpCall && in.op <= OpCallInterface && in.c < limit) limit = in.c;
+    }
+    ComputeLiveness();
+
+    kind.assign(limit, NoKind);
+    if (fn->regKinds) {
+        for (int v = 0; v < limit; v++)
+            kind[v] = fn->regKinds[v] == VoidValue ? (int)MixedKinds : (int)fn->regKinds[v];
+    } else {
+        InferKinds();
+    }
+    ChooseRegisters();
+}
+
+/* Without regKinds, the kinds are worked out from the code: what each
+ * instruction makes, and copies of that to a fixpoint. */
+void RegisterAllocator::InferKinds()
+{
+    std::vector<int> uses;
+    for (int v = 0; v < limit && fn->codeSize > 0; v++) {
+        if (!liveIn[0][v]) continue;
+        int entry = fn->regInit[v].kind;
+        if (v < fn->numParams) {
+            bool isMethod = fn->decl->IsMethod();
+            Type *t = v == 0 && isMethod ? NULL :
+                      fn->decl->GetFormals()->Nth(v - isMethod)->GetType();
+            entry = t == Type::intType ? IntValue : t == Type::doubleType ? DoubleValue : VoidValue;
+        }
+        MergeKind(&kind[v], entry);
+    }
+    for (int pc = 0; pc < fn->codeSize; pc++) {
+        const Instr &in = fn->code[pc];
+        int def;
+        uses.clear();
+        GetOperands(in, &uses, &def);
+        if (def >= 0 && def < limit && in.op != OpMove) MergeKind(&kind[def], ResultKind(in));
+    }
+    for (bool changed = true; changed; ) {
+        changed = false;
+        for (int pc = 0; pc < fn->codeSize; pc++) {
+            const Instr &in = fn->code[pc];
+            if (in.op != OpMove || in.a >= limit) continue;
+            int k = kind[in.a];
+            MergeKind(&kind[in.a], in.b < limit ? kind[in.b] : VoidValue);
+            if (kind[in.a] != k) changed = true;
+        }
+    }
+}
+
+void RegisterAllocator::ComputeLiveness()
+{
+    liveIn.assign(fn->codeSize, std::vector<bool>(limit, false));
+    liveOut.assign(fn->codeSize, std::vector<bool>(limit, false));
+    std::vector<int> succs, uses;
+    for (bool changed = true; changed; ) {
+        changed = false;
+        for (int pc = fn->codeSize - 1; pc >= 0; pc--) {
+            succs.clear();
+            GetSuccessors(fn, pc, &succs);
+            std::vector<bool> &out = liveOut[pc];
+            for (size_t i = 0; i < succs.size(); i++) {
+                if (succs[i] >= fn->codeSize) continue;
+                const std::vector<bool> &next = liveIn[succs[i]];
+                for (int v = 0; v < limit; v++)
+                    if (next[v] && !out[v]) out[v] = true;
+            }
+            std::vector<bool> in = out;
+            int def;
+            uses.clear();
+            GetOperands(fn->code[pc], &uses, &def);
+            if (def >= 0 && def < limit) in[def] = false;
+            for (size_t i = 0; i < uses.size(); i++)
+                if (uses[i] < limit) in[uses[i]] = true;
+            if (in != liveIn[pc]) {
+                liveIn[pc].swap(in);
+                changed = true;
+            }
+        }
+    }
+}
+
+struct Interval {
+    int reg, start, end;
+    bool acrossCall;
+
+    bool operator<(const Interval &other) const { return start < other.start; }
+};
+
+void RegisterAllocator::ChooseRegisters()
+{
+    std::vector<Interval> intervals;
+    std::vector<int> uses;
+    for (int v = 0; v < limit; v++) {
+        if (kind[v] != IntValue && kind[v] != DoubleValue) continue;
+        Interval interval = { v, -1, -1, false };
+        for (int pc = 0; pc < fn->codeSize; pc++) {
+            int def;
+            uses.clear();
+            GetOperands(fn->code[pc], &uses, &def);
+            if (!liveIn[pc][v] && def != v) continue;
+            if (interval.start < 0) interval.start = pc;
+            interval.end = pc;
+            if (CallsOut(fn->code[pc].op) && liveOut[pc][v] && def != v)
+                interval.acrossCall = true;
+        }
+        if (interval.start >= 0) intervals.push_back(interval);
+    }
+    std::stable_sort(intervals.begin(), intervals.end());
+
+    static const int preserved[] = { R14, R15, RBP };
+    static const int scratch[] = { RSI, RDI, R8, R9, R10, R11 };
+    std::vector<int> ints(preserved, preserved + 3), xmms;
+    ints.insert(ints.end(), scratch, scratch + 6);
+    for (int x = 1; x < 16; x++)
+        xmms.push_back(x);
+    std::vector<Interval*> intOwner(16, (Interval *)NULL), xmmOwner(16, (Interval *)NULL);
+
+    for (size_t i = 0; i < intervals.size(); i++) {
+        Interval &cur = intervals[i];
+        bool dbl = kind[cur.reg] == DoubleValue;
+        std::vector<Interval*> &owner = dbl ? xmmOwner : intOwner;
+        for (int r = 0; r < 16; r++) {
+            if (owner[r] && owner[r]->end < cur.start) owner[r] = NULL;
+            if (owner[r] && home[owner[r]->reg] != r) owner[r] = NULL;    // lost it
+        }
+        // those calls preserve for what lives across them, the others first for the rest
+        std::vector<int> order = dbl ? xmms : ints;
+        if (!dbl && !cur.acrossCall) std::rotate(order.begin(), order.begin() + 3, order.end());
+        int chosen = -1;
+        for (size_t k = 0; k < order.size() && chosen < 0; k++)
+            if (!owner[order[k]]) chosen = order[k];
+        if (chosen < 0) {
+            Interval *last = NULL;
+            for (size_t k = 0; k < order.size(); k++)
+                if (!last || owner[order[k]]->end > last->end) last = owner[order[k]];
+            if (last->end <= cur.end) continue;
+            chosen = home[last->reg];
+            home[last->reg] = -1;
+        }
+        owner[chosen] = &cur;
+        home[cur.reg] = chosen;
+        isDouble[cur.reg] = dbl;
+    }
+    for (int v = 0; v < limit; v++)
+        if (home[v] >= 0) allocated++;
+}
+
+void RegisterAllocator::GetLiveIn(int pc, std::vector<int> *regs)
+{
+    for (int v = 0; v < limit; v++)
+        if (liveIn[pc][v] && home[v] >= 0) regs->push_back(v);
+}
+
+void RegisterAllocator::GetLiveOut(int pc, std::vector<int> *regs)
+{
+    for (int v = 0; v < limit; v++)
+        if (liveOut[pc][v] && home[v] >= 0) regs->push_back(v);
+}
+
+
+/* Class: Compiler
+ * ---------------
+ * Compiles one function. Jumps are patched once the code of every
+ * instruction has its place; the checks that fail all jump to stubs at
+ * the end that report the error.
+ */
+class Compiler
+{
+  private:
+    BcFunction *fn;
+    Assembler as;
+    RegisterAllocator allocator;
+    std::vector<int> offsets;           // of the code of each instruction
+    std::vector<int> jumps, targets;    // jumps to instructions
+    std::vector<int> toReturn, toNull, toBounds;
+
+    bool InReg(int reg) { return allocator.home[reg] >= 0; }
+    int Home(int reg) { return allocator.home[reg]; }
+    void Spill(int reg, int base, int disp);
+    void Fill(int reg, int base, int disp);
+    void Put(int base, int disp, int reg);
+    void Get(int reg, int base, int disp);
+    void LoadInt(int r, int reg);
+    void IntOp(int op, int r, int reg);
+    void LoadDouble(int xmm, int reg);
+    void SseOp(int prefix, int op, int xmm, int reg);
+    void Copy(int dstBase, int dstDisp, int srcBase, int srcDisp);
+    void StoreInt(int reg);
+    void StoreBool(int reg);
+    void StoreDouble(int reg);
+    void CheckNull();
+    void Barrier(int reg, int disp);
+    void ElementAddress(int arrayReg, int indexReg, bool checked = true);
+    void JumpTo(int cond, int target);
+    void Call(const Instr &in);
+    void Compare(int cond, const Instr &in);
+    void CompareDouble(int cond, const Instr &in, bool swap);
+    void Arithmetic(int op, const Instr &in);
+    void ArithmeticDouble(int op, const Instr &in);
+    void MapElems(const Instr &in);
+    void Instruction(const Instr &in);
+    void InstructionAt(int pc);
+    void Stub(const char *msg);
+
+  public:
+    Compiler(BcFunction *f) : fn(f), allocator(f), offsets(f->codeSize) {}
+    bool Compile();
+};
+
+/* A register in a machine register goes to the Value at [base + disp],
+ * with its kind, or comes from it. */
+void Compiler::Spill(int reg, int base, int disp)
+{
+    if (allocator.isDouble[reg]) {
+        as.Store32Imm(base, disp + offsetof(Value, kind), DoubleValue);
+        as.Sse(0xf2, 0x11, Home(reg), base, disp + offsetof(Value, d));
+    } else {
+        as.Store32Imm(base, disp + offsetof(Value, kind), IntValue);
+        as.Store32(Home(reg), base, disp + offsetof(Value, i));
+    }
+}
+
+void Compiler::Fill(int reg, int base, int disp)
+{
+    if (allocator.isDouble[reg])
+        as.Sse(0xf2, 0x10, Home(reg), base, disp + offsetof(Value, d));
+    else
+        as.Load32(Home(reg), base, disp + offsetof(Value, i));
+}
+
+// The Value of a register, wherever it is, to [base + disp], and back
+void Compiler::Put(int base, int disp, int reg)
+{
+    if (InReg(reg)) Spill(reg, base, disp);
+    else Copy(base, disp, RBX, reg * sizeof(Value));
+}
+
+void Compiler::Get(int reg, int base, int disp)
+{
+    if (InReg(reg)) Fill(reg, base, disp);
+    else Copy(RBX, reg * sizeof(Value), base, disp);
+}
+
+// r = the int in reg
+void Compiler::LoadInt(int r, int reg)
+{
+    if (InReg(reg)) as.Mov32(r, Home(reg));
+    else as.Load32(r, RBX, ValueOf(reg));
+}
+
+// op r, the int in reg: op is the form taking a register first
+void Compiler::IntOp(int op, int r, int reg)
+{
+    if (InReg(reg)) as.OpReg(false, op, r, Home(reg));
+    else as.OpMem(0, false, op, r, RBX, ValueOf(reg));
+}
+
+void Compiler::LoadDouble(int xmm, int reg)
+{
+    SseOp(0xf2, 0x10, xmm, reg);                            // movsd
+}
+
+void Compiler::SseOp(int prefix, int op, int xmm, int reg)
+{
+    if (InReg(reg)) as.SseReg(prefix, false, op, xmm, Home(reg));
+    else as.Sse(prefix, op, xmm, RBX, ValueOf(reg));
+}
+
+// Value by value through rdx, which no template keeps anything in
+void Compiler::Copy(int dstBase, int dstDisp, int srcBase, int srcDisp)
+{
+    as.Load64(RDX, srcBase, srcDisp);
+    as.Store64(RDX, dstBase, dstDisp);
+    as.Load64(RDX, srcBase, srcDisp + 8);
+    as.Store64(RDX, dstBase, dstDisp + 8);
+}
+
+// reg = eax
+void Compiler::StoreInt(int reg)
+{
+    if (InReg(reg)) {
+        as.Mov32(Home(reg), RAX);
+        return;
+    }
+    as.Store32Imm(RBX, KindOf(reg), IntValue);
+    as.Store32(RAX, RBX, ValueOf(reg));
+}
+
+void Compiler::StoreBool(int reg)
+{
+    as.Store32Imm(RBX, KindOf(reg), BoolValue);
+    as.Store8(RAX, RBX, ValueOf(reg));
+}
+
+// reg = xmm0
+void Compiler::StoreDouble(int reg)
+{
+    if (InReg(reg)) {
+        as.SseReg(0xf2, false, 0x10, Home(reg), 0);
+        return;
+    }
+    as.Store32Imm(RBX, KindOf(reg), DoubleValue);
+    as.Sse(0xf2, 0x11, 0, RBX, ValueOf(reg));
+}
+
+// The object or array in rax must not be null.
+void Compiler::CheckNull()
+{
+    as.OpReg(true, 0x85, RAX, RAX);                         // test rax, rax
+    toNull.push_back(as.Jcc(CondE));
+}
+
+/* The write barrier (see gc.h) after reg is stored to [rax + disp]: the
+ * slot's card is marked if the Value is a reference. A register that
+ * only ever holds ints or doubles needs none. */
+void Compiler::Barrier(int reg, int disp)
+{
+    if (InReg(reg) || (reg < (int)allocator.kind.size() &&
+                       (allocator.kind[reg] == IntValue || allocator.kind[reg] == DoubleValue)))
+        return;
+    as.Cmp8Imm(RBX, KindOf(reg), ObjectValue);
+    int skip = as.Jcc(CondB);
+    as.Lea(RCX, RAX, disp);
+    as.OpReg(true, 0xc1, 5, RCX);                           // shr rcx, CardShift
+    as.Byte(Heap::CardShift);
+    as.MovImm64(RDX, Heap::cards);
+    as.OpReg(true, 0x01, RDX, RCX);                         // add rcx, rdx
+    as.OpMem(0, false, 0xc6, 0, RCX, 0);                    // mov byte [rcx], 1
+    as.Byte(1);
+    as.PatchJump(skip, as.Size());
+}
+
+/* Leaves in rax the address of the element, less the offset of elems.
+ * Compared unsigned, a negative index is out of bounds too. An access
+ * the optimizer proved safe skips the checks. */
+void Compiler::ElementAddress(int arrayReg, int indexReg, bool checked)
+{
+    Assert(sizeof(Value) == 16);
+    as.Load64(RAX, RBX, ValueOf(arrayReg));
+    if (checked) CheckNull();
+    LoadInt(RCX, indexReg);
+    if (checked) {
+        as.OpMem(0, false, 0x3b, RCX, RAX, offsetof(ArrayObject, length));  // cmp
+        toBounds.push_back(as.Jcc(CondAE));
+    }
+    as.OpReg(true, 0xc1, 4, RCX);                           // shl rcx, 4
+    as.Byte(4);
+    as.OpReg(true, 0x01, RCX, RAX);                         // add rax, rcx
+}
+
+void Compiler::JumpTo(int cond, int target)
+{
+    jumps.push_back(cond < 0 ? as.Jmp() : as.Jcc(cond));
+    targets.push_back(target);
+}
+
+/* The callee is found (for a method looked up, by the call's inline
+ * cache if the receiver's class is the one in it, and otherwise in C),
+ * then VM::Enter runs it in the window starting at register c and leaves
+ * its result there. */
+void Compiler::Call(const Instr &in)
+{
+    if (in.op != OpCall) {
+        as.Load64(RAX, RBX, ValueOf(in.c));
+        CheckNull();
+    }
+    if (in.op == OpCall || in.op == OpCallMethod) {
+        as.MovImm64(RDI, program->functions.Nth(in.b));
+    } else {
+        InlineCache *cache = fn->caches + in.b;
+        as.MovImm64(RDX, cache);
+        as.Load64(RCX, RAX, offsetof(Object, cls));
+        as.OpMem(0, true, 0x3b, RCX, RDX, offsetof(InlineCache, cls));   // cmp rcx, cls
+        int miss = as.Jcc(CondNE);
+        as.Load64(RDI, RDX, offsetof(InlineCache, callee));
+        int hit = as.Jmp();
+        as.PatchJump(miss, as.Size());
+        as.Mov64(RDI, RAX);
+        if (in.op == OpCallVirtual) {
+            as.MovImm32(RSI, cache->method);
+            as.Call((void *)LookupVirtual);
+        } else {
+            as.MovImm64(RSI, constants[cache->method].s);
+            as.Call((void *)LookupInterface);
+        }
+        as.Mov64(RDI, RAX);
+        as.PatchJump(hit, as.Size());
+    }
+    as.Lea(RSI, RBX, in.c * sizeof(Value));
+    as.Call((void *)VM::Enter);
+    if (in.a != in.c)
+        Copy(RBX, in.a * sizeof(Value), RBX, in.c * sizeof(Value));
+}
+
+void Compiler::Compare(int cond, const Instr &in)
+{
+    LoadInt(RAX, in.b);
+    IntOp(0x3b, RAX, in.c);                                 // cmp eax, c
+    as.Setcc(cond, RAX);
+    StoreBool(in.a);
+}
+
+/* ucomisd sets the flags as an unsigned compare would, and sets them all
+ * if either operand is NaN. So a < b is tested as b above a, which is
+ * false for NaN as C's < is; equality also needs the parity flag clear,
+ * and inequality is true if it is set. */
+void Compiler::CompareDouble(int cond, const Instr &in, bool swap)
+{
+    LoadDouble(0, swap ? in.c : in.b);
+    SseOp(0x66, 0x2e, 0, swap ? in.b : in.c);               // ucomisd
+    as.Setcc(cond, RAX);
+    if (cond == CondE) {
+        as.Setcc(CondNP, RCX);
+        as.OpReg(false, 0x20, RCX, RAX);                    // and al, cl
+    } else if (cond == CondNE) {
+        as.Setcc(CondP, RCX);
+        as.OpReg(false, 0x08, RCX, RAX);                    // or al, cl
+    }
+    StoreBool(in.a);
+}
+
+void Compiler::Arithmetic(int op, const Instr &in)
+{
+    LoadInt(RAX, in.b);
+    IntOp(op, RAX, in.c);
+    StoreInt(in.a);
+}
+
+void Compiler::ArithmeticDouble(int op, const Instr &in)
+{
+    LoadDouble(0, in.b);
+    SseOp(0xf2, op, 0, in.c);
+    StoreDouble(in.a);
+}
+
+/* A loop that walks rdi over the elements stored to, and rsi and r8
+ * over those of the operands that are arrays, with rcx counting down
+ * what is left; the operands that are values are in r9 and r10, or xmm1
+ * and xmm2. A copy moves each Value whole, by an SSE2 move of its
+ * sixteen bytes, after CopyBarrier has seen to the write barrier.
+ * Making rows is left to C. InstructionAt has the allocated registers
+ * these clobber saved, as for a call. */
+void Compiler::MapElems(const Instr &in)
+{
+    const int size = sizeof(Value), elems = offsetof(ArrayObject, elems);
+    int op = in.b, scalars = in.c;
+    bool isInt = op == OpAddInt || op == OpSubInt || op == OpMulInt;
+    if (op == OpNewArray) {
+        as.Lea(RDI, RBX, in.a * size);
+        as.MovImm64(RSI, program->types.Nth(scalars));
+        as.Call((void *)NewRows);
+        return;
+    }
+    if (op == OpMove) {
+        as.Lea(RDI, RBX, in.a * size);
+        as.Call((void *)CopyBarrier);
+    }
+    as.Load32(RCX, RBX, ValueOf(in.a + 2));                 // to
+    as.OpMem(0, false, 0x2b, RCX, RBX, ValueOf(in.a + 1));  // sub ecx, from
+    int skip = as.Jcc(CondLE);
+    as.OpMem(0, true, 0x63, RDX, RBX, ValueOf(in.a + 1));   // movsxd rdx, from
+    as.OpReg(true, 0xc1, 4, RDX);                           // shl rdx, 4
+    as.Byte(4);
+
+    static const int pointers[] = { RDI, RSI, R8 }, ints[] = { -1, R9, R10 };
+    for (int k = 0; k < (op == OpMove ? 2 : 3); k++) {
+        int reg = in.a + (k == 0 ? 0 : k + 2);
+        if (k > 0 && scalars & k) {
+            if (op == OpMove) as.Sse(0xf3, 0x6f, k, RBX, reg * size);       // movdqu
+            else if (isInt) as.Load32(ints[k], RBX, ValueOf(reg));
+            else as.Sse(0xf2, 0x10, k, RBX, ValueOf(reg));
+            continue;
+        }
+        as.Load64(pointers[k], RBX, ValueOf(reg));
+        as.OpReg(true, 0x01, RDX, pointers[k]);             // add, rdx
+    }
+
+    int top = as.Size();
+    if (op == OpMove) {
+        if (!(scalars & 1)) as.Sse(0xf3, 0x6f, 1, RSI, elems);
+        as.Sse(0xf3, 0x7f, 1, RDI, elems);
+    } else if (isInt) {
+        static const int forms[] = { 0x03, 0x2b, 0x0faf };  // add, sub, imul
+        int form = forms[op - OpAddInt];
+        if (scalars & 1) as.Mov32(RAX, R9);
+        else as.Load32(RAX, RSI, elems + offsetof(Value, i));
+        if (scalars & 2) as.OpReg(false, form, RAX, R10);
+        else as.OpMem(0, false, form, RAX, R8, elems + offsetof(Value, i));
+        as.Store32Imm(RDI, elems + offsetof(Value, kind), IntValue);
+        as.Store32(RAX, RDI, elems + offsetof(Value, i));
+    } else {
+        static const int forms[] = { 0x58, 0x5c, 0x59, 0x5e };  // add, sub, mul, div
+        int form = forms[op - OpAddDouble];
+        if (scalars & 1) as.SseReg(0xf2, false, 0x10, 0, 1);
+        else as.Sse(0xf2, 0x10, 0, RSI, elems + offsetof(Value, d));
+        if (scalars & 2) as.SseReg(0xf2, false, form, 0, 2);
+        else as.Sse(0xf2, form, 0, R8, elems + offsetof(Value, d));
+        as.Store32Imm(RDI, elems + offsetof(Value, kind), DoubleValue);
+        as.Sse(0xf2, 0x11, 0, RDI, elems + offsetof(Value, d));
+    }
+    for (int k = 0; k < (op == OpMove ? 2 : 3); k++) {
+        if (k > 0 && scalars & k) continue;
+        as.OpReg(true, 0x83, 0, pointers[k]);               // add, 16
+        as.Byte(size);
+    }
+    as.OpReg(false, 0xff, 1, RCX);                          // dec ecx
+    as.PatchJump(as.Jcc(CondNE), top);
+    as.PatchJump(skip, as.Size());
+}
+
+void Compiler::Instruction(const Instr &in)
+{
+    const int size = sizeof(Value);
+    switch (in.op) {
+      case OpMove:
+        if (!InReg(in.a))
+            Put(RBX, in.a * size, in.b);
+        else if (!InReg(in.b))
+            Fill(in.a, RBX, in.b * size);
+        else if (allocator.isDouble[in.a])
+            as.SseReg(0xf2, false, 0x10, Home(in.a), Home(in.b));
+        else
+            as.Mov32(Home(in.a), Home(in.b));
+        break;
+      case OpLoadInt:
+        if (InReg(in.a)) {
+            as.MovImm32(Home(in.a), (short)in.b);
+            break;
+        }
+        as.Store32Imm(RBX, KindOf(in.a), IntValue);
+        as.Store32Imm(RBX, ValueOf(in.a), (short)in.b);
+        break;
+      case OpLoadConst:
+        if (!InReg(in.a))
+            Copy(RBX, in.a * size, R12, in.b * size);
+        else if (allocator.isDouble[in.a])
+            Fill(in.a, R12, in.b * size);
+        else
+            as.MovImm32(Home(in.a), constants[in.b].i);
+        break;
+      case OpLoadGlobal:
+        Get(in.a, R13, in.b * size);
+        break;
+      case OpStoreGlobal:
+        Put(R13, in.a * size, in.b);
+        break;
+
+      case OpGetField:
+        as.Load64(RAX, RBX, ValueOf(in.b));
+        CheckNull();
+        Get(in.a, RAX, offsetof(Object, fields) + in.c * size);
+        break;
+      case OpSetField:
+        as.Load64(RAX, RBX, ValueOf(in.a));
+        CheckNull();
+        Put(RAX, offsetof(Object, fields) + in.b * size, in.c);
+        Barrier(in.c, offsetof(Object, fields) + in.b * size);
+        break;
+      case OpGetElem:
+        ElementAddress(in.b, in.c);
+        Get(in.a, RAX, offsetof(ArrayObject, elems));
+        break;
+      case OpSetElem:
+        ElementAddress(in.a, in.b);
+        Put(RAX, offsetof(ArrayObject, elems), in.c);
+        Barrier(in.c, offsetof(ArrayObject, elems));
+        break;
+      case OpSetElemConst:
+        ElementAddress(in.a, in.b);
+        Copy(RAX, offsetof(ArrayObject, elems), R12, in.c * size);
+        break;
+      case OpGetElemUnchecked:
+        ElementAddress(in.b, in.c, false);
+        Get(in.a, RAX, offsetof(ArrayObject, elems));
+        break;
+      case OpSetElemUnchecked:
+        ElementAddress(in.a, in.b, false);
+        Put(RAX, offsetof(ArrayObject, elems), in.c);
+        Barrier(in.c, offsetof(ArrayObject, elems));
+        break;
+      case OpSetElemConstUnchecked:
+        ElementAddress(in.a, in.b, false);
+        Copy(RAX, offsetof(ArrayObject, elems), R12, in.c * size);
+        break;
+      case OpLength:
+        as.Load64(RAX, RBX, ValueOf(in.b));
+        CheckNull();
+        as.Load32(RAX, RAX, offsetof(ArrayObject, length));
+        StoreInt(in.a);
+        break;
+
+      // 32-bit arithmetic wraps around, as the VM's does
+      case OpAddInt: Arithmetic(0x03, in); break;
+      case OpSubInt: Arithmetic(0x2b, in); break;
+      case OpMulInt: Arithmetic(0x0faf, in); break;
+      case OpAddIntImm:
+        LoadInt(RAX, in.b);
+        as.OpReg(false, 0x81, 0, RAX);                      // add eax, imm32
+        as.Int32((short)in.c);
+        StoreInt(in.a);
+        break;
+      case OpNegate:
+        LoadInt(RAX, in.b);
+        as.OpReg(false, 0xf7, 3, RAX);                      // neg eax
+        StoreInt(in.a);
+        break;
+      case OpAddDouble: ArithmeticDouble(0x58, in); break;
+      case OpSubDouble: ArithmeticDouble(0x5c, in); break;
+      case OpMulDouble: ArithmeticDouble(0x59, in); break;
+      case OpDivDouble: ArithmeticDouble(0x5e, in); break;
+      case OpNegateDouble:
+        LoadDouble(0, in.b);
+        as.SseReg(0x66, true, 0x7e, 0, RAX);                // movq rax, xmm0
+        as.OpReg(true, 0x0fba, 7, RAX);                     // btc rax, 63
+        as.Byte(63);
+        as.SseReg(0x66, true, 0x6e, 0, RAX);                // movq xmm0, rax
+        StoreDouble(in.a);
+        break;
+
+      case OpLessInt:         Compare(CondL, in); break;
+      case OpLessEqualInt:    Compare(CondLE, in); break;
+      case OpGreaterInt:      Compare(CondG, in); break;
+      case OpGreaterEqualInt: Compare(CondGE, in); break;
+      case OpEqualInt:        Compare(CondE, in); break;
+      case OpNotEqualInt:     Compare(CondNE, in); break;
+      case OpLessDouble:         CompareDouble(CondA, in, true); break;
+      case OpLessEqualDouble:    CompareDouble(CondAE, in, true); break;
+      case OpGreaterDouble:      CompareDouble(CondA, in, false); break;
+      case OpGreaterEqualDouble: CompareDouble(CondAE, in, false); break;
+      case OpEqualDouble:        CompareDouble(CondE, in, false); break;
+      case OpNotEqualDouble:     CompareDouble(CondNE, in, false); break;
+      case OpEqualBool: case OpNotEqualBool:
+        as.Load8(RAX, RBX, ValueOf(in.b));
+        as.OpMem(0, false, 0x3a, RAX, RBX, ValueOf(in.c));  // cmp al, c
+        as.Setcc(in.op == OpEqualBool ? CondE : CondNE, RAX);
+        StoreBool(in.a);
+        break;
+      case OpEqualRef: case OpNotEqualRef:
+        as.Load64(RAX, RBX, ValueOf(in.b));
+        as.OpMem(0, true, 0x3b, RAX, RBX, ValueOf(in.c));   // cmp rax, c
+        as.Setcc(in.op == OpEqualRef ? CondE : CondNE, RAX);
+        StoreBool(in.a);
+        break;
+      case OpNotBool:
+        as.Load8(RAX, RBX, ValueOf(in.b));
+        as.Byte(0x34);                                      // xor al, 1
+        as.Byte(1);
+        StoreBool(in.a);
+        break;
+
+      case OpJump:
+        JumpTo(-1, in.Target());
+        break;
+      case OpJumpIf: case OpJumpIfNot:
+        as.Cmp8Imm(RBX, ValueOf(in.a), 0);
+        JumpTo(in.op == OpJumpIf ? CondNE : CondE, in.Target());
+        break;
+      case OpJumpIfLessInt: case OpJumpIfLessEqualInt: case OpJumpIfGreaterInt:
+      case OpJumpIfGreaterEqualInt: case OpJumpIfEqualInt: case OpJumpIfNotEqualInt: {
+        static const int conds[] = { CondL, CondLE, CondG, CondGE, CondE, CondNE };
+        LoadInt(RAX, in.a);
+        IntOp(0x3b, RAX, in.b);
+        JumpTo(conds[in.op - OpJumpIfLessInt], in.c);
+        break;
+      }
+      case OpJumpTable:
+        as.Mov64(RDI, RBX);
+        as.MovImm64(RSI, &in);
+        as.MovImm64(RDX, fn);
+        as.Call((void *)TableEntry);
+        as.JmpReg(RAX);
+        break;
+
+      case OpCall: case OpCallMethod: case OpCallVirtual: case OpCallInterface:
+        Call(in);
+        break;
+      case OpMapElems:
+        MapElems(in);
+        break;
+      case OpReturn:
+        if (in.a != 0 || InReg(in.a)) Put(RBX, 0, in.a);
+        toReturn.push_back(as.Jmp());
+        break;
+      case OpReturnVoid: {
+        unsigned long long words[2];
+        memcpy(words, &fn->returnZero, sizeof(words));
+        as.MovImm64(RAX, words[0]);
+        as.Store64(RAX, RBX, 0);
+        as.MovImm64(RAX, words[1]);
+        as.Store64(RAX, RBX, 8);
+        toReturn.push_back(as.Jmp());
+        break;
+      }
+
+      default:
+        Assert(IsSlow(in.op));
+        as.Mov64(RDI, RBX);
+        as.MovImm64(RSI, &in);
+        as.Call((void *)Slow);
+        break;
+    }
+}
+
+/* The code of the instruction at pc, with what the machine registers
+ * need around it: before a call, the registers live across it that the
+ * call does not preserve go to the window, and after it they come back;
+ * so do the operands of the instructions Slow() executes, which it takes
+ * from the window and leaves its result in. Where a JumpTable goes on,
+ * the registers are taken from the window, as where the VM enters. */
+void Compiler::InstructionAt(int pc)
+{
+    const Instr &in = fn->code[pc];
+    if (!CallsOut(in.op)) {
+        Instruction(in);
+        return;
+    }
+    std::vector<int> saved, uses;
+    int def;
+    GetOperands(in, &uses, &def);
+    allocator.GetLiveOut(pc, &saved);
+    for (size_t i = 0; i < saved.size(); ) {
+        int r = saved[i];
+        if (r == def || (RegisterAllocator::IsPreserved(Home(r)) && !allocator.isDouble[r] &&
+                         in.op != OpJumpTable))
+            saved.erase(saved.begin() + i);
+        else
+            i++;
+    }
+    for (size_t i = 0; i < saved.size(); i++)
+        Spill(saved[i], RBX, saved[i] * sizeof(Value));
+    if (IsSlow(in.op)) {
+        for (size_t i = 0; i < uses.size(); i++)
+            if (InReg(uses[i])) Spill(uses[i], RBX, uses[i] * sizeof(Value));
+    }
+    Instruction(in);
+    if (def >= 0 && InReg(def)) Fill(def, RBX, def * sizeof(Value));
+    for (size_t i = 0; i < saved.size(); i++)
+        Fill(saved[i], RBX, saved[i] * sizeof(Value));
+}
+
+void Compiler::Stub(const char *msg)
+{
+    as.MovImm64(RDI, msg);
+    as.Call((void *)Interpreter::Halt);
+}
+
+/* Function: Compile()
+ * -------------------
+ * The prologue saves the registers the code uses and jumps to the entry
+ * it was given; six pushes and eight bytes on top of the return address
+ * keep the stack aligned for the calls the templates make.
+ *
+ * Where the VM can enter the code (the start, and the target of a jump
+ * back, or of a JumpTable) and registers are live in machine registers,
+ * the entry is a stub that takes them from the window first.
+ */
+bool Compiler::Compile()
+{
+    static const int saved[] = { RBX, R12, R13, R14, R15, RBP };
+    for (int i = 0; i < 6; i++)
+        as.Push(saved[i]);
+    as.OpReg(true, 0x83, 5, RSP);                           // sub rsp, 8
+    as.Byte(8);
+    as.Mov64(RBX, RDI);
+    as.MovImm64(R12, constants);
+    as.MovImm64(R13, globals);
+    as.JmpReg(RSI);
+
+    std::vector<bool> isEntry(fn->codeSize + 1, false);
+    isEntry[0] = true;
+    std::vector<int> succs;
+    for (int pc = 0; pc < fn->codeSize; pc++) {
+        offsets[pc] = as.Size();
+        InstructionAt(pc);
+        const Instr &in = fn->code[pc];
+        if (in.op == OpJumpTable || in.op == OpJump || in.op == OpJumpIf ||
+            in.op == OpJumpIfNot || IsCompareJump(in.op)) {
+            succs.clear();
+            GetSuccessors(fn, pc, &succs);
+            for (size_t i = 0; i < succs.size(); i++)
+                if (in.op == OpJumpTable || succs[i] <= pc) isEntry[succs[i]] = true;
+        }
+    }
+
+    int epilogue = as.Size();
+    as.OpReg(true, 0x83, 0, RSP);                           // add rsp, 8
+    as.Byte(8);
+    for (int i = 5; i >= 0; i--)
+        as.Pop(saved[i]);
+    as.Ret();
+
+    std::vector<int> entries(offsets), live;
+    for (int pc = 0; pc < fn->codeSize; pc++) {
+        if (!isEntry[pc]) continue;
+        live.clear();
+        allocator.GetLiveIn(pc, &live);
+        if (live.empty()) continue;
+        entries[pc] = as.Size();
+        for (size_t i = 0; i < live.size(); i++)
+            Fill(live[i], RBX, live[i] * sizeof(Value));
+        jumps.push_back(as.Jmp());
+        targets.push_back(pc);
+    }
+    int nullStub = as.Size();
+    Stub("Null object reference");
+    int boundsStub = as.Size();
+    Stub("Array subscript out of bounds");
+
+    for (size_t i = 0; i < jumps.size(); i++)
+        as.PatchJump(jumps[i], offsets[targets[i]]);
+    for (size_t i = 0; i < toReturn.size(); i++)
+        as.PatchJump(toReturn[i], epilogue);
+    for (size_t i = 0; i < toNull.size(); i++)
+        as.PatchJump(toNull[i], nullStub);
+    for (size_t i = 0; i < toBounds.size(); i++)
+        as.PatchJump(toBounds[i], boundsStub);
+
+    // written while writable, then made executable instead
+    size_t size = (as.Size() + 4095) & ~(size_t)4095;
+    void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) return false;
+    memcpy(mem, &as.code[0], as.Size());
+    if (mprotect(mem, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(mem, size);
+        return false;
+    }
+    Region r = { mem, size };
+    regions.push_back(r);
+
+    fn->nativeOffsets = new int[fn->codeSize];
+    memcpy(fn->nativeOffsets, &entries[0], fn->codeSize * sizeof(int));
+    fn->native = (unsigned char *)mem;
+    PrintDebug("jit", "%s: %d instructions, %d bytes, %d registers in machine registers",
+               fn->name, fn->codeSize, as.Size(), allocator.allocated);
+    return true;
+}
+
+
+bool JIT::IsAvailable()
+{
+    return true;
+}
+
+void JIT::Start(BcProgram *p, Value *c, Value *g)
+{
+    program = p;
+    constants = c;
+    globals = g;
+}
+
+void JIT::Finish()
+{
+    for (size_t i = 0; i < regions.size(); i++)
+        munmap(regions[i].start, regions[i].size);
+    regions.clear();
+}
+
+bool JIT::Compile(BcFunction *fn)
+{
+    Compiler compiler(fn);
+    return compiler.Compile();
+}
+
+#else
+
+bool JIT::IsAvailable() { return false; }
+void JIT::Start(BcProgram *p, Value *c, Value *g) {}
+void JIT::Finish() {}
+bool JIT::Compile(BcFunction *fn) { return false; }
+
+#endif
@@ -0,0 +1,53 @@
+/* File: jit.h
+ * -----------
+ * A baseline JIT compiler from bytecode (see bytecode.h) to x86-64
+ * machine code, for the functions the VM finds hot. It works template by
+ * template, one instruction at a time: what it saves over the VM is the
+ * dispatch and the decoding of operands, which the machine code has
+ * built in, and, by a linear scan register allocator, the loads and
+ * stores of the int and double registers it keeps in machine registers.
+ *
+ * The machine code for a function keeps its other registers where the
+ * VM keeps them, in the function's window of the VM's stack (see vm.h),
+ * and the allocated ones there too wherever the VM can come in or
+ * another function can look: the VM can switch to it at the start, the
+ * top of a loop that has become hot, or a JumpTable's target, through a
+ * stub that loads what is live, and calls between compiled and
+ * interpreted functions need no translation. Every instruction is
+ * compiled, so the machine code never has to fall back to the VM part
+ * way through.
+ *
+ * Only x86-64 Linux is supported; elsewhere IsAvailable() is false and
+ * the VM interprets everything.
+ */
+
+#ifndef _H_jit
+#define _H_jit
+
+#include "bytecode.h"
+
+// Machine code for a function, entered with the function's registers
+// and the address of the code for the instruction to start at. The
+// function's result is left in its first register.
+typedef void (*NativeCode)(Value *regs, const unsigned char *entry);
+
+class JIT
+{
+  public:
+    // Calls plus loop iterations before a function is compiled.
+    static const int HotThreshold = 1000;
+
+    static bool IsAvailable();
+
+    // Prepares for compiling functions of the program about to run, with
+    // its constant pool and globals at the given addresses, and releases
+    // their machine code once the run is over.
+    static void Start(BcProgram *program, Value *constants, Value *globals);
+    static void Finish();
+
+    // Compiles fn, setting its native code. Returns false if it could
+    // not, and the function should go on being interpreted.
+    static bool Compile(BcFunction *fn);
+};
+
+#endif
@@ -2581,6 +2581,8 @@ void yyfree (void * ptr )
 
 
 
+#include "trace.h"
+
 /* Function: InitScanner
  * ---------------------
  * This function will be called before any calls to yylex().  It is designed
@@ -2592,15 +2594,19 @@ void yyfree (void * ptr )
  * is printed. Setting it to true will give you a running trail that might
  * be helpful when debugging your scanner. Please be sure the variable is
  * set to false when submitting your final version.
+ * When several files are compiled, it is called again before each one to
+ * start over at line 1 with an empty set of saved lines.
  */
 void InitScanner()
 {
+    TRACE_ZONE("InitScanner");
     PrintDebug("lex", "Initializing scanner");
     yy_flex_debug = false;
     BEGIN(N);
     yy_push_state(COPY); // copy first line at start
     curLineNum = 1;
     curColNum = 1;
+    savedLines = List<const char*>();
 }
 
 
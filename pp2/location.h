@@ -20,6 +20,7 @@ typedef struct yyltype
     int first_line, first_column;
     int last_line, last_column;      
     char *text;                    // you can also ignore this field
+    long long traceStart;          // when the token was asked for (-trace)
 } yyltype;
 
 #define YYLTYPE yyltype
@@ -0,0 +1,255 @@
+/* File: loops.cc
+ * --------------
+ * Implementation of finding and copying loops.
+ */
+
+#include "loops.h"
+#include <algorithm>
+#include "utility.h"
+
+
+static bool FewerBlocks(const Loop &a, const Loop &b)
+{
+    return a.blocks.size() < b.blocks.size();
+}
+
+/* Function: FindLoops()
+ * ---------------------
+ * Each back edge adds to its header's loop the blocks found walking
+ * back from its source to the header. A loop inside another has fewer
+ * blocks, so sorting by size puts inner loops first.
+ */
+void FindLoops(TacFunction *fn, DominatorTree &dom, std::vector<Loop> *loops)
+{
+    int numBlocks = fn->blocks.size();
+    std::vector<int> loopOf(numBlocks, -1);     // of each header
+    for (size_t i = 0; i < dom.order.size(); i++) {
+        int from = dom.order[i];
+        const std::vector<int> &succs = fn->blocks[from].succs;
+        for (size_t j = 0; j < succs.size(); j++) {
+            int header = succs[j];
+            if (!dom.Dominates(header, from)) continue;
+            if (loopOf[header] < 0) {
+                loopOf[header] = loops->size();
+                loops->push_back(Loop());
+                Loop &loop = loops->back();
+                loop.header = header;
+                loop.blocks.push_back(header);
+                loop.contains.assign(numBlocks, false);
+                loop.contains[header] = true;
+            }
+            Loop &loop = (*loops)[loopOf[header]];
+            std::vector<int> work(1, from);
+            while (!work.empty()) {
+                int b = work.back();
+                work.pop_back();
+                if (loop.contains[b]) continue;
+                loop.contains[b] = true;
+                loop.blocks.push_back(b);
+                const std::vector<int> &preds = fn->blocks[b].preds;
+                for (size_t k = 0; k < preds.size(); k++)
+                    if (dom.orderIndex[preds[k]] >= 0) work.push_back(preds[k]);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < loops->size(); i++) {
+        Loop &loop = (*loops)[i];
+        const std::vector<int> &preds = fn->blocks[loop.header].preds;
+        int entering = 0;
+        loop.preheader = -1;
+        for (size_t k = 0; k < preds.size(); k++) {
+            if (loop.contains[preds[k]]) continue;
+            entering++;
+            loop.preheader = preds[k];
+        }
+        if (entering != 1 || fn->blocks[loop.preheader].succs.size() != 1)
+            loop.preheader = -1;
+
+        loop.exit = -1;
+        bool single = true;
+        for (size_t j = 0; j < loop.blocks.size(); j++) {
+            const std::vector<int> &succs = fn->blocks[loop.blocks[j]].succs;
+            for (size_t k = 0; k < succs.size(); k++) {
+                if (loop.contains[succs[k]]) continue;
+                if (loop.exit >= 0 && loop.exit != succs[k]) single = false;
+                loop.exit = succs[k];
+            }
+        }
+        if (loop.exit >= 0) {
+            const std::vector<int> &exitPreds = fn->blocks[loop.exit].preds;
+            for (size_t k = 0; k < exitPreds.size(); k++)
+                if (!loop.contains[exitPreds[k]]) single = false;
+        }
+        if (!single) loop.exit = -1;
+    }
+    std::stable_sort(loops->begin(), loops->end(), FewerBlocks);
+}
+
+bool MakePreheader(TacFunction *fn, Loop *loop)
+{
+    const std::vector<int> &preds = fn->blocks[loop->header].preds;
+    int entering = -1, count = 0;
+    for (size_t k = 0; k < preds.size(); k++) {
+        if (loop->contains[preds[k]]) continue;
+        entering = preds[k];
+        count++;
+    }
+    if (count != 1 || loop->preheader >= 0) return false;
+
+    int preheader = fn->blocks.size();
+    TacBlock block;
+    TacInstr jump;
+    jump.op = TacJump;
+    jump.dst = -1;
+    jump.a = loop->header;
+    jump.b = jump.c = 0;
+    jump.firstArg = jump.numArgs = 0;
+    block.instrs.push_back(jump);
+    block.preds.push_back(entering);
+    block.succs.push_back(loop->header);
+    block.inlinedFrom = fn->blocks[loop->header].inlinedFrom;
+    fn->blocks.push_back(block);
+
+    std::vector<int*> slots;
+    fn->GetTargetSlots(fn->blocks[entering].Terminator(), &slots);
+    for (size_t k = 0; k < slots.size(); k++)
+        if (*slots[k] == loop->header) *slots[k] = preheader;
+    std::vector<int> &succs = fn->blocks[entering].succs;
+    std::replace(succs.begin(), succs.end(), loop->header, preheader);
+    std::vector<int> &headerPreds = fn->blocks[loop->header].preds;
+    std::replace(headerPreds.begin(), headerPreds.end(), entering, preheader);
+    loop->preheader = preheader;
+    return true;
+}
+
+/* Function: CopyLoop()
+ * --------------------
+ * As every way out of the loop goes through the exit, a value defined in
+ * the loop and used beyond it is used where the exit dominates, and a
+ * phi in the exit can take its place. That needs the definition to
+ * dominate the exit, which is checked before anything is changed.
+ */
+int CopyLoop(TacFunction *fn, const Loop &loop, DominatorTree &dom,
+             std::vector<int> *blockMap, std::vector<int> *regMap)
+{
+    Assert(fn->ssa && loop.preheader >= 0 && loop.exit >= 0);
+    int numBlocks = fn->blocks.size(), numRegs = fn->NumRegs();
+    std::vector<int> defBlock(numRegs, -1);
+    for (size_t i = 0; i < loop.blocks.size(); i++) {
+        const std::vector<TacInstr> &instrs = fn->blocks[loop.blocks[i]].instrs;
+        for (size_t j = 0; j < instrs.size(); j++)
+            if (instrs[j].dst >= 0) defBlock[instrs[j].dst] = loop.blocks[i];
+    }
+
+    // the exit's phis take their arguments from the loop, and from the
+    // copy too once it is made
+    std::vector<int> liveOut, uses;
+    std::vector<bool> isLiveOut(numRegs, false);
+    for (int b = 0; b < numBlocks; b++) {
+        if (loop.contains[b]) continue;
+        const std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        for (size_t j = 0; j < instrs.size(); j++) {
+            if (b == loop.exit && instrs[j].op == TacPhi) continue;
+            uses.clear();
+            fn->GetUses(instrs[j], &uses);
+            for (size_t k = 0; k < uses.size(); k++) {
+                int r = uses[k];
+                if (defBlock[r] < 0 || isLiveOut[r]) continue;
+                if (!dom.Dominates(defBlock[r], loop.exit)) return -1;
+                isLiveOut[r] = true;
+                liveOut.push_back(r);
+            }
+        }
+    }
+
+    blockMap->assign(numBlocks, -1);
+    regMap->assign(numRegs, -1);
+    for (size_t i = 0; i < loop.blocks.size(); i++)
+        (*blockMap)[loop.blocks[i]] = numBlocks + i;
+    for (int r = 0; r < numRegs; r++)
+        if (defBlock[r] >= 0) (*regMap)[r] = fn->NewReg(fn->regTypes[r]);
+
+    std::vector<int*> slots;
+    for (size_t i = 0; i < loop.blocks.size(); i++) {
+        int b = loop.blocks[i];
+        TacBlock copy;
+        copy.instrs = fn->blocks[b].instrs;
+        copy.inlinedFrom = fn->blocks[b].inlinedFrom;
+        const std::vector<int> &preds = fn->blocks[b].preds;
+        for (size_t k = 0; k < preds.size(); k++)
+            copy.preds.push_back(loop.contains[preds[k]] ? (*blockMap)[preds[k]] : preds[k]);
+        const std::vector<int> &succs = fn->blocks[b].succs;
+        for (size_t k = 0; k < succs.size(); k++)
+            copy.succs.push_back(loop.contains[succs[k]] ? (*blockMap)[succs[k]] : succs[k]);
+        for (size_t j = 0; j < copy.instrs.size(); j++) {
+            TacInstr &in = copy.instrs[j];
+            if (in.numArgs > 0) {
+                // a list of its own, for the renaming
+                int first = fn->args.size();
+                for (int k = 0; k < in.numArgs; k++) {
+                    int arg = fn->args[in.firstArg + k];
+                    fn->args.push_back(arg);
+                }
+                in.firstArg = first;
+            }
+            if (in.dst >= 0) in.dst = (*regMap)[in.dst];
+            slots.clear();
+            fn->GetUseSlots(in, &slots);
+            for (size_t k = 0; k < slots.size(); k++)
+                if ((*regMap)[*slots[k]] >= 0) *slots[k] = (*regMap)[*slots[k]];
+            slots.clear();
+            fn->GetTargetSlots(in, &slots);
+            for (size_t k = 0; k < slots.size(); k++)
+                if ((*blockMap)[*slots[k]] >= 0) *slots[k] = (*blockMap)[*slots[k]];
+        }
+        fn->blocks.push_back(copy);
+    }
+
+    // every predecessor of the exit is in the loop, and has a copy
+    TacBlock &exit = fn->blocks[loop.exit];
+    size_t numPreds = exit.preds.size();
+    for (size_t k = 0; k < numPreds; k++)
+        exit.preds.push_back((*blockMap)[exit.preds[k]]);
+    for (size_t j = 0; j < exit.instrs.size() && exit.instrs[j].op == TacPhi; j++) {
+        TacInstr &phi = exit.instrs[j];
+        int first = fn->args.size();
+        for (size_t k = 0; k < 2 * numPreds; k++) {
+            int arg = fn->args[phi.firstArg + k % numPreds];
+            if (k >= numPreds && (*regMap)[arg] >= 0) arg = (*regMap)[arg];
+            fn->args.push_back(arg);
+        }
+        phi.firstArg = first;
+        phi.numArgs = 2 * numPreds;
+    }
+    std::vector<int> merged(numRegs, -1);
+    std::vector<TacInstr> phis;
+    for (size_t i = 0; i < liveOut.size(); i++) {
+        int r = liveOut[i];
+        TacInstr phi;
+        phi.op = TacPhi;
+        phi.dst = merged[r] = fn->NewReg(fn->regTypes[r]);
+        phi.a = phi.b = phi.c = 0;
+        phi.firstArg = fn->args.size();
+        phi.numArgs = 2 * numPreds;
+        for (size_t k = 0; k < numPreds; k++)
+            fn->args.push_back(r);
+        for (size_t k = 0; k < numPreds; k++)
+            fn->args.push_back((*regMap)[r]);
+        phis.push_back(phi);
+    }
+    exit.instrs.insert(exit.instrs.begin(), phis.begin(), phis.end());
+
+    for (int b = 0; b < numBlocks; b++) {
+        if (loop.contains[b]) continue;
+        std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        for (size_t j = 0; j < instrs.size(); j++) {
+            if (b == loop.exit && instrs[j].op == TacPhi) continue;
+            slots.clear();
+            fn->GetUseSlots(instrs[j], &slots);
+            for (size_t k = 0; k < slots.size(); k++)
+                if (merged[*slots[k]] >= 0) *slots[k] = merged[*slots[k]];
+        }
+    }
+    return (*blockMap)[loop.header];
+}
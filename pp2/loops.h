@@ -0,0 +1,56 @@
+/* File: loops.h
+ * -------------
+ * The loops of a function's control flow graph, for the passes of the
+ * optimizer that work on loops (see opt.h), and loop versioning.
+ *
+ * A loop is a natural loop: a back edge is an edge to a block (the
+ * loop's header) from a block the header dominates, and the loop is the
+ * header with every block that reaches the source of one of its back
+ * edges without passing through it. Back edges to the same header make
+ * one loop.
+ *
+ * CopyLoop versions a loop in SSA form: it makes a second copy of the
+ * loop with registers of its own, for a pass to specialize and to enter
+ * instead of the original when a test made before it allows.
+ */
+
+#ifndef _H_loops
+#define _H_loops
+
+#include <vector>
+#include "tac.h"
+#include "ssa.h"
+
+struct Loop {
+    int header;
+    std::vector<int> blocks;        // the header first
+    std::vector<bool> contains;     // of each block of the function
+    int preheader;                  // the one block entering the loop,
+                                    // which goes nowhere else, or -1
+    int exit;                       // the one block the loop leaves to,
+                                    // which nothing else goes to, or -1
+};
+
+// The loops of a function as its edges and dominators stand, inner
+// loops before the loops they are in.
+void FindLoops(TacFunction *fn, DominatorTree &dom, std::vector<Loop> *loops);
+
+// Gives a loop that is entered by one edge, from a block that goes
+// elsewhere too, a preheader: a new block on that edge. Returns whether
+// it did; if so, the loops are to be found again.
+bool MakePreheader(TacFunction *fn, Loop *loop);
+
+// Copies a loop in SSA form that has a preheader and an exit. The copy
+// is like the loop but for its registers and blocks, which blockMap and
+// regMap give for those of the loop (-1 for the others), and leaves to
+// the same exit, where a value the loop defines and later code uses
+// comes from a phi of it and its copy. Nothing enters the copy: its
+// header has the preheader for a predecessor, in the place the loop's
+// header does, but the preheader does not go there; the caller is to
+// make it, and update the edges. Returns the copy's header, or -1 if
+// a value the loop defines is used beyond the exit in a way a phi there
+// cannot stand for, in which case nothing is changed.
+int CopyLoop(TacFunction *fn, const Loop &loop, DominatorTree &dom,
+             std::vector<int> *blockMap, std::vector<int> *regMap);
+
+#endif
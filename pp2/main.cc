@@ -1,31 +1,41 @@
 /* File: main.cc
  * -------------
  * This file defines the main() routine for the program and not much else.
- * You should not need to modify this file.
+ * The work of a compilation is done by the driver (driver.h).
  */
- 
+
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include "utility.h"
-#include "errors.h"
-#include "parser.h"
+#include "driver.h"
+#include "server.h"
 
 
 /* Function: main()
  * ----------------
  * Entry point to the entire program.  We parse the command line and turn
  * on any debugging flags requested by the user when invoking the program.
- * InitScanner() is used to set up the scanner.
- * InitParser() is used to set up the parser. The call to yyparse() will
- * attempt to parse a complete program from the input. 
+ * With --server, the process becomes a compile server; otherwise the
+ * input files named on the command line (or stdin, if there are none) are
+ * compiled once.
  */
 int main(int argc, char *argv[])
 {
     ParseCommandLine(argc, argv);
-  
-    InitScanner();
-    InitParser();
-    yyparse();
-    return (ReportError::NumErrors() == 0? 0 : -1);
-}
 
+    if (IsOptionOn("--server")) {
+        const char *limit = GetOptionValue("--time-limit");
+        int timeLimit = limit ? atoi(limit) : DefaultTimeLimit;
+        if (timeLimit <= 0) {
+            PrintUsage();
+            return 2;
+        }
+        return RunCompileServer(GetOptionValue("--server"), timeLimit);
+    }
+    if (IsOptionOn("--time-limit")) {
+        PrintUsage();
+        return 2;
+    }
+    return CompileProgram(stdin);
+}
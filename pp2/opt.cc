@@ -0,0 +1,2000 @@
+/* File: opt.cc
+ * ------------
+ * Implementation of the optimizer's passes and pass manager.
+ */
+
+#include "opt.h"
+#include <string.h>
+#include <math.h>
+#include <map>
+#include <algorithm>
+#include <string>
+#include "ssa.h"
+#include "loops.h"
+#include "ast_decl.h"
+#include "ast_type.h"
+#include "interp.h"
+#include "dstring.h"
+#include "timer.h"
+#include "utility.h"
+
+
+/* Function: Fold()
+ * ----------------
+ * Int arithmetic wraps around, as in ArithmeticExpr::Eval.
+ */
+bool Optimizer::Fold(int op, Value a, Value b, Value *result)
+{
+    unsigned x = a.i, y = b.i;
+    switch (op) {
+      case TacCopy:         *result = a; return true;
+      case TacAddInt:       *result = MakeInt(x + y); return true;
+      case TacSubInt:       *result = MakeInt(x - y); return true;
+      case TacMulInt:       *result = MakeInt(x * y); return true;
+      case TacDivInt:
+        if (b.i == 0) return false;
+        *result = MakeInt(b.i == -1 ? -x : a.i / b.i);
+        return true;
+      case TacModInt:
+        if (b.i == 0) return false;
+        *result = MakeInt(b.i == -1 ? 0 : a.i % b.i);
+        return true;
+      case TacNegInt:       *result = MakeInt(-x); return true;
+      case TacAddDouble:    *result = MakeDouble(a.d + b.d); return true;
+      case TacSubDouble:    *result = MakeDouble(a.d - b.d); return true;
+      case TacMulDouble:    *result = MakeDouble(a.d * b.d); return true;
+      case TacDivDouble:    *result = MakeDouble(a.d / b.d); return true;
+      case TacModDouble:    *result = MakeDouble(fmod(a.d, b.d)); return true;
+      case TacNegDouble:    *result = MakeDouble(-a.d); return true;
+      case TacLessInt:      *result = MakeBool(a.i < b.i); return true;
+      case TacLessEqualInt: *result = MakeBool(a.i <= b.i); return true;
+      case TacGreaterInt:   *result = MakeBool(a.i > b.i); return true;
+      case TacGreaterEqualInt: *result = MakeBool(a.i >= b.i); return true;
+      case TacEqualInt:     *result = MakeBool(a.i == b.i); return true;
+      case TacNotEqualInt:  *result = MakeBool(a.i != b.i); return true;
+      case TacLessDouble:   *result = MakeBool(a.d < b.d); return true;
+      case TacLessEqualDouble: *result = MakeBool(a.d <= b.d); return true;
+      case TacGreaterDouble: *result = MakeBool(a.d > b.d); return true;
+      case TacGreaterEqualDouble: *result = MakeBool(a.d >= b.d); return true;
+      case TacEqualDouble:  *result = MakeBool(a.d == b.d); return true;
+      case TacNotEqualDouble: *result = MakeBool(a.d != b.d); return true;
+      case TacEqualBool:    *result = MakeBool(a.b == b.b); return true;
+      case TacNotEqualBool: *result = MakeBool(a.b != b.b); return true;
+      case TacEqualString:  *result = MakeBool(Strings::Equal(a.s, b.s)); return true;
+      case TacNotEqualString: *result = MakeBool(!Strings::Equal(a.s, b.s)); return true;
+      case TacEqualRef:     *result = MakeBool(a.ref == b.ref); return true;
+      case TacNotEqualRef:  *result = MakeBool(a.ref != b.ref); return true;
+      case TacNotBool:      *result = MakeBool(!a.b); return true;
+      default:              return false;
+    }
+}
+
+/* Whether two constants are the same value; doubles by their bits, so
+ * that 0.0 and -0.0 stay apart. String constants are all interned. */
+static bool SameConstant(Value a, Value b)
+{
+    if (a.kind != b.kind) return false;
+    switch (a.kind) {
+      case IntValue:    return a.i == b.i;
+      case DoubleValue: return !memcmp(&a.d, &b.d, sizeof(double));
+      case BoolValue:   return a.b == b.b;
+      default:          return a.ref == b.ref;
+    }
+}
+
+static TacInstr MakeInstr(int op, int dst, int a = 0, int b = 0, int c = 0)
+{
+    TacInstr in;
+    in.op = op;
+    in.dst = dst;
+    in.a = a;
+    in.b = b;
+    in.c = c;
+    in.firstArg = in.numArgs = 0;
+    return in;
+}
+
+
+/* Sparse conditional constant propagation
+ * ---------------------------------------
+ * Each register's cell starts out unknown (Top) and can only go down,
+ * to a constant, then to varying (Bottom). Two worklists drive it: the
+ * edges of the graph found to be executable, and the registers whose
+ * cells have changed, whose uses must be looked at again. A block's
+ * instructions are looked at only once an edge into it is executable,
+ * and a phi meets only the arguments coming in by executable edges.
+ */
+enum { Top, Constant, Bottom };
+
+struct Cell {
+    int state;
+    Value value;
+};
+
+class ConstantPropagation
+{
+  private:
+    TacProgram *program;
+    TacFunction *fn;
+    std::vector<Cell> cells;
+    std::vector<std::vector<std::pair<int, int> > > useSites;  // block, instr
+    std::vector<std::vector<bool> > edgeExecutable;   // by block, then pred
+    std::vector<bool> blockExecutable;
+    std::vector<std::pair<int, int> > flowWork;       // edges
+    std::vector<int> ssaWork;                         // registers
+
+    void Lower(int reg, const Cell &c);
+    void AddEdge(int from, int to) { flowWork.push_back(std::make_pair(from, to)); }
+    void Visit(int block, int index);
+
+  public:
+    ConstantPropagation(TacProgram *program, TacFunction *fn);
+    void Solve();
+    void Rewrite();
+};
+
+ConstantPropagation::ConstantPropagation(TacProgram *p, TacFunction *f)
+{
+    program = p;
+    fn = f;
+    Cell top;
+    top.state = Top;
+    top.value = MakeVoid();
+    cells.assign(fn->NumRegs(), top);
+    for (int i = 0; i < fn->numParams; i++)
+        cells[i].state = Bottom;
+    useSites.resize(fn->NumRegs());
+    std::vector<int> uses;
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        TacBlock &block = fn->blocks[b];
+        edgeExecutable.push_back(std::vector<bool>(block.preds.size(), false));
+        for (size_t j = 0; j < block.instrs.size(); j++) {
+            uses.clear();
+            fn->GetUses(block.instrs[j], &uses);
+            for (size_t k = 0; k < uses.size(); k++)
+                useSites[uses[k]].push_back(std::make_pair((int)b, (int)j));
+        }
+    }
+    blockExecutable.assign(fn->blocks.size(), false);
+}
+
+void ConstantPropagation::Lower(int reg, const Cell &c)
+{
+    Cell &old = cells[reg];
+    if (old.state == c.state &&
+        (c.state != Constant || SameConstant(old.value, c.value)))
+        return;
+    old = c;
+    ssaWork.push_back(reg);
+}
+
+void ConstantPropagation::Visit(int block, int index)
+{
+    TacInstr &in = fn->blocks[block].instrs[index];
+    Cell result;
+    result.state = Bottom;
+    result.value = MakeVoid();
+    switch (in.op) {
+      case TacPhi: {
+        result.state = Top;
+        for (int k = 0; k < in.numArgs && result.state != Bottom; k++) {
+            if (!edgeExecutable[block][k]) continue;
+            const Cell &arg = cells[fn->args[in.firstArg + k]];
+            if (arg.state == Top) continue;
+            if (arg.state == Bottom || (result.state == Constant &&
+                                        !SameConstant(result.value, arg.value)))
+                result.state = Bottom;
+            else
+                result = arg;
+        }
+        break;
+      }
+      case TacJump:
+        AddEdge(block, in.a);
+        return;
+      case TacBranch: {
+        const Cell &cond = cells[in.a];
+        if (cond.state == Constant) {
+            AddEdge(block, cond.value.b ? in.b : in.c);
+        } else if (cond.state == Bottom) {
+            AddEdge(block, in.b);
+            AddEdge(block, in.c);
+        }
+        return;
+      }
+      case TacSwitch: {
+        const Cell &value = cells[in.a];
+        if (value.state == Constant) {
+            AddEdge(block, fn->SwitchTarget(in, value.value.i));
+        } else if (value.state == Bottom) {
+            for (size_t k = 0; k < fn->blocks[block].succs.size(); k++)
+                AddEdge(block, fn->blocks[block].succs[k]);
+        }
+        return;
+      }
+      case TacConst:
+        result.state = Constant;
+        result.value = program->constants.Nth(in.a);
+        break;
+      default:
+        if (in.dst < 0) return;
+        if (IsBinary(in.op) || IsUnary(in.op)) {
+            const Cell &a = cells[in.a];
+            const Cell &b = IsBinary(in.op) ? cells[in.b] : a;
+            if (a.state == Top || b.state == Top) {
+                result.state = Top;
+            } else if (a.state == Constant && b.state == Constant &&
+                       Optimizer::Fold(in.op, a.value, b.value, &result.value)) {
+                result.state = Constant;
+            }
+        }
+        break;
+    }
+    if (in.dst >= 0) Lower(in.dst, result);
+}
+
+void ConstantPropagation::Solve()
+{
+    AddEdge(-1, 0);
+    while (!flowWork.empty() || !ssaWork.empty()) {
+        if (!flowWork.empty()) {
+            int from = flowWork.back().first, to = flowWork.back().second;
+            flowWork.pop_back();
+            TacBlock &b = fn->blocks[to];
+            if (from >= 0) {
+                size_t k = 0;
+                while (b.preds[k] != from) k++;
+                if (edgeExecutable[to][k]) continue;
+                edgeExecutable[to][k] = true;
+            } else if (blockExecutable[to]) {
+                continue;
+            }
+            size_t j = 0;
+            for (; j < b.instrs.size() && b.instrs[j].op == TacPhi; j++)
+                Visit(to, j);
+            if (blockExecutable[to]) continue;
+            blockExecutable[to] = true;
+            for (; j < b.instrs.size(); j++)
+                Visit(to, j);
+        } else {
+            int reg = ssaWork.back();
+            ssaWork.pop_back();
+            for (size_t i = 0; i < useSites[reg].size(); i++) {
+                int b = useSites[reg][i].first;
+                if (blockExecutable[b]) Visit(b, useSites[reg][i].second);
+            }
+        }
+    }
+}
+
+/* The instructions found to compute constants become Consts (those that
+ * are phis after the block's remaining phis), and branches on constants
+ * jumps; the blocks never reached then drop out. */
+void ConstantPropagation::Rewrite()
+{
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        if (!blockExecutable[b]) continue;
+        std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        std::vector<TacInstr> phis, rest;
+        for (size_t j = 0; j < instrs.size(); j++) {
+            TacInstr in = instrs[j];
+            if (in.op == TacBranch && cells[in.a].state == Constant)
+                in = MakeInstr(TacJump, -1, cells[in.a].value.b ? in.b : in.c);
+            if (in.op == TacSwitch && cells[in.a].state == Constant)
+                in = MakeInstr(TacJump, -1, fn->SwitchTarget(in, cells[in.a].value.i));
+            if (in.dst >= 0 && in.op != TacConst && cells[in.dst].state == Constant)
+                in = MakeInstr(TacConst, in.dst, program->AddConstant(cells[in.dst].value));
+            if (in.op == TacPhi) phis.push_back(in);
+            else rest.push_back(in);
+        }
+        instrs.swap(phis);
+        instrs.insert(instrs.end(), rest.begin(), rest.end());
+    }
+    fn->ComputeEdges();
+    fn->RemoveUnreachable();
+}
+
+void Optimizer::PropagateConstants(TacProgram *program, TacFunction *fn)
+{
+    Assert(fn->ssa);
+    ConstantPropagation sccp(program, fn);
+    sccp.Solve();
+    sccp.Rewrite();
+}
+
+
+/* Global value numbering
+ * ----------------------
+ * The blocks are walked in preorder of the dominator tree, with a table
+ * of the values computed by the blocks dominating the current one: each
+ * pure operation, keyed by its opcode and the value numbers of its
+ * operands (in order, for a commutative operator), and each constant.
+ * A copy, or a phi whose arguments are all one value, just gives its
+ * register that value. Operations that can fail at runtime take part
+ * too, as the earlier one would already have failed; loads do not, as
+ * memory can change in between.
+ */
+struct ValueKey {
+    int op, a, b;
+    Value constant;         // for Const
+    std::string text;       // of a string constant, or a phi's arguments
+
+    bool operator<(const ValueKey &other) const {
+        if (op != other.op) return op < other.op;
+        if (a != other.a) return a < other.a;
+        if (b != other.b) return b < other.b;
+        if (op == TacConst) {
+            if (constant.kind != other.constant.kind) return constant.kind < other.constant.kind;
+            switch (constant.kind) {
+              case IntValue:    return constant.i < other.constant.i;
+              case BoolValue:   return constant.b < other.constant.b;
+              case DoubleValue: return memcmp(&constant.d, &other.constant.d, sizeof(double)) < 0;
+              case StringValue: break;
+              default:          return constant.ref < other.constant.ref;
+            }
+        }
+        return text < other.text;
+    }
+};
+
+static bool IsCommutative(int op)
+{
+    switch (op) {
+      case TacAddInt: case TacMulInt: case TacAddDouble: case TacMulDouble:
+      case TacEqualInt: case TacNotEqualInt: case TacEqualDouble: case TacNotEqualDouble:
+      case TacEqualBool: case TacNotEqualBool: case TacEqualString: case TacNotEqualString:
+      case TacEqualRef: case TacNotEqualRef:
+        return true;
+      default:
+        return false;
+    }
+}
+
+static int Leader(std::vector<int> &value, int reg)
+{
+    while (value[reg] != reg) reg = value[reg] = value[value[reg]];
+    return reg;
+}
+
+void Optimizer::NumberValues(TacProgram *program, TacFunction *fn)
+{
+    Assert(fn->ssa);
+    DominatorTree dom(fn);
+    std::vector<int> preorder;
+    dom.GetPreorder(&preorder);
+    std::vector<int> value(fn->NumRegs());
+    for (size_t i = 0; i < value.size(); i++)
+        value[i] = i;
+
+    std::map<ValueKey, int> table;
+    std::vector<std::map<ValueKey, int>::iterator> added;
+    std::vector<std::pair<int, size_t> > scopes;      // block, size of added
+    std::vector<int*> slots;
+    for (size_t i = 0; i < preorder.size(); i++) {
+        int b = preorder[i];
+        while (!scopes.empty() && scopes.back().first != dom.idom[b]) {
+            while (added.size() > scopes.back().second) {
+                table.erase(added.back());
+                added.pop_back();
+            }
+            scopes.pop_back();
+        }
+        scopes.push_back(std::make_pair(b, added.size()));
+
+        std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        std::vector<TacInstr> kept;
+        for (size_t j = 0; j < instrs.size(); j++) {
+            TacInstr &in = instrs[j];
+            slots.clear();
+            fn->GetUseSlots(in, &slots);
+            for (size_t k = 0; k < slots.size(); k++)
+                *slots[k] = Leader(value, *slots[k]);
+
+            ValueKey key;
+            key.op = in.op;
+            key.a = key.b = 0;
+            key.constant = MakeVoid();
+            if (in.op == TacCopy) {
+                value[in.dst] = in.a;
+                continue;
+            } else if (in.op == TacPhi) {
+                int same = -1;
+                bool meaningless = true;
+                for (int k = 0; k < in.numArgs && meaningless; k++) {
+                    int arg = fn->args[in.firstArg + k];
+                    if (arg == in.dst || arg == same) continue;
+                    if (same < 0) same = arg;
+                    else meaningless = false;
+                }
+                if (meaningless && same >= 0) {
+                    value[in.dst] = same;
+                    continue;
+                }
+                key.a = b;
+                for (int k = 0; k < in.numArgs; k++) {
+                    char buf[16];
+                    snprintf(buf, sizeof(buf), "%d,", fn->args[in.firstArg + k]);
+                    key.text += buf;
+                }
+            } else if (in.op == TacConst) {
+                key.constant = program->constants.Nth(in.a);
+                if (key.constant.kind == StringValue) key.text = key.constant.s;
+            } else if (IsBinary(in.op) || (IsUnary(in.op) && in.op != TacCopy)) {
+                key.a = in.a;
+                key.b = IsBinary(in.op) ? in.b : 0;
+                if (IsCommutative(in.op) && key.a > key.b) std::swap(key.a, key.b);
+            } else {
+                kept.push_back(in);
+                continue;
+            }
+            std::map<ValueKey, int>::iterator found = table.find(key);
+            if (found != table.end()) {
+                value[in.dst] = found->second;
+                continue;
+            }
+            added.push_back(table.insert(std::make_pair(key, in.dst)).first);
+            kept.push_back(in);
+        }
+        instrs.swap(kept);
+    }
+
+    // uses the walk has not seen yet, the arguments of phis coming in
+    // by back edges, take the values too
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        for (size_t j = 0; j < instrs.size(); j++) {
+            slots.clear();
+            fn->GetUseSlots(instrs[j], &slots);
+            for (size_t k = 0; k < slots.size(); k++)
+                *slots[k] = Leader(value, *slots[k]);
+        }
+    }
+}
+
+
+/* Dead code elimination
+ * ---------------------
+ * Mark and sweep: the instructions with an effect (stores, calls, I/O,
+ * control, and anything that can stop the program with a runtime error)
+ * are live, and so is the definition of every register a live
+ * instruction uses. The rest go. Whether an instruction has an effect
+ * is decided once, before the sweep, which both phases then go by: the
+ * sweep rebuilds the blocks' instructions, which defs points into.
+ */
+static bool HasEffect(TacProgram *program, TacFunction *fn, const TacInstr &in,
+                      const std::vector<const TacInstr*> &defs)
+{
+    switch (in.op) {
+      case TacCopy: case TacConst: case TacLoadGlobal: case TacNewObject:
+      case TacNegInt: case TacNotBool: case TacPhi: case TacGetElemUnchecked:
+        return false;
+      case TacDivInt: case TacModInt: {
+        const TacInstr *divisor = defs[in.b];
+        return !(divisor && divisor->op == TacConst &&
+                 program->constants.Nth(divisor->a).i != 0);
+      }
+      default:
+        return !IsBinary(in.op) && in.op != TacNegDouble;
+    }
+}
+
+void Optimizer::EliminateDeadCode(TacProgram *program, TacFunction *fn)
+{
+    Assert(fn->ssa);
+    std::vector<const TacInstr*> defs(fn->NumRegs(), (const TacInstr*)NULL);
+    for (size_t b = 0; b < fn->blocks.size(); b++)
+        for (size_t j = 0; j < fn->blocks[b].instrs.size(); j++)
+            if (fn->blocks[b].instrs[j].dst >= 0)
+                defs[fn->blocks[b].instrs[j].dst] = &fn->blocks[b].instrs[j];
+
+    std::vector<std::vector<bool> > effect(fn->blocks.size());
+    std::vector<bool> live(fn->NumRegs(), false);
+    std::vector<int> work, uses;
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        effect[b].resize(fn->blocks[b].instrs.size());
+        for (size_t j = 0; j < fn->blocks[b].instrs.size(); j++) {
+            const TacInstr &in = fn->blocks[b].instrs[j];
+            effect[b][j] = HasEffect(program, fn, in, defs);
+            if (!effect[b][j]) continue;
+            uses.clear();
+            fn->GetUses(in, &uses);
+            work.insert(work.end(), uses.begin(), uses.end());
+        }
+    }
+    while (!work.empty()) {
+        int reg = work.back();
+        work.pop_back();
+        if (live[reg]) continue;
+        live[reg] = true;
+        if (!defs[reg]) continue;           // a parameter
+        uses.clear();
+        fn->GetUses(*defs[reg], &uses);
+        work.insert(work.end(), uses.begin(), uses.end());
+    }
+
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        std::vector<TacInstr> kept;
+        for (size_t j = 0; j < instrs.size(); j++)
+            if (instrs[j].dst < 0 || live[instrs[j].dst] || effect[b][j])
+                kept.push_back(instrs[j]);
+        instrs.swap(kept);
+    }
+}
+
+
+/* Loops
+ * -----
+ * What the passes over loops need to know of the stores in one, for
+ * whether a load in it gives the same value every time around.
+ */
+
+/* Whether a store to an element of array could change an element of
+ * other. Arrays of different element types are different arrays, but
+ * for classes, where one type can be a subtype of the other. */
+static bool MayAlias(TacFunction *fn, int array, int other)
+{
+    ArrayType *a = dynamic_cast<ArrayType*>(fn->regTypes[array]);
+    ArrayType *b = dynamic_cast<ArrayType*>(fn->regTypes[other]);
+    if (!a || !b) return true;
+    Type *x = a->GetElemType(), *y = b->GetElemType();
+    if (x->IsEquivalentTo(y)) return true;
+    return dynamic_cast<NamedType*>(x) && dynamic_cast<NamedType*>(y);
+}
+
+struct LoopStores {
+    bool hasCalls;
+    std::vector<int> globals, fields, arrays;   // stored to by the loop
+
+    void Gather(TacFunction *fn, const Loop &loop);
+    // Whether a LoadGlobal, GetField or GetElem could give something else
+    // on a later time around the loop, from the same operands.
+    bool MayChange(TacFunction *fn, const TacInstr &load);
+};
+
+void LoopStores::Gather(TacFunction *fn, const Loop &loop)
+{
+    hasCalls = false;
+    globals.clear();
+    fields.clear();
+    arrays.clear();
+    for (size_t i = 0; i < loop.blocks.size(); i++) {
+        const std::vector<TacInstr> &instrs = fn->blocks[loop.blocks[i]].instrs;
+        for (size_t j = 0; j < instrs.size(); j++) {
+            const TacInstr &in = instrs[j];
+            if (IsCall(in.op)) hasCalls = true;
+            if (in.op == TacStoreGlobal) globals.push_back(in.a);
+            if (in.op == TacSetField) fields.push_back(in.b);
+            if (in.op == TacSetElem || in.op == TacSetElemUnchecked) arrays.push_back(in.a);
+        }
+    }
+}
+
+bool LoopStores::MayChange(TacFunction *fn, const TacInstr &load)
+{
+    if (hasCalls) return true;
+    switch (load.op) {
+      case TacLoadGlobal:
+        return std::find(globals.begin(), globals.end(), load.a) != globals.end();
+      case TacGetField:
+        return std::find(fields.begin(), fields.end(), load.b) != fields.end();
+      case TacGetElem: case TacGetElemUnchecked:
+        for (size_t i = 0; i < arrays.size(); i++)
+            if (MayAlias(fn, arrays[i], load.a)) return true;
+        return false;
+      default:
+        return true;
+    }
+}
+
+
+/* Bounds check elimination
+ * ------------------------
+ * A counted loop has a header that tests an induction variable i
+ * against a bound n and stays in the loop while i < n. Here i is a phi
+ * of the header that starts at some v and goes up by one each time
+ * around. Wherever the test must have passed, in a block dominated by
+ * the one it goes on to, i lies in [v, n) (and i + 1 cannot wrap, as
+ * i < n). So an access a[i] there is in bounds if 0 <= v and
+ * n <= a.length, where a must be the same array all through the loop:
+ * either defined before the loop, or loaded inside it from a place the
+ * loop never stores to and makes no calls that could. So must n, which
+ * may also be the length of such an array, as a length never changes.
+ *
+ * If constants show this (v and n constant, and the array from a
+ * NewArray of constant size), the accesses lose their checks outright.
+ * Otherwise the loop is versioned. A guard in its preheader makes the
+ * tests, and a copy of the loop without the checks runs if they pass,
+ * the original loop if not. The guard cannot fail itself: before it
+ * repeats a load the loop makes, it tests that the load would succeed,
+ * and takes the original loop if not, which then fails where it always
+ * did.
+ */
+class BoundsCheckElimination
+{
+  private:
+    TacProgram *program;
+    TacFunction *fn;
+    std::vector<int> defBlock, defIndex;        // of each register, -1 if none
+    std::vector<bool> done;                     // of each loop header
+    const Loop *loop;
+    LoopStores stores;
+    std::map<int, bool> invariant;
+    int guard, slow;                            // blocks the guard is filling, and fails to
+    std::map<int, int> guardValue;              // of registers, in the guard
+    std::map<ValueKey, int> guardLoads;         // what the guard has loaded
+    std::vector<int> notNull;                   // what the guard has tested
+    int zero, null;
+
+    static const int MaxCopiedInstrs = 400;
+
+    const TacInstr *Def(int reg);
+    bool ConstantOf(int reg, int *value);
+    bool KnownLength(int reg, int *length);
+    bool IsInvariant(int reg);
+    void Emit(const TacInstr &in) { fn->blocks[guard].instrs.push_back(in); }
+    void Check(int op, int a, int b);
+    void CheckNotNull(int reg);
+    int Materialize(int reg);
+    bool Handle(const Loop &loop, DominatorTree &dom);
+
+  public:
+    int removed;
+
+    BoundsCheckElimination(TacProgram *p, TacFunction *f) : program(p), fn(f), removed(0) {}
+    // Handles one loop not yet handled; false if there are none left.
+    bool Run();
+};
+
+const TacInstr *BoundsCheckElimination::Def(int reg)
+{
+    // none for the registers the guard defines
+    if (reg >= (int)defBlock.size() || defBlock[reg] < 0) return NULL;
+    return &fn->blocks[defBlock[reg]].instrs[defIndex[reg]];
+}
+
+bool BoundsCheckElimination::ConstantOf(int reg, int *value)
+{
+    const TacInstr *in = Def(reg);
+    if (!in || in->op != TacConst || program->constants.Nth(in->a).kind != IntValue) return false;
+    *value = program->constants.Nth(in->a).i;
+    return true;
+}
+
+bool BoundsCheckElimination::KnownLength(int reg, int *length)
+{
+    const TacInstr *in = Def(reg);
+    return in && in->op == TacNewArray && ConstantOf(in->a, length);
+}
+
+// Whether reg has the same value all through the loop.
+bool BoundsCheckElimination::IsInvariant(int reg)
+{
+    if (defBlock[reg] < 0 || !loop->contains[defBlock[reg]]) return true;
+    std::map<int, bool>::iterator found = invariant.find(reg);
+    if (found != invariant.end()) return found->second;
+    invariant[reg] = false;                     // until shown otherwise
+    const TacInstr &in = *Def(reg);
+    bool result = false;
+    switch (in.op) {
+      case TacConst:
+        result = true;
+        break;
+      case TacCopy:
+        result = IsInvariant(in.a);
+        break;
+      case TacLoadGlobal:
+        result = !stores.MayChange(fn, in);
+        break;
+      case TacGetField:
+        result = IsInvariant(in.a) && !stores.MayChange(fn, in);
+        break;
+      case TacGetElem:
+        result = IsInvariant(in.a) && IsInvariant(in.b) && !stores.MayChange(fn, in);
+        break;
+      case TacLength:
+        result = IsInvariant(in.a);
+        break;
+      default:
+        break;
+    }
+    invariant[reg] = result;
+    return result;
+}
+
+// Goes on to a new block of the guard if op of a and b is true, and to
+// the original loop if not.
+void BoundsCheckElimination::Check(int op, int a, int b)
+{
+    int cond = fn->NewReg(Type::boolType);
+    Emit(MakeInstr(op, cond, a, b));
+    int next = fn->blocks.size();
+    fn->blocks.push_back(TacBlock());
+    Emit(MakeInstr(TacBranch, -1, cond, next, slow));
+    guard = next;
+}
+
+// The receiver of a method is never null, as calling it would have failed.
+void BoundsCheckElimination::CheckNotNull(int reg)
+{
+    int length;
+    if (KnownLength(reg, &length) || (reg == 0 && fn->decl->IsMethod()) ||
+        std::find(notNull.begin(), notNull.end(), reg) != notNull.end())
+        return;
+    notNull.push_back(reg);
+    if (null < 0) {
+        null = fn->NewReg(Type::nullType);
+        Emit(MakeInstr(TacConst, null, program->AddConstant(MakeObject(NULL))));
+    }
+    Check(TacNotEqualRef, reg, null);
+}
+
+/* The register holding the value of reg in the guard, which loads it
+ * there if the loop does, once it has checked that the load is safe. As
+ * nothing in the guard stores, loads of the same place give the same
+ * value, and the first serves for the others. */
+int BoundsCheckElimination::Materialize(int reg)
+{
+    if (defBlock[reg] < 0 || !loop->contains[defBlock[reg]]) return reg;
+    std::map<int, int>::iterator found = guardValue.find(reg);
+    if (found != guardValue.end()) return found->second;
+    TacInstr in = *Def(reg);
+    if (in.op == TacCopy) return guardValue[reg] = Materialize(in.a);
+    if (in.op == TacGetField || in.op == TacGetElem || in.op == TacLength)
+        in.a = Materialize(in.a);
+    if (in.op == TacGetElem) in.b = Materialize(in.b);
+    ValueKey key;
+    key.op = in.op;
+    key.a = in.a;
+    key.b = in.b;
+    if (in.op == TacConst) {
+        key.a = key.b = 0;
+        key.constant = program->constants.Nth(in.a);
+        if (key.constant.kind == StringValue) key.text = key.constant.s;
+    }
+    std::map<ValueKey, int>::iterator loaded = guardLoads.find(key);
+    if (loaded != guardLoads.end()) return guardValue[reg] = loaded->second;
+
+    in.dst = fn->NewReg(fn->regTypes[reg]);
+    if (in.op == TacGetField || in.op == TacLength) {
+        CheckNotNull(in.a);
+    } else if (in.op == TacGetElem) {
+        CheckNotNull(in.a);
+        int length = fn->NewReg(Type::intType);
+        Emit(MakeInstr(TacLength, length, in.a));
+        if (zero < 0) {
+            zero = fn->NewReg(Type::intType);
+            Emit(MakeInstr(TacConst, zero, program->AddConstant(MakeInt(0))));
+        }
+        Check(TacLessEqualInt, zero, in.b);
+        Check(TacLessInt, in.b, length);
+    }
+    Emit(in);
+    guardLoads[key] = in.dst;
+    return guardValue[reg] = in.dst;
+}
+
+bool BoundsCheckElimination::Handle(const Loop &l, DominatorTree &dom)
+{
+    loop = &l;
+    int header = l.header;
+    const TacInstr &branch = fn->blocks[header].Terminator();
+    if (l.preheader < 0 || branch.op != TacBranch) return false;
+    int body = branch.b;
+    if (!l.contains[body] || l.contains[branch.c] || fn->blocks[body].preds.size() != 1)
+        return false;
+
+    // the test, i < n (or n > i), and the induction variable i
+    const TacInstr *test = Def(branch.a);
+    if (!test || defBlock[branch.a] != header) return false;
+    int index, bound;
+    if (test->op == TacLessInt) index = test->a, bound = test->b;
+    else if (test->op == TacGreaterInt) index = test->b, bound = test->a;
+    else return false;
+    const TacInstr *phi = Def(index);
+    if (!phi || phi->op != TacPhi || defBlock[index] != header) return false;
+    int start = -1;
+    const std::vector<int> &preds = fn->blocks[header].preds;
+    for (size_t k = 0; k < preds.size(); k++) {
+        int arg = fn->args[phi->firstArg + k], one;
+        if (preds[k] == l.preheader) {
+            start = arg;
+            continue;
+        }
+        const TacInstr *step = Def(arg);
+        if (!step || step->op != TacAddInt) return false;
+        if (!(step->a == index && ConstantOf(step->b, &one) && one == 1) &&
+            !(step->b == index && ConstantOf(step->a, &one) && one == 1))
+            return false;
+    }
+
+    stores.Gather(fn, l);
+    invariant.clear();
+    int size = 0;
+    for (size_t i = 0; i < l.blocks.size(); i++)
+        size += fn->blocks[l.blocks[i]].instrs.size();
+    if (!IsInvariant(bound)) return false;
+
+    // the accesses a[i] where the test has passed
+    std::vector<std::pair<int, int> > accesses;
+    std::vector<int> arrays;
+    for (size_t i = 0; i < l.blocks.size(); i++) {
+        int b = l.blocks[i];
+        if (!dom.Dominates(body, b)) continue;
+        const std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        for (size_t j = 0; j < instrs.size(); j++) {
+            const TacInstr &in = instrs[j];
+            if ((in.op != TacGetElem && in.op != TacSetElem) || in.b != index || !IsInvariant(in.a))
+                continue;
+            accesses.push_back(std::make_pair(b, (int)j));
+            if (std::find(arrays.begin(), arrays.end(), in.a) == arrays.end())
+                arrays.push_back(in.a);
+        }
+    }
+    if (accesses.empty()) return false;
+
+    int value, n, length;
+    bool startKnown = ConstantOf(start, &value) && value >= 0, known = startKnown;
+    std::vector<bool> lengthKnown(arrays.size());
+    for (size_t i = 0; i < arrays.size(); i++) {
+        lengthKnown[i] = ConstantOf(bound, &n) && KnownLength(arrays[i], &length) && n <= length;
+        if (!lengthKnown[i]) known = false;
+    }
+    if (known) {
+        for (size_t i = 0; i < accesses.size(); i++) {
+            TacInstr &in = fn->blocks[accesses[i].first].instrs[accesses[i].second];
+            in.op = in.op == TacGetElem ? TacGetElemUnchecked : TacSetElemUnchecked;
+        }
+        removed += accesses.size();
+        return true;
+    }
+
+    if (size > MaxCopiedInstrs || l.exit < 0) return false;
+    std::vector<int> blockMap, regMap;
+    int copy = CopyLoop(fn, l, dom, &blockMap, &regMap);
+    if (copy < 0) return false;
+    done.resize(fn->blocks.size(), false);
+    for (size_t i = 0; i < l.blocks.size(); i++)
+        if (done[l.blocks[i]]) done[blockMap[l.blocks[i]]] = true;
+
+    // the guard, between the preheader and the loops
+    slow = fn->blocks.size();
+    fn->blocks.push_back(TacBlock());
+    guard = fn->blocks.size();
+    fn->blocks.push_back(TacBlock());
+    guardValue.clear();
+    guardLoads.clear();
+    notNull.clear();
+    zero = null = -1;
+    TacInstr &enter = fn->blocks[l.preheader].Terminator();
+    Assert(enter.op == TacJump && enter.a == header);
+    enter.a = guard;
+    fn->blocks[slow].instrs.push_back(MakeInstr(TacJump, -1, header));
+    if (!startKnown) {
+        zero = fn->NewReg(Type::intType);
+        Emit(MakeInstr(TacConst, zero, program->AddConstant(MakeInt(0))));
+        Check(TacLessEqualInt, zero, start);
+    }
+    int limit = Materialize(bound);
+    for (size_t i = 0; i < arrays.size(); i++) {
+        if (lengthKnown[i]) continue;
+        int array = Materialize(arrays[i]);
+        CheckNotNull(array);
+        int arrayLength = fn->NewReg(Type::intType);
+        Emit(MakeInstr(TacLength, arrayLength, array));
+        Check(TacLessEqualInt, limit, arrayLength);
+    }
+    Emit(MakeInstr(TacJump, -1, copy));
+
+    // the loops' headers have new predecessors in place of the preheader
+    std::replace(fn->blocks[header].preds.begin(), fn->blocks[header].preds.end(), l.preheader, slow);
+    std::replace(fn->blocks[copy].preds.begin(), fn->blocks[copy].preds.end(), l.preheader, guard);
+    fn->ComputeEdges();
+
+    for (size_t i = 0; i < accesses.size(); i++) {
+        TacInstr &in = fn->blocks[blockMap[accesses[i].first]].instrs[accesses[i].second];
+        in.op = in.op == TacGetElem ? TacGetElemUnchecked : TacSetElemUnchecked;
+    }
+    removed += accesses.size();
+    return true;
+}
+
+bool BoundsCheckElimination::Run()
+{
+    int numRegs = fn->NumRegs();
+    defBlock.assign(numRegs, -1);
+    defIndex.assign(numRegs, -1);
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        const std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        for (size_t j = 0; j < instrs.size(); j++) {
+            if (instrs[j].dst < 0) continue;
+            defBlock[instrs[j].dst] = b;
+            defIndex[instrs[j].dst] = j;
+        }
+    }
+    done.resize(fn->blocks.size(), false);
+    DominatorTree dom(fn);
+    std::vector<Loop> loops;
+    FindLoops(fn, dom, &loops);
+    for (size_t i = 0; i < loops.size(); i++) {
+        if (done[loops[i].header]) continue;
+        done[loops[i].header] = true;
+        if (Handle(loops[i], dom)) return true;
+    }
+    return false;
+}
+
+void Optimizer::EliminateBoundsChecks(TacProgram *program, TacFunction *fn)
+{
+    Assert(fn->ssa);
+    BoundsCheckElimination bce(program, fn);
+    while (bce.Run())
+        ;
+    PhaseTimer::Count("bce: checks removed", bce.removed);
+}
+
+
+/* Loop-invariant code motion
+ * --------------------------
+ * Loops are visited inner first, once each has a preheader (made by
+ * putting a block on the edge into a loop that lacks one). An
+ * instruction of a loop moves to the end of its preheader when its
+ * operands are defined outside the loop, or have been moved out, and
+ * moving it cannot change what the program does:
+ *
+ *  - pure operations that cannot fail, from anywhere in the loop;
+ *  - loads of what the loop does not store to (and with no calls in it,
+ *    which could): LoadGlobal, the GetElemUnchecked bce leaves, whose
+ *    checks hold all through the loop, and GetField and Length of what
+ *    is known not to be null: the receiver of a method, or a new object;
+ *  - any other such instruction, even one that can fail, found in the
+ *    header ahead of everything there with an effect or that can fail:
+ *    the header runs whenever the loop is entered, so the instruction
+ *    would have failed there before anything else happened.
+ *
+ * What moves out of an inner loop is then in the outer one, and can
+ * move again.
+ */
+class LoopInvariantCodeMotion
+{
+  private:
+    TacProgram *program;
+    TacFunction *fn;
+    std::vector<TacInstr> def;                  // of each register; op -1 if none
+    std::vector<int> defBlock;
+    LoopStores stores;
+
+    bool ConstantOf(int reg, int *value);
+    bool IsNotNull(int reg);
+    bool IsQuiet(const TacInstr &in);
+    bool CanMove(const TacInstr &in, bool first);
+
+  public:
+    int moved;
+
+    LoopInvariantCodeMotion(TacProgram *p, TacFunction *f);
+    void Hoist(const Loop &loop, DominatorTree &dom);
+};
+
+LoopInvariantCodeMotion::LoopInvariantCodeMotion(TacProgram *p, TacFunction *f)
+    : program(p), fn(f), moved(0)
+{
+    TacInstr none = MakeInstr(-1, -1);
+    def.assign(fn->NumRegs(), none);
+    defBlock.assign(fn->NumRegs(), -1);
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        const std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        for (size_t j = 0; j < instrs.size(); j++) {
+            if (instrs[j].dst < 0) continue;
+            def[instrs[j].dst] = instrs[j];
+            defBlock[instrs[j].dst] = b;
+        }
+    }
+}
+
+bool LoopInvariantCodeMotion::ConstantOf(int reg, int *value)
+{
+    if (def[reg].op != TacConst || program->constants.Nth(def[reg].a).kind != IntValue)
+        return false;
+    *value = program->constants.Nth(def[reg].a).i;
+    return true;
+}
+
+bool LoopInvariantCodeMotion::IsNotNull(int reg)
+{
+    return (reg == 0 && fn->decl->IsMethod()) || def[reg].op == TacNewObject ||
+           def[reg].op == TacNewArray;
+}
+
+// Whether in has no effect and cannot fail.
+bool LoopInvariantCodeMotion::IsQuiet(const TacInstr &in)
+{
+    int divisor;
+    switch (in.op) {
+      case TacConst: case TacCopy: case TacNegInt: case TacNegDouble: case TacNotBool:
+      case TacPhi: case TacLoadGlobal: case TacGetElemUnchecked:
+        return true;
+      case TacDivInt: case TacModInt:
+        return ConstantOf(in.b, &divisor) && divisor != 0;
+      case TacGetField: case TacLength:
+        return IsNotNull(in.a);
+      default:
+        return IsBinary(in.op);
+    }
+}
+
+// first says whether nothing ahead of in in the header has an effect or
+// can fail.
+bool LoopInvariantCodeMotion::CanMove(const TacInstr &in, bool first)
+{
+    switch (in.op) {
+      case TacPhi:
+        return false;
+      case TacLoadGlobal: case TacGetField: case TacGetElem: case TacGetElemUnchecked:
+        return (first || IsQuiet(in)) && !stores.MayChange(fn, in);
+      case TacLength:
+        return first || IsQuiet(in);
+      default:
+        return IsQuiet(in) || (first && (in.op == TacDivInt || in.op == TacModInt));
+    }
+}
+
+void LoopInvariantCodeMotion::Hoist(const Loop &loop, DominatorTree &dom)
+{
+    stores.Gather(fn, loop);
+    std::vector<int> uses;
+    std::vector<TacInstr> &preheader = fn->blocks[loop.preheader].instrs;
+    bool again = true;
+    while (again) {
+        again = false;
+        for (size_t i = 0; i < dom.order.size(); i++) {
+            int b = dom.order[i];
+            if (!loop.contains[b]) continue;
+            bool first = b == loop.header;
+            std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+            for (size_t j = 0; j < instrs.size(); ) {
+                const TacInstr &in = instrs[j];
+                bool invariant = in.dst >= 0;
+                uses.clear();
+                fn->GetUses(in, &uses);
+                for (size_t k = 0; k < uses.size() && invariant; k++)
+                    if (defBlock[uses[k]] >= 0 && loop.contains[defBlock[uses[k]]]) invariant = false;
+                if (invariant && CanMove(in, first)) {
+                    defBlock[in.dst] = loop.preheader;
+                    preheader.insert(preheader.end() - 1, in);
+                    instrs.erase(instrs.begin() + j);
+                    moved++;
+                    again = true;
+                    continue;
+                }
+                if (!IsQuiet(in)) first = false;
+                j++;
+            }
+        }
+    }
+}
+
+void Optimizer::HoistInvariants(TacProgram *program, TacFunction *fn)
+{
+    Assert(fn->ssa);
+    std::vector<Loop> loops;
+    {
+        DominatorTree dom(fn);
+        FindLoops(fn, dom, &loops);
+    }
+    bool changed = false;
+    for (size_t i = 0; i < loops.size(); i++)
+        if (MakePreheader(fn, &loops[i])) changed = true;
+    DominatorTree dom(fn);
+    if (changed) {
+        loops.clear();
+        FindLoops(fn, dom, &loops);
+    }
+    LoopInvariantCodeMotion licm(program, fn);
+    for (size_t i = 0; i < loops.size(); i++)
+        if (loops[i].preheader >= 0) licm.Hoist(loops[i], dom);
+    PhaseTimer::Count("licm: instructions hoisted", licm.moved);
+}
+
+
+/* Strength reduction
+ * ------------------
+ * An induction variable of a loop is a phi i of its header that goes up
+ * by a constant c each time around: its argument from the one block
+ * going back to the header (the latch) is i + c. A product i * k in the
+ * loop, with k defined outside it, then goes up by k * c. A new phi of
+ * the header takes the place of the product: it starts at the product
+ * of i's first value and k, made in the preheader, and the latch adds
+ * k * c to it. Int arithmetic wraps around the same either way.
+ */
+void Optimizer::ReduceStrength(TacProgram *program, TacFunction *fn)
+{
+    Assert(fn->ssa);
+    DominatorTree dom(fn);
+    std::vector<Loop> loops;
+    FindLoops(fn, dom, &loops);
+    std::vector<int> defBlock(fn->NumRegs(), -1);
+    std::vector<TacInstr> def(fn->NumRegs(), MakeInstr(-1, -1));
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        const std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        for (size_t j = 0; j < instrs.size(); j++) {
+            if (instrs[j].dst < 0) continue;
+            defBlock[instrs[j].dst] = b;
+            def[instrs[j].dst] = instrs[j];
+        }
+    }
+
+    int reduced = 0;
+    for (size_t l = 0; l < loops.size(); l++) {
+        const Loop &loop = loops[l];
+        TacBlock &header = fn->blocks[loop.header];
+        if (loop.preheader < 0 || header.preds.size() != 2) continue;
+        int fromPreheader = header.preds[0] == loop.preheader ? 0 : 1;
+        int latch = header.preds[1 - fromPreheader];
+
+        // the step of each induction variable, and its first value
+        std::map<int, std::pair<int, int> > induction;
+        for (size_t j = 0; j < header.instrs.size() && header.instrs[j].op == TacPhi; j++) {
+            const TacInstr &phi = header.instrs[j];
+            int start = fn->args[phi.firstArg + fromPreheader];
+            const TacInstr &next = def[fn->args[phi.firstArg + 1 - fromPreheader]];
+            if (next.op != TacAddInt && next.op != TacSubInt) continue;
+            int other = next.a == phi.dst ? next.b : next.op == TacAddInt && next.b == phi.dst ? next.a : -1;
+            if (other < 0 || def[other].op != TacConst ||
+                program->constants.Nth(def[other].a).kind != IntValue)
+                continue;
+            int step = program->constants.Nth(def[other].a).i;
+            if (next.op == TacSubInt) step = -(unsigned)step;
+            induction[phi.dst] = std::make_pair(step, start);
+        }
+        if (induction.empty()) continue;
+
+        std::map<std::pair<int, int>, int> products;    // by variable and factor
+        for (size_t i = 0; i < loop.blocks.size(); i++) {
+            std::vector<TacInstr> &instrs = fn->blocks[loop.blocks[i]].instrs;
+            for (size_t j = 0; j < instrs.size(); j++) {
+                TacInstr &in = instrs[j];
+                if (in.op != TacMulInt) continue;
+                int var = induction.count(in.a) ? in.a : induction.count(in.b) ? in.b : -1;
+                if (var < 0) continue;
+                int factor = var == in.a ? in.b : in.a;
+                if (defBlock[factor] >= 0 && loop.contains[defBlock[factor]]) continue;
+
+                std::pair<int, int> key(var, factor);
+                if (!products.count(key)) {
+                    std::vector<TacInstr> &pre = fn->blocks[loop.preheader].instrs;
+                    std::vector<TacInstr>::iterator end = pre.end() - 1;
+                    int first = fn->NewReg(Type::intType), step = factor;
+                    end = pre.insert(end, MakeInstr(TacMulInt, first, induction[var].second, factor)) + 1;
+                    if (induction[var].first != 1) {
+                        int c = fn->NewReg(Type::intType);
+                        step = fn->NewReg(Type::intType);
+                        end = pre.insert(end, MakeInstr(TacConst, c,
+                                         program->AddConstant(MakeInt(induction[var].first)))) + 1;
+                        pre.insert(end, MakeInstr(TacMulInt, step, factor, c));
+                    }
+
+                    int phi = fn->NewReg(Type::intType), next = fn->NewReg(Type::intType);
+                    std::vector<TacInstr> &back = fn->blocks[latch].instrs;
+                    back.insert(back.end() - 1, MakeInstr(TacAddInt, next, phi, step));
+                    TacInstr merge = MakeInstr(TacPhi, phi);
+                    merge.firstArg = fn->args.size();
+                    merge.numArgs = 2;
+                    fn->args.push_back(fromPreheader == 0 ? first : next);
+                    fn->args.push_back(fromPreheader == 0 ? next : first);
+                    std::vector<TacInstr> &top = fn->blocks[loop.header].instrs;
+                    top.insert(top.begin(), merge);
+                    products[key] = phi;
+                    if (loop.blocks[i] == loop.header) j++;
+                }
+                TacInstr &product = fn->blocks[loop.blocks[i]].instrs[j];
+                product = MakeInstr(TacCopy, product.dst, products[key]);
+                reduced++;
+            }
+        }
+    }
+    PhaseTimer::Count("sr: multiplications reduced", reduced);
+}
+
+
+/* Vectorization
+ * -------------
+ * A counted loop (see bce) that does nothing but set each element of
+ * one array from the elements of others at the same index, or from
+ * values the loop does not change, as in
+ *
+ *    for (i = v; i < n; i = i + 1) a[i] = b[i] + c[i];
+ *
+ * becomes one MapElems instruction doing the same, which the VM runs as
+ * a loop in C and the JIT as a loop of machine code, with no dispatch,
+ * test or branch of the loop's own for each element. The accesses must
+ * be unchecked already, so the elements from v up to n are known to be
+ * there. Each element is stored after the ones at its index are read,
+ * and no others, so a may be b or c. Nothing the loop computes may be
+ * used beyond it, the counter included, as the instruction leaves none
+ * of it behind.
+ *
+ * The loop that fills in the rows of a rectangular array,
+ *
+ *    a = NewArray(n, int[]);
+ *    for (i = 0; i < n; i = i + 1) a[i] = NewArray(m, int);
+ *
+ * is one too, a MapElems of NewArray: all the rows are made at once, in
+ * one block of the heap, so they sit next to each other in memory
+ * whatever else is allocated meanwhile, and a walk over the whole array
+ * goes through memory in order.
+ */
+static bool IsMappable(int op)
+{
+    switch (op) {
+      case TacAddInt: case TacSubInt: case TacMulInt:
+      case TacAddDouble: case TacSubDouble: case TacMulDouble: case TacDivDouble:
+        return true;
+      default:
+        return false;
+    }
+}
+
+void Optimizer::VectorizeLoops(TacProgram *program, TacFunction *fn)
+{
+    Assert(fn->ssa);
+    DominatorTree dom(fn);
+    std::vector<Loop> loops;
+    FindLoops(fn, dom, &loops);
+    std::vector<int> defBlock(fn->NumRegs(), -1);
+    std::vector<TacInstr> def(fn->NumRegs(), MakeInstr(-1, -1));
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        const std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        for (size_t j = 0; j < instrs.size(); j++) {
+            if (instrs[j].dst < 0) continue;
+            defBlock[instrs[j].dst] = b;
+            def[instrs[j].dst] = instrs[j];
+        }
+    }
+
+    int vectorized = 0;
+    std::vector<int> uses;
+    for (size_t l = 0; l < loops.size(); l++) {
+        const Loop &loop = loops[l];
+        TacBlock &header = fn->blocks[loop.header];
+        if (loop.blocks.size() != 2 || loop.preheader < 0 || header.instrs.size() != 3)
+            continue;
+        int body = loop.blocks[1];
+        const TacInstr &phi = header.instrs[0], &test = header.instrs[1], &branch = header.instrs[2];
+        if (phi.op != TacPhi || test.op != TacLessInt || test.a != phi.dst ||
+            branch.op != TacBranch || branch.a != test.dst || branch.b != body ||
+            (defBlock[test.b] >= 0 && loop.contains[defBlock[test.b]]))
+            continue;
+        int fromPreheader = header.preds[0] == loop.preheader ? 0 : 1;
+        int i = phi.dst, next = fn->args[phi.firstArg + 1 - fromPreheader];
+
+        // the body: loads at i, at most one operation, the store at i, and i + 1
+        std::map<int, int> loads;                   // array of each
+        const TacInstr *op = NULL, *store = NULL;
+        bool ok = true, stepped = false;
+        const std::vector<TacInstr> &instrs = fn->blocks[body].instrs;
+        for (size_t j = 0; j + 1 < instrs.size() && ok; j++) {
+            const TacInstr &in = instrs[j];
+            if (in.op == TacGetElemUnchecked && in.b == i) {
+                loads[in.dst] = in.a;
+            } else if (in.op == TacSetElemUnchecked && in.b == i && !store) {
+                store = &in;
+            } else if (in.op == TacAddInt && in.dst == next && in.a == i &&
+                       def[in.b].op == TacConst &&
+                       program->constants.Nth(def[in.b].a).kind == IntValue &&
+                       program->constants.Nth(def[in.b].a).i == 1) {
+                stepped = true;
+            } else if ((IsMappable(in.op) || in.op == TacNewArray) && !op) {
+                op = &in;
+            } else {
+                ok = false;
+            }
+        }
+        if (!ok || !store || !stepped) continue;
+
+        // what the store's value is made of: arrays loaded at i, or
+        // registers defined outside the loop
+        std::vector<int> operands;
+        if (op && op->op == TacNewArray) {
+            if (store->c != op->dst || !loads.empty()) continue;
+            operands.push_back(op->a);              // the length of each row
+        } else if (op) {
+            if (store->c != op->dst) continue;
+            operands.push_back(op->a);
+            operands.push_back(op->b);
+        } else {
+            operands.push_back(store->c);
+        }
+        int scalars = 0, used = 0;
+        std::vector<int> mapArgs(1, store->a);
+        mapArgs.push_back(fn->args[phi.firstArg + fromPreheader]);
+        mapArgs.push_back(test.b);
+        for (size_t k = 0; k < operands.size(); k++) {
+            int r = operands[k];
+            if (loads.count(r)) {
+                mapArgs.push_back(loads[r]);
+                used++;
+            } else {
+                mapArgs.push_back(r);
+                scalars |= 1 << k;
+            }
+        }
+        if (used != (int)loads.size()) continue;    // a load used for something else
+        for (size_t k = 0; k < mapArgs.size(); k++)
+            if (defBlock[mapArgs[k]] >= 0 && loop.contains[defBlock[mapArgs[k]]]) ok = false;
+        for (size_t b = 0; b < fn->blocks.size() && ok; b++) {
+            if (loop.contains[b]) continue;
+            const std::vector<TacInstr> &rest = fn->blocks[b].instrs;
+            for (size_t j = 0; j < rest.size() && ok; j++) {
+                uses.clear();
+                fn->GetUses(rest[j], &uses);
+                for (size_t k = 0; k < uses.size(); k++)
+                    if (defBlock[uses[k]] >= 0 && loop.contains[defBlock[uses[k]]]) ok = false;
+            }
+        }
+        if (!ok) continue;
+
+        TacInstr map = MakeInstr(TacMapElems, -1, op ? op->op : TacCopy,
+                                 op && op->op == TacNewArray ? op->b : scalars);
+        map.firstArg = fn->args.size();
+        map.numArgs = mapArgs.size();
+        fn->args.insert(fn->args.end(), mapArgs.begin(), mapArgs.end());
+        int exit = branch.c;
+        header.instrs.clear();
+        header.instrs.push_back(map);
+        header.instrs.push_back(MakeInstr(TacJump, -1, exit));
+        vectorized++;
+    }
+    if (vectorized > 0) {
+        fn->ComputeEdges();
+        fn->RemoveUnreachable();
+        EliminateDeadCode(program, fn);
+    }
+    PhaseTimer::Count("vec: loops vectorized", vectorized);
+}
+
+/* Devirtualization
+ * ----------------
+ * Rapid type analysis over the whole program: the classes that can have
+ * instances are those with a NewObject in a function that can run, and
+ * the functions that can run are main and those a call in one of them
+ * can go to. For a method call, those are the methods the classes of
+ * instances that can be its receiver have for it: the classes that can
+ * have instances and are subtypes of the receiver's static type (class
+ * hierarchy analysis alone would take them all), or just its class if
+ * it was made by a NewObject in the function. The two sets grow
+ * together until neither changes. Then a method call that can go to
+ * only one method becomes a CallMethod of it, which checks for a null
+ * receiver as the lookup did.
+ */
+class Devirtualizer
+{
+  private:
+    TacProgram *program;
+    std::vector<bool> reached;              // of each function
+    std::vector<bool> instantiated;         // of each class of NewObject
+    std::vector<ClassDecl*> classes;        // that are instantiated
+    bool changed;
+
+    Decl *ReceiverType(TacFunction *fn, const TacInstr &in);
+    ClassDecl *ReceiverClass(TacFunction *fn, const TacInstr &in);
+    void Reach(int function);
+    void Scan(TacFunction *fn);
+
+  public:
+    int direct;
+
+    Devirtualizer(TacProgram *p) : program(p), direct(0) {}
+    // The methods a method call can go to, by code index.
+    void GetCallees(TacFunction *fn, const TacInstr &in, std::vector<int> *callees);
+    void Run();
+};
+
+// The class or interface the receiver is declared as, or NULL if unknown.
+Decl *Devirtualizer::ReceiverType(TacFunction *fn, const TacInstr &in)
+{
+    NamedType *type = dynamic_cast<NamedType*>(fn->regTypes[fn->args[in.firstArg]]);
+    return type ? type->GetDecl() : NULL;
+}
+
+// The class of the receiver if it was made by a NewObject, or NULL.
+ClassDecl *Devirtualizer::ReceiverClass(TacFunction *fn, const TacInstr &in)
+{
+    int receiver = fn->args[in.firstArg];
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        const std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        for (size_t j = 0; j < instrs.size(); j++) {
+            if (instrs[j].dst != receiver) continue;
+            return instrs[j].op == TacNewObject ? program->classes.Nth(instrs[j].a) : NULL;
+        }
+    }
+    return NULL;
+}
+
+void Devirtualizer::GetCallees(TacFunction *fn, const TacInstr &in, std::vector<int> *callees)
+{
+    Decl *type = ReceiverType(fn, in);
+    ClassDecl *exact = ReceiverClass(fn, in);
+    for (size_t i = 0; i < classes.size(); i++) {
+        ClassDecl *cls = classes[i];
+        if ((type && !cls->IsSubtypeOf(type)) || (exact && cls != exact)) continue;
+        FnDecl *method = NULL;
+        if (in.op == TacCallInterface)
+            method = cls->LookupMethod(program->constants.Nth(in.a).s);
+        else if (in.a < cls->NumMethods())
+            method = cls->GetMethod(in.a);
+        if (method && std::find(callees->begin(), callees->end(),
+                                method->GetCodeIndex()) == callees->end())
+            callees->push_back(method->GetCodeIndex());
+    }
+}
+
+void Devirtualizer::Reach(int function)
+{
+    if (reached[function]) return;
+    reached[function] = changed = true;
+}
+
+void Devirtualizer::Scan(TacFunction *fn)
+{
+    std::vector<int> callees;
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        const std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        for (size_t j = 0; j < instrs.size(); j++) {
+            const TacInstr &in = instrs[j];
+            if (in.op == TacNewObject && !instantiated[in.a]) {
+                instantiated[in.a] = changed = true;
+                classes.push_back(program->classes.Nth(in.a));
+            } else if (in.op == TacCall || in.op == TacCallMethod) {
+                Reach(in.a);
+            } else if (in.op == TacCallVirtual || in.op == TacCallInterface) {
+                callees.clear();
+                GetCallees(fn, in, &callees);
+                for (size_t k = 0; k < callees.size(); k++)
+                    Reach(callees[k]);
+            }
+        }
+    }
+}
+
+void Devirtualizer::Run()
+{
+    reached.assign(program->functions.size(), false);
+    instantiated.assign(program->classes.NumElements(), false);
+    reached[program->main->decl->GetCodeIndex()] = true;
+    do {
+        changed = false;
+        for (size_t i = 0; i < program->functions.size(); i++)
+            if (reached[i] && program->functions[i]) Scan(program->functions[i]);
+    } while (changed);
+
+    std::vector<int> callees;
+    for (size_t i = 0; i < program->functions.size(); i++) {
+        TacFunction *fn = program->functions[i];
+        if (!fn || !reached[i]) continue;
+        for (size_t b = 0; b < fn->blocks.size(); b++) {
+            std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+            for (size_t j = 0; j < instrs.size(); j++) {
+                TacInstr &in = instrs[j];
+                if (in.op != TacCallVirtual && in.op != TacCallInterface) continue;
+                callees.clear();
+                GetCallees(fn, in, &callees);
+                if (callees.size() != 1 || !ReceiverType(fn, in)) continue;
+                in.op = TacCallMethod;
+                in.a = callees[0];
+                direct++;
+            }
+        }
+    }
+}
+
+void Optimizer::Devirtualize(TacProgram *program)
+{
+    Devirtualizer devirtualizer(program);
+    devirtualizer.Run();
+    PhaseTimer::Count("devirt: calls made direct", devirtualizer.direct);
+}
+
+
+/* Inlining
+ * --------
+ * Functions are visited callees first, in postorder of the call graph,
+ * so a callee's own calls have been inlined by the time its callers
+ * take its code. A call is inlined if its callee is small: up to
+ * SmallCallee instructions, or LoopCallee for a call in a loop, which
+ * runs often enough to pay for more, while the caller has at most
+ * MaxCallerInstrs. An edge of the call graph back to a function not
+ * yet finished closes a cycle and is never inlined, so recursion is
+ * not expanded without end (only unrolled once, at most).
+ *
+ * The callee's blocks are copied in after the call with registers of
+ * the caller's own, the parameters replaced by the arguments and each
+ * return by a jump to the rest of the caller's block, where a phi takes
+ * the result. A CallMethod checks that its receiver is not null: once
+ * inlined, that is a branch to the call itself, which then fails as it
+ * did, unless the receiver is known not to be null.
+ *
+ * An inlined call takes no frame, so at -O2 a program can recurse deeper
+ * before a "Stack overflow" than Interpreter::MaxDepth calls: as much
+ * deeper as calls were inlined on the way down, up to twice as deep for
+ * a recursion unrolled once. Counting the frames that inlining saves
+ * would cost a check on every inlined call, which is much of what
+ * inlining saves, and the limit is only a guard against runaway
+ * recursion: a program that comes near it may finish at -O2 where it
+ * overflows the stack at -O0 and -O1 (tests/difftest.sh allows for it).
+ */
+class Inliner
+{
+  private:
+    TacProgram *program;
+    std::vector<int> finished;              // place of each function in order, or -1
+    std::vector<bool> onStack;
+    std::vector<int> order;
+
+    static const int SmallCallee = 12;
+    static const int LoopCallee = 40;
+    static const int MaxCallerInstrs = 2000;
+
+    void Visit(int function);
+    bool IsNotNull(TacFunction *fn, int reg);
+    int Inline(TacFunction *fn, int block, int index, TacFunction *callee);
+    void InlineCalls(int function);
+
+  public:
+    int sites;
+
+    Inliner(TacProgram *p) : program(p), sites(0) {}
+    void Run();
+};
+
+void Inliner::Visit(int function)
+{
+    onStack[function] = true;
+    TacFunction *fn = program->functions[function];
+    for (size_t b = 0; fn && b < fn->blocks.size(); b++) {
+        const std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        for (size_t j = 0; j < instrs.size(); j++) {
+            const TacInstr &in = instrs[j];
+            if ((in.op == TacCall || in.op == TacCallMethod) &&
+                finished[in.a] < 0 && !onStack[in.a])
+                Visit(in.a);
+        }
+    }
+    onStack[function] = false;
+    finished[function] = order.size();
+    order.push_back(function);
+}
+
+bool Inliner::IsNotNull(TacFunction *fn, int reg)
+{
+    if (reg == 0 && fn->decl->IsMethod()) return true;
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        const std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        for (size_t j = 0; j < instrs.size(); j++)
+            if (instrs[j].dst == reg) return instrs[j].op == TacNewObject;
+    }
+    return false;
+}
+
+/* Inlines the call at the index in the block, and returns the block
+ * that continues after it. */
+int Inliner::Inline(TacFunction *fn, int block, int index, TacFunction *callee)
+{
+    TacInstr call = fn->blocks[block].instrs[index];
+    int result = call.dst, cont = fn->blocks.size();
+    TacBlock rest;
+    std::vector<TacInstr> &instrs = fn->blocks[block].instrs;
+    rest.instrs.assign(instrs.begin() + index + 1, instrs.end());
+    rest.succs = fn->blocks[block].succs;
+    rest.inlinedFrom = fn->blocks[block].inlinedFrom;
+    instrs.resize(index);
+    for (size_t k = 0; k < rest.succs.size(); k++) {
+        std::vector<int> &preds = fn->blocks[rest.succs[k]].preds;
+        std::replace(preds.begin(), preds.end(), block, cont);
+    }
+    fn->blocks.push_back(rest);
+
+    int first = fn->blocks.size();
+    std::vector<int> regMap(callee->NumRegs());
+    for (int r = 0; r < callee->NumRegs(); r++)
+        regMap[r] = r < callee->numParams ? fn->args[call.firstArg + r]
+                                          : fn->NewReg(callee->regTypes[r]);
+    std::vector<int> results, from;     // the value returned, and the block returning it
+    std::vector<int*> slots;
+    for (size_t i = 0; i < callee->blocks.size(); i++) {
+        TacBlock copy = callee->blocks[i];
+        if (!copy.inlinedFrom) copy.inlinedFrom = callee->decl;
+        for (size_t k = 0; k < copy.preds.size(); k++) copy.preds[k] += first;
+        for (size_t k = 0; k < copy.succs.size(); k++) copy.succs[k] += first;
+        for (size_t j = 0; j < copy.instrs.size(); j++) {
+            TacInstr &in = copy.instrs[j];
+            if (in.numArgs > 0) {
+                int firstArg = fn->args.size();
+                for (int k = 0; k < in.numArgs; k++)
+                    fn->args.push_back(callee->args[in.firstArg + k]);
+                in.firstArg = firstArg;
+            }
+            if (in.dst >= 0) in.dst = regMap[in.dst];
+            slots.clear();
+            fn->GetUseSlots(in, &slots);
+            for (size_t k = 0; k < slots.size(); k++) *slots[k] = regMap[*slots[k]];
+            slots.clear();
+            fn->GetTargetSlots(in, &slots);
+            for (size_t k = 0; k < slots.size(); k++) *slots[k] += first;
+        }
+        TacInstr &t = copy.Terminator();
+        if (t.op == TacReturn || t.op == TacReturnVoid) {
+            int value = t.op == TacReturn ? t.a : -1;
+            if (value < 0 && result >= 0) {
+                value = fn->NewReg(fn->regTypes[result]);
+                Value zero = Interpreter::ZeroOf(callee->decl->GetReturnType());
+                copy.instrs.insert(copy.instrs.end() - 1,
+                                   MakeInstr(TacConst, value, program->AddConstant(zero)));
+            }
+            copy.instrs.back() = MakeInstr(TacJump, -1, cont);
+            copy.succs.assign(1, cont);
+            results.push_back(value);
+            from.push_back(first + i);
+        }
+        fn->blocks.push_back(copy);
+    }
+    fn->blocks[first].preds.assign(1, block);
+
+    int receiver = call.numArgs > 0 ? fn->args[call.firstArg] : -1;
+    std::vector<TacInstr> &head = fn->blocks[block].instrs;
+    if (call.op == TacCallMethod && !IsNotNull(fn, receiver)) {
+        int slow = fn->blocks.size();
+        TacBlock failing;
+        if (result >= 0) call.dst = fn->NewReg(fn->regTypes[result]);
+        failing.instrs.push_back(call);
+        failing.instrs.push_back(MakeInstr(TacJump, -1, cont));
+        failing.preds.assign(1, block);
+        failing.succs.assign(1, cont);
+        failing.inlinedFrom = fn->blocks[block].inlinedFrom;
+        results.push_back(call.dst);
+        from.push_back(slow);
+        int null = fn->NewReg(Type::nullType), cond = fn->NewReg(Type::boolType);
+        head.push_back(MakeInstr(TacConst, null, program->AddConstant(MakeObject(NULL))));
+        head.push_back(MakeInstr(TacNotEqualRef, cond, receiver, null));
+        head.push_back(MakeInstr(TacBranch, -1, cond, first, slow));
+        fn->blocks.push_back(failing);
+    } else {
+        head.push_back(MakeInstr(TacJump, -1, first));
+    }
+
+    TacBlock &after = fn->blocks[cont];
+    after.preds = from;
+    if (result >= 0) {
+        TacInstr phi = MakeInstr(TacPhi, result);
+        phi.firstArg = fn->args.size();
+        phi.numArgs = results.size();
+        fn->args.insert(fn->args.end(), results.begin(), results.end());
+        after.instrs.insert(after.instrs.begin(), phi);
+    }
+    fn->ComputeEdges();
+    return cont;
+}
+
+void Inliner::InlineCalls(int function)
+{
+    TacFunction *fn = program->functions[function];
+    if (!fn) return;
+    DominatorTree dom(fn);
+    std::vector<Loop> loops;
+    FindLoops(fn, dom, &loops);
+    std::vector<bool> inLoop(fn->blocks.size(), false);
+    for (size_t i = 0; i < loops.size(); i++)
+        for (size_t k = 0; k < loops[i].blocks.size(); k++)
+            inLoop[loops[i].blocks[k]] = true;
+
+    // the blocks copied in are not looked at again; the rest of a block
+    // after a call is
+    std::vector<bool> copied(fn->blocks.size(), false);
+    int size = fn->NumInstrs();
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        if (copied[b]) continue;
+        for (size_t j = 0; j < fn->blocks[b].instrs.size(); j++) {
+            const TacInstr &in = fn->blocks[b].instrs[j];
+            if (in.op != TacCall && in.op != TacCallMethod) continue;
+            TacFunction *callee = program->functions[in.a];
+            if (!callee || finished[in.a] >= finished[function] || !callee->ssa ||
+                !callee->blocks[0].preds.empty())
+                continue;
+            int calleeSize = callee->NumInstrs();
+            if (calleeSize > (inLoop[b] ? LoopCallee : SmallCallee) ||
+                size + calleeSize > MaxCallerInstrs)
+                continue;
+            int cont = Inline(fn, b, j, callee);
+            sites++;
+            size += calleeSize;
+            copied.resize(fn->blocks.size(), true);
+            inLoop.resize(fn->blocks.size(), inLoop[b]);
+            copied[cont] = false;
+            break;
+        }
+    }
+    fn->RemoveUnreachable();
+}
+
+void Inliner::Run()
+{
+    int numFunctions = program->functions.size();
+    finished.assign(numFunctions, -1);
+    onStack.assign(numFunctions, false);
+    for (int i = 0; i < numFunctions; i++)
+        if (finished[i] < 0) Visit(i);
+    for (size_t i = 0; i < order.size(); i++)
+        InlineCalls(order[i]);
+}
+
+void Optimizer::InlineCalls(TacProgram *program)
+{
+    long long size = 0;
+    for (size_t i = 0; i < program->functions.size(); i++)
+        if (program->functions[i]) size -= program->functions[i]->NumInstrs();
+    Inliner inliner(program);
+    inliner.Run();
+    for (size_t i = 0; i < program->functions.size(); i++)
+        if (program->functions[i]) size += program->functions[i]->NumInstrs();
+    PhaseTimer::Count("inline: sites inlined", inliner.sites);
+    PhaseTimer::Count("inline: instructions added", size);
+}
+
+
+/* Scalar replacement
+ * ------------------
+ * An object that never leaves the function that makes it needs no
+ * memory: its fields can live in registers. That is so when the
+ * register holding it is used only to get and set its fields, and not
+ * stored, passed, returned, compared or merged by a phi, which after
+ * inlining is what becomes of many short-lived objects. The same goes
+ * for an array of a small constant length whose elements are accessed
+ * only at constant indices within it, and its length. None of these
+ * accesses can fail, as the object is never null.
+ *
+ * A new object is never null, so its tests against null are known, and
+ * so are the branches on them, first of all. That takes away the calls
+ * inlining left for a null receiver, which would let the object out.
+ * Dead code, the phis especially, goes too before the uses are looked
+ * at.
+ *
+ * The NewObject (or NewArray) becomes the zero values of the fields, in
+ * registers of their own, a SetField a copy into one, and a GetField a
+ * copy out. As the field registers are assigned more than once, the
+ * function leaves SSA form for the rewriting and goes back into it
+ * after, which places the phis they need.
+ */
+static const int MaxReplacedElems = 16;
+
+struct Aggregate {
+    int length;                             // -1 for an object
+    std::vector<Type*> types;               // of each field or element
+    int first;                              // the register of the first
+};
+
+static bool IsReplaceableUse(const TacInstr &in, int *slot,
+                             const Aggregate &agg, const std::vector<int> &constant,
+                             const std::vector<bool> &isConstant)
+{
+    if (slot != &in.a) return false;
+    if (agg.length < 0) return in.op == TacGetField || in.op == TacSetField;
+    switch (in.op) {
+      case TacLength:
+        return true;
+      case TacGetElem: case TacGetElemUnchecked: case TacSetElem: case TacSetElemUnchecked:
+        return isConstant[in.b] && constant[in.b] >= 0 && constant[in.b] < agg.length;
+      default:
+        return false;
+    }
+}
+
+// Folds the tests of new objects against null, and the branches on
+// them. Returns whether any branch went.
+static bool FoldNullTests(TacProgram *program, TacFunction *fn)
+{
+    std::vector<bool> isNew(fn->NumRegs(), false), isNull(fn->NumRegs(), false);
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        const std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        for (size_t j = 0; j < instrs.size(); j++) {
+            const TacInstr &in = instrs[j];
+            if (in.op == TacNewObject || in.op == TacNewArray) isNew[in.dst] = true;
+            if (in.op != TacConst) continue;
+            const Value &v = program->constants.Nth(in.a);
+            isNull[in.dst] = (v.kind == ObjectValue || v.kind == ArrayValue) && !v.ref;
+        }
+    }
+    std::map<int, bool> known;
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        for (size_t j = 0; j < instrs.size(); j++) {
+            TacInstr &in = instrs[j];
+            if ((in.op == TacEqualRef || in.op == TacNotEqualRef) &&
+                ((isNew[in.a] && isNull[in.b]) || (isNull[in.a] && isNew[in.b]))) {
+                known[in.dst] = in.op == TacNotEqualRef;
+                in = MakeInstr(TacConst, in.dst, program->AddConstant(MakeBool(known[in.dst])));
+            }
+        }
+    }
+    bool changed = false;
+    for (size_t b = 0; b < fn->blocks.size() && !known.empty(); b++) {
+        TacInstr &in = fn->blocks[b].Terminator();
+        if (in.op != TacBranch || !known.count(in.a)) continue;
+        in = MakeInstr(TacJump, -1, known[in.a] ? in.b : in.c);
+        changed = true;
+    }
+    return changed;
+}
+
+void Optimizer::ReplaceAggregates(TacProgram *program, TacFunction *fn)
+{
+    Assert(fn->ssa);
+    if (FoldNullTests(program, fn)) {
+        fn->ComputeEdges();
+        fn->RemoveUnreachable();
+    }
+    EliminateDeadCode(program, fn);
+    int numRegs = fn->NumRegs();
+    std::vector<int> constant(numRegs, 0);
+    std::vector<bool> isConstant(numRegs, false);
+    std::map<int, Aggregate> aggregates;
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        const std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        for (size_t j = 0; j < instrs.size(); j++) {
+            const TacInstr &in = instrs[j];
+            if (in.op == TacConst && program->constants.Nth(in.a).kind == IntValue) {
+                isConstant[in.dst] = true;
+                constant[in.dst] = program->constants.Nth(in.a).i;
+            } else if (in.op == TacNewObject) {
+                ClassDecl *cls = program->classes.Nth(in.a);
+                Aggregate &agg = aggregates[in.dst];
+                agg.length = -1;
+                for (int i = 0; i < cls->NumFields(); i++)
+                    agg.types.push_back(cls->GetField(i)->GetType());
+            }
+        }
+    }
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        const std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        for (size_t j = 0; j < instrs.size(); j++) {
+            const TacInstr &in = instrs[j];
+            if (in.op != TacNewArray || !isConstant[in.a]) continue;
+            int length = constant[in.a];
+            if (length <= 0 || length > MaxReplacedElems) continue;
+            Aggregate &agg = aggregates[in.dst];
+            agg.length = length;
+            agg.types.assign(length, program->types.Nth(in.b));
+        }
+    }
+
+    std::vector<int*> slots;
+    for (size_t b = 0; b < fn->blocks.size() && !aggregates.empty(); b++) {
+        std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        for (size_t j = 0; j < instrs.size(); j++) {
+            slots.clear();
+            fn->GetUseSlots(instrs[j], &slots);
+            for (size_t k = 0; k < slots.size(); k++) {
+                std::map<int, Aggregate>::iterator it = aggregates.find(*slots[k]);
+                if (it != aggregates.end() &&
+                    !IsReplaceableUse(instrs[j], slots[k], it->second, constant, isConstant))
+                    aggregates.erase(it);
+            }
+        }
+    }
+    if (aggregates.empty()) return;
+
+    LeaveSSA(fn);
+    std::map<int, int> zeros;                   // constant of each kind of value
+    for (std::map<int, Aggregate>::iterator it = aggregates.begin(); it != aggregates.end(); ++it) {
+        Aggregate &agg = it->second;
+        agg.first = fn->NumRegs();
+        for (size_t i = 0; i < agg.types.size(); i++)
+            fn->NewReg(agg.types[i]);
+    }
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        std::vector<TacInstr> replaced;
+        for (size_t j = 0; j < instrs.size(); j++) {
+            TacInstr in = instrs[j];
+            std::map<int, Aggregate>::iterator it;
+            if ((in.op == TacNewObject || in.op == TacNewArray) &&
+                (it = aggregates.find(in.dst)) != aggregates.end()) {
+                const Aggregate &agg = it->second;
+                for (size_t i = 0; i < agg.types.size(); i++) {
+                    Value zero = Interpreter::ZeroOf(agg.types[i]);
+                    if (!zeros.count(zero.kind)) zeros[zero.kind] = program->AddConstant(zero);
+                    replaced.push_back(MakeInstr(TacConst, agg.first + i, zeros[zero.kind]));
+                }
+                continue;
+            }
+            // the others name no register by a, or no aggregate
+            it = aggregates.find(in.a);
+            if (it == aggregates.end()) {
+                replaced.push_back(in);
+                continue;
+            }
+            const Aggregate &agg = it->second;
+            switch (in.op) {
+              case TacGetField:
+                in = MakeInstr(TacCopy, in.dst, agg.first + in.b);
+                break;
+              case TacSetField:
+                in = MakeInstr(TacCopy, agg.first + in.b, in.c);
+                break;
+              case TacGetElem: case TacGetElemUnchecked:
+                in = MakeInstr(TacCopy, in.dst, agg.first + constant[in.b]);
+                break;
+              case TacSetElem: case TacSetElemUnchecked:
+                in = MakeInstr(TacCopy, agg.first + constant[in.b], in.c);
+                break;
+              case TacLength:
+                in = MakeInstr(TacConst, in.dst, program->AddConstant(MakeInt(agg.length)));
+                break;
+              default:
+                replaced.push_back(in);
+                continue;
+            }
+            replaced.push_back(in);
+        }
+        instrs.swap(replaced);
+    }
+    BuildSSA(fn);
+    PhaseTimer::Count("sra: allocations replaced", aggregates.size());
+}
+
+
+/* The pass manager
+ * ----------------
+ * Passes run one at a time over all functions, so each is a single
+ * phase in the -time-phases report. A pass over the whole program at
+ * once has runProgram in place of run.
+ */
+static void BuildSSAPass(TacProgram *program, TacFunction *fn) { BuildSSA(fn); }
+static void LeaveSSAPass(TacProgram *program, TacFunction *fn) { LeaveSSA(fn); }
+
+static const struct {
+    const char *name;
+    int level;                              // the lowest it runs at
+    void (*run)(TacProgram *program, TacFunction *fn);
+    void (*runProgram)(TacProgram *program);
+    const char *counter;                    // of instructions removed
+} passes[] = {
+    { "ssa",     1, BuildSSAPass, NULL, NULL },
+    { "sccp",    1, Optimizer::PropagateConstants, NULL, "sccp: instructions removed" },
+    { "devirt",  1, NULL, Optimizer::Devirtualize, NULL },
+    { "inline",  2, NULL, Optimizer::InlineCalls, NULL },
+    { "sra",     2, Optimizer::ReplaceAggregates, NULL, NULL },
+    { "gvn",     2, Optimizer::NumberValues, NULL, "gvn: instructions removed" },
+    { "bce",     2, Optimizer::EliminateBoundsChecks, NULL, NULL },
+    { "licm",    2, Optimizer::HoistInvariants, NULL, NULL },
+    { "sr",      2, Optimizer::ReduceStrength, NULL, NULL },
+    { "dce",     1, Optimizer::EliminateDeadCode, NULL, "dce: instructions removed" },
+    { "vec",     2, Optimizer::VectorizeLoops, NULL, NULL },
+    { "ssa-out", 1, LeaveSSAPass, NULL, NULL },
+};
+
+bool Optimizer::Run(TacProgram *program, int level)
+{
+    for (size_t i = 0; i < sizeof(passes) / sizeof(passes[0]); i++) {
+        if (passes[i].level > level) continue;
+        PhaseScope scope(passes[i].name);
+        long long removed = 0;
+        if (passes[i].runProgram) passes[i].runProgram(program);
+        for (size_t j = 0; j < program->functions.size() && passes[i].run; j++) {
+            TacFunction *fn = program->functions[j];
+            if (!fn) continue;
+            removed += fn->NumInstrs();
+            passes[i].run(program, fn);
+            removed -= fn->NumInstrs();
+        }
+        if (passes[i].counter) PhaseTimer::Count(passes[i].counter, removed);
+        if (IsDebugOn("tac")) {
+            fprintf(stderr, "=== after %s\n", passes[i].name);
+            program->Print(stderr);
+            if (!program->Verify()) {
+                fprintf(stderr, "dcc: %s produced bad code\n", passes[i].name);
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,104 @@
+/* File: opt.h
+ * -----------
+ * The optimizer: passes over the three-address code of a program (see
+ * tac.h), run in turn by a pass manager at the level given by -O:
+ *
+ *    -O0   none; --run lowers the AST to bytecode directly (codegen.h)
+ *    -O1   ssa, sccp, devirt, dce, ssa-out
+ *    -O2   ssa, sccp, devirt, inline, sra, gvn, bce, licm, sr, dce,
+ *          vec, ssa-out
+ *
+ *  - ssa puts each function into SSA form (see ssa.h), which the passes
+ *    up to ssa-out work on, and ssa-out takes it out again.
+ *  - sccp is sparse conditional constant propagation (Wegman and
+ *    Zadeck): it finds the registers that hold the same constant
+ *    whenever they are assigned, assuming only the blocks found to be
+ *    reachable can run, so a branch or switch on a constant drops the
+ *    code it never takes, and the phis along with it.
+ *  - devirt works on the whole program: rapid type analysis finds the
+ *    classes it can make instances of, and a method call that can then
+ *    go to only one method calls that method directly. The calls left
+ *    to look up their method have an inline cache in the VM and the JIT
+ *    (see bytecode.h).
+ *  - inline copies small functions into their callers, in place of the
+ *    calls to them (those devirt made direct too): the smallest
+ *    anywhere, somewhat larger ones in loops, so long as the caller
+ *    does not grow too large and the call does not close a cycle of
+ *    recursion. The blocks copied in say what function they are from
+ *    in the -emit-tac listing.
+ *  - sra is scalar replacement of aggregates: an object the function
+ *    makes and uses only through its fields, never letting it out,
+ *    lives in registers instead of being allocated, as does a small
+ *    array of constant length used only at constant indices.
+ *  - gvn is global value numbering over the dominator tree: an
+ *    instruction computing what one dominating it already computed
+ *    (the same operation of the same operands, after copies are seen
+ *    through) is dropped and its uses take the earlier result.
+ *  - bce is bounds check elimination: accesses to arrays indexed by the
+ *    counter of a loop that stays within them lose their checks, known
+ *    from constants, or by versioning the loop (see loops.h) behind a
+ *    guard that tests the array is long enough before entering it.
+ *  - licm is loop-invariant code motion: what a loop computes the same
+ *    each time around moves to a block ahead of it, when that cannot
+ *    change what the program does: loads of what the loop does not
+ *    store to, and what could fail only if it is ahead of anything
+ *    else the loop does.
+ *  - sr is strength reduction: a product of a loop's counter and a
+ *    value the loop does not change is kept in a register of its own,
+ *    which goes up by an addition each time around instead.
+ *  - dce drops the instructions whose results nothing needs, unless
+ *    they have an effect or can fail at runtime.
+ *  - vec is vectorization: a loop that only sets the elements of an
+ *    array, each from those of other arrays at the same index by one
+ *    arithmetic operation (or a copy, or a fill with one value), gives
+ *    way to a MapElems instruction (see tac.h), a loop the VM and the
+ *    JIT run without the loop's overhead for each element. So does a
+ *    loop that gives each element a new array of the same length, the
+ *    rows of a rectangular array, which are then made all at once,
+ *    next to each other in memory. It runs after bce, whose unchecked
+ *    accesses it needs, and licm and dce, which leave the loop with
+ *    nothing else in it.
+ *
+ * Each pass is a phase of its own in the -time-phases report, and
+ * counts how many instructions it took out of the program (devirt, how
+ * many calls it made direct; inline, how many calls it inlined and how
+ * many instructions that added; sra, how many allocations it replaced;
+ * bce, how many checks; licm, how many instructions it moved; sr, how
+ * many multiplications; and vec, how many loops), so the report shows
+ * both what a pass costs and what it buys.
+ */
+
+#ifndef _H_opt
+#define _H_opt
+
+#include "tac.h"
+
+class Optimizer
+{
+  public:
+    // Runs the passes of the level (1 or 2) over every function. With
+    // -d tac, the code is listed on stderr and verified after each one,
+    // and false is returned as soon as a pass leaves it not well formed.
+    static bool Run(TacProgram *program, int level);
+
+    // The passes over the whole program.
+    static void Devirtualize(TacProgram *program);
+    static void InlineCalls(TacProgram *program);
+
+    // The passes over a function in SSA form.
+    static void PropagateConstants(TacProgram *program, TacFunction *fn);
+    static void ReplaceAggregates(TacProgram *program, TacFunction *fn);
+    static void NumberValues(TacProgram *program, TacFunction *fn);
+    static void EliminateBoundsChecks(TacProgram *program, TacFunction *fn);
+    static void HoistInvariants(TacProgram *program, TacFunction *fn);
+    static void ReduceStrength(TacProgram *program, TacFunction *fn);
+    static void VectorizeLoops(TacProgram *program, TacFunction *fn);
+    static void EliminateDeadCode(TacProgram *program, TacFunction *fn);
+
+    // The value of the pure operation op on constant operands, as the
+    // interpreter would compute it. Returns false if op is not pure or
+    // would stop with a runtime error (division by zero).
+    static bool Fold(int op, Value a, Value b, Value *result);
+};
+
+#endif
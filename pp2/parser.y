@@ -19,9 +19,51 @@
 #include "scanner.h" // for yylex
 #include "parser.h"
 #include "errors.h"
+#include "timer.h"
 
 void yyerror(const char *msg); // standard error-handling routine
 
+/* Each call the parser makes to the scanner is timed as the "scan" phase
+ * (which includes the scanner's copying of each line for error context),
+ * so that -time-phases can tell scanning and parsing apart. With -trace,
+ * the token's location also records when it was asked for. */
+static int TimedLex() {
+    PhaseScope scope("scan", false);
+#ifdef DCC_TRACE
+    if (Tracer::enabled) yylloc.traceStart = Tracer::Now();
+#endif
+    return yylex();
+}
+#define yylex TimedLex
+
+/* Bison's default, except that a reduction's location also takes the
+ * time its first token was asked for (now, if it has none). */
+#define YYLLOC_DEFAULT(Current, Rhs, N) do {                                  \
+    if (N) {                                                                  \
+        (Current).first_line = YYRHSLOC(Rhs, 1).first_line;                   \
+        (Current).first_column = YYRHSLOC(Rhs, 1).first_column;               \
+        (Current).last_line = YYRHSLOC(Rhs, N).last_line;                     \
+        (Current).last_column = YYRHSLOC(Rhs, N).last_column;                 \
+        (Current).traceStart = YYRHSLOC(Rhs, 1).traceStart;                   \
+    } else {                                                                  \
+        (Current).first_line = (Current).last_line = YYRHSLOC(Rhs, 0).last_line; \
+        (Current).first_column = (Current).last_column = YYRHSLOC(Rhs, 0).last_column; \
+        (Current).traceStart = Tracer::enabled ? Tracer::Now() : 0;           \
+    }                                                                         \
+} while (0)
+
+/* With -trace, each declaration (top-level or in a class) and each
+ * statement is drawn as a zone that runs from when its first token was
+ * asked for to its reduction, i.e. the time spent scanning and parsing
+ * it. Expressions and the local variables of a block are not zones of
+ * their own; their time is part of the statement that holds them. */
+static void TraceReduction(Node *node, const char *detail, const yyltype &loc) {
+#ifdef DCC_TRACE
+    if (Tracer::enabled)
+        Tracer::AddZone(node->GetPrintNameForNode(), detail, loc.traceStart, Tracer::Now());
+#endif
+}
+
 %}
 
 /* The section before the first %% is the Definitions section of the yacc
@@ -159,20 +201,20 @@ Program   :    DeclList            {
                                       /* pp2: The @1 is needed to convince 
                                    /    * yacc to set up yylloc. You can remove 
                                        * it once you have other uses of @n*/
-                                      Program *program = new Program($1);
-                                      // if no errors, advance to next phase
-                                      if (ReportError::NumErrors() == 0) 
-                                          program->Print(0);
+                                      // hand the declarations back to the
+                                      // driver, which merges the lists of
+                                      // all input files into one Program
+                                      parsedDecls = $1;
                                     }
           ;
 
 DeclList  :    DeclList Decl        { ($$=$1)->Append($2); }
           |    Decl                 { ($$ = new List<Decl*>)->Append($1); };
 
-Decl      :    VarDecl              { $$=$1; }
-          |    FnDecl               { $$=$1; }
-	  |    ClassDecl	    { $$=$1; }
-	  |    InterfaceDecl  	    { $$=$1; }
+Decl      :    VarDecl              { $$=$1; TraceReduction($$, $$->GetName(), @1); }
+          |    FnDecl               { $$=$1; TraceReduction($$, $$->GetName(), @1); }
+	  |    ClassDecl	    { $$=$1; TraceReduction($$, $$->GetName(), @1); }
+	  |    InterfaceDecl  	    { $$=$1; TraceReduction($$, $$->GetName(), @1); }
 ;
 
 VarDecl   :    Variable ';'         { $$=$1; }
@@ -229,8 +271,8 @@ FieldList:     FieldList Field     { ($$=$1)->Append($2); }
                | /* empty*/    		{ $$ = new List<Decl*>; }
 ;
 	  
-Field: 		VarDecl 	{ $$ = $1; }
-	|	FnDecl		{ $$ = $1; }     
+Field: 		VarDecl 	{ $$ = $1; TraceReduction($$, $$->GetName(), @1); }
+	|	FnDecl		{ $$ = $1; TraceReduction($$, $$->GetName(), @1); }
 ;
 
 InterfaceDecl: T_Interface T_Identifier '{' PrototypeList '}' 
@@ -253,15 +295,15 @@ StmtList: 	Stmt StmtList 	{ ($$=$2)->InsertAt($1, 0); }
 	|			{ $$ = new List<Stmt*>; }
 ;
 
-Stmt:	OptionalExpr ';'	{ $$ = $1;}
-	|	IfStmt	{ $$ = $1; }
-	|	WhileStmt	{ $$ = $1; }
-	|	ForStmt	{ $$ = $1; }
-	|	BreakStmt	{ $$ = $1; }
-	|	ReturnStmt	{ $$ = $1; }
-	|	PrintStmt	{ $$ = $1; }
-	|	StmtBlock	{ $$ = $1; }
-	|	SwitchStmt	{ $$ = $1; }
+Stmt:	OptionalExpr ';'	{ $$ = $1; TraceReduction($$, NULL, @$); }
+	|	IfStmt	{ $$ = $1; TraceReduction($$, NULL, @1); }
+	|	WhileStmt	{ $$ = $1; TraceReduction($$, NULL, @1); }
+	|	ForStmt	{ $$ = $1; TraceReduction($$, NULL, @1); }
+	|	BreakStmt	{ $$ = $1; TraceReduction($$, NULL, @1); }
+	|	ReturnStmt	{ $$ = $1; TraceReduction($$, NULL, @1); }
+	|	PrintStmt	{ $$ = $1; TraceReduction($$, NULL, @1); }
+	|	StmtBlock	{ $$ = $1; TraceReduction($$, NULL, @1); }
+	|	SwitchStmt	{ $$ = $1; TraceReduction($$, NULL, @1); }
 ;
 
 OptionalExpr:	Expr	{ $$ = $1; }
@@ -388,6 +430,14 @@ Constant:	T_IntConstant	{ $$ = new IntConstant(@1, $1); }
  * This section is where you put definitions of helper functions.
  */
 
+/* Global variable: parsedDecls
+ * ----------------------------
+ * The declaration list of the last input successfully reduced to a
+ * Program, or NULL if the parse did not get that far.
+ */
+List<Decl*> *parsedDecls;
+
+
 /* Function: InitParser
  * --------------------
  * This function will be called before any calls to yyparse().  It is designed
@@ -405,4 +455,5 @@ void InitParser()
 {
    PrintDebug("parser", "Initializing parser");
    yydebug = false;
+   parsedDecls = NULL;
 }
@@ -0,0 +1,22 @@
+/* File: scope.cc
+ * --------------
+ * Implementation of the Scope class.
+ */
+
+#include "scope.h"
+#include "ast_decl.h"
+#include "errors.h"
+
+Scope::Scope() {
+    table = new Hashtable<Decl*>;
+}
+
+bool Scope::Declare(Decl *decl) {
+    Decl *prev = table->Lookup(decl->GetName());
+    if (prev) {
+        ReportError::DeclConflict(decl, prev);
+        return false;
+    }
+    table->Enter(decl->GetName(), decl);
+    return true;
+}
@@ -0,0 +1,34 @@
+/* File: scope.h
+ * -------------
+ * A Scope is the set of declarations made in one region of the program:
+ * the globals, the members of a class or interface, the formals of a
+ * function or the variables of a statement block. The nodes that open a
+ * region own its Scope, and names are resolved by walking up the tree
+ * from the point of use through the enclosing scopes (see
+ * Node::FindDecl in ast.h).
+ */
+
+#ifndef _H_scope
+#define _H_scope
+
+#include "hashtable.h"
+
+class Decl;
+
+class Scope
+{
+  protected:
+    Hashtable<Decl*> *table;
+
+  public:
+    Scope();
+
+    // Returns the declaration of name made in this scope, or NULL.
+    Decl *Lookup(const char *name) { return table->Lookup(name); }
+
+    // Enters decl, unless its name is already declared in this scope,
+    // in which case the conflict is reported and false is returned.
+    bool Declare(Decl *decl);
+};
+
+#endif
@@ -0,0 +1,186 @@
+/* File: server.cc
+ * ---------------
+ * Implementation of the compile server.
+ */
+
+#include "server.h"
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <string>
+#include <vector>
+#include "wire.h"
+#include "capture.h"
+#include "driver.h"
+#include "utility.h"
+#include "io.h"
+
+
+/* Function: Compile()
+ * -------------------
+ * Runs one request's compilation with the given working directory,
+ * arguments and stdin contents, and returns its exit status.
+ */
+static int Compile(const std::string &cwd, std::vector<std::string> &args,
+                   const std::string &input)
+{
+    if (chdir(cwd.c_str()) != 0) {
+        fprintf(stderr, "dcc: cannot change to directory %s\n", cwd.c_str());
+        return 2;
+    }
+
+    std::vector<char*> argv;
+    argv.push_back((char *)"dcc");
+    for (size_t i = 0; i < args.size(); i++)
+        argv.push_back(&args[i][0]);
+    argv.push_back(NULL);
+    if (!ParseArguments(argv.size() - 1, &argv[0]) || IsOptionOn("--server") ||
+        IsOptionOn("--time-limit")) {
+        PrintUsage();
+        return 2;
+    }
+
+    FILE *in = tmpfile();
+    Assert(in != NULL);
+    fwrite(input.data(), 1, input.size(), in);
+    rewind(in);
+    int status = CompileProgram(in);
+    fclose(in);
+    return status;
+}
+
+
+/* Function: RunsProgram()
+ * -----------------------
+ * Returns whether a request's arguments ask for its program to be run,
+ * which, unlike compiling it, need never finish.
+ */
+static bool RunsProgram(const std::vector<std::string> &args)
+{
+    for (size_t i = 0; i < args.size(); i++)
+        if (args[i] == "--interpret" || args[i] == "--run") return true;
+    return false;
+}
+
+/* Function: StopChild()
+ * ---------------------
+ * The SIGALRM handler of a child running a request: what the program
+ * printed is flushed before the signal is let kill the child. (Neither
+ * flush is safe in a handler, but the child goes away either way.)
+ */
+static void StopChild(int sig)
+{
+    IO::Flush();
+    fflush(NULL);
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+/* Function: CompileInChild()
+ * --------------------------
+ * Runs Compile() in a child process that is killed if it takes longer
+ * than timeLimit seconds, and returns its exit status. The child writes
+ * to the same descriptors, so what it printed before being stopped is
+ * kept. Nothing the child does reaches the server's own state, its
+ * parse cache included.
+ */
+static int CompileInChild(const std::string &cwd, std::vector<std::string> &args,
+                          const std::string &input, int timeLimit)
+{
+    fflush(NULL);
+    pid_t pid = fork();
+    if (pid == 0) {
+        signal(SIGALRM, StopChild);
+        alarm(timeLimit);
+        int status = Compile(cwd, args, input);
+        fflush(NULL);
+        _exit(status);
+    }
+    int status;
+    if (pid < 0) {
+        fprintf(stderr, "dcc: cannot fork: %s\n", strerror(errno));
+        return 2;
+    }
+    while (waitpid(pid, &status, 0) < 0)
+        if (errno != EINTR) return 2;
+    if (WIFEXITED(status)) return WEXITSTATUS(status);
+    if (WTERMSIG(status) == SIGALRM)
+        fprintf(stderr, "dcc: stopped after the time limit of %d seconds\n", timeLimit);
+    else
+        fprintf(stderr, "dcc: killed by signal %d\n", WTERMSIG(status));
+    return 2;
+}
+
+
+/* Function: HandleRequest()
+ * -------------------------
+ * Reads one request from a connected client, compiles it with the
+ * output captured, and sends back the reply. A request that runs its
+ * program does so in a child process, under the time limit.
+ */
+static void HandleRequest(int fd, int timeLimit)
+{
+    std::string cwd, input, arg, out, err;
+    std::vector<std::string> args;
+
+    if (!ReadField(fd, &cwd) || !ReadField(fd, &input)) return;
+    while (true) {
+        if (!ReadField(fd, &arg)) return;
+        if (arg.empty()) break;
+        args.push_back(arg);
+    }
+
+    int status;
+    {
+        OutputCapture capture;
+        if (RunsProgram(args)) status = CompileInChild(cwd, args, input, timeLimit);
+        else status = Compile(cwd, args, input);
+        capture.Finish(&out, &err);
+    }
+    PrintDebug("server", "Compiled request with %d args, status %d",
+               (int)args.size(), status);
+
+    char statusText[16];
+    sprintf(statusText, "%d", status);
+    WriteField(fd, statusText) && WriteField(fd, out) && WriteField(fd, err);
+}
+
+
+int RunCompileServer(const char *socketPath, int timeLimit)
+{
+    struct sockaddr_un addr;
+    if (strlen(socketPath) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "dcc: socket path too long: %s\n", socketPath);
+        return 2;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socketPath);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socketPath);
+    if (listener < 0 || bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(listener, SOMAXCONN) != 0) {
+        fprintf(stderr, "dcc: cannot listen on %s: %s\n", socketPath, strerror(errno));
+        return 2;
+    }
+
+    signal(SIGPIPE, SIG_IGN); // a client that goes away must not kill us
+    SetParseCacheEnabled(true);
+    PrintDebug("server", "Listening on %s", socketPath);
+    while (true) {
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "dcc: accept failed: %s\n", strerror(errno));
+            return 2;
+        }
+        HandleRequest(fd, timeLimit);
+        close(fd);
+    }
+}
@@ -0,0 +1,37 @@
+/* File: server.h
+ * --------------
+ * The compile server lets one long-running dcc process handle the
+ * compilations of many client invocations. Started with
+ *
+ *    dcc --server <socket-path>
+ *
+ * it listens on a Unix domain socket and compiles one request at a time,
+ * replying with the exit status and the text the compilation wrote to
+ * stdout and stderr. Between requests it keeps its parse cache (see
+ * driver.h) and the rest of its initialized state, so a request pays
+ * neither process startup nor re-parsing of unchanged files. The dcc-client
+ * program (client.cc) is the matching drop-in replacement for dcc.
+ *
+ * A request that runs its program (--interpret or --run) does so in a
+ * child process, stopped once it has run for the time limit (--time-limit
+ * <seconds> after the socket path), so that a program that never ends
+ * cannot hold up the requests behind it.
+ */
+
+#ifndef _H_server
+#define _H_server
+
+// How long, in seconds, a request may run its program unless the server
+// was started with --time-limit.
+static const int DefaultTimeLimit = 30;
+
+/* Function: RunCompileServer()
+ * ----------------------------
+ * Binds the socket at the given path (replacing a stale one) and serves
+ * requests until the process is killed, giving each request that runs
+ * its program timeLimit seconds. Returns only if the socket could not be
+ * set up, in which case the return value is the exit status.
+ */
+int RunCompileServer(const char *socketPath, int timeLimit);
+
+#endif
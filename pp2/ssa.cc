@@ -0,0 +1,373 @@
+/* File: ssa.cc
+ * ------------
+ * Implementation of dominators and of SSA construction and destruction.
+ */
+
+#include "ssa.h"
+#include "utility.h"
+
+
+/* The blocks are numbered in reverse postorder, and a block's dominator
+ * found as the closest common ancestor, in the tree as computed so far,
+ * of its predecessors; repeated until nothing changes, which for the
+ * graphs of structured code is after the second pass. */
+DominatorTree::DominatorTree(TacFunction *fn)
+{
+    int numBlocks = fn->blocks.size();
+    std::vector<int> post;
+    std::vector<bool> visited(numBlocks, false);
+    std::vector<std::pair<int, size_t> > stack;
+    stack.push_back(std::make_pair(0, (size_t)0));
+    visited[0] = true;
+    while (!stack.empty()) {
+        int b = stack.back().first;
+        size_t next = stack.back().second;
+        std::vector<int> &succs = fn->blocks[b].succs;
+        if (next < succs.size()) {
+            stack.back().second++;
+            if (!visited[succs[next]]) {
+                visited[succs[next]] = true;
+                stack.push_back(std::make_pair(succs[next], (size_t)0));
+            }
+        } else {
+            post.push_back(b);
+            stack.pop_back();
+        }
+    }
+    order.assign(post.rbegin(), post.rend());
+    orderIndex.assign(numBlocks, -1);
+    for (size_t i = 0; i < order.size(); i++)
+        orderIndex[order[i]] = i;
+
+    idom.assign(numBlocks, -1);
+    idom[0] = 0;
+    for (bool changed = true; changed; ) {
+        changed = false;
+        for (size_t i = 1; i < order.size(); i++) {
+            int b = order[i], newIdom = -1;
+            std::vector<int> &preds = fn->blocks[b].preds;
+            for (size_t j = 0; j < preds.size(); j++) {
+                int p = preds[j];
+                if (idom[p] < 0) continue;       // not reached yet, or unreachable
+                if (newIdom < 0) {
+                    newIdom = p;
+                    continue;
+                }
+                int x = p, y = newIdom;
+                while (x != y) {
+                    while (orderIndex[x] > orderIndex[y]) x = idom[x];
+                    while (orderIndex[y] > orderIndex[x]) y = idom[y];
+                }
+                newIdom = x;
+            }
+            if (idom[b] != newIdom) {
+                idom[b] = newIdom;
+                changed = true;
+            }
+        }
+    }
+    idom[0] = -1;
+    children.assign(numBlocks, std::vector<int>());
+    for (size_t i = 1; i < order.size(); i++)
+        children[idom[order[i]]].push_back(order[i]);
+}
+
+/* A join point is in the frontier of each block on the way up the tree
+ * from a predecessor to the join point's dominator. */
+void DominatorTree::ComputeFrontiers(TacFunction *fn)
+{
+    frontier.assign(fn->blocks.size(), std::vector<int>());
+    for (size_t i = 0; i < order.size(); i++) {
+        int b = order[i];
+        std::vector<int> &preds = fn->blocks[b].preds;
+        if (preds.size() < 2) continue;
+        for (size_t j = 0; j < preds.size(); j++) {
+            for (int runner = preds[j]; runner != idom[b] && orderIndex[runner] >= 0;
+                 runner = idom[runner]) {
+                std::vector<int> &f = frontier[runner];
+                if (f.empty() || f.back() != b) f.push_back(b);
+            }
+        }
+    }
+}
+
+bool DominatorTree::Dominates(int a, int b)
+{
+    while (b >= 0 && b != a)
+        b = idom[b];
+    return b == a;
+}
+
+void DominatorTree::GetPreorder(std::vector<int> *blocks)
+{
+    std::vector<int> stack(1, 0);
+    while (!stack.empty()) {
+        int b = stack.back();
+        stack.pop_back();
+        blocks->push_back(b);
+        for (size_t i = children[b].size(); i > 0; i--)
+            stack.push_back(children[b][i-1]);
+    }
+}
+
+
+/* Function: BuildSSA()
+ * --------------------
+ * Phis are placed only for the registers that some block reads before
+ * assigning them, and only where the register is live (pruned SSA): the
+ * temporaries of an expression, used only where they are computed, need
+ * none, and a join that a path reaches before the register is assigned
+ * gets none either, so every phi argument names an assignment. A phi
+ * records the register it stands for in its operand a until it is
+ * renamed.
+ */
+void BuildSSA(TacFunction *fn)
+{
+    Assert(!fn->ssa);
+    DominatorTree dom(fn);
+    dom.ComputeFrontiers(fn);
+    int numBlocks = fn->blocks.size(), numVars = fn->NumRegs();
+
+    std::vector<bool> global(numVars, false);
+    std::vector<std::vector<int> > defBlocks(numVars);
+    std::vector<std::vector<int> > useBlocks(numVars);    // read before assigned
+    std::vector<int> assignedIn(numVars, -1);
+    for (int v = 0; v < fn->numParams; v++)
+        defBlocks[v].push_back(0);
+    std::vector<int> uses;
+    for (size_t i = 0; i < dom.order.size(); i++) {
+        int b = dom.order[i];
+        std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        for (size_t j = 0; j < instrs.size(); j++) {
+            uses.clear();
+            fn->GetUses(instrs[j], &uses);
+            for (size_t k = 0; k < uses.size(); k++) {
+                int u = uses[k];
+                if (assignedIn[u] == b) continue;
+                global[u] = true;
+                if (useBlocks[u].empty() || useBlocks[u].back() != b) useBlocks[u].push_back(b);
+            }
+            int d = instrs[j].dst;
+            if (d < 0) continue;
+            assignedIn[d] = b;
+            if (defBlocks[d].empty() || defBlocks[d].back() != b) defBlocks[d].push_back(b);
+        }
+    }
+
+    std::vector<std::vector<int> > phiVars(numBlocks);
+    std::vector<int> hasPhi(numBlocks, -1), queued(numBlocks, -1);
+    std::vector<int> assigns(numBlocks, -1), liveIn(numBlocks, -1);
+    for (int v = 0; v < numVars; v++) {
+        if (!global[v]) continue;
+        // live on entry to the blocks reached going back from a read
+        // before any assignment
+        for (size_t i = 0; i < defBlocks[v].size(); i++)
+            assigns[defBlocks[v][i]] = v;
+        std::vector<int> work = useBlocks[v];
+        for (size_t i = 0; i < work.size(); i++)
+            liveIn[work[i]] = v;
+        while (!work.empty()) {
+            std::vector<int> &preds = fn->blocks[work.back()].preds;
+            work.pop_back();
+            for (size_t i = 0; i < preds.size(); i++) {
+                int p = preds[i];
+                if (liveIn[p] == v || assigns[p] == v) continue;
+                liveIn[p] = v;
+                work.push_back(p);
+            }
+        }
+
+        work = defBlocks[v];
+        for (size_t i = 0; i < work.size(); i++)
+            queued[work[i]] = v;
+        while (!work.empty()) {
+            int b = work.back();
+            work.pop_back();
+            for (size_t i = 0; i < dom.frontier[b].size(); i++) {
+                int f = dom.frontier[b][i];
+                if (hasPhi[f] == v || liveIn[f] != v) continue;
+                hasPhi[f] = v;
+                phiVars[f].push_back(v);
+                if (queued[f] != v) {
+                    queued[f] = v;
+                    work.push_back(f);
+                }
+            }
+        }
+    }
+    for (int b = 0; b < numBlocks; b++) {
+        if (phiVars[b].empty()) continue;
+        std::vector<TacInstr> phis;
+        for (size_t i = 0; i < phiVars[b].size(); i++) {
+            TacInstr phi;
+            phi.op = TacPhi;
+            phi.dst = phi.a = phiVars[b][i];
+            phi.b = phi.c = 0;
+            phi.firstArg = fn->args.size();
+            phi.numArgs = fn->blocks[b].preds.size();
+            fn->args.insert(fn->args.end(), phi.numArgs, -1);
+            phis.push_back(phi);
+        }
+        std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        instrs.insert(instrs.begin(), phis.begin(), phis.end());
+    }
+
+    // renaming: the first assignment of a register keeps it, the others
+    // get fresh ones; a use sees the innermost name on the way down the
+    // dominator tree
+    std::vector<std::vector<int> > names(numVars);
+    std::vector<bool> taken(numVars, false);
+    for (int v = 0; v < fn->numParams; v++) {
+        names[v].push_back(v);
+        taken[v] = true;
+    }
+    struct Frame {
+        int block;
+        size_t nextChild;
+        std::vector<int> pushed;
+    };
+    std::vector<Frame> stack(1);
+    stack[0].block = 0;
+    stack[0].nextChild = 0;
+    bool entering = true;
+    std::vector<int*> slots;
+    while (!stack.empty()) {
+        Frame &frame = stack.back();
+        int b = frame.block;
+        if (entering) {
+            std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+            for (size_t j = 0; j < instrs.size(); j++) {
+                TacInstr &in = instrs[j];
+                if (in.op != TacPhi) {
+                    slots.clear();
+                    fn->GetUseSlots(in, &slots);
+                    for (size_t k = 0; k < slots.size(); k++)
+                        if (*slots[k] < numVars && !names[*slots[k]].empty())
+                            *slots[k] = names[*slots[k]].back();
+                }
+                if (in.dst < 0) continue;
+                int v = in.op == TacPhi ? in.a : in.dst;
+                int name = v;
+                if (taken[v]) name = fn->NewReg(fn->regTypes[v]);
+                taken[v] = true;
+                names[v].push_back(name);
+                frame.pushed.push_back(v);
+                in.dst = name;
+            }
+            std::vector<int> &succs = fn->blocks[b].succs;
+            for (size_t i = 0; i < succs.size(); i++) {
+                TacBlock &s = fn->blocks[succs[i]];
+                size_t k = 0;
+                while (s.preds[k] != b) k++;
+                for (size_t j = 0; j < s.instrs.size() && s.instrs[j].op == TacPhi; j++) {
+                    int v = s.instrs[j].a;
+                    fn->args[s.instrs[j].firstArg + k] = names[v].empty() ? v : names[v].back();
+                }
+            }
+        }
+        if (frame.nextChild < dom.children[b].size()) {
+            Frame child;
+            child.block = dom.children[b][frame.nextChild++];
+            child.nextChild = 0;
+            stack.push_back(child);
+            entering = true;
+        } else {
+            for (size_t i = 0; i < frame.pushed.size(); i++)
+                names[frame.pushed[i]].pop_back();
+            stack.pop_back();
+            entering = false;
+        }
+    }
+    fn->ssa = true;
+}
+
+
+/* Function: SequentializeCopies()
+ * -------------------------------
+ * Adds the copies before the terminator of the block, in an order that
+ * has each read its source before anything assigns it; a cycle of copies
+ * (two phis swapping their values from one iteration to the next) is
+ * broken by saving one of the values in a fresh register first.
+ */
+static void SequentializeCopies(TacFunction *fn, int block,
+                                std::vector<std::pair<int, int> > copies)
+{
+    std::vector<TacInstr> seq;
+    TacInstr copy;
+    copy.op = TacCopy;
+    copy.b = copy.c = copy.firstArg = copy.numArgs = 0;
+    for (size_t i = 0; i < copies.size(); )
+        if (copies[i].first == copies[i].second) copies.erase(copies.begin() + i);
+        else i++;
+    while (!copies.empty()) {
+        size_t ready = copies.size();
+        for (size_t i = 0; i < copies.size() && ready == copies.size(); i++) {
+            bool isSource = false;
+            for (size_t j = 0; j < copies.size() && !isSource; j++)
+                isSource = j != i && copies[j].second == copies[i].first;
+            if (!isSource) ready = i;
+        }
+        if (ready == copies.size()) {
+            int saved = copies[0].first, temp = fn->NewReg(fn->regTypes[saved]);
+            copy.dst = temp;
+            copy.a = saved;
+            seq.push_back(copy);
+            for (size_t j = 0; j < copies.size(); j++)
+                if (copies[j].second == saved) copies[j].second = temp;
+            continue;
+        }
+        copy.dst = copies[ready].first;
+        copy.a = copies[ready].second;
+        seq.push_back(copy);
+        copies.erase(copies.begin() + ready);
+    }
+    std::vector<TacInstr> &instrs = fn->blocks[block].instrs;
+    instrs.insert(instrs.end() - 1, seq.begin(), seq.end());
+}
+
+void LeaveSSA(TacFunction *fn)
+{
+    Assert(fn->ssa);
+    int numBlocks = fn->blocks.size();
+    for (int b = 0; b < numBlocks; b++) {
+        size_t numPhis = 0;
+        while (numPhis < fn->blocks[b].instrs.size() && fn->blocks[b].instrs[numPhis].op == TacPhi)
+            numPhis++;
+        if (numPhis == 0) continue;
+        for (size_t k = 0; k < fn->blocks[b].preds.size(); k++) {
+            int p = fn->blocks[b].preds[k], target = p;
+            if (fn->blocks[p].succs.size() > 1) {
+                // the copies need an edge of their own
+                target = fn->blocks.size();
+                fn->blocks.push_back(TacBlock());
+                TacBlock &split = fn->blocks.back();
+                TacInstr jump;
+                jump.op = TacJump;
+                jump.dst = -1;
+                jump.a = b;
+                jump.b = jump.c = jump.firstArg = jump.numArgs = 0;
+                split.instrs.push_back(jump);
+                split.preds.push_back(p);
+                split.succs.push_back(b);
+                TacBlock &pred = fn->blocks[p];
+                std::vector<int*> slots;
+                fn->GetTargetSlots(pred.Terminator(), &slots);
+                for (size_t i = 0; i < slots.size(); i++)
+                    if (*slots[i] == b) *slots[i] = target;
+                for (size_t i = 0; i < pred.succs.size(); i++)
+                    if (pred.succs[i] == b) pred.succs[i] = target;
+                fn->blocks[b].preds[k] = target;
+            }
+            std::vector<std::pair<int, int> > copies;
+            for (size_t j = 0; j < numPhis; j++) {
+                TacInstr &phi = fn->blocks[b].instrs[j];
+                copies.push_back(std::make_pair(phi.dst, fn->args[phi.firstArg + k]));
+            }
+            SequentializeCopies(fn, target, copies);
+        }
+        std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        instrs.erase(instrs.begin(), instrs.begin() + numPhis);
+    }
+    fn->ssa = false;
+    fn->ComputeEdges();     // the split edges' blocks, in order
+}
@@ -0,0 +1,53 @@
+/* File: ssa.h
+ * -----------
+ * Static single assignment form for three-address code (see tac.h), in
+ * which every register is assigned exactly once, so a register names a
+ * value rather than a variable. The optimizations in opt.h work on this
+ * form: with one definition per register, "what is the value of r here"
+ * has a single answer.
+ *
+ * BuildSSA puts a function into SSA form the classic way (Cytron et
+ * al.). The dominator tree is found by the iterative algorithm of
+ * Cooper, Harvey and Kennedy, phis are placed at the iterated dominance
+ * frontiers of the blocks assigning each register that is live across
+ * blocks, and every definition is then renamed to a fresh register
+ * walking the dominator tree. Parameters keep their registers, which are
+ * assigned on entry.
+ *
+ * LeaveSSA takes the function out of SSA form again for the lowering to
+ * bytecode: each phi becomes copies at the end of its predecessors, on
+ * edges of their own where a predecessor has other successors, made in
+ * an order that gives the phis of a block their values at once.
+ */
+
+#ifndef _H_ssa
+#define _H_ssa
+
+#include <vector>
+#include "tac.h"
+
+/* Class: DominatorTree
+ * --------------------
+ * The dominators of the blocks of a function, as they stand when it is
+ * built. Only blocks reachable from the entry are in the tree.
+ */
+class DominatorTree
+{
+  public:
+    std::vector<int> order;          // reachable blocks in reverse postorder
+    std::vector<int> orderIndex;     // of each block in order, -1 if unreachable
+    std::vector<int> idom;           // immediate dominator, -1 for the entry
+    std::vector<std::vector<int> > children;
+    std::vector<std::vector<int> > frontier;   // filled in by ComputeFrontiers
+
+    DominatorTree(TacFunction *fn);
+    void ComputeFrontiers(TacFunction *fn);
+    bool Dominates(int a, int b);
+    // The blocks in preorder of the tree, every block after its dominator.
+    void GetPreorder(std::vector<int> *blocks);
+};
+
+void BuildSSA(TacFunction *fn);
+void LeaveSSA(TacFunction *fn);
+
+#endif
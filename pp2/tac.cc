@@ -0,0 +1,443 @@
+/* File: tac.cc
+ * ------------
+ * Implementation of the three-address code, its listing and its
+ * verifier.
+ */
+
+#include "tac.h"
+#include <sstream>
+#include "ast_decl.h"
+#include "ast_type.h"
+#include "utility.h"
+
+#define TAC_OPCODE_NAME(name) #name,
+const char *tacOpcodeNames[NumTacOpcodes] = { TAC_OPCODES(TAC_OPCODE_NAME) };
+#undef TAC_OPCODE_NAME
+
+
+int TacFunction::NumInstrs()
+{
+    int n = 0;
+    for (size_t i = 0; i < blocks.size(); i++)
+        n += blocks[i].instrs.size();
+    return n;
+}
+
+void TacFunction::GetUses(const TacInstr &in, std::vector<int> *uses)
+{
+    std::vector<int*> slots;
+    GetUseSlots(const_cast<TacInstr&>(in), &slots);
+    for (size_t i = 0; i < slots.size(); i++)
+        uses->push_back(*slots[i]);
+}
+
+void TacFunction::GetUseSlots(TacInstr &in, std::vector<int*> *slots)
+{
+    switch (in.op) {
+      case TacConst: case TacLoadGlobal: case TacNewObject:
+      case TacReadInteger: case TacReadLine: case TacJump: case TacReturnVoid:
+        return;
+      case TacStoreGlobal:
+        slots->push_back(&in.b);
+        return;
+      case TacSetField:
+        slots->push_back(&in.a);
+        slots->push_back(&in.c);
+        return;
+      case TacSetElem: case TacSetElemUnchecked:
+        slots->push_back(&in.a);
+        slots->push_back(&in.b);
+        slots->push_back(&in.c);
+        return;
+      case TacCall: case TacCallMethod: case TacCallVirtual: case TacCallInterface:
+      case TacPhi: case TacMapElems:
+        for (int i = 0; i < in.numArgs; i++)
+            slots->push_back(&args[in.firstArg + i]);
+        return;
+      case TacGetElem: case TacGetElemUnchecked:
+        slots->push_back(&in.a);
+        slots->push_back(&in.b);
+        return;
+      default:
+        slots->push_back(&in.a);
+        if (IsBinary(in.op)) slots->push_back(&in.b);
+        return;
+    }
+}
+
+void TacFunction::GetTargets(const TacInstr &in, std::vector<int> *targets)
+{
+    std::vector<int*> slots;
+    GetTargetSlots(const_cast<TacInstr&>(in), &slots);
+    for (size_t i = 0; i < slots.size(); i++) {
+        size_t j = 0;
+        while (j < targets->size() && (*targets)[j] != *slots[i]) j++;
+        if (j == targets->size()) targets->push_back(*slots[i]);
+    }
+}
+
+void TacFunction::GetTargetSlots(TacInstr &in, std::vector<int*> *slots)
+{
+    switch (in.op) {
+      case TacJump:
+        slots->push_back(&in.a);
+        return;
+      case TacBranch:
+        slots->push_back(&in.b);
+        slots->push_back(&in.c);
+        return;
+      case TacSwitch:
+        for (int i = 0; i < in.numArgs; i++)
+            slots->push_back(&args[in.firstArg + i]);
+        slots->push_back(&in.c);
+        return;
+      default:
+        return;
+    }
+}
+
+int TacFunction::SwitchTarget(const TacInstr &in, int value)
+{
+    Assert(in.op == TacSwitch);
+    unsigned index = (unsigned)value - (unsigned)in.b;
+    return index < (unsigned)in.numArgs ? args[in.firstArg + index] : in.c;
+}
+
+void TacFunction::ComputeEdges()
+{
+    std::vector<std::vector<int> > oldPreds(blocks.size());
+    for (size_t i = 0; i < blocks.size(); i++) {
+        TacBlock &b = blocks[i];
+        oldPreds[i].swap(b.preds);
+        b.succs.clear();
+        TacInstr &t = b.Terminator();
+        GetTargets(t, &b.succs);
+        if (b.succs.size() == 1 && t.op != TacJump) {
+            t.op = TacJump;
+            t.a = b.succs[0];
+            t.firstArg = t.numArgs = 0;
+        }
+    }
+    for (size_t i = 0; i < blocks.size(); i++)
+        for (size_t j = 0; j < blocks[i].succs.size(); j++)
+            blocks[blocks[i].succs[j]].preds.push_back(i);
+
+    for (size_t i = 0; i < blocks.size(); i++) {
+        TacBlock &b = blocks[i];
+        if (b.preds == oldPreds[i]) continue;
+        for (size_t j = 0; j < b.instrs.size() && b.instrs[j].op == TacPhi; j++) {
+            TacInstr &phi = b.instrs[j];
+            int first = args.size();
+            for (size_t k = 0; k < b.preds.size(); k++) {
+                size_t n = 0;
+                while (n < oldPreds[i].size() && oldPreds[i][n] != b.preds[k]) n++;
+                Assert(n < oldPreds[i].size());
+                args.push_back(args[phi.firstArg + n]);
+            }
+            phi.firstArg = first;
+            phi.numArgs = b.preds.size();
+        }
+    }
+}
+
+void TacFunction::RemoveUnreachable()
+{
+    std::vector<bool> reached(blocks.size(), false);
+    std::vector<int> work(1, 0);
+    reached[0] = true;
+    while (!work.empty()) {
+        TacBlock &b = blocks[work.back()];
+        work.pop_back();
+        for (size_t i = 0; i < b.succs.size(); i++) {
+            if (!reached[b.succs[i]]) {
+                reached[b.succs[i]] = true;
+                work.push_back(b.succs[i]);
+            }
+        }
+    }
+    std::vector<int> newIndex(blocks.size(), -1);
+    int n = 0;
+    for (size_t i = 0; i < blocks.size(); i++)
+        if (reached[i]) newIndex[i] = n++;
+    if (n == (int)blocks.size()) return;
+
+    // the remaining blocks keep their predecessors, renumbered, so that
+    // ComputeEdges can match the phis' arguments to them
+    std::vector<TacBlock> kept;
+    kept.reserve(n);
+    for (size_t i = 0; i < blocks.size(); i++) {
+        if (newIndex[i] < 0) continue;
+        kept.push_back(TacBlock());
+        TacBlock &b = kept.back();
+        b.instrs.swap(blocks[i].instrs);
+        b.inlinedFrom = blocks[i].inlinedFrom;
+        for (size_t j = 0; j < blocks[i].preds.size(); j++)
+            b.preds.push_back(newIndex[blocks[i].preds[j]]);   // -1 if dropped
+        std::vector<int*> targets;
+        GetTargetSlots(b.Terminator(), &targets);
+        for (size_t j = 0; j < targets.size(); j++)
+            *targets[j] = newIndex[*targets[j]];
+    }
+    blocks.swap(kept);
+    ComputeEdges();
+}
+
+
+int TacProgram::AddConstant(Value v)
+{
+    constants.Append(v);
+    return constants.NumElements() - 1;
+}
+
+int TacProgram::AddClass(ClassDecl *cls)
+{
+    for (int i = 0; i < classes.NumElements(); i++)
+        if (classes.Nth(i) == cls) return i;
+    classes.Append(cls);
+    return classes.NumElements() - 1;
+}
+
+int TacProgram::AddType(Type *t)
+{
+    types.Append(t);
+    return types.NumElements() - 1;
+}
+
+
+void TacProgram::Print(FILE *fp)
+{
+    for (size_t i = 0; i < functions.size(); i++)
+        if (functions[i]) PrintFunction(fp, functions[i]);
+}
+
+void TacProgram::PrintFunction(FILE *fp, TacFunction *fn)
+{
+    fprintf(fp, "function %s: %d params, %d registers\n", fn->name, fn->numParams,
+            fn->NumRegs());
+    for (size_t i = 0; i < fn->blocks.size(); i++) {
+        TacBlock &b = fn->blocks[i];
+        fprintf(fp, "  B%d:", (int)i);
+        if (!b.preds.empty()) fprintf(fp, "%*s; preds", 10 - (i < 10 ? 1 : i < 100 ? 2 : 3), "");
+        for (size_t j = 0; j < b.preds.size(); j++)
+            fprintf(fp, " B%d", b.preds[j]);
+        if (b.inlinedFrom) fprintf(fp, "  (inlined from %s)", b.inlinedFrom->GetName());
+        fprintf(fp, "\n");
+        for (size_t j = 0; j < b.instrs.size(); j++) {
+            fprintf(fp, "    ");
+            PrintInstr(fp, fn, b.instrs[j]);
+        }
+    }
+    fprintf(fp, "\n");
+}
+
+static void PrintValue(FILE *fp, Value v)
+{
+    switch (v.kind) {
+      case IntValue:    fprintf(fp, "%d", v.i); break;
+      case DoubleValue: fprintf(fp, "%g", v.d); break;
+      case BoolValue:   fprintf(fp, "%s", v.b ? "true" : "false"); break;
+      case StringValue: fprintf(fp, "\"%s\"", v.s); break;
+      default:          fprintf(fp, "null"); break;
+    }
+}
+
+void TacProgram::PrintInstr(FILE *fp, TacFunction *fn, const TacInstr &in)
+{
+    if (in.dst >= 0) fprintf(fp, "r%d = ", in.dst);
+    fprintf(fp, "%s", tacOpcodeNames[in.op]);
+    switch (in.op) {
+      case TacConst:
+        fprintf(fp, " ");
+        PrintValue(fp, constants.Nth(in.a));
+        break;
+      case TacLoadGlobal:
+        fprintf(fp, " g%d", in.a);
+        break;
+      case TacStoreGlobal:
+        fprintf(fp, " g%d r%d", in.a, in.b);
+        break;
+      case TacGetField:
+        fprintf(fp, " r%d.%d", in.a, in.b);
+        break;
+      case TacSetField:
+        fprintf(fp, " r%d.%d r%d", in.a, in.b, in.c);
+        break;
+      case TacGetElem: case TacGetElemUnchecked:
+        fprintf(fp, " r%d[r%d]", in.a, in.b);
+        break;
+      case TacSetElem: case TacSetElemUnchecked:
+        fprintf(fp, " r%d[r%d] r%d", in.a, in.b, in.c);
+        break;
+      case TacNewObject:
+        fprintf(fp, " %s", classes.Nth(in.a)->GetName());
+        break;
+      case TacNewArray: {
+        std::ostringstream type;
+        type << types.Nth(in.b);
+        fprintf(fp, " r%d %s", in.a, type.str().c_str());
+        break;
+      }
+      case TacCall: case TacCallMethod:
+        fprintf(fp, " %s", functions[in.a] ? functions[in.a]->name : "?");
+        break;
+      case TacCallVirtual:
+        fprintf(fp, " #%d", in.a);
+        break;
+      case TacCallInterface:
+        fprintf(fp, " %s", constants.Nth(in.a).s);
+        break;
+      case TacMapElems:
+        if (in.a == TacNewArray) {
+            std::ostringstream type;
+            type << types.Nth(in.b);
+            fprintf(fp, " %s %s", tacOpcodeNames[in.a], type.str().c_str());
+        } else {
+            fprintf(fp, " %s %d", tacOpcodeNames[in.a], in.b);
+        }
+        break;
+      case TacReadInteger: case TacReadLine: case TacReturnVoid: case TacPhi:
+        break;
+      case TacJump:
+        fprintf(fp, " B%d", in.a);
+        break;
+      case TacBranch:
+        fprintf(fp, " r%d B%d B%d", in.a, in.b, in.c);
+        break;
+      case TacSwitch:
+        fprintf(fp, " r%d from %d [", in.a, in.b);
+        for (int i = 0; i < in.numArgs; i++)
+            fprintf(fp, "%sB%d", i > 0 ? " " : "", fn->args[in.firstArg + i]);
+        fprintf(fp, "] else B%d", in.c);
+        break;
+      default:
+        fprintf(fp, " r%d", in.a);
+        if (IsBinary(in.op)) fprintf(fp, " r%d", in.b);
+        break;
+    }
+    if (HasArgs(in.op)) {
+        fprintf(fp, " (");
+        for (int i = 0; i < in.numArgs; i++)
+            fprintf(fp, "%sr%d", i > 0 ? ", " : "", fn->args[in.firstArg + i]);
+        fprintf(fp, ")");
+    }
+    fprintf(fp, "\n");
+}
+
+
+/* Function: Verify()
+ * ------------------
+ * Checks the shape of the graph (a terminator ending every block and
+ * only there, the edges in step with the terminators, the entry not
+ * jumped to, phis first and with an argument per predecessor), that
+ * every operand is in range for what it indexes, that every register
+ * used is a parameter or assigned somewhere, and in SSA form that each
+ * register is assigned once, parameters not at all.
+ */
+bool TacProgram::Verify(TacFunction *fn)
+{
+    int errors = 0;
+    int numBlocks = fn->blocks.size(), numRegs = fn->NumRegs();
+#define FAIL(...) do { fprintf(stderr, "dcc: bad TAC in %s, B%d: ", fn->name, (int)i); \
+                       fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); errors++; } while (0)
+
+    std::vector<std::vector<int> > preds(numBlocks);
+    std::vector<bool> defined(numRegs, false), assigned(numRegs, false);
+    std::vector<int> firstUse(numRegs, -1);     // the block
+    for (size_t i = 0; i < fn->blocks.size(); i++) {
+        TacBlock &b = fn->blocks[i];
+        if (b.instrs.empty() || !IsTerminator(b.Terminator().op)) {
+            FAIL("no terminator");
+            continue;
+        }
+        std::vector<int> succs;
+        const TacInstr &t = b.Terminator();
+        if (t.op == TacSwitch && (t.firstArg < 0 || t.numArgs < 0 ||
+                                  t.firstArg + t.numArgs > (int)fn->args.size()))
+            FAIL("switch blocks out of range");
+        else
+            fn->GetTargets(t, &succs);
+        for (size_t j = 0; j < succs.size(); j++) {
+            if (succs[j] <= 0 || succs[j] >= numBlocks) FAIL("jump to B%d", succs[j]);
+            else preds[succs[j]].push_back(i);
+        }
+        if (succs != b.succs) FAIL("successors out of date");
+
+        for (size_t j = 0; j < b.instrs.size(); j++) {
+            const TacInstr &in = b.instrs[j];
+            if (in.op < 0 || in.op >= NumTacOpcodes) {
+                FAIL("bad opcode %d", in.op);
+                continue;
+            }
+            if (IsTerminator(in.op) && j + 1 < b.instrs.size()) FAIL("%s before the end", tacOpcodeNames[in.op]);
+            if (in.op == TacPhi && !fn->ssa) FAIL("phi outside SSA form");
+            if (in.op == TacPhi && j > 0 && b.instrs[j-1].op != TacPhi) FAIL("phi after other instructions");
+            if (in.op == TacPhi && in.numArgs != (int)b.preds.size()) FAIL("phi r%d has %d arguments for %d predecessors", in.dst, in.numArgs, (int)b.preds.size());
+            if (HasArgs(in.op) &&
+                (in.firstArg < 0 || in.numArgs < 0 || in.firstArg + in.numArgs > (int)fn->args.size()))
+                FAIL("arguments out of range");
+            if (in.dst < -1 || in.dst >= numRegs) FAIL("defines r%d", in.dst);
+            bool needsDst = !IsTerminator(in.op) && !IsCall(in.op) && in.op != TacStoreGlobal &&
+                            in.op != TacSetField && in.op != TacSetElem &&
+                            in.op != TacSetElemUnchecked && in.op != TacMapElems &&
+                            (in.op < TacPrintInt || in.op > TacPrintString);
+            if (needsDst && in.dst < 0) FAIL("%s defines nothing", tacOpcodeNames[in.op]);
+            if (in.dst >= 0 && in.dst < numRegs) assigned[in.dst] = true;
+            if (fn->ssa && in.dst >= 0 && in.dst < numRegs) {
+                if (defined[in.dst] || in.dst < fn->numParams) FAIL("r%d assigned twice", in.dst);
+                defined[in.dst] = true;
+            }
+            std::vector<int> uses;
+            if (!HasArgs(in.op)) fn->GetUses(in, &uses);
+            else if (in.firstArg >= 0 && in.firstArg + in.numArgs <= (int)fn->args.size()) fn->GetUses(in, &uses);
+            for (size_t k = 0; k < uses.size(); k++) {
+                if (uses[k] < 0 || uses[k] >= numRegs) FAIL("%s uses r%d", tacOpcodeNames[in.op], uses[k]);
+                else if (firstUse[uses[k]] < 0) firstUse[uses[k]] = i;
+            }
+            switch (in.op) {
+              case TacConst: case TacCallInterface:
+                if (in.a < 0 || in.a >= constants.NumElements()) FAIL("constant %d", in.a);
+                break;
+              case TacNewObject:
+                if (in.a < 0 || in.a >= classes.NumElements()) FAIL("class %d", in.a);
+                break;
+              case TacNewArray:
+                if (in.b < 0 || in.b >= types.NumElements()) FAIL("type %d", in.b);
+                break;
+              case TacCall:
+                if (in.a < 0 || in.a >= (int)functions.size()) FAIL("function %d", in.a);
+                break;
+              case TacCallMethod:
+                if (in.a < 0 || in.a >= (int)functions.size()) FAIL("function %d", in.a);
+                if (in.numArgs < 1) FAIL("method call without a receiver");
+                break;
+              case TacCallVirtual:
+                if (in.numArgs < 1) FAIL("method call without a receiver");
+                break;
+              case TacMapElems:
+                if (in.numArgs != (in.a == TacCopy || in.a == TacNewArray ? 4 : 5))
+                    FAIL("MapElems with %d arguments", in.numArgs);
+                if (in.a == TacNewArray && (in.b < 0 || in.b >= types.NumElements()))
+                    FAIL("type %d", in.b);
+                break;
+              default:
+                break;
+            }
+        }
+    }
+    for (size_t i = 0; i < fn->blocks.size(); i++)
+        if (preds[i] != fn->blocks[i].preds) FAIL("predecessors out of date");
+    for (int r = fn->numParams; r < numRegs; r++) {
+        size_t i = firstUse[r];
+        if (firstUse[r] >= 0 && !assigned[r]) FAIL("r%d used but never assigned", r);
+    }
+#undef FAIL
+    return errors == 0;
+}
+
+bool TacProgram::Verify()
+{
+    bool ok = true;
+    for (size_t i = 0; i < functions.size(); i++)
+        if (functions[i] && !Verify(functions[i])) ok = false;
+    return ok;
+}
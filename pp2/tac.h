@@ -0,0 +1,220 @@
+/* File: tac.h
+ * -----------
+ * The three-address code (TAC) a checked program is lowered to for
+ * optimizing (see tacgen.h for the lowering). Unlike the bytecode, which
+ * is laid out for the VM to run, TAC is laid out for passes to analyze
+ * and rewrite: each function is a control flow graph of basic blocks,
+ * with the edges between them explicit.
+ *
+ * A function computes in virtual registers, numbered from 0, any number
+ * of them. The first are the slots of its frame as the semantic check
+ * assigned them (receiver, formals, locals; see FnDecl), and the
+ * temporaries of the lowering come after them; a register may be
+ * assigned any number of times. Locals start out holding the zero value
+ * of their type, which the entry block sets them to, so every register
+ * is assigned before it is used on every path.
+ *
+ * The representation is dense: a block's instructions are an array of
+ * fixed-size structs, and operands are plain indices (of registers,
+ * blocks, constants, ...), so a pass over a large function walks
+ * contiguous memory and chases no pointers. The variable-length operand
+ * lists of calls, phis and switches live in one array per function (see
+ * args).
+ *
+ * Phis appear only while a function is in SSA form, in which each
+ * register is assigned exactly once (see ssa.h).
+ *
+ * Each block ends in exactly one terminator (Jump, Branch, Switch, Return
+ * or ReturnVoid) and has no other; its successors are the blocks its
+ * terminator names, each once, and its predecessors are kept in step
+ * with them. Block 0 is the entry, which nothing jumps to. Operands are
+ * registers unless noted:
+ *
+ *    Copy d a          d = a
+ *    Const d k         d = constant k
+ *    LoadGlobal d g    d = global g
+ *    StoreGlobal g a   global g = a
+ *    GetField d a f    d = field f of object a
+ *    SetField a f b    field f of object a = b
+ *    GetElem d a b     d = element b of array a
+ *    SetElem a b c     element b of array a = c
+ *    GetElemUnchecked d a b  and SetElemUnchecked a b c: the same, for
+ *                      an array and index known to be in bounds
+ *    Length d a        d = length of array a
+ *    NewObject d k     d = new instance of class k
+ *    NewArray d a t    d = new array of a elements of type t
+ *    AddInt d a b      d = a + b, etc., for the arithmetic and comparison
+ *                      operators on ints, doubles, bools and strings,
+ *                      and for references (EqualRef, NotEqualRef)
+ *    NegInt d a        d = -a (NegDouble for doubles); NotBool d a
+ *    Call d f          d = function f called with the argument list
+ *    CallMethod d f    the same for method f, once the receiver (the
+ *                      first argument) is checked not to be null
+ *    CallVirtual d m   d = method m of the vtable of the first argument
+ *    CallInterface d k d = the method named by string constant k
+ *                      (d is -1 when a call's result is not wanted)
+ *    PrintInt a        and PrintBool, PrintString: print the value of a
+ *    ReadInteger d     and ReadLine d: d = a line of input
+ *    MapElems k s      for each i from the second argument up to the
+ *                      third: element i of the first = element i of the
+ *                      fourth k element i of the fifth, for k one of
+ *                      AddInt, SubInt, MulInt, AddDouble, SubDouble,
+ *                      MulDouble or DivDouble, or with k Copy, element i
+ *                      of the fourth alone; bit 1 of s has the fourth
+ *                      taken as a value rather than an array, and bit 2
+ *                      the fifth (see opt.h). With k NewArray, element
+ *                      i of the first = a new array of the fourth
+ *                      elements of type s: the rows of a rectangular
+ *                      array, made in one block of memory
+ *    Phi d             d = the n-th argument when control came from the
+ *                      n-th predecessor (only at the start of a block)
+ *    Jump B            continue at block B
+ *    Branch a B C      continue at B if a is true, at C if not
+ *    Switch a k C      continue at the (a-k)-th block of the argument
+ *                      list if there is one, at C if not
+ *    Return a          return the value of a
+ *    ReturnVoid        return the zero value of the return type
+ *
+ * As in the bytecode, the operations that can fail at runtime (division,
+ * the accesses to objects and arrays, calls, NewArray) check as they go,
+ * but for the unchecked accesses the optimizer has proved safe.
+ */
+
+#ifndef _H_tac
+#define _H_tac
+
+#include <stdio.h>
+#include <vector>
+#include "list.h"
+#include "value.h"
+
+class FnDecl;
+class ClassDecl;
+class Type;
+
+#define TAC_OPCODES(X) \
+    X(Copy) X(Const) X(LoadGlobal) X(StoreGlobal) \
+    X(GetField) X(SetField) X(GetElem) X(SetElem) \
+    X(GetElemUnchecked) X(SetElemUnchecked) X(Length) \
+    X(NewObject) X(NewArray) \
+    X(AddInt) X(SubInt) X(MulInt) X(DivInt) X(ModInt) X(NegInt) \
+    X(AddDouble) X(SubDouble) X(MulDouble) X(DivDouble) X(ModDouble) \
+    X(NegDouble) \
+    X(LessInt) X(LessEqualInt) X(GreaterInt) X(GreaterEqualInt) \
+    X(EqualInt) X(NotEqualInt) \
+    X(LessDouble) X(LessEqualDouble) X(GreaterDouble) X(GreaterEqualDouble) \
+    X(EqualDouble) X(NotEqualDouble) \
+    X(EqualBool) X(NotEqualBool) X(EqualString) X(NotEqualString) \
+    X(EqualRef) X(NotEqualRef) X(NotBool) \
+    X(Call) X(CallMethod) X(CallVirtual) X(CallInterface) \
+    X(PrintInt) X(PrintBool) X(PrintString) X(ReadInteger) X(ReadLine) \
+    X(MapElems) X(Phi) \
+    X(Jump) X(Branch) X(Switch) X(Return) X(ReturnVoid)
+
+#define TAC_OPCODE_ENUM(name) Tac##name,
+typedef enum { TAC_OPCODES(TAC_OPCODE_ENUM) NumTacOpcodes } tacOpcodeT;
+#undef TAC_OPCODE_ENUM
+
+extern const char *tacOpcodeNames[NumTacOpcodes];
+
+/* Struct: TacInstr
+ * ----------------
+ * One instruction: the register it defines in dst (-1 if none) and up to
+ * three operands, as listed above. A call, phi or MapElems has its list
+ * of arguments in the function's args, numArgs of them from firstArg,
+ * and a switch its list of blocks.
+ */
+struct TacInstr {
+    int op;
+    int dst;
+    int a, b, c;
+    int firstArg, numArgs;
+};
+
+// The kinds of instruction, by what passes need to know of them.
+inline bool IsTerminator(int op) { return op >= TacJump; }
+inline bool IsCall(int op) { return op >= TacCall && op <= TacCallInterface; }
+inline bool HasArgs(int op) { return IsCall(op) || op == TacPhi || op == TacMapElems; }
+inline bool IsBinary(int op) { return (op >= TacAddInt && op <= TacModInt) ||
+                                      (op >= TacAddDouble && op <= TacModDouble) ||
+                                      (op >= TacLessInt && op <= TacNotEqualRef); }
+inline bool IsUnary(int op) { return op == TacNegInt || op == TacNegDouble ||
+                                     op == TacNotBool || op == TacCopy || op == TacLength; }
+
+struct TacBlock {
+    std::vector<TacInstr> instrs;    // the terminator last
+    std::vector<int> preds, succs;
+    FnDecl *inlinedFrom;             // the function the code is from, if
+                                     // not the one it is in (see opt.h)
+
+    TacBlock() : inlinedFrom(NULL) {}
+    TacInstr &Terminator() { return instrs.back(); }
+};
+
+struct TacFunction {
+    FnDecl *decl;
+    const char *name;
+    int numParams;                   // including the receiver of a method
+    int numSlots;                    // the registers of the frame's slots
+    std::vector<Type*> regTypes;     // the type of each register
+    std::vector<TacBlock> blocks;
+    std::vector<int> args;           // of calls, phis and switches
+    bool ssa;                        // whether it is in SSA form (see ssa.h)
+
+    TacFunction() : ssa(false) {}
+    int NumRegs() { return regTypes.size(); }
+    int NewReg(Type *type) { regTypes.push_back(type); return regTypes.size() - 1; }
+    int NumInstrs();
+
+    // The registers an instruction reads, which it appends to uses.
+    void GetUses(const TacInstr &in, std::vector<int> *uses);
+    // The same, as the operands holding them, for a pass to rename.
+    void GetUseSlots(TacInstr &in, std::vector<int*> *slots);
+
+    // The blocks a terminator goes on to, each once, in the order it
+    // first names them.
+    void GetTargets(const TacInstr &in, std::vector<int> *targets);
+    // Every operand of a terminator that names a block, for a pass to
+    // retarget.
+    void GetTargetSlots(TacInstr &in, std::vector<int*> *slots);
+    // Where a Switch goes on when its register holds value.
+    int SwitchTarget(const TacInstr &in, int value);
+
+    // Recomputes the successors of every block from its terminator, and
+    // the predecessors from them, keeping each phi's arguments matched to
+    // the predecessors that remain. A Branch or Switch to the same block
+    // every way becomes a Jump.
+    void ComputeEdges();
+    // Drops the blocks control cannot reach from the entry (by the edges
+    // as they are), renumbering the others in their order.
+    void RemoveUnreachable();
+};
+
+class TacProgram
+{
+  public:
+    std::vector<TacFunction*> functions;   // indexed by FnDecl::GetCodeIndex()
+    List<Value> constants;
+    List<ClassDecl*> classes;              // for NewObject
+    List<Type*> types;                     // element types for NewArray
+    TacFunction *main;
+
+    TacProgram() : main(NULL) {}
+
+    int AddConstant(Value v);
+    int AddClass(ClassDecl *cls);
+    int AddType(Type *t);
+
+    // Prints the code of every function, for -emit-tac.
+    void Print(FILE *fp);
+    void PrintFunction(FILE *fp, TacFunction *fn);
+    void PrintInstr(FILE *fp, TacFunction *fn, const TacInstr &in);
+
+    // Checks that the code of a function is well formed, as described
+    // above (and in SSA form, that no register is assigned twice),
+    // printing what is wrong to stderr if not.
+    bool Verify(TacFunction *fn);
+    bool Verify();
+};
+
+#endif
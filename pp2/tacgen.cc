@@ -0,0 +1,139 @@
+/* File: tacgen.cc
+ * ---------------
+ * Implementation of the TacBuilder class.
+ */
+
+#include "tacgen.h"
+#include "ast_decl.h"
+#include "ast_type.h"
+#include "utility.h"
+
+
+TacBuilder::TacBuilder(TacProgram *p)
+{
+    program = p;
+    fn = NULL;
+    current = -1;
+}
+
+void TacBuilder::BeginFunction(FnDecl *decl)
+{
+    Assert(fn == NULL);
+    fn = new TacFunction;
+    fn->decl = decl;
+    fn->name = decl->GetName();
+    fn->numParams = decl->GetFormals()->NumElements() + (decl->IsMethod() ? 1 : 0);
+    fn->numSlots = decl->GetFrameSize();
+    for (int i = 0; i < fn->numSlots; i++)
+        fn->regTypes.push_back(decl->GetSlotType(i));
+    breakTargets.clear();
+    SetBlock(NewBlock());
+    for (int i = fn->numParams; i < fn->numSlots; i++)
+        GenConst(i, decl->GetFrameInit()[i]);
+}
+
+/* Function: EndFunction()
+ * -----------------------
+ * Control falling off the end returns the zero value. The edges are
+ * worked out from the terminators, and the blocks nothing reaches are
+ * dropped.
+ */
+TacFunction *TacBuilder::EndFunction()
+{
+    if (current >= 0) Gen(TacReturnVoid, -1);
+    for (size_t i = 0; i < fn->blocks.size(); i++) {
+        std::vector<TacInstr> &instrs = fn->blocks[i].instrs;
+        Assert(!instrs.empty() && IsTerminator(instrs.back().op));
+    }
+    fn->ComputeEdges();
+    fn->RemoveUnreachable();
+    TacFunction *result = fn;
+    fn = NULL;
+    return result;
+}
+
+
+int TacBuilder::NewTemp(Type *type)
+{
+    return fn->NewReg(type);
+}
+
+int TacBuilder::Protect(int reg, Type *type, bool mustCopy)
+{
+    if (!mustCopy || IsTemp(reg)) return reg;
+    int copy = NewTemp(type);
+    Gen(TacCopy, copy, reg);
+    return copy;
+}
+
+int TacBuilder::NewBlock()
+{
+    fn->blocks.push_back(TacBlock());
+    return fn->blocks.size() - 1;
+}
+
+void TacBuilder::SetBlock(int block)
+{
+    Assert(fn->blocks[block].instrs.empty());
+    current = block;
+}
+
+
+void TacBuilder::Gen(int op, int dst, int a, int b, int c)
+{
+    if (current < 0) current = NewBlock();      // unreachable
+    TacInstr in;
+    in.op = op;
+    in.dst = dst;
+    in.a = a;
+    in.b = b;
+    in.c = c;
+    in.firstArg = in.numArgs = 0;
+    fn->blocks[current].instrs.push_back(in);
+    if (IsTerminator(op)) current = -1;
+}
+
+void TacBuilder::GenConst(int dst, Value v)
+{
+    Gen(TacConst, dst, program->AddConstant(v));
+}
+
+void TacBuilder::GenCall(int op, int dst, int target, const std::vector<int> &args)
+{
+    Gen(op, dst, target);
+    TacInstr &in = fn->blocks[current].instrs.back();
+    in.firstArg = fn->args.size();
+    in.numArgs = args.size();
+    fn->args.insert(fn->args.end(), args.begin(), args.end());
+}
+
+void TacBuilder::GenJump(int block)
+{
+    Gen(TacJump, -1, block);
+}
+
+void TacBuilder::GenBranch(int cond, int ifTrue, int ifFalse)
+{
+    Gen(TacBranch, -1, cond, ifTrue, ifFalse);
+}
+
+void TacBuilder::GenSwitch(int value, int low, const std::vector<int> &blocks, int otherwise)
+{
+    if (current < 0) current = NewBlock();      // unreachable
+    TacBlock &b = fn->blocks[current];
+    Gen(TacSwitch, -1, value, low, otherwise);
+    TacInstr &in = b.instrs.back();
+    in.firstArg = fn->args.size();
+    in.numArgs = blocks.size();
+    fn->args.insert(fn->args.end(), blocks.begin(), blocks.end());
+}
+
+void TacBuilder::GenMoveResult(int dst, int src)
+{
+    if (dst == src) return;
+    std::vector<TacInstr> *instrs = current >= 0 ? &fn->blocks[current].instrs : NULL;
+    if (IsTemp(src) && instrs && !instrs->empty() && instrs->back().dst == src)
+        instrs->back().dst = dst;
+    else
+        Gen(TacCopy, dst, src);
+}
@@ -0,0 +1,70 @@
+/* File: tacgen.h
+ * --------------
+ * The TacBuilder is the helper the EmitTac methods of the AST nodes use
+ * to lower a checked program to three-address code (see tac.h). It plays
+ * the part the CodeGenerator (codegen.h) plays for bytecode: it hands out
+ * registers for temporaries and collects the code of the function being
+ * lowered, here into basic blocks.
+ *
+ * Code is always added to the end of the current block. Generating a
+ * terminator closes it; code that follows before another block is made
+ * current can never run, and goes into a block of its own that is
+ * dropped once the function is done. Statements that transfer control
+ * make new blocks for where it goes and make them current in turn.
+ */
+
+#ifndef _H_tacgen
+#define _H_tacgen
+
+#include <vector>
+#include "tac.h"
+
+class FnDecl;
+
+class TacBuilder
+{
+  private:
+    TacProgram *program;
+    TacFunction *fn;                // the function being lowered
+    int current;                    // the block being added to, or -1
+    std::vector<int> breakTargets;  // innermost loop or switch last
+
+  public:
+    TacBuilder(TacProgram *program);
+    TacProgram *GetProgram() { return program; }
+
+    // Starts a function whose entry block sets its locals to zero.
+    void BeginFunction(FnDecl *decl);
+    TacFunction *EndFunction();
+
+    // A fresh register for a temporary of the given type.
+    int NewTemp(Type *type);
+    bool IsTemp(int reg) { return reg >= fn->numSlots; }
+
+    // The register itself, or a copy of it if it is not a temporary and
+    // mustCopy is set (see HasAssignment in ast_expr.h).
+    int Protect(int reg, Type *type, bool mustCopy);
+
+    int NewBlock();
+    void SetBlock(int block);
+
+    void PushBreakTarget(int block) { breakTargets.push_back(block); }
+    void PopBreakTarget() { breakTargets.pop_back(); }
+    int GetBreakTarget() { return breakTargets.back(); }
+
+    void Gen(int op, int dst, int a = 0, int b = 0, int c = 0);
+    void GenConst(int dst, Value v);
+    // A call, with the arguments (the receiver first, for a method).
+    void GenCall(int op, int dst, int target, const std::vector<int> &args);
+    void GenJump(int block);
+    void GenBranch(int cond, int ifTrue, int ifFalse);
+    // Goes on to blocks[value - low], or to otherwise if there is no such
+    // block.
+    void GenSwitch(int value, int low, const std::vector<int> &blocks, int otherwise);
+    // Sets dst to the value an expression has just computed into src,
+    // which is not needed afterwards: the instruction that computed it
+    // is made to compute it into dst, if it is a temporary.
+    void GenMoveResult(int dst, int src);
+};
+
+#endif
@@ -0,0 +1,499 @@
+/* File: taclower.cc
+ * -----------------
+ * Implementation of the lowering of three-address code to bytecode.
+ */
+
+#include "taclower.h"
+#include "ast_decl.h"
+#include "ast_type.h"
+#include "codegen.h"
+#include "utility.h"
+
+
+/* Class: FunctionLowering
+ * -----------------------
+ * Lowers one function: finds which registers are live where, colors
+ * them, and generates its code with a CodeGenerator.
+ */
+class FunctionLowering
+{
+  private:
+    TacProgram *tac;
+    BcProgram *program;
+    TacFunction *fn;
+    CodeGenerator *cg;
+    std::vector<int> numUses, numDefs, foldedUses;
+    std::vector<const TacInstr*> def;          // the only definition, or NULL
+    std::vector<std::vector<bool> > liveOut;   // of each block
+    std::vector<std::vector<int> > interferes, partners;
+    std::vector<int> color;                    // VM register of each register
+    std::vector<int> colorKind;                // what each VM register holds
+    int numColors;
+    std::vector<bool> fused;                   // block's branch fused with its test
+    std::vector<int> labels;
+    int scratch;
+
+    void CountUses();
+    void ComputeLiveness();
+    void BuildInterference();
+    void Color(int reg);
+    void AssignRegisters();
+
+    bool IsConstant(int reg) { return def[reg] && def[reg]->op == TacConst; }
+    Value ConstantOf(int reg) { return tac->constants.Nth(def[reg]->a); }
+    bool FoldsImmediate(const TacInstr &in, int *reg, int *imm);
+    bool FoldsStore(const TacInstr &in) { return (in.op == TacSetElem || in.op == TacSetElemUnchecked) &&
+                                                 IsConstant(in.c); }
+    int Reg(int reg) { return color[reg]; }
+
+    void GenInstr(const TacInstr &in, bool intoScratch);
+    void GenCall(const TacInstr &in);
+    void GenBlock(int block, int next);
+    bool ShouldCopy(int block);
+
+  public:
+    FunctionLowering(TacProgram *tac, BcProgram *program, CodeGenerator *cg, TacFunction *fn);
+    BcFunction *Lower();
+};
+
+FunctionLowering::FunctionLowering(TacProgram *t, BcProgram *p, CodeGenerator *c, TacFunction *f)
+{
+    tac = t;
+    program = p;
+    cg = c;
+    fn = f;
+    numColors = 0;
+    scratch = -1;
+}
+
+void FunctionLowering::CountUses()
+{
+    int numRegs = fn->NumRegs();
+    numUses.assign(numRegs, 0);
+    numDefs.assign(numRegs, 0);
+    foldedUses.assign(numRegs, 0);
+    def.assign(numRegs, (const TacInstr*)NULL);
+    std::vector<int> uses;
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        for (size_t i = 0; i < fn->blocks[b].instrs.size(); i++) {
+            const TacInstr &in = fn->blocks[b].instrs[i];
+            uses.clear();
+            fn->GetUses(in, &uses);
+            for (size_t j = 0; j < uses.size(); j++)
+                numUses[uses[j]]++;
+            if (in.dst >= 0 && numDefs[in.dst]++ == 0) def[in.dst] = &in;
+        }
+    }
+    for (int r = 0; r < numRegs; r++)
+        if (numDefs[r] != 1 || r < fn->numParams) def[r] = NULL;
+
+    // what the generated code will not need a register for
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        for (size_t i = 0; i < fn->blocks[b].instrs.size(); i++) {
+            const TacInstr &in = fn->blocks[b].instrs[i];
+            int reg, imm;
+            if (FoldsImmediate(in, &reg, &imm))
+                foldedUses[in.a == reg ? in.b : in.a]++;
+            if (FoldsStore(in))
+                foldedUses[in.c]++;
+        }
+    }
+    fused.assign(fn->blocks.size(), false);
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        if (instrs.size() < 2 || instrs.back().op != TacBranch) continue;
+        const TacInstr &test = instrs[instrs.size() - 2];
+        int cond = instrs.back().a;
+        fused[b] = test.dst == cond && numUses[cond] == 1 && numDefs[cond] == 1 &&
+                   ((test.op >= TacLessInt && test.op <= TacNotEqualInt) || test.op == TacNotBool);
+    }
+}
+
+/* Function: ComputeLiveness()
+ * ---------------------------
+ * The usual backward dataflow: a register is live out of a block if it
+ * is live into a successor, and live into a block if the block uses it
+ * before assigning it or it is live out and not assigned.
+ */
+void FunctionLowering::ComputeLiveness()
+{
+    int numBlocks = fn->blocks.size(), numRegs = fn->NumRegs();
+    std::vector<std::vector<bool> > gen(numBlocks), kill(numBlocks), liveIn(numBlocks);
+    std::vector<int> uses;
+    for (int b = 0; b < numBlocks; b++) {
+        gen[b].assign(numRegs, false);
+        kill[b].assign(numRegs, false);
+        liveIn[b].assign(numRegs, false);
+        for (size_t i = 0; i < fn->blocks[b].instrs.size(); i++) {
+            const TacInstr &in = fn->blocks[b].instrs[i];
+            uses.clear();
+            fn->GetUses(in, &uses);
+            for (size_t j = 0; j < uses.size(); j++)
+                if (!kill[b][uses[j]]) gen[b][uses[j]] = true;
+            if (in.dst >= 0) kill[b][in.dst] = true;
+        }
+    }
+    liveOut.assign(numBlocks, std::vector<bool>(numRegs, false));
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int b = numBlocks - 1; b >= 0; b--) {
+            std::vector<bool> &out = liveOut[b];
+            const std::vector<int> &succs = fn->blocks[b].succs;
+            for (size_t s = 0; s < succs.size(); s++)
+                for (int r = 0; r < numRegs; r++)
+                    if (liveIn[succs[s]][r]) out[r] = true;
+            for (int r = 0; r < numRegs; r++) {
+                bool in = gen[b][r] || (out[r] && !kill[b][r]);
+                if (in && !liveIn[b][r]) {
+                    liveIn[b][r] = true;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+/* Function: BuildInterference()
+ * -----------------------------
+ * Two registers interfere, and need VM registers of their own, if one is
+ * assigned while the other is live; walking each block backward from
+ * what is live out of it finds every such pair. The source of a copy
+ * does not interfere with its destination there, as they hold the same
+ * value, which is what lets them share a register. The live set is kept
+ * sparse, as a list and the position of each register in it, so the
+ * walk costs what is live rather than all the registers.
+ */
+void FunctionLowering::BuildInterference()
+{
+    int numRegs = fn->NumRegs();
+    interferes.assign(numRegs, std::vector<int>());
+    partners.assign(numRegs, std::vector<int>());
+    std::vector<int> live, position(numRegs, -1), uses;
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        live.clear();
+        for (int r = 0; r < numRegs; r++) {
+            position[r] = -1;
+            if (liveOut[b][r]) {
+                position[r] = live.size();
+                live.push_back(r);
+            }
+        }
+        const std::vector<TacInstr> &instrs = fn->blocks[b].instrs;
+        for (int i = instrs.size() - 1; i >= 0; i--) {
+            const TacInstr &in = instrs[i];
+            if (in.dst >= 0) {
+                int d = in.dst;
+                for (size_t j = 0; j < live.size(); j++) {
+                    int r = live[j];
+                    if (r == d || (in.op == TacCopy && r == in.a)) continue;
+                    interferes[d].push_back(r);
+                    interferes[r].push_back(d);
+                }
+                if (in.op == TacCopy) {
+                    partners[d].push_back(in.a);
+                    partners[in.a].push_back(d);
+                }
+                if (position[d] >= 0) {
+                    int last = live.back();
+                    live[position[d]] = last;
+                    position[last] = position[d];
+                    live.pop_back();
+                    position[d] = -1;
+                }
+            }
+            uses.clear();
+            fn->GetUses(in, &uses);
+            for (size_t j = 0; j < uses.size(); j++) {
+                if (position[uses[j]] < 0) {
+                    position[uses[j]] = live.size();
+                    live.push_back(uses[j]);
+                }
+            }
+        }
+    }
+}
+
+/* Ints, doubles, and everything else: a VM register holds one of these
+ * only, so that the JIT can keep those holding ints or doubles in
+ * machine registers (see jit.h). */
+enum { OtherKind, IntKind, DoubleKind };
+
+static int KindOf(Type *type)
+{
+    if (type == Type::intType) return IntKind;
+    if (type == Type::doubleType) return DoubleKind;
+    return OtherKind;
+}
+
+/* Function: Color()
+ * -----------------
+ * Gives reg the register of a copy partner if none of its neighbours
+ * has it, and otherwise the lowest register none of them has, of those
+ * holding its kind of value.
+ */
+void FunctionLowering::Color(int reg)
+{
+    int kind = KindOf(fn->regTypes[reg]);
+    std::vector<bool> taken(numColors + 1, false);
+    for (int c = 0; c < numColors; c++)
+        if (colorKind[c] != kind) taken[c] = true;
+    for (size_t i = 0; i < interferes[reg].size(); i++) {
+        int c = color[interferes[reg][i]];
+        if (c >= 0) taken[c] = true;
+    }
+    for (size_t i = 0; i < partners[reg].size(); i++) {
+        int c = color[partners[reg][i]];
+        if (c >= 0 && !taken[c]) {
+            color[reg] = c;
+            return;
+        }
+    }
+    int c = 0;
+    while (taken[c]) c++;
+    color[reg] = c;
+    if (c == numColors) {
+        colorKind.push_back(kind);
+        numColors++;
+    }
+}
+
+/* The parameters are where the caller put them; the rest are colored in
+ * the order they are assigned, which tends to color a register once the
+ * registers it is copied from are. */
+void FunctionLowering::AssignRegisters()
+{
+    color.assign(fn->NumRegs(), -1);
+    colorKind.clear();
+    for (int r = 0; r < fn->numParams; r++) {
+        color[r] = r;
+        colorKind.push_back(KindOf(fn->regTypes[r]));
+    }
+    numColors = fn->numParams;
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        for (size_t i = 0; i < fn->blocks[b].instrs.size(); i++) {
+            const TacInstr &in = fn->blocks[b].instrs[i];
+            if (in.dst >= 0 && color[in.dst] < 0) Color(in.dst);
+        }
+    }
+}
+
+
+/* Function: FoldsImmediate()
+ * --------------------------
+ * Whether in adds or subtracts an int constant small enough to be the
+ * immediate of an AddIntImm, which sets reg to the register it is added
+ * to and imm to what is added.
+ */
+bool FunctionLowering::FoldsImmediate(const TacInstr &in, int *reg, int *imm)
+{
+    if (in.op != TacAddInt && in.op != TacSubInt) return false;
+    for (int side = 0; side < 2; side++) {
+        int k = side == 0 ? in.b : in.a;
+        if (!IsConstant(k) || (side == 1 && in.op == TacSubInt)) continue;
+        int value = ConstantOf(k).i;
+        if (!CodeGenerator::FitsImmediate(value)) continue;
+        if (in.op == TacSubInt) {
+            if (!CodeGenerator::FitsImmediate(-value)) continue;
+            value = -value;
+        }
+        *reg = side == 0 ? in.a : in.b;
+        *imm = value;
+        return true;
+    }
+    return false;
+}
+
+/* The opcodes of the arithmetic, comparisons and NotBool are in the same
+ * order in both instruction sets, but for AddIntImm in the bytecode's. */
+static opcodeT ToBytecode(int op)
+{
+    if (op >= TacAddInt && op <= TacModInt) return (opcodeT)(OpAddInt + (op - TacAddInt));
+    if (op == TacNegInt) return OpNegate;
+    if (op >= TacAddDouble && op <= TacNegDouble) return (opcodeT)(OpAddDouble + (op - TacAddDouble));
+    Assert(op >= TacLessInt && op <= TacNotBool);
+    return (opcodeT)(OpLessInt + (op - TacLessInt));
+}
+
+void FunctionLowering::GenInstr(const TacInstr &in, bool intoScratch)
+{
+    int dst = in.dst < 0 ? -1 : intoScratch ? scratch : Reg(in.dst);
+    int reg, imm;
+    switch (in.op) {
+      case TacCopy:
+        cg->GenMove(dst, Reg(in.a));
+        return;
+      case TacConst: {
+        if (numUses[in.dst] == foldedUses[in.dst] && def[in.dst]) return;
+        Value v = tac->constants.Nth(in.a);
+        if (v.kind == IntValue)
+            cg->GenLoadInt(dst, v.i);
+        else
+            cg->GenLoadConst(dst, v);
+        return;
+      }
+      case TacLoadGlobal:  cg->Gen(OpLoadGlobal, dst, in.a); return;
+      case TacStoreGlobal: cg->Gen(OpStoreGlobal, in.a, Reg(in.b)); return;
+      case TacGetField:    cg->Gen(OpGetField, dst, Reg(in.a), in.b); return;
+      case TacSetField:    cg->Gen(OpSetField, Reg(in.a), in.b, Reg(in.c)); return;
+      case TacGetElem:     cg->Gen(OpGetElem, dst, Reg(in.a), Reg(in.b)); return;
+      case TacSetElem:
+        if (FoldsStore(in))
+            cg->Gen(OpSetElemConst, Reg(in.a), Reg(in.b),
+                    program->AddConstant(ConstantOf(in.c)));
+        else
+            cg->Gen(OpSetElem, Reg(in.a), Reg(in.b), Reg(in.c));
+        return;
+      case TacGetElemUnchecked:
+        cg->Gen(OpGetElemUnchecked, dst, Reg(in.a), Reg(in.b));
+        return;
+      case TacSetElemUnchecked:
+        if (FoldsStore(in))
+            cg->Gen(OpSetElemConstUnchecked, Reg(in.a), Reg(in.b),
+                    program->AddConstant(ConstantOf(in.c)));
+        else
+            cg->Gen(OpSetElemUnchecked, Reg(in.a), Reg(in.b), Reg(in.c));
+        return;
+      case TacLength:      cg->Gen(OpLength, dst, Reg(in.a)); return;
+      case TacNewObject:
+        cg->Gen(OpNewObject, dst, program->AddClass(tac->classes.Nth(in.a)));
+        return;
+      case TacNewArray:
+        cg->Gen(OpNewArray, dst, Reg(in.a), program->AddType(tac->types.Nth(in.b)));
+        return;
+      case TacCall: case TacCallMethod: case TacCallVirtual: case TacCallInterface:
+        GenCall(in);
+        return;
+      case TacMapElems: {
+        int mark = cg->GetTempMark();
+        int base = cg->NewTemps(5);
+        for (int i = 0; i < in.numArgs; i++)
+            cg->GenMove(base + i, Reg(fn->args[in.firstArg + i]));
+        if (in.a == TacNewArray)
+            cg->Gen(OpMapElems, base, OpNewArray, program->AddType(tac->types.Nth(in.b)));
+        else
+            cg->Gen(OpMapElems, base, in.a == TacCopy ? OpMove : ToBytecode(in.a), in.b);
+        cg->FreeTemps(mark);
+        return;
+      }
+      case TacPrintInt:    cg->Gen(OpPrintInt, Reg(in.a)); return;
+      case TacPrintBool:   cg->Gen(OpPrintBool, Reg(in.a)); return;
+      case TacPrintString: cg->Gen(OpPrintString, Reg(in.a)); return;
+      case TacReadInteger: cg->Gen(OpReadInteger, dst); return;
+      case TacReadLine:    cg->Gen(OpReadLine, dst); return;
+      case TacReturn:      cg->Gen(OpReturn, Reg(in.a)); return;
+      case TacReturnVoid:  cg->Gen(OpReturnVoid); return;
+      default:
+        break;
+    }
+    Assert(in.op != TacPhi && in.op != TacJump && in.op != TacBranch && in.op != TacSwitch);
+    if (FoldsImmediate(in, &reg, &imm))
+        cg->Gen(OpAddIntImm, dst, Reg(reg), (unsigned short)imm);
+    else if (IsBinary(in.op))
+        cg->Gen(ToBytecode(in.op), dst, Reg(in.a), Reg(in.b));
+    else
+        cg->Gen(ToBytecode(in.op), dst, Reg(in.a));
+}
+
+/* The arguments are moved to the top of the frame, where the callee's
+ * registers will start; the result can go straight to its register,
+ * which is below them. */
+void FunctionLowering::GenCall(const TacInstr &in)
+{
+    static const opcodeT ops[] = { OpCall, OpCallMethod, OpCallVirtual, OpCallInterface };
+    int mark = cg->GetTempMark();
+    int base = cg->NewTemps(in.numArgs > 0 ? in.numArgs : 1);
+    for (int i = 0; i < in.numArgs; i++)
+        cg->GenMove(base + i, Reg(fn->args[in.firstArg + i]));
+    int target = in.a;
+    if (in.op == TacCallInterface)
+        target = program->AddConstant(tac->constants.Nth(in.a));
+    cg->Gen(ops[in.op - TacCall], in.dst >= 0 ? Reg(in.dst) : base, target, base);
+    cg->FreeTemps(mark);
+}
+
+bool FunctionLowering::ShouldCopy(int block)
+{
+    const std::vector<TacInstr> &instrs = fn->blocks[block].instrs;
+    return instrs.size() <= 3 && instrs.back().op == TacBranch;
+}
+
+/* Function: GenBlock()
+ * --------------------
+ * Generates the code of a block that next is laid out after (-1 if
+ * none), so that a jump there can be left out.
+ */
+void FunctionLowering::GenBlock(int block, int next)
+{
+    const std::vector<TacInstr> &instrs = fn->blocks[block].instrs;
+    for (size_t i = 0; i + 1 < instrs.size(); i++)
+        GenInstr(instrs[i], fused[block] && i + 2 == instrs.size());
+
+    const TacInstr &t = instrs.back();
+    if (t.op == TacJump) {
+        if (t.a == next) return;
+        if (ShouldCopy(t.a) && t.a != block)
+            GenBlock(t.a, next);
+        else
+            cg->GenJump(OpJump, labels[t.a]);
+    } else if (t.op == TacBranch) {
+        int cond = fused[block] ? scratch : Reg(t.a);
+        if (t.b == next) {
+            cg->GenBranch(OpJumpIfNot, labels[t.c], cond);
+        } else {
+            cg->GenBranch(OpJumpIf, labels[t.b], cond);
+            if (t.c != next) cg->GenJump(OpJump, labels[t.c]);
+        }
+    } else if (t.op == TacSwitch) {
+        std::vector<int> targets;
+        for (int i = 0; i < t.numArgs; i++)
+            targets.push_back(labels[fn->args[t.firstArg + i]]);
+        cg->GenJumpTable(Reg(t.a), t.b, targets);
+        if (t.c != next) cg->GenJump(OpJump, labels[t.c]);
+    } else {
+        GenInstr(t, false);
+    }
+}
+
+BcFunction *FunctionLowering::Lower()
+{
+    Assert(!fn->ssa);
+    CountUses();
+    ComputeLiveness();
+    BuildInterference();
+    AssignRegisters();
+    liveOut.clear();
+    interferes.clear();
+
+    cg->BeginFunction(fn->decl, numColors);
+    scratch = cg->NewTemp();
+    labels.clear();
+    for (size_t b = 0; b < fn->blocks.size(); b++)
+        labels.push_back(cg->NewLabel());
+    for (size_t b = 0; b < fn->blocks.size(); b++) {
+        cg->PlaceLabel(labels[b]);
+        GenBlock(b, b + 1 < fn->blocks.size() ? b + 1 : -1);
+    }
+    BcFunction *result = cg->EndFunction();
+    result->regKinds = new ValueKind[result->numRegs];
+    for (int r = 0; r < result->numRegs; r++) {
+        int kind = r < numColors ? colorKind[r] : OtherKind;
+        result->regKinds[r] = kind == IntKind ? IntValue : kind == DoubleKind ? DoubleValue : VoidValue;
+    }
+    return result;
+}
+
+
+BcProgram *TacLowering::Lower(TacProgram *tac)
+{
+    BcProgram *program = new BcProgram;
+    CodeGenerator cg(program);
+    for (size_t i = 0; i < tac->functions.size(); i++) {
+        TacFunction *fn = tac->functions[i];
+        Assert(fn != NULL);
+        FunctionLowering lowering(tac, program, &cg, fn);
+        program->functions.Append(lowering.Lower());
+        if (fn == tac->main) program->main = program->functions.Nth(i);
+    }
+    return program;
+}
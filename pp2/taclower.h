@@ -0,0 +1,39 @@
+/* File: taclower.h
+ * ----------------
+ * Lowers optimized three-address code (see tac.h and opt.h), out of SSA
+ * form, to bytecode for the VM, in place of the direct lowering of the
+ * AST (codegen.h) when --run is given -O1 or more.
+ *
+ * The TAC's virtual registers are mapped onto as few VM registers as
+ * will do: a register allocator colors the graph of which registers are
+ * live at the same time, and tries to give the two sides of a copy the
+ * same register so the copy goes away. Ints, doubles and other values
+ * get registers apart, which BcFunction::regKinds records for the JIT's
+ * register allocator (see jit.h). The parameters keep their
+ * registers, where the caller put them. One register above those holds
+ * a comparison a branch is fused with, and the arguments of calls go
+ * above that, as the VM wants them at the top of the frame.
+ *
+ * The lowering also picks the bytecode's combined instructions where it
+ * can: AddIntImm for adding or subtracting a small constant,
+ * SetElemConst for storing a constant, the JumpIf...Int compare and
+ * branch, and JumpTable for a Switch. Blocks are laid out in their
+ * order, jumps to the next block are left out, and a jump to a short
+ * block that ends in a branch, the test at the top of a loop, gets a
+ * copy of it instead, so a loop runs one jump per iteration rather than
+ * two.
+ */
+
+#ifndef _H_taclower
+#define _H_taclower
+
+#include "bytecode.h"
+#include "tac.h"
+
+class TacLowering
+{
+  public:
+    static BcProgram *Lower(TacProgram *program);
+};
+
+#endif
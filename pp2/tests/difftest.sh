@@ -0,0 +1,52 @@
+#!/bin/sh
+# Runs every sample, and each program under tests/, every way dcc can
+# and checks each agrees with the tree-walking interpreter, output and
+# exit status: on the VM at -O0, -O1 and -O2, and as a C program built
+# with -o. The optimized three-address code is also verified after
+# every pass (-d tac).
+#    tests/difftest.sh [dcc]
+
+DCC=${1:-./dcc}
+TMP=${TMPDIR:-/tmp}/dcc-difftest.$$
+mkdir -p $TMP
+trap 'rm -rf $TMP' 0 1 2 15
+failed=0
+
+fail() {
+    echo "FAIL: $*"
+    failed=1
+}
+
+printf 'hello\n42\n' > $TMP/in
+for f in samples/*.decaf tests/*.decaf; do
+    case $f in
+        *control.decaf) continue;;    # never ends
+    esac
+    $DCC --interpret $f < $TMP/in > $TMP/expected 2>&1
+    expected=$?
+
+    for o in -O0 -O1 -O2; do
+        # inlined calls take no frame, so at -O2 a program may recurse
+        # deeper before it overflows the stack (see Inliner in opt.cc)
+        [ $o = -O2 ] && grep -q "Stack overflow" $TMP/expected && continue
+        $DCC --run $o $f < $TMP/in > $TMP/out 2>&1
+        status=$?
+        cmp -s $TMP/expected $TMP/out && [ $status = $expected ] || fail "$f, --run $o"
+    done
+
+    if $DCC -o $TMP/prog $f > $TMP/out 2>&1; then
+        $TMP/prog < $TMP/in > $TMP/out 2>&1
+        status=$?
+        cmp -s $TMP/expected $TMP/out && [ $status = $expected ] || fail "$f, -o"
+    elif [ $expected != 255 ]; then
+        fail "$f, -o did not compile"
+    fi
+
+    for o in -O1 -O2; do
+        $DCC -emit-tac $o -d tac $f < /dev/null > /dev/null 2> $TMP/out
+        status=$?
+        [ $status = 0 -o $status = 255 ] || fail "$f, -emit-tac $o -d tac"
+    done
+done
+[ $failed = 0 ] && echo "difftest: all passed"
+exit $failed
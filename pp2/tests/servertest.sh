@@ -0,0 +1,67 @@
+#!/bin/sh
+# Runs each sample through a compile server in two modes one after the
+# other, and checks the second still matches dcc run on its own: a
+# request must not see what an earlier one did to a cached parse tree
+# (checking it, folding its constants). First, a program that never
+# ends must be stopped at the server's time limit.
+#    tests/servertest.sh [dcc [dcc-client]]
+
+DCC=${1:-./dcc}
+CLIENT=${2:-./dcc-client}
+TMP=${TMPDIR:-/tmp}/dcc-servertest.$$
+SOCK=$TMP/sock
+mkdir -p $TMP
+failed=0
+
+$DCC --server $SOCK --time-limit 2 2> $TMP/server.err &
+server=$!
+trap 'kill $server 2> /dev/null; rm -rf $TMP' 0 1 2 15
+for i in 1 2 3 4 5 6 7 8 9 10; do
+    [ -S $SOCK ] && break
+    sleep 1
+done
+
+cat > $TMP/loop.decaf <<'END'
+void main() {
+  while (true) {}
+}
+END
+DCC_SERVER=$SOCK $CLIENT --run $TMP/loop.decaf < /dev/null > $TMP/server.out 2>&1
+if [ $? = 0 ] || ! grep -q "time limit" $TMP/server.out; then
+    echo "FAIL: a program that never ends was not stopped"
+    failed=1
+fi
+
+# None of the samples that check cleanly has constants to fold, so one
+# is made up here.
+cat > $TMP/fold.decaf <<'END'
+void main() {
+  int a;
+  a = 2 + 3 * 4;
+  if (a > 10 && true) Print(a * (7 - 5), "\n");
+}
+END
+
+for f in samples/*.decaf $TMP/fold.decaf; do
+    case $f in
+        *control.decaf) continue;;    # never ends
+    esac
+    printf 'hello\n42\n' > $TMP/in
+    for first in --interpret --run -emit-tac; do
+        DCC_SERVER=$SOCK $CLIENT $first $f < $TMP/in > /dev/null 2>&1
+        DCC_SERVER=$SOCK $CLIENT $f < /dev/null > $TMP/server.out 2>&1
+        $DCC $f < /dev/null > $TMP/alone.out 2>&1
+        if ! cmp -s $TMP/server.out $TMP/alone.out; then
+            echo "FAIL: $f, parsed after $first"
+            failed=1
+        fi
+        DCC_SERVER=$SOCK $CLIENT --interpret $f < $TMP/in > $TMP/server.out 2>&1
+        $DCC --interpret $f < $TMP/in > $TMP/alone.out 2>&1
+        if ! cmp -s $TMP/server.out $TMP/alone.out; then
+            echo "FAIL: $f, run after $first"
+            failed=1
+        fi
+    done
+done
+[ $failed = 0 ] && echo "servertest: all passed"
+exit $failed
@@ -0,0 +1,201 @@
+/* File: timer.cc
+ * --------------
+ * Implementation of the per-phase timing and memory report.
+ */
+
+#include "timer.h"
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <new>
+#include <sys/resource.h>
+#include "list.h"
+
+bool PhaseTimer::enabled = false;
+
+struct PhaseStats {
+    const char *name;
+    int calls;
+    double wallMs, cpuMs;
+    long long allocs, allocBytes;
+    long peakRssKb;
+};
+
+struct Counter {
+    const char *name;
+    long long value;
+};
+
+static List<PhaseStats*> phases;      // in order of first entry
+static List<Counter*> counters;
+static const int MaxDepth = 64;
+static PhaseStats *phaseStack[MaxDepth];
+static int depth = 0;
+
+// Running totals of allocations made with new, kept only while enabled.
+static long long numAllocs = 0, numAllocBytes = 0;
+
+// The clocks and allocation totals at the last phase entry or exit.
+static struct timespec lastWall, lastCpu;
+static long long lastAllocs, lastAllocBytes;
+
+
+static double ElapsedMs(const struct timespec &from, const struct timespec &to)
+{
+    return (to.tv_sec - from.tv_sec) * 1e3 + (to.tv_nsec - from.tv_nsec) / 1e6;
+}
+
+/* Function: ChargeInnermost()
+ * ---------------------------
+ * Charges the time and allocations since the last phase transition to the
+ * phase on top of the stack (if any) and starts a new interval.
+ */
+static void ChargeInnermost()
+{
+    struct timespec wall, cpu;
+    clock_gettime(CLOCK_MONOTONIC, &wall);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu);
+    if (depth > 0) {
+        PhaseStats *top = phaseStack[depth-1];
+        top->wallMs += ElapsedMs(lastWall, wall);
+        top->cpuMs += ElapsedMs(lastCpu, cpu);
+        top->allocs += numAllocs - lastAllocs;
+        top->allocBytes += numAllocBytes - lastAllocBytes;
+    }
+    lastWall = wall;
+    lastCpu = cpu;
+    lastAllocs = numAllocs;
+    lastAllocBytes = numAllocBytes;
+}
+
+static PhaseStats *LookupPhase(const char *name)
+{
+    for (int i = 0; i < phases.NumElements(); i++) {
+        PhaseStats *p = phases.Nth(i);
+        if (p->name == name || !strcmp(p->name, name)) return p;
+    }
+    PhaseStats *p = new PhaseStats;
+    memset(p, 0, sizeof(*p));
+    p->name = name;
+    phases.Append(p);
+    return p;
+}
+
+
+void PhaseTimer::Reset(bool enable)
+{
+    phases = List<PhaseStats*>();
+    counters = List<Counter*>();
+    depth = 0;
+    enabled = enable;
+}
+
+void PhaseTimer::Enter(const char *phase)
+{
+    ChargeInnermost();
+    Assert(depth < MaxDepth);
+    PhaseStats *p = LookupPhase(phase);
+    p->calls++;
+    phaseStack[depth++] = p;
+}
+
+void PhaseTimer::Exit()
+{
+    if (depth == 0) return;
+    ChargeInnermost();
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    phaseStack[--depth]->peakRssKb = usage.ru_maxrss;
+}
+
+void PhaseTimer::Count(const char *counter, long long amount)
+{
+    if (!enabled) return;
+    for (int i = 0; i < counters.NumElements(); i++) {
+        if (!strcmp(counters.Nth(i)->name, counter)) {
+            counters.Nth(i)->value += amount;
+            return;
+        }
+    }
+    Counter *c = new Counter;
+    c->name = counter;
+    c->value = amount;
+    counters.Append(c);
+}
+
+void PhaseTimer::PrintReport(FILE *fp, bool json)
+{
+    double wall = 0, cpu = 0;
+    long long allocs = 0, bytes = 0;
+    long peak = 0;
+
+    if (json) fprintf(fp, "{\"phases\": [");
+    else fprintf(fp, "%-16s %8s %10s %10s %12s %10s %12s\n", "Phase", "Calls",
+                 "Wall ms", "CPU ms", "Peak RSS KB", "Allocs", "Alloc bytes");
+    for (int i = 0; i < phases.NumElements(); i++) {
+        PhaseStats *p = phases.Nth(i);
+        wall += p->wallMs;
+        cpu += p->cpuMs;
+        allocs += p->allocs;
+        bytes += p->allocBytes;
+        if (p->peakRssKb > peak) peak = p->peakRssKb;
+        if (json)
+            fprintf(fp, "%s\n  {\"name\": \"%s\", \"calls\": %d, \"wall_ms\": %.3f, "
+                    "\"cpu_ms\": %.3f, \"peak_rss_kb\": %ld, \"allocs\": %lld, "
+                    "\"alloc_bytes\": %lld}", i ? "," : "", p->name, p->calls,
+                    p->wallMs, p->cpuMs, p->peakRssKb, p->allocs, p->allocBytes);
+        else
+            fprintf(fp, "%-16s %8d %10.3f %10.3f %12ld %10lld %12lld\n", p->name,
+                    p->calls, p->wallMs, p->cpuMs, p->peakRssKb, p->allocs,
+                    p->allocBytes);
+    }
+    if (json) {
+        fprintf(fp, "],\n \"total\": {\"wall_ms\": %.3f, \"cpu_ms\": %.3f, "
+                "\"peak_rss_kb\": %ld, \"allocs\": %lld, \"alloc_bytes\": %lld},\n"
+                " \"counters\": {", wall, cpu, peak, allocs, bytes);
+        for (int i = 0; i < counters.NumElements(); i++)
+            fprintf(fp, "%s\"%s\": %lld", i ? ", " : "", counters.Nth(i)->name,
+                    counters.Nth(i)->value);
+        fprintf(fp, "}}\n");
+    } else {
+        fprintf(fp, "%-16s %8s %10.3f %10.3f %12ld %10lld %12lld\n", "total", "",
+                wall, cpu, peak, allocs, bytes);
+        for (int i = 0; i < counters.NumElements(); i++)
+            fprintf(fp, "%-24s %lld\n", counters.Nth(i)->name, counters.Nth(i)->value);
+    }
+}
+
+
+/* Allocation counting
+ * -------------------
+ * Replacements for the global operator new and delete that tally the
+ * allocations made while timing is on. All of the compiler's own data
+ * structures (ast nodes, lists, strings) are allocated this way; memory
+ * from malloc/strdup (the scanner's copies of lexemes and lines) is not
+ * counted, though it does show up in the peak RSS.
+ */
+static void *CountedAlloc(size_t size)
+{
+    if (PhaseTimer::enabled) {
+        numAllocs++;
+        numAllocBytes += size;
+    }
+    void *p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void *operator new(size_t size)                            { return CountedAlloc(size); }
+void *operator new[](size_t size)                          { return CountedAlloc(size); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    try { return CountedAlloc(size); } catch (...) { return NULL; }
+}
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    try { return CountedAlloc(size); } catch (...) { return NULL; }
+}
+void operator delete(void *p) noexcept                     { free(p); }
+void operator delete[](void *p) noexcept                   { free(p); }
+void operator delete(void *p, size_t) noexcept             { free(p); }
+void operator delete[](void *p, size_t) noexcept           { free(p); }
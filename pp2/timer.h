@@ -0,0 +1,71 @@
+/* File: timer.h
+ * -------------
+ * Support for the -time-phases report, which shows where the time and
+ * memory of a compilation go. Code that makes up a phase of compilation
+ * marks itself with a PhaseScope:
+ *
+ *    {
+ *        PhaseScope scope("parse");
+ *        yyparse();
+ *    }
+ *
+ * For each phase the report gives the number of times it was entered,
+ * its wall and CPU time, the peak resident set size seen when it last
+ * ended, and the number and total size of the allocations made with new
+ * while it ran. Phases may nest; time and allocations are charged to the
+ * innermost phase only, so "parse" does not include the "scan" time spent
+ * in the scanner calls the parser makes. Passes can also record counters
+ * (e.g. how many call sites were inlined) that are listed after the
+ * phases.
+ *
+ * -time-phases prints the report as a table on stderr at the end of the
+ * compilation; -time-phases=json prints it as one JSON object instead.
+ * When neither is given, a PhaseScope costs a single test of a flag.
+ */
+
+#ifndef _H_timer
+#define _H_timer
+
+#include <stdio.h>
+#include "trace.h"
+
+class PhaseTimer
+{
+  public:
+    static bool enabled;
+
+    // Turns timing on (or off) and forgets everything recorded so far.
+    static void Reset(bool enable);
+
+    static void Enter(const char *phase);
+    static void Exit();
+
+    // Adds amount to the named counter.
+    static void Count(const char *counter, long long amount);
+
+    static void PrintReport(FILE *fp, bool json);
+};
+
+/* Class: PhaseScope
+ * -----------------
+ * Marks the rest of the enclosing block as part of a phase. Unless traced
+ * is false (for phases entered far too often to be worth drawing, such as
+ * the scanner's), the phase is also a trace zone (see trace.h).
+ */
+class PhaseScope
+{
+#ifdef DCC_TRACE
+  private:
+    TraceZone zone;
+#endif
+
+  public:
+    PhaseScope(const char *phase, bool traced = true)
+#ifdef DCC_TRACE
+      : zone(traced ? phase : NULL)
+#endif
+        { if (PhaseTimer::enabled) PhaseTimer::Enter(phase); }
+    ~PhaseScope() { if (PhaseTimer::enabled) PhaseTimer::Exit(); }
+};
+
+#endif
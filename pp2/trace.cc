@@ -0,0 +1,102 @@
+/* File: trace.cc
+ * --------------
+ * Implementation of Chrome trace_event output.
+ */
+
+#include "trace.h"
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+bool Tracer::enabled = false;
+
+struct TraceEvent {
+    const char *name;
+    std::string detail;
+    long long start, end;
+    int tid;
+};
+
+static std::mutex eventsLock;
+static std::vector<TraceEvent> events;
+
+static int CurrentThreadId()
+{
+    static thread_local int tid = 0;
+    if (!tid) tid = syscall(SYS_gettid);
+    return tid;
+}
+
+/* Function: PrintJsonString()
+ * ---------------------------
+ * Writes str as a JSON string literal, escaping as needed.
+ */
+static void PrintJsonString(FILE *fp, const char *str)
+{
+    fputc('"', fp);
+    for (const char *p = str; *p; p++) {
+        if (*p == '"' || *p == '\\') fprintf(fp, "\\%c", *p);
+        else if ((unsigned char)*p < 0x20) fprintf(fp, "\\u%04x", *p);
+        else fputc(*p, fp);
+    }
+    fputc('"', fp);
+}
+
+
+void Tracer::Reset(bool enable)
+{
+    std::lock_guard<std::mutex> guard(eventsLock);
+    events.clear();
+    enabled = enable;
+}
+
+long long Tracer::Now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+void Tracer::AddZone(const char *name, const char *detail, long long start,
+                     long long end)
+{
+    TraceEvent e;
+    e.name = name;
+    if (detail) e.detail = detail;
+    e.start = start;
+    e.end = end;
+    e.tid = CurrentThreadId();
+    std::lock_guard<std::mutex> guard(eventsLock);
+    events.push_back(e);
+}
+
+bool Tracer::Write(const char *path)
+{
+    FILE *fp = fopen(path, "w");
+    if (!fp) return false;
+
+    std::lock_guard<std::mutex> guard(eventsLock);
+    int pid = getpid();
+    fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    fprintf(fp, "  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, "
+            "\"args\": {\"name\": \"dcc\"}}", pid);
+    for (size_t i = 0; i < events.size(); i++) {
+        const TraceEvent &e = events[i];
+        fprintf(fp, ",\n  {\"name\": ");
+        PrintJsonString(fp, e.name);
+        fprintf(fp, ", \"cat\": \"dcc\", \"ph\": \"X\", \"ts\": %lld, \"dur\": %lld, "
+                "\"pid\": %d, \"tid\": %d", e.start, e.end - e.start, pid, e.tid);
+        if (!e.detail.empty()) {
+            fprintf(fp, ", \"args\": {\"detail\": ");
+            PrintJsonString(fp, e.detail.c_str());
+            fprintf(fp, "}");
+        }
+        fprintf(fp, "}");
+    }
+    fprintf(fp, "\n]}\n");
+    return fclose(fp) == 0;
+}
@@ -0,0 +1,80 @@
+/* File: trace.h
+ * -------------
+ * Trace zones record when pieces of the compiler ran, for viewing on a
+ * timeline in chrome://tracing or Perfetto. A zone covers the rest of the
+ * enclosing block:
+ *
+ *    void InitScanner() {
+ *        TRACE_ZONE("InitScanner");
+ *        ...
+ *    }
+ *
+ * Every phase marked with a PhaseScope (timer.h) is also a zone, so new
+ * passes show up on the timeline without further work. The parser adds
+ * a zone for each declaration and each statement it reduces, from its
+ * first token to its reduction; expressions and a block's local
+ * variables are not zones of their own but part of their statement.
+ *
+ * Running with -trace <file> writes all zones of the compilation to the
+ * file as Chrome trace_event JSON ("X" complete events). Each event
+ * carries the id of the thread it ran on, so zones from several threads
+ * sort themselves into separate tracks.
+ *
+ * Zones are compiled in only when DCC_TRACE is defined (the Makefile does
+ * so by default). Compiled in but not turned on with -trace, a zone costs
+ * one test of a flag.
+ */
+
+#ifndef _H_trace
+#define _H_trace
+
+#include <stdio.h>
+
+class Tracer
+{
+  public:
+    static bool enabled;
+
+    // Turns tracing on (or off) and drops any events recorded so far.
+    static void Reset(bool enable);
+
+    // Microseconds since an arbitrary fixed point.
+    static long long Now();
+
+    // Records a zone named name that ran from start to end. The detail,
+    // if not NULL, is shown with it (e.g. the name of a declaration).
+    static void AddZone(const char *name, const char *detail,
+                        long long start, long long end);
+
+    // Writes the events recorded so far; returns false on failure.
+    static bool Write(const char *path);
+};
+
+class TraceZone
+{
+  private:
+    const char *name, *detail;
+    long long start;
+
+  public:
+    // A zone with a NULL name records nothing.
+    TraceZone(const char *n, const char *d = NULL) : name(n), detail(d) {
+        if (Tracer::enabled) start = Tracer::Now();
+    }
+    ~TraceZone() {
+        if (Tracer::enabled && name) Tracer::AddZone(name, detail, start, Tracer::Now());
+    }
+};
+
+#ifdef DCC_TRACE
+#define TRACE_ZONE_CONCAT2(a, b) a##b
+#define TRACE_ZONE_CONCAT(a, b) TRACE_ZONE_CONCAT2(a, b)
+#define TRACE_ZONE(name) TraceZone TRACE_ZONE_CONCAT(traceZone, __LINE__)(name)
+#define TRACE_ZONE_DETAIL(name, detail) \
+    TraceZone TRACE_ZONE_CONCAT(traceZone, __LINE__)(name, detail)
+#else
+#define TRACE_ZONE(name)
+#define TRACE_ZONE_DETAIL(name, detail)
+#endif
+
+#endif
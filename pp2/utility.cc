@@ -66,17 +66,144 @@ void PrintDebug(const char *key, const char *format, ...)
 }
 
 
+/* Options
+ * -------
+ * The options dcc understands besides -d. An option that takes a value
+ * consumes the argument that follows it.
+ */
+static const struct {
+  const char *name;
+  bool takesValue;
+} knownOptions[] = {
+  { "--server", true },
+  { "--time-limit", true },
+  { "--cache-dir", true },
+  { "--cache-size", true },
+  { "-time-phases", false },
+  { "-time-phases=json", false },
+  { "-trace", true },
+  { "--interpret", false },
+  { "--run", false },
+  { "-op-profile", false },
+  { "-no-jit", false },
+  { "-gc-stats", false },
+  { "-nursery", true },
+  { "-emit-c", false },
+  { "-o", true },
+  { "-emit-tac", false },
+  { "-O0", false },
+  { "-O1", false },
+  { "-O2", false },
+};
+static const int NumKnownOptions = sizeof(knownOptions)/sizeof(knownOptions[0]);
+
+static List<const char*> inputFiles, flagArgs, optionNames, optionValues;
+
+static bool IsInputFile(const char *arg)
+{
+  const char *ext = ".decaf";
+  int len = strlen(arg), extLen = strlen(ext);
+  return len > extLen && !strcmp(arg + len - extLen, ext);
+}
+
+static int IndexOfKnownOption(const char *arg)
+{
+  for (int i = 0; i < NumKnownOptions; i++)
+    if (!strcmp(knownOptions[i].name, arg)) return i;
+  return -1;
+}
+
+bool ParseArguments(int argc, char *argv[])
+{
+  bool inDebugKeys = false;
+
+  inputFiles = List<const char*>();
+  flagArgs = List<const char*>();
+  optionNames = List<const char*>();
+  optionValues = List<const char*>();
+  debugKeys = List<const char*>();
+  for (int i = 1; i < argc; i++) {
+    int opt = IndexOfKnownOption(argv[i]);
+    if (IsInputFile(argv[i])) {
+      inputFiles.Append(argv[i]);
+      inDebugKeys = false;
+      continue;
+    }
+    flagArgs.Append(argv[i]);
+    if (!strcmp(argv[i], "-d")) {
+      inDebugKeys = true;
+    } else if (opt != -1) {
+      const char *value = NULL;
+      if (knownOptions[opt].takesValue) {
+        if (i + 1 == argc) return false;
+        value = argv[++i];
+        flagArgs.Append(value);
+      }
+      optionNames.Append(knownOptions[opt].name);
+      optionValues.Append(value);
+      inDebugKeys = false;
+    } else if (inDebugKeys) {
+      SetDebugForKey(argv[i], true);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+void PrintUsage()
+{
+  printf("Usage:   [-d <debug-key-1> <debug-key-2> ...]\n"
+         "         [--server <socket> [--time-limit <seconds>]]\n"
+         "         [--cache-dir <dir> [--cache-size <n>[K|M|G]]] [-time-phases[=json]]\n"
+         "         [-trace <file.json>] [--interpret | --run [-op-profile] [-no-jit]\n"
+         "         [-gc-stats] [-nursery <n>[K|M]]]\n"
+         "         [-emit-c | -o <prog> | -emit-tac] [-O0 | -O1 | -O2]\n"
+         "         [file.decaf ...]\n");
+}
+
 void ParseCommandLine(int argc, char *argv[])
 {
-  if (argc == 1)
-    return;
-  
-  if (strcmp(argv[1], "-d") != 0) { // first arg is not -d
-    printf("Usage:   -d <debug-key-1> <debug-key-2> ... \n");
+  if (!ParseArguments(argc, argv)) {
+    PrintUsage();
     exit(2);
   }
+}
+
+int NumInputFiles()
+{
+  return inputFiles.NumElements();
+}
+
+const char *GetInputFile(int n)
+{
+  return inputFiles.Nth(n);
+}
 
-  for (int i = 2; i < argc; i++)
-    SetDebugForKey(argv[i], true);
+int NumFlagArguments()
+{
+  return flagArgs.NumElements();
+}
+
+const char *GetFlagArgument(int n)
+{
+  return flagArgs.Nth(n);
 }
 
+static int IndexOfOption(const char *name)
+{
+  for (int i = 0; i < optionNames.NumElements(); i++)
+    if (!strcmp(optionNames.Nth(i), name)) return i;
+  return -1;
+}
+
+bool IsOptionOn(const char *name)
+{
+  return IndexOfOption(name) != -1;
+}
+
+const char *GetOptionValue(const char *name)
+{
+  int k = IndexOfOption(name);
+  return k == -1 ? NULL : optionValues.Nth(k);
+}
@@ -74,10 +74,54 @@ bool IsDebugOn(const char *key);
 
 /* Function: ParseCommandLine
  * --------------------------
- * Turn on the debugging flags from the command line.  Verifies that
- * first argument is -d, and then interpret all the arguments that follow
- * as being flags to turn on.
+ * Turn on the debugging flags from the command line and collect the names
+ * of the input files and any options given. Any argument ending in ".decaf"
+ * is an input file. Arguments that follow -d are taken as debug keys to
+ * turn on, up to the next option or input file. With no input files, the
+ * program is read from stdin. Prints the usage and exits on a bad command
+ * line.
  */
 void ParseCommandLine(int argc, char *argv[]);
+
+
+/* Function: ParseArguments
+ * Usage: if (!ParseArguments(argc, argv)) PrintUsage();
+ * -----------------------------------------------------
+ * Does the work of ParseCommandLine, but returns false instead of exiting
+ * on a bad command line. Any debug keys, options and input files from an
+ * earlier call are forgotten first, so it can be used once per compile
+ * request by a long-running process.
+ */
+bool ParseArguments(int argc, char *argv[]);
+void PrintUsage();
+
+
+/* Function: IsOptionOn, GetOptionValue
+ * Usage: if (IsOptionOn("--server")) Listen(GetOptionValue("--server"));
+ * ---------------------------------------------------------------------
+ * Return whether the given option appeared on the command line and the
+ * argument given for it (NULL for options that take none).
+ */
+bool IsOptionOn(const char *name);
+const char *GetOptionValue(const char *name);
+
+
+/* Function: NumInputFiles, GetInputFile
+ * Usage: for (int i = 0; i < NumInputFiles(); i++) ... GetInputFile(i)
+ * -------------------------------------------------------------------
+ * Access the input files named on the command line, in command-line order.
+ */
+int NumInputFiles();
+const char *GetInputFile(int n);
+
+
+/* Function: NumFlagArguments, GetFlagArgument
+ * -------------------------------------------
+ * Access all other command-line arguments (options, their values, -d and
+ * debug keys) in command-line order, e.g. to tell whether two compilations
+ * were asked for in the same way.
+ */
+int NumFlagArguments();
+const char *GetFlagArgument(int n);
      
 #endif
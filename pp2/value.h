@@ -0,0 +1,55 @@
+/* File: value.h
+ * -------------
+ * The values a Decaf program computes with, as the tree-walking
+ * interpreter represents them. A Value is a small tagged union that is
+ * passed around by value, so ints, doubles and bools never touch the
+ * heap. Objects and arrays live on the heap (see gc.h) and Values refer
+ * to them; a string is the characters of an immutable, length-prefixed
+ * string (see dstring.h). A null reference is an ObjectValue whose
+ * pointer is NULL.
+ */
+
+#ifndef _H_value
+#define _H_value
+
+class ClassDecl;
+struct Object;
+struct ArrayObject;
+
+typedef enum { VoidValue, IntValue, DoubleValue, BoolValue, StringValue,
+               ObjectValue, ArrayValue } ValueKind;
+
+struct Value {
+    ValueKind kind;
+    union {
+        int i;
+        double d;
+        bool b;
+        const char *s;
+        Object *obj;
+        ArrayObject *arr;
+        void *ref;       // either of the above, e.g. to compare references
+    };
+};
+
+/* An instance of a class: the class it was made from (which gives the
+ * vtable) followed by its fields, inherited ones first. */
+struct Object {
+    ClassDecl *cls;
+    Value fields[1];     // really NumFields() of them
+};
+
+struct ArrayObject {
+    int length;
+    Value elems[1];      // really length of them
+};
+
+inline Value MakeInt(int i)            { Value v; v.kind = IntValue; v.i = i; return v; }
+inline Value MakeDouble(double d)      { Value v; v.kind = DoubleValue; v.d = d; return v; }
+inline Value MakeBool(bool b)          { Value v; v.kind = BoolValue; v.b = b; return v; }
+inline Value MakeString(const char *s) { Value v; v.kind = StringValue; v.s = s; return v; }
+inline Value MakeObject(Object *o)     { Value v; v.kind = ObjectValue; v.obj = o; return v; }
+inline Value MakeArray(ArrayObject *a) { Value v; v.kind = ArrayValue; v.arr = a; return v; }
+inline Value MakeVoid()                { Value v; v.kind = VoidValue; v.ref = 0; return v; }
+
+#endif
@@ -0,0 +1,598 @@
+/* File: vm.cc
+ * -----------
+ * Implementation of the bytecode VM.
+ */
+
+#include "vm.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "interp.h"
+#include "jit.h"
+#include "gc.h"
+#include "dstring.h"
+#include "io.h"
+#include "ast_decl.h"
+#include "utility.h"
+
+static const int StackSize = 1 << 20;     // in Values
+
+/* The call at each depth, for returning to it and for the collector,
+ * which needs the window of every active call. A call records itself
+ * when it calls another or allocates, or when it starts as machine code
+ * (whose pc is then not kept). */
+struct CallFrame {
+    BcFunction *fn;
+    const Instr *pc;            // just after the call instruction
+    Value *regs;
+};
+
+static Value *stack = NULL;
+static CallFrame *frames = NULL;
+static int topDepth;        // of the call that last allocated
+static int numGlobals;
+
+// what the run is of, the lists copied to arrays for fast indexing
+static BcProgram *program;
+static BcFunction **functionTable;
+static Value *constantPool;
+
+bool VM::profiling = false;
+bool VM::jit = true;
+static bool jitOn;          // for this run
+static int nativeDepth;     // the depth of the call in machine code
+
+/* Function: RunNative()
+ * ---------------------
+ * Runs fn's machine code from instruction pc on, in the window regs, as
+ * the call depth deep.
+ */
+static void RunNative(BcFunction *fn, Value *regs, const Instr *pc, int depth)
+{
+    nativeDepth = depth;
+    frames[depth].fn = fn;
+    frames[depth].regs = regs;
+    ((NativeCode)fn->native)(regs, fn->native + fn->nativeOffsets[pc - fn->code]);
+}
+
+// Counts a call or loop iteration towards compiling fn, and says whether
+// it is to run as machine code.
+static inline bool IsNative(BcFunction *fn)
+{
+    return fn->native || (jitOn && ++fn->hotness == JIT::HotThreshold && JIT::Compile(fn));
+}
+
+static long long opCounts[NumOpcodes];
+static long long pairCounts[NumOpcodes][NumOpcodes];
+static int lastOp;
+
+static inline void CountOp(int op)
+{
+    opCounts[op]++;
+    if (lastOp >= 0) pairCounts[lastOp][op]++;
+    lastOp = op;
+}
+
+
+/* Function: MapElems()
+ * --------------------
+ * The loop of a MapElems instruction, whose operands are in ops: a loop
+ * per operation, so the one for elements has nothing to decide.
+ */
+#define MAP_ELEMS(expr) \
+    for (int i = from; i < to; i++, b += bStep, c += cStep) dst[i] = expr; \
+    break
+
+static void MapElems(Value *ops, int op, int scalars)
+{
+    Value *dst = ops[0].arr->elems;
+    int from = ops[1].i, to = ops[2].i;
+    if (from >= to) return;
+    int bStep = scalars & 1 ? 0 : 1, cStep = scalars & 2 || op == OpMove ? 0 : 1;
+    const Value *b = bStep ? ops[3].arr->elems + from : &ops[3];
+    const Value *c = cStep ? ops[4].arr->elems + from : &ops[4];
+    switch (op) {
+      case OpMove:
+        Heap::WriteBarrier(dst + from, to - from);
+        MAP_ELEMS(*b);
+      // ints wrap around, as in the interpreter
+      case OpAddInt:    MAP_ELEMS(MakeInt((unsigned)b->i + c->i));
+      case OpSubInt:    MAP_ELEMS(MakeInt((unsigned)b->i - c->i));
+      case OpMulInt:    MAP_ELEMS(MakeInt((unsigned)b->i * c->i));
+      case OpAddDouble: MAP_ELEMS(MakeDouble(b->d + c->d));
+      case OpSubDouble: MAP_ELEMS(MakeDouble(b->d - c->d));
+      case OpMulDouble: MAP_ELEMS(MakeDouble(b->d * c->d));
+      case OpDivDouble: MAP_ELEMS(MakeDouble(b->d / c->d));
+      default: Assert(0);
+    }
+}
+#undef MAP_ELEMS
+
+/* Function: NewRows()
+ * -------------------
+ * Makes the rows from ops[1] up to ops[2] of the array in ops[0], each
+ * of ops[3] elements, as a loop of NewArray would, but in one block.
+ * Only once they are made is the array taken from ops[0], as making
+ * them may have moved it.
+ */
+void VM::NewRows(Value *ops, Type *elemType)
+{
+    int from = ops[1].i, to = ops[2].i, length = ops[3].i;
+    if (from >= to) return;
+    if (length <= 0) Interpreter::Halt("Array size is <= 0");
+    ArrayObject *row = Heap::NewArrays(to - from, length);
+    size_t stride = Heap::ArrayStride(length);
+    Value zero = Interpreter::ZeroOf(elemType);
+    Value *rows = ops[0].arr->elems;
+    for (int i = from; i < to; i++) {
+        row->length = length;
+        for (int j = 0; j < length; j++)
+            row->elems[j] = zero;
+        rows[i] = MakeArray(row);
+        row = (ArrayObject *)((char *)row + stride);
+    }
+    Heap::WriteBarrier(rows + from, to - from);
+}
+
+
+/* Dispatch
+ * --------
+ * The code of each instruction ends by dispatching to the next one. With
+ * VM_THREADED (which the Makefile sets) and GCC's labels as values, that
+ * is an indirect jump through a table of label addresses, repeated at
+ * the end of every instruction, which the branch predictor can tell
+ * apart far better than the one indirect jump a switch compiles to.
+ * Otherwise it is a plain switch in a loop.
+ */
+#if defined(VM_THREADED) && defined(__GNUC__)
+#define LABEL_ADDRESS(name) &&Do##name,
+#define DISPATCH_START \
+    static void *dispatch[] = { OPCODES(LABEL_ADDRESS) }; \
+    NEXT
+#define CASE(name) Do##name:
+#define NEXT \
+    { in = pc++; a = &regs[in->a]; if (profiling) CountOp(in->op); goto *dispatch[in->op]; }
+#define DISPATCH_END
+#else
+#define DISPATCH_START \
+    for (;;) { \
+        in = pc++; \
+        a = &regs[in->a]; \
+        if (profiling) CountOp(in->op); \
+        switch (in->op) {
+#define CASE(name) case Op##name:
+#define NEXT break
+#define DISPATCH_END \
+          default: Assert(0); \
+        } \
+    }
+#endif
+
+
+/* Before an instruction that may collect garbage, the call makes itself
+ * the top of the stack the collector scans. */
+#define SAFEPOINT \
+    frames[depth].fn = fn; \
+    frames[depth].regs = regs; \
+    topDepth = depth
+
+/* A jump back to the top of a loop counts towards compiling the
+ * function, and once it is compiled the rest of the call runs as machine
+ * code, from the jump's target on. */
+#define BACK_EDGE \
+    if (pc <= in && IsNative(fn)) { \
+        RunNative(fn, regs, pc, depth); \
+        v = regs[0]; \
+        goto ret; \
+    }
+
+
+/* Function: Execute()
+ * --------------------
+ * The VM's main loop: runs fn, whose registers regs are set up, to its
+ * end, with the result left in its first register. The call is depth
+ * deep: main is run at 0, and the functions the JIT's code calls that
+ * have not been compiled are run deeper (see Enter). A runtime error
+ * does not return here but longjmps back to Run. It is compiled twice,
+ * with and without the counting for -op-profile, so that the normal loop
+ * pays nothing for it.
+ */
+template <bool profiling>
+static void Execute(BcFunction *fn, Value *regs, int depth)
+{
+    BcFunction **functions = functionTable, *callee;
+    Value *constants = constantPool, *globals = Interpreter::globals;
+    const Value *stackLimit = stack + StackSize;
+    const int base = depth;
+    const Instr *pc = fn->code, *in;
+    Value *a, v;
+
+    DISPATCH_START;
+    CASE(Move)        *a = regs[in->b]; NEXT;
+    CASE(LoadInt)     *a = MakeInt((short)in->b); NEXT;
+    CASE(LoadConst)   *a = constants[in->b]; NEXT;
+    CASE(LoadGlobal)  *a = globals[in->b]; NEXT;
+    CASE(StoreGlobal) globals[in->a] = regs[in->b]; NEXT;
+
+    CASE(GetField) {
+      Object *obj = regs[in->b].obj;
+      if (!obj) Interpreter::Halt("Null object reference");
+      *a = obj->fields[in->c];
+      NEXT;
+    }
+    CASE(SetField) {
+      Object *obj = a->obj;
+      if (!obj) Interpreter::Halt("Null object reference");
+      obj->fields[in->b] = regs[in->c];
+      Heap::WriteBarrier(&obj->fields[in->b]);
+      NEXT;
+    }
+    CASE(GetElem) {
+      ArrayObject *arr = regs[in->b].arr;
+      int i = regs[in->c].i;
+      if (!arr) Interpreter::Halt("Null object reference");
+      if (i < 0 || i >= arr->length) Interpreter::Halt("Array subscript out of bounds");
+      *a = arr->elems[i];
+      NEXT;
+    }
+    CASE(SetElem) {
+      ArrayObject *arr = a->arr;
+      int i = regs[in->b].i;
+      if (!arr) Interpreter::Halt("Null object reference");
+      if (i < 0 || i >= arr->length) Interpreter::Halt("Array subscript out of bounds");
+      arr->elems[i] = regs[in->c];
+      Heap::WriteBarrier(&arr->elems[i]);
+      NEXT;
+    }
+    CASE(SetElemConst) {
+      ArrayObject *arr = a->arr;
+      int i = regs[in->b].i;
+      if (!arr) Interpreter::Halt("Null object reference");
+      if (i < 0 || i >= arr->length) Interpreter::Halt("Array subscript out of bounds");
+      arr->elems[i] = constants[in->c];
+      NEXT;
+    }
+    CASE(GetElemUnchecked)
+      *a = regs[in->b].arr->elems[regs[in->c].i];
+      NEXT;
+    CASE(SetElemUnchecked) {
+      Value *elem = &a->arr->elems[regs[in->b].i];
+      *elem = regs[in->c];
+      Heap::WriteBarrier(elem);
+      NEXT;
+    }
+    CASE(SetElemConstUnchecked)
+      a->arr->elems[regs[in->b].i] = constants[in->c];
+      NEXT;
+    CASE(Length) {
+      ArrayObject *arr = regs[in->b].arr;
+      if (!arr) Interpreter::Halt("Null object reference");
+      *a = MakeInt(arr->length);
+      NEXT;
+    }
+    CASE(NewObject)
+      SAFEPOINT;
+      *a = Interpreter::NewObject(program->classes.Nth(in->b));
+      NEXT;
+    CASE(NewArray)
+      SAFEPOINT;
+      *a = Interpreter::NewArray(regs[in->b].i, program->types.Nth(in->c));
+      NEXT;
+
+    // ints wrap around, as in the interpreter
+    CASE(AddInt)    *a = MakeInt((unsigned)regs[in->b].i + regs[in->c].i); NEXT;
+    CASE(SubInt)    *a = MakeInt((unsigned)regs[in->b].i - regs[in->c].i); NEXT;
+    CASE(MulInt)    *a = MakeInt((unsigned)regs[in->b].i * regs[in->c].i); NEXT;
+    CASE(AddIntImm) *a = MakeInt((unsigned)regs[in->b].i + (short)in->c); NEXT;
+    CASE(Negate)    *a = MakeInt(-(unsigned)regs[in->b].i); NEXT;
+    CASE(DivInt) {
+      int l = regs[in->b].i, r = regs[in->c].i;
+      if (r == 0) Interpreter::Halt("Division by zero");
+      *a = MakeInt(r == -1 ? -(unsigned)l : l / r);
+      NEXT;
+    }
+    CASE(ModInt) {
+      int l = regs[in->b].i, r = regs[in->c].i;
+      if (r == 0) Interpreter::Halt("Division by zero");
+      *a = MakeInt(r == -1 ? 0 : l % r);
+      NEXT;
+    }
+    CASE(AddDouble)    *a = MakeDouble(regs[in->b].d + regs[in->c].d); NEXT;
+    CASE(SubDouble)    *a = MakeDouble(regs[in->b].d - regs[in->c].d); NEXT;
+    CASE(MulDouble)    *a = MakeDouble(regs[in->b].d * regs[in->c].d); NEXT;
+    CASE(DivDouble)    *a = MakeDouble(regs[in->b].d / regs[in->c].d); NEXT;
+    CASE(ModDouble)    *a = MakeDouble(fmod(regs[in->b].d, regs[in->c].d)); NEXT;
+    CASE(NegateDouble) *a = MakeDouble(-regs[in->b].d); NEXT;
+
+    CASE(LessInt)           *a = MakeBool(regs[in->b].i < regs[in->c].i); NEXT;
+    CASE(LessEqualInt)      *a = MakeBool(regs[in->b].i <= regs[in->c].i); NEXT;
+    CASE(GreaterInt)        *a = MakeBool(regs[in->b].i > regs[in->c].i); NEXT;
+    CASE(GreaterEqualInt)   *a = MakeBool(regs[in->b].i >= regs[in->c].i); NEXT;
+    CASE(EqualInt)          *a = MakeBool(regs[in->b].i == regs[in->c].i); NEXT;
+    CASE(NotEqualInt)       *a = MakeBool(regs[in->b].i != regs[in->c].i); NEXT;
+    CASE(LessDouble)        *a = MakeBool(regs[in->b].d < regs[in->c].d); NEXT;
+    CASE(LessEqualDouble)   *a = MakeBool(regs[in->b].d <= regs[in->c].d); NEXT;
+    CASE(GreaterDouble)     *a = MakeBool(regs[in->b].d > regs[in->c].d); NEXT;
+    CASE(GreaterEqualDouble)*a = MakeBool(regs[in->b].d >= regs[in->c].d); NEXT;
+    CASE(EqualDouble)       *a = MakeBool(regs[in->b].d == regs[in->c].d); NEXT;
+    CASE(NotEqualDouble)    *a = MakeBool(regs[in->b].d != regs[in->c].d); NEXT;
+    CASE(EqualBool)         *a = MakeBool(regs[in->b].b == regs[in->c].b); NEXT;
+    CASE(NotEqualBool)      *a = MakeBool(regs[in->b].b != regs[in->c].b); NEXT;
+    CASE(EqualString)       *a = MakeBool(Strings::Equal(regs[in->b].s, regs[in->c].s)); NEXT;
+    CASE(NotEqualString)    *a = MakeBool(!Strings::Equal(regs[in->b].s, regs[in->c].s)); NEXT;
+    CASE(EqualRef)          *a = MakeBool(regs[in->b].ref == regs[in->c].ref); NEXT;
+    CASE(NotEqualRef)       *a = MakeBool(regs[in->b].ref != regs[in->c].ref); NEXT;
+    CASE(NotBool)           *a = MakeBool(!regs[in->b].b); NEXT;
+
+    CASE(Jump)
+      pc = fn->code + in->Target();
+      BACK_EDGE;
+      NEXT;
+    CASE(JumpIf)
+      if (a->b) {
+          pc = fn->code + in->Target();
+          BACK_EDGE;
+      }
+      NEXT;
+    CASE(JumpIfNot)
+      if (!a->b) {
+          pc = fn->code + in->Target();
+          BACK_EDGE;
+      }
+      NEXT;
+    CASE(JumpIfLessInt)
+      if (a->i < regs[in->b].i) {
+          pc = fn->code + in->c;
+          BACK_EDGE;
+      }
+      NEXT;
+    CASE(JumpIfLessEqualInt)
+      if (a->i <= regs[in->b].i) {
+          pc = fn->code + in->c;
+          BACK_EDGE;
+      }
+      NEXT;
+    CASE(JumpIfGreaterInt)
+      if (a->i > regs[in->b].i) {
+          pc = fn->code + in->c;
+          BACK_EDGE;
+      }
+      NEXT;
+    CASE(JumpIfGreaterEqualInt)
+      if (a->i >= regs[in->b].i) {
+          pc = fn->code + in->c;
+          BACK_EDGE;
+      }
+      NEXT;
+    CASE(JumpIfEqualInt)
+      if (a->i == regs[in->b].i) {
+          pc = fn->code + in->c;
+          BACK_EDGE;
+      }
+      NEXT;
+    CASE(JumpIfNotEqualInt)
+      if (a->i != regs[in->b].i) {
+          pc = fn->code + in->c;
+          BACK_EDGE;
+      }
+      NEXT;
+    CASE(JumpTable) {
+      // unsigned, a value below low is out of range too
+      const int *table = fn->tables + in->Target();
+      unsigned index = (unsigned)a->i - (unsigned)table[0];
+      if (index < (unsigned)table[1]) {
+          pc = fn->code + table[2 + index];
+          BACK_EDGE;
+      }
+      NEXT;
+    }
+
+    CASE(Call)
+      callee = functions[in->b];
+      goto call;
+    CASE(CallMethod)
+      if (!regs[in->c].obj) Interpreter::Halt("Null object reference");
+      callee = functions[in->b];
+      goto call;
+    CASE(CallVirtual) {
+      Object *obj = regs[in->c].obj;
+      if (!obj) Interpreter::Halt("Null object reference");
+      InlineCache *cache = fn->caches + in->b;
+      if (cache->cls != obj->cls) {
+          cache->cls = obj->cls;
+          cache->callee = functions[obj->cls->GetMethod(cache->method)->GetCodeIndex()];
+      }
+      callee = cache->callee;
+      goto call;
+    }
+    CASE(CallInterface) {
+      Object *obj = regs[in->c].obj;
+      if (!obj) Interpreter::Halt("Null object reference");
+      InlineCache *cache = fn->caches + in->b;
+      if (cache->cls != obj->cls) {
+          cache->cls = obj->cls;
+          cache->callee = functions[obj->cls->LookupMethod(constants[cache->method].s)->GetCodeIndex()];
+      }
+      callee = cache->callee;
+      goto call;
+    }
+    call: {
+      Value *window = regs + in->c;
+      if (depth + 1 >= Interpreter::MaxDepth || window + callee->numRegs > stackLimit)
+          Interpreter::Halt("Stack overflow");
+      memcpy(window + callee->numParams, callee->regInit + callee->numParams,
+             (callee->numRegs - callee->numParams) * sizeof(Value));
+      frames[depth].fn = fn;
+      frames[depth].pc = pc;
+      frames[depth].regs = regs;
+      if (IsNative(callee)) {
+          RunNative(callee, window, callee->code, depth + 1);
+          regs[in->a] = window[0];
+          NEXT;
+      }
+      depth++;
+      fn = callee;
+      regs = window;
+      pc = fn->code;
+      NEXT;
+    }
+
+    CASE(Return)
+      v = *a;
+      goto ret;
+    CASE(ReturnVoid)
+      v = fn->returnZero;
+    ret:
+      if (depth == base) {
+          regs[0] = v;
+          return;
+      }
+      depth--;
+      fn = frames[depth].fn;
+      pc = frames[depth].pc;
+      regs = frames[depth].regs;
+      regs[pc[-1].a] = v;
+      NEXT;
+
+    CASE(PrintInt)    IO::PrintInt(a->i); NEXT;
+    CASE(PrintBool)   IO::PrintBool(a->b); NEXT;
+    CASE(PrintString) IO::PrintString(a->s); NEXT;
+    CASE(ReadInteger) *a = Interpreter::ReadInteger(); NEXT;
+    CASE(ReadLine)    *a = Interpreter::ReadLine(); NEXT;
+
+    CASE(MapElems)
+      if (in->b == OpNewArray) {
+          SAFEPOINT;
+          VM::NewRows(a, program->types.Nth(in->c));
+      } else {
+          MapElems(a, in->b, in->c);
+      }
+      NEXT;
+
+    DISPATCH_END;
+}
+
+/* Function: Enter()
+ * -----------------
+ * Calls callee, with its arguments in place in window, for the JIT's
+ * code: by its own machine code if it has some or has just become hot,
+ * and otherwise by running the VM on it.
+ */
+void VM::Enter(BcFunction *callee, Value *window)
+{
+    int depth = nativeDepth + 1;
+    if (depth >= Interpreter::MaxDepth || window + callee->numRegs > stack + StackSize)
+        Interpreter::Halt("Stack overflow");
+    memcpy(window + callee->numParams, callee->regInit + callee->numParams,
+           (callee->numRegs - callee->numParams) * sizeof(Value));
+    if (IsNative(callee))
+        RunNative(callee, window, callee->code, depth);
+    else
+        Execute<false>(callee, window, depth);
+    nativeDepth = depth - 1;
+}
+
+void VM::NativeSafepoint()
+{
+    topDepth = nativeDepth;
+}
+
+/* Function: VisitRoots()
+ * ----------------------
+ * The collector's roots: the globals, and the registers of every active
+ * call. A callee's window starts inside its caller's, so together they
+ * are one run of the stack, up to the end of the window that reaches
+ * furthest; every register in it was set on entry to its call, if not
+ * since.
+ */
+static void VisitRoots(ValueVisitor visit)
+{
+    visit(Interpreter::globals, numGlobals);
+    Value *end = stack;
+    for (int d = 0; d <= topDepth; d++) {
+        Value *last = frames[d].regs + frames[d].fn->numRegs;
+        if (last > end) end = last;
+    }
+    visit(stack, end - stack);
+}
+
+int VM::Run(BcProgram *p, List<VarDecl*> *globalVars, FILE *in)
+{
+    if (!stack) {
+        stack = new Value[StackSize + 1];   // a result goes in a window's first register
+        frames = new CallFrame[Interpreter::MaxDepth];
+    }
+    Interpreter::Start(globalVars, in);
+    numGlobals = globalVars->NumElements();
+    Heap::Start(VisitRoots);
+
+    program = p;
+    int n = program->functions.NumElements();
+    functionTable = new BcFunction*[n + 1];
+    for (int i = 0; i < n; i++) functionTable[i] = program->functions.Nth(i);
+    n = program->constants.NumElements();
+    constantPool = new Value[n + 1];
+    for (int i = 0; i < n; i++) constantPool[i] = program->constants.Nth(i);
+
+    // the counts would miss what runs as machine code
+    jitOn = jit && !profiling && JIT::IsAvailable();
+    if (jitOn) JIT::Start(program, constantPool, Interpreter::globals);
+
+    memset(opCounts, 0, sizeof(opCounts));
+    memset(pairCounts, 0, sizeof(pairCounts));
+    lastOp = -1;
+    BcFunction *main = program->main;
+    memcpy(stack, main->regInit, main->numRegs * sizeof(Value));
+    int status = 0;
+    if (setjmp(Interpreter::halted) != 0)
+        status = 1;
+    else if (profiling)
+        Execute<true>(main, stack, 0);
+    else
+        Execute<false>(main, stack, 0);
+    Heap::Finish();
+    if (jitOn) JIT::Finish();
+    delete[] functionTable;
+    delete[] constantPool;
+    IO::Flush();
+    fflush(stdout);
+    return status;
+}
+
+/* Function: PrintProfile()
+ * ------------------------
+ * Lists how often each opcode ran and the most frequent pairs of opcodes
+ * run one after the other, the candidates for superinstructions.
+ */
+void VM::PrintProfile(FILE *fp)
+{
+    struct Pair { long long count; int first, second; };
+    const int MaxPairs = 30;
+    long long total = 0;
+    for (int i = 0; i < NumOpcodes; i++) total += opCounts[i];
+    if (total == 0) return;
+
+    fprintf(fp, "%-22s %14s %7s\n", "Opcode", "Count", "%");
+    for (int i = 0; i < NumOpcodes; i++)
+        if (opCounts[i])
+            fprintf(fp, "%-22s %14lld %6.2f%%\n", opcodeNames[i], opCounts[i],
+                    100.0 * opCounts[i] / total);
+
+    Pair top[MaxPairs];
+    int numTop = 0;
+    for (int i = 0; i < NumOpcodes; i++) {
+        for (int j = 0; j < NumOpcodes; j++) {
+            long long n = pairCounts[i][j];
+            if (n == 0 || (numTop == MaxPairs && n <= top[numTop-1].count)) continue;
+            int k = numTop < MaxPairs ? numTop++ : MaxPairs - 1;
+            for (; k > 0 && top[k-1].count < n; k--) top[k] = top[k-1];
+            top[k].count = n;
+            top[k].first = i;
+            top[k].second = j;
+        }
+    }
+    fprintf(fp, "\n%-44s %14s %7s\n", "Opcode pair", "Count", "%");
+    for (int i = 0; i < numTop; i++)
+        fprintf(fp, "%-21s %-22s %14lld %6.2f%%\n", opcodeNames[top[i].first],
+                opcodeNames[top[i].second], top[i].count, 100.0 * top[i].count / total);
+}
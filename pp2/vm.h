@@ -0,0 +1,64 @@
+/* File: vm.h
+ * ----------
+ * The VM runs a program lowered to bytecode (see bytecode.h). It shares
+ * its values, heap, input and output and runtime errors with the
+ * tree-walking interpreter (see interp.h), so the two give the same
+ * results; the VM is just faster.
+ *
+ * The registers of all active calls are windows onto one stack of
+ * Values. A call's window starts at the register holding its first
+ * argument (or receiver) in the caller, so the arguments are in place
+ * without copying, and only the callee's locals need initializing. The
+ * return value is written back to the register the window started at.
+ *
+ * Functions that run often, or loop for long, are compiled to machine
+ * code by the JIT (see jit.h), which works on the same windows, so the
+ * VM can hand a call or the rest of a loop over to it at any point.
+ *
+ * Objects and arrays are allocated in the garbage-collected heap (see
+ * gc.h), whose roots are the globals and the windows of the active
+ * calls. Stores into the heap go through its write barrier.
+ */
+
+#ifndef _H_vm
+#define _H_vm
+
+#include <stdio.h>
+#include "bytecode.h"
+
+class VarDecl;
+class Type;
+
+class VM
+{
+  public:
+    // Runs main (with the given globals zeroed) reading input from in.
+    // Returns 0 if the program ran to completion and 1 if it stopped
+    // with a runtime error.
+    static int Run(BcProgram *program, List<VarDecl*> *globalVars, FILE *in);
+
+    // With profiling on, Run counts how often each opcode and each pair
+    // of consecutive opcodes runs, for PrintProfile to list afterwards.
+    static bool profiling;
+    static void PrintProfile(FILE *fp);
+
+    // Whether hot functions are compiled to machine code (see jit.h),
+    // where the JIT is available and the run is not being profiled.
+    static bool jit;
+
+    // For the JIT's code: calls callee, with its arguments in place at
+    // the start of its window, leaving the result in the same register.
+    static void Enter(BcFunction *callee, Value *window);
+
+    // For the JIT's code, before something that may collect garbage:
+    // makes the call running as machine code the top of the stack that
+    // the collector scans.
+    static void NativeSafepoint();
+
+    // The loop of a MapElems of NewArray, whose operands are in ops: new
+    // rows of elemType, made at once (see Heap::NewArrays). For the VM
+    // and the JIT, after their safepoint.
+    static void NewRows(Value *ops, Type *elemType);
+};
+
+#endif
@@ -0,0 +1,62 @@
+/* File: wire.cc
+ * -------------
+ * Implementation of the compile server message framing.
+ */
+
+#include "wire.h"
+#include <errno.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <stdint.h>
+
+static bool WriteFully(int fd, const char *buf, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool ReadFully(int fd, char *buf, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = read(fd, buf, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool WriteField(int fd, const std::string &field)
+{
+    uint32_t len = htonl(field.size());
+    return WriteFully(fd, (const char *)&len, sizeof(len)) &&
+           WriteFully(fd, field.data(), field.size());
+}
+
+bool ReadField(int fd, std::string *field)
+{
+    uint32_t len;
+    if (!ReadFully(fd, (char *)&len, sizeof(len))) return false;
+    field->resize(ntohl(len));
+    return field->empty() || ReadFully(fd, &(*field)[0], field->size());
+}
+
+bool ReadAll(int fd, std::string *contents)
+{
+    char buf[8192];
+    ssize_t n;
+    contents->clear();
+    while ((n = read(fd, buf, sizeof(buf))) != 0) {
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return false;
+        contents->append(buf, n);
+    }
+    return true;
+}
@@ -0,0 +1,26 @@
+/* File: wire.h
+ * ------------
+ * Framing used between the compile server and its client. Every message
+ * is a sequence of fields and each field is sent as a 4-byte length in
+ * network byte order followed by that many bytes.
+ *
+ * A request carries the client's working directory, the contents of its
+ * stdin (empty if input files are named), and then the command-line
+ * arguments, one per field, ending with an empty field. The reply carries
+ * the exit status as decimal text, then everything the compilation wrote
+ * to stdout, then everything it wrote to stderr.
+ */
+
+#ifndef _H_wire
+#define _H_wire
+
+#include <string>
+
+// Both return false if the connection failed or closed early.
+bool WriteField(int fd, const std::string &field);
+bool ReadField(int fd, std::string *field);
+
+// Reads everything remaining on fd into contents.
+bool ReadAll(int fd, std::string *contents);
+
+#endif
@@ -1,8 +1,9 @@
-/* A Bison parser, made by GNU Bison 3.0.2.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison implementation for Yacc-like parsers in C
 
-   Copyright (C) 1984, 1989-1990, 2000-2013 Free Software Foundation, Inc.
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
 
    This program is free software: you can redistribute it and/or modify
    it under the terms of the GNU General Public License as published by
@@ -15,7 +16,7 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -33,6 +34,10 @@
 /* C LALR(1) parser skeleton written by Richard Stallman, by
    simplifying the original so-called "semantic" parser.  */
 
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
 /* All symbols defined below should begin with yy or YY, to avoid
    infringing on user name space.  This should be done even for local
    variables, as they might otherwise be expanded by user macros.
@@ -40,11 +45,11 @@
    define necessary library symbols; they are noted "INFRINGES ON
    USER NAME SPACE" below.  */
 
-/* Identify Bison output.  */
-#define YYBISON 1
+/* Identify Bison output, and Bison version.  */
+#define YYBISON 30802
 
-/* Bison version.  */
-#define YYBISON_VERSION "3.0.2"
+/* Bison version string.  */
+#define YYBISON_VERSION "3.8.2"
 
 /* Skeleton name.  */
 #define YYSKELETON_NAME "yacc.c"
@@ -61,8 +66,8 @@
 
 
 
-/* Copy the first part of user declarations.  */
-#line 11 "parser.y" /* yacc.c:339  */
+/* First part of user prologue.  */
+#line 11 "parser.y"
 
 
 /* Just like lex, the text within this first region delimited by %{ and %}
@@ -74,30 +79,77 @@
 #include "scanner.h" // for yylex
 #include "parser.h"
 #include "errors.h"
+#include "timer.h"
 
 void yyerror(const char *msg); // standard error-handling routine
 
+/* Each call the parser makes to the scanner is timed as the "scan" phase
+ * (which includes the scanner's copying of each line for error context),
+ * so that -time-phases can tell scanning and parsing apart. With -trace,
+ * the token's location also records when it was asked for. */
+static int TimedLex() {
+    PhaseScope scope("scan", false);
+#ifdef DCC_TRACE
+    if (Tracer::enabled) yylloc.traceStart = Tracer::Now();
+#endif
+    return yylex();
+}
+#define yylex TimedLex
+
+/* Bison's default, except that a reduction's location also takes the
+ * time its first token was asked for (now, if it has none). */
+#define YYLLOC_DEFAULT(Current, Rhs, N) do {                                  \
+    if (N) {                                                                  \
+        (Current).first_line = YYRHSLOC(Rhs, 1).first_line;                   \
+        (Current).first_column = YYRHSLOC(Rhs, 1).first_column;               \
+        (Current).last_line = YYRHSLOC(Rhs, N).last_line;                     \
+        (Current).last_column = YYRHSLOC(Rhs, N).last_column;                 \
+        (Current).traceStart = YYRHSLOC(Rhs, 1).traceStart;                   \
+    } else {                                                                  \
+        (Current).first_line = (Current).last_line = YYRHSLOC(Rhs, 0).last_line; \
+        (Current).first_column = (Current).last_column = YYRHSLOC(Rhs, 0).last_column; \
+        (Current).traceStart = Tracer::enabled ? Tracer::Now() : 0;           \
+    }                                                                         \
+} while (0)
+
+/* With -trace, each declaration (top-level or in a class) and each
+ * statement is drawn as a zone that runs from when its first token was
+ * asked for to its reduction, i.e. the time spent scanning and parsing
+ * it. Expressions and the local variables of a block are not zones of
+ * their own; their time is part of the statement that holds them. */
+static void TraceReduction(Node *node, const char *detail, const yyltype &loc) {
+#ifdef DCC_TRACE
+    if (Tracer::enabled)
+        Tracer::AddZone(node->GetPrintNameForNode(), detail, loc.traceStart, Tracer::Now());
+#endif
+}
 
-#line 82 "y.tab.c" /* yacc.c:339  */
 
+#line 129 "y.tab.c"
+
+# ifndef YY_CAST
+#  ifdef __cplusplus
+#   define YY_CAST(Type, Val) static_cast<Type> (Val)
+#   define YY_REINTERPRET_CAST(Type, Val) reinterpret_cast<Type> (Val)
+#  else
+#   define YY_CAST(Type, Val) ((Type) (Val))
+#   define YY_REINTERPRET_CAST(Type, Val) ((Type) (Val))
+#  endif
+# endif
 # ifndef YY_NULLPTR
-#  if defined __cplusplus && 201103L <= __cplusplus
-#   define YY_NULLPTR nullptr
+#  if defined __cplusplus
+#   if 201103L <= __cplusplus
+#    define YY_NULLPTR nullptr
+#   else
+#    define YY_NULLPTR 0
+#   endif
 #  else
-#   define YY_NULLPTR 0
+#   define YY_NULLPTR ((void*)0)
 #  endif
 # endif
 
-/* Enabling verbose error messages.  */
-#ifdef YYERROR_VERBOSE
-# undef YYERROR_VERBOSE
-# define YYERROR_VERBOSE 1
-#else
-# define YYERROR_VERBOSE 0
-#endif
-
-/* In a future release of Bison, this section will be replaced
-   by #include "y.tab.h".  */
+/* Use api.header.include to #include this header
+   instead of duplicating it here.  */
 #ifndef YY_YY_Y_TAB_H_INCLUDED
 # define YY_YY_Y_TAB_H_INCLUDED
 /* Debug traces.  */
@@ -108,54 +160,63 @@ void yyerror(const char *msg); // standard error-handling routine
 extern int yydebug;
 #endif
 
-/* Token type.  */
+/* Token kinds.  */
 #ifndef YYTOKENTYPE
 # define YYTOKENTYPE
   enum yytokentype
   {
-    T_Void = 258,
-    T_Bool = 259,
-    T_Int = 260,
-    T_Double = 261,
-    T_String = 262,
-    T_Class = 263,
-    T_LessEqual = 264,
-    T_GreaterEqual = 265,
-    T_Equal = 266,
-    T_NotEqual = 267,
-    T_Dims = 268,
-    T_And = 269,
-    T_Or = 270,
-    T_Null = 271,
-    T_Extends = 272,
-    T_This = 273,
-    T_Interface = 274,
-    T_Implements = 275,
-    T_While = 276,
-    T_For = 277,
-    T_If = 278,
-    T_Else = 279,
-    T_Return = 280,
-    T_Break = 281,
-    T_New = 282,
-    T_NewArray = 283,
-    T_Print = 284,
-    T_ReadInteger = 285,
-    T_ReadLine = 286,
-    T_Increment = 287,
-    T_Decrement = 288,
-    T_Switch = 289,
-    T_Case = 290,
-    T_Default = 291,
-    T_Identifier = 292,
-    T_StringConstant = 293,
-    T_IntConstant = 294,
-    T_DoubleConstant = 295,
-    T_BoolConstant = 296,
-    ELSECHECK = 297
+    YYEMPTY = -2,
+    YYEOF = 0,                     /* "end of file"  */
+    YYerror = 256,                 /* error  */
+    YYUNDEF = 257,                 /* "invalid token"  */
+    T_Void = 258,                  /* T_Void  */
+    T_Bool = 259,                  /* T_Bool  */
+    T_Int = 260,                   /* T_Int  */
+    T_Double = 261,                /* T_Double  */
+    T_String = 262,                /* T_String  */
+    T_Class = 263,                 /* T_Class  */
+    T_LessEqual = 264,             /* T_LessEqual  */
+    T_GreaterEqual = 265,          /* T_GreaterEqual  */
+    T_Equal = 266,                 /* T_Equal  */
+    T_NotEqual = 267,              /* T_NotEqual  */
+    T_Dims = 268,                  /* T_Dims  */
+    T_And = 269,                   /* T_And  */
+    T_Or = 270,                    /* T_Or  */
+    T_Null = 271,                  /* T_Null  */
+    T_Extends = 272,               /* T_Extends  */
+    T_This = 273,                  /* T_This  */
+    T_Interface = 274,             /* T_Interface  */
+    T_Implements = 275,            /* T_Implements  */
+    T_While = 276,                 /* T_While  */
+    T_For = 277,                   /* T_For  */
+    T_If = 278,                    /* T_If  */
+    T_Else = 279,                  /* T_Else  */
+    T_Return = 280,                /* T_Return  */
+    T_Break = 281,                 /* T_Break  */
+    T_New = 282,                   /* T_New  */
+    T_NewArray = 283,              /* T_NewArray  */
+    T_Print = 284,                 /* T_Print  */
+    T_ReadInteger = 285,           /* T_ReadInteger  */
+    T_ReadLine = 286,              /* T_ReadLine  */
+    T_Increment = 287,             /* T_Increment  */
+    T_Decrement = 288,             /* T_Decrement  */
+    T_Switch = 289,                /* T_Switch  */
+    T_Case = 290,                  /* T_Case  */
+    T_Default = 291,               /* T_Default  */
+    T_Identifier = 292,            /* T_Identifier  */
+    T_StringConstant = 293,        /* T_StringConstant  */
+    T_IntConstant = 294,           /* T_IntConstant  */
+    T_DoubleConstant = 295,        /* T_DoubleConstant  */
+    T_BoolConstant = 296,          /* T_BoolConstant  */
+    ELSECHECK = 297                /* ELSECHECK  */
   };
+  typedef enum yytokentype yytoken_kind_t;
 #endif
-/* Tokens.  */
+/* Token kinds.  */
+#define YYEMPTY -2
+#define YYEOF 0
+#define YYerror 256
+#define YYUNDEF 257
 #define T_Void 258
 #define T_Bool 259
 #define T_Int 260
@@ -199,10 +260,9 @@ extern int yydebug;
 
 /* Value type.  */
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
-typedef union YYSTYPE YYSTYPE;
 union YYSTYPE
 {
-#line 41 "parser.y" /* yacc.c:355  */
+#line 83 "parser.y"
 
     int integerConstant;
     bool boolConstant;
@@ -242,8 +302,10 @@ union YYSTYPE
 	CaseStmt *cast;
 	Default *deft;
 
-#line 246 "y.tab.c" /* yacc.c:355  */
+#line 306 "y.tab.c"
+
 };
+typedef union YYSTYPE YYSTYPE;
 # define YYSTYPE_IS_TRIVIAL 1
 # define YYSTYPE_IS_DECLARED 1
 #endif
@@ -265,40 +327,216 @@ struct YYLTYPE
 
 extern YYSTYPE yylval;
 extern YYLTYPE yylloc;
+
 int yyparse (void);
 
+
 #endif /* !YY_YY_Y_TAB_H_INCLUDED  */
+/* Symbol kind.  */
+enum yysymbol_kind_t
+{
+  YYSYMBOL_YYEMPTY = -2,
+  YYSYMBOL_YYEOF = 0,                      /* "end of file"  */
+  YYSYMBOL_YYerror = 1,                    /* error  */
+  YYSYMBOL_YYUNDEF = 2,                    /* "invalid token"  */
+  YYSYMBOL_T_Void = 3,                     /* T_Void  */
+  YYSYMBOL_T_Bool = 4,                     /* T_Bool  */
+  YYSYMBOL_T_Int = 5,                      /* T_Int  */
+  YYSYMBOL_T_Double = 6,                   /* T_Double  */
+  YYSYMBOL_T_String = 7,                   /* T_String  */
+  YYSYMBOL_T_Class = 8,                    /* T_Class  */
+  YYSYMBOL_T_LessEqual = 9,                /* T_LessEqual  */
+  YYSYMBOL_T_GreaterEqual = 10,            /* T_GreaterEqual  */
+  YYSYMBOL_T_Equal = 11,                   /* T_Equal  */
+  YYSYMBOL_T_NotEqual = 12,                /* T_NotEqual  */
+  YYSYMBOL_T_Dims = 13,                    /* T_Dims  */
+  YYSYMBOL_T_And = 14,                     /* T_And  */
+  YYSYMBOL_T_Or = 15,                      /* T_Or  */
+  YYSYMBOL_T_Null = 16,                    /* T_Null  */
+  YYSYMBOL_T_Extends = 17,                 /* T_Extends  */
+  YYSYMBOL_T_This = 18,                    /* T_This  */
+  YYSYMBOL_T_Interface = 19,               /* T_Interface  */
+  YYSYMBOL_T_Implements = 20,              /* T_Implements  */
+  YYSYMBOL_T_While = 21,                   /* T_While  */
+  YYSYMBOL_T_For = 22,                     /* T_For  */
+  YYSYMBOL_T_If = 23,                      /* T_If  */
+  YYSYMBOL_T_Else = 24,                    /* T_Else  */
+  YYSYMBOL_T_Return = 25,                  /* T_Return  */
+  YYSYMBOL_T_Break = 26,                   /* T_Break  */
+  YYSYMBOL_T_New = 27,                     /* T_New  */
+  YYSYMBOL_T_NewArray = 28,                /* T_NewArray  */
+  YYSYMBOL_T_Print = 29,                   /* T_Print  */
+  YYSYMBOL_T_ReadInteger = 30,             /* T_ReadInteger  */
+  YYSYMBOL_T_ReadLine = 31,                /* T_ReadLine  */
+  YYSYMBOL_T_Increment = 32,               /* T_Increment  */
+  YYSYMBOL_T_Decrement = 33,               /* T_Decrement  */
+  YYSYMBOL_T_Switch = 34,                  /* T_Switch  */
+  YYSYMBOL_T_Case = 35,                    /* T_Case  */
+  YYSYMBOL_T_Default = 36,                 /* T_Default  */
+  YYSYMBOL_T_Identifier = 37,              /* T_Identifier  */
+  YYSYMBOL_T_StringConstant = 38,          /* T_StringConstant  */
+  YYSYMBOL_T_IntConstant = 39,             /* T_IntConstant  */
+  YYSYMBOL_T_DoubleConstant = 40,          /* T_DoubleConstant  */
+  YYSYMBOL_T_BoolConstant = 41,            /* T_BoolConstant  */
+  YYSYMBOL_42_ = 42,                       /* '='  */
+  YYSYMBOL_43_ = 43,                       /* '.'  */
+  YYSYMBOL_44_ = 44,                       /* '['  */
+  YYSYMBOL_45_ = 45,                       /* '!'  */
+  YYSYMBOL_46_ = 46,                       /* '{'  */
+  YYSYMBOL_47_ = 47,                       /* '<'  */
+  YYSYMBOL_48_ = 48,                       /* '>'  */
+  YYSYMBOL_49_ = 49,                       /* '+'  */
+  YYSYMBOL_50_ = 50,                       /* '-'  */
+  YYSYMBOL_51_ = 51,                       /* '*'  */
+  YYSYMBOL_52_ = 52,                       /* '/'  */
+  YYSYMBOL_53_ = 53,                       /* '%'  */
+  YYSYMBOL_ELSECHECK = 54,                 /* ELSECHECK  */
+  YYSYMBOL_55_ = 55,                       /* ';'  */
+  YYSYMBOL_56_ = 56,                       /* '('  */
+  YYSYMBOL_57_ = 57,                       /* ')'  */
+  YYSYMBOL_58_ = 58,                       /* ','  */
+  YYSYMBOL_59_ = 59,                       /* '}'  */
+  YYSYMBOL_60_ = 60,                       /* ':'  */
+  YYSYMBOL_61_ = 61,                       /* ']'  */
+  YYSYMBOL_YYACCEPT = 62,                  /* $accept  */
+  YYSYMBOL_Program = 63,                   /* Program  */
+  YYSYMBOL_DeclList = 64,                  /* DeclList  */
+  YYSYMBOL_Decl = 65,                      /* Decl  */
+  YYSYMBOL_VarDecl = 66,                   /* VarDecl  */
+  YYSYMBOL_Variable = 67,                  /* Variable  */
+  YYSYMBOL_Type = 68,                      /* Type  */
+  YYSYMBOL_FnDecl = 69,                    /* FnDecl  */
+  YYSYMBOL_FnHeader = 70,                  /* FnHeader  */
+  YYSYMBOL_Formals = 71,                   /* Formals  */
+  YYSYMBOL_FormalList = 72,                /* FormalList  */
+  YYSYMBOL_ClassDecl = 73,                 /* ClassDecl  */
+  YYSYMBOL_ExtendsClause = 74,             /* ExtendsClause  */
+  YYSYMBOL_ImplementBlock = 75,            /* ImplementBlock  */
+  YYSYMBOL_IdentifierList = 76,            /* IdentifierList  */
+  YYSYMBOL_FieldList = 77,                 /* FieldList  */
+  YYSYMBOL_Field = 78,                     /* Field  */
+  YYSYMBOL_InterfaceDecl = 79,             /* InterfaceDecl  */
+  YYSYMBOL_PrototypeList = 80,             /* PrototypeList  */
+  YYSYMBOL_StmtBlock = 81,                 /* StmtBlock  */
+  YYSYMBOL_VarDecls = 82,                  /* VarDecls  */
+  YYSYMBOL_StmtList = 83,                  /* StmtList  */
+  YYSYMBOL_Stmt = 84,                      /* Stmt  */
+  YYSYMBOL_OptionalExpr = 85,              /* OptionalExpr  */
+  YYSYMBOL_IfStmt = 86,                    /* IfStmt  */
+  YYSYMBOL_ElseStmt = 87,                  /* ElseStmt  */
+  YYSYMBOL_WhileStmt = 88,                 /* WhileStmt  */
+  YYSYMBOL_ForStmt = 89,                   /* ForStmt  */
+  YYSYMBOL_ReturnStmt = 90,                /* ReturnStmt  */
+  YYSYMBOL_BreakStmt = 91,                 /* BreakStmt  */
+  YYSYMBOL_PrintStmt = 92,                 /* PrintStmt  */
+  YYSYMBOL_SwitchStmt = 93,                /* SwitchStmt  */
+  YYSYMBOL_SwitchBlock = 94,               /* SwitchBlock  */
+  YYSYMBOL_CaseBlock = 95,                 /* CaseBlock  */
+  YYSYMBOL_CaseStmt = 96,                  /* CaseStmt  */
+  YYSYMBOL_Default = 97,                   /* Default  */
+  YYSYMBOL_ExprList = 98,                  /* ExprList  */
+  YYSYMBOL_Expr = 99,                      /* Expr  */
+  YYSYMBOL_PostfixExpr = 100,              /* PostfixExpr  */
+  YYSYMBOL_AssignExpr = 101,               /* AssignExpr  */
+  YYSYMBOL_ArithmeticExpr = 102,           /* ArithmeticExpr  */
+  YYSYMBOL_RelationalExpr = 103,           /* RelationalExpr  */
+  YYSYMBOL_LogicalExpr = 104,              /* LogicalExpr  */
+  YYSYMBOL_EqualityExpr = 105,             /* EqualityExpr  */
+  YYSYMBOL_LValue = 106,                   /* LValue  */
+  YYSYMBOL_Call = 107,                     /* Call  */
+  YYSYMBOL_Actuals = 108,                  /* Actuals  */
+  YYSYMBOL_Constant = 109                  /* Constant  */
+};
+typedef enum yysymbol_kind_t yysymbol_kind_t;
+
 
-/* Copy the second part of user declarations.  */
 
-#line 275 "y.tab.c" /* yacc.c:358  */
 
 #ifdef short
 # undef short
 #endif
 
-#ifdef YYTYPE_UINT8
-typedef YYTYPE_UINT8 yytype_uint8;
-#else
-typedef unsigned char yytype_uint8;
+/* On compilers that do not define __PTRDIFF_MAX__ etc., make sure
+   <limits.h> and (if available) <stdint.h> are included
+   so that the code can choose integer types of a good width.  */
+
+#ifndef __PTRDIFF_MAX__
+# include <limits.h> /* INFRINGES ON USER NAME SPACE */
+# if defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
+#  include <stdint.h> /* INFRINGES ON USER NAME SPACE */
+#  define YY_STDINT_H
+# endif
 #endif
 
-#ifdef YYTYPE_INT8
-typedef YYTYPE_INT8 yytype_int8;
+/* Narrow types that promote to a signed type and that can represent a
+   signed or unsigned integer of at least N bits.  In tables they can
+   save space and decrease cache pressure.  Promoting to a signed type
+   helps avoid bugs in integer arithmetic.  */
+
+#ifdef __INT_LEAST8_MAX__
+typedef __INT_LEAST8_TYPE__ yytype_int8;
+#elif defined YY_STDINT_H
+typedef int_least8_t yytype_int8;
 #else
 typedef signed char yytype_int8;
 #endif
 
-#ifdef YYTYPE_UINT16
-typedef YYTYPE_UINT16 yytype_uint16;
+#ifdef __INT_LEAST16_MAX__
+typedef __INT_LEAST16_TYPE__ yytype_int16;
+#elif defined YY_STDINT_H
+typedef int_least16_t yytype_int16;
+#else
+typedef short yytype_int16;
+#endif
+
+/* Work around bug in HP-UX 11.23, which defines these macros
+   incorrectly for preprocessor constants.  This workaround can likely
+   be removed in 2023, as HPE has promised support for HP-UX 11.23
+   (aka HP-UX 11i v2) only through the end of 2022; see Table 2 of
+   <https://h20195.www2.hpe.com/V2/getpdf.aspx/4AA4-7673ENW.pdf>.  */
+#ifdef __hpux
+# undef UINT_LEAST8_MAX
+# undef UINT_LEAST16_MAX
+# define UINT_LEAST8_MAX 255
+# define UINT_LEAST16_MAX 65535
+#endif
+
+#if defined __UINT_LEAST8_MAX__ && __UINT_LEAST8_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST8_TYPE__ yytype_uint8;
+#elif (!defined __UINT_LEAST8_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST8_MAX <= INT_MAX)
+typedef uint_least8_t yytype_uint8;
+#elif !defined __UINT_LEAST8_MAX__ && UCHAR_MAX <= INT_MAX
+typedef unsigned char yytype_uint8;
 #else
-typedef unsigned short int yytype_uint16;
+typedef short yytype_uint8;
 #endif
 
-#ifdef YYTYPE_INT16
-typedef YYTYPE_INT16 yytype_int16;
+#if defined __UINT_LEAST16_MAX__ && __UINT_LEAST16_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST16_TYPE__ yytype_uint16;
+#elif (!defined __UINT_LEAST16_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST16_MAX <= INT_MAX)
+typedef uint_least16_t yytype_uint16;
+#elif !defined __UINT_LEAST16_MAX__ && USHRT_MAX <= INT_MAX
+typedef unsigned short yytype_uint16;
 #else
-typedef short int yytype_int16;
+typedef int yytype_uint16;
+#endif
+
+#ifndef YYPTRDIFF_T
+# if defined __PTRDIFF_TYPE__ && defined __PTRDIFF_MAX__
+#  define YYPTRDIFF_T __PTRDIFF_TYPE__
+#  define YYPTRDIFF_MAXIMUM __PTRDIFF_MAX__
+# elif defined PTRDIFF_MAX
+#  ifndef ptrdiff_t
+#   include <stddef.h> /* INFRINGES ON USER NAME SPACE */
+#  endif
+#  define YYPTRDIFF_T ptrdiff_t
+#  define YYPTRDIFF_MAXIMUM PTRDIFF_MAX
+# else
+#  define YYPTRDIFF_T long
+#  define YYPTRDIFF_MAXIMUM LONG_MAX
+# endif
 #endif
 
 #ifndef YYSIZE_T
@@ -306,15 +544,28 @@ typedef short int yytype_int16;
 #  define YYSIZE_T __SIZE_TYPE__
 # elif defined size_t
 #  define YYSIZE_T size_t
-# elif ! defined YYSIZE_T
+# elif defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
 #  include <stddef.h> /* INFRINGES ON USER NAME SPACE */
 #  define YYSIZE_T size_t
 # else
-#  define YYSIZE_T unsigned int
+#  define YYSIZE_T unsigned
 # endif
 #endif
 
-#define YYSIZE_MAXIMUM ((YYSIZE_T) -1)
+#define YYSIZE_MAXIMUM                                  \
+  YY_CAST (YYPTRDIFF_T,                                 \
+           (YYPTRDIFF_MAXIMUM < YY_CAST (YYSIZE_T, -1)  \
+            ? YYPTRDIFF_MAXIMUM                         \
+            : YY_CAST (YYSIZE_T, -1)))
+
+#define YYSIZEOF(X) YY_CAST (YYPTRDIFF_T, sizeof (X))
+
+
+/* Stored state numbers (used for stacks). */
+typedef yytype_uint8 yy_state_t;
+
+/* State numbers in computations.  */
+typedef int yy_state_fast_t;
 
 #ifndef YY_
 # if defined YYENABLE_NLS && YYENABLE_NLS
@@ -328,47 +579,43 @@ typedef short int yytype_int16;
 # endif
 #endif
 
-#ifndef YY_ATTRIBUTE
-# if (defined __GNUC__                                               \
-      && (2 < __GNUC__ || (__GNUC__ == 2 && 96 <= __GNUC_MINOR__)))  \
-     || defined __SUNPRO_C && 0x5110 <= __SUNPRO_C
-#  define YY_ATTRIBUTE(Spec) __attribute__(Spec)
-# else
-#  define YY_ATTRIBUTE(Spec) /* empty */
-# endif
-#endif
 
 #ifndef YY_ATTRIBUTE_PURE
-# define YY_ATTRIBUTE_PURE   YY_ATTRIBUTE ((__pure__))
+# if defined __GNUC__ && 2 < __GNUC__ + (96 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_PURE __attribute__ ((__pure__))
+# else
+#  define YY_ATTRIBUTE_PURE
+# endif
 #endif
 
 #ifndef YY_ATTRIBUTE_UNUSED
-# define YY_ATTRIBUTE_UNUSED YY_ATTRIBUTE ((__unused__))
-#endif
-
-#if !defined _Noreturn \
-     && (!defined __STDC_VERSION__ || __STDC_VERSION__ < 201112)
-# if defined _MSC_VER && 1200 <= _MSC_VER
-#  define _Noreturn __declspec (noreturn)
+# if defined __GNUC__ && 2 < __GNUC__ + (7 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_UNUSED __attribute__ ((__unused__))
 # else
-#  define _Noreturn YY_ATTRIBUTE ((__noreturn__))
+#  define YY_ATTRIBUTE_UNUSED
 # endif
 #endif
 
 /* Suppress unused-variable warnings by "using" E.  */
 #if ! defined lint || defined __GNUC__
-# define YYUSE(E) ((void) (E))
+# define YY_USE(E) ((void) (E))
 #else
-# define YYUSE(E) /* empty */
+# define YY_USE(E) /* empty */
 #endif
 
-#if defined __GNUC__ && 407 <= __GNUC__ * 100 + __GNUC_MINOR__
 /* Suppress an incorrect diagnostic about yylval being uninitialized.  */
-# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN \
-    _Pragma ("GCC diagnostic push") \
-    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")\
+#if defined __GNUC__ && ! defined __ICC && 406 <= __GNUC__ * 100 + __GNUC_MINOR__
+# if __GNUC__ * 100 + __GNUC_MINOR__ < 407
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")
+# else
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")              \
     _Pragma ("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
-# define YY_IGNORE_MAYBE_UNINITIALIZED_END \
+# endif
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END      \
     _Pragma ("GCC diagnostic pop")
 #else
 # define YY_INITIAL_VALUE(Value) Value
@@ -381,8 +628,22 @@ typedef short int yytype_int16;
 # define YY_INITIAL_VALUE(Value) /* Nothing. */
 #endif
 
+#if defined __cplusplus && defined __GNUC__ && ! defined __ICC && 6 <= __GNUC__
+# define YY_IGNORE_USELESS_CAST_BEGIN                          \
+    _Pragma ("GCC diagnostic push")                            \
+    _Pragma ("GCC diagnostic ignored \"-Wuseless-cast\"")
+# define YY_IGNORE_USELESS_CAST_END            \
+    _Pragma ("GCC diagnostic pop")
+#endif
+#ifndef YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_END
+#endif
 
-#if ! defined yyoverflow || YYERROR_VERBOSE
+
+#define YY_ASSERT(E) ((void) (0 && (E)))
+
+#if !defined yyoverflow
 
 /* The parser invokes alloca or malloc; define the necessary symbols.  */
 
@@ -447,8 +708,7 @@ void free (void *); /* INFRINGES ON USER NAME SPACE */
 #   endif
 #  endif
 # endif
-#endif /* ! defined yyoverflow || YYERROR_VERBOSE */
-
+#endif /* !defined yyoverflow */
 
 #if (! defined yyoverflow \
      && (! defined __cplusplus \
@@ -458,18 +718,19 @@ void free (void *); /* INFRINGES ON USER NAME SPACE */
 /* A type that is properly aligned for any stack member.  */
 union yyalloc
 {
-  yytype_int16 yyss_alloc;
+  yy_state_t yyss_alloc;
   YYSTYPE yyvs_alloc;
   YYLTYPE yyls_alloc;
 };
 
 /* The size of the maximum gap between one aligned stack and the next.  */
-# define YYSTACK_GAP_MAXIMUM (sizeof (union yyalloc) - 1)
+# define YYSTACK_GAP_MAXIMUM (YYSIZEOF (union yyalloc) - 1)
 
 /* The size of an array large to enough to hold all stacks, each with
    N elements.  */
 # define YYSTACK_BYTES(N) \
-     ((N) * (sizeof (yytype_int16) + sizeof (YYSTYPE) + sizeof (YYLTYPE)) \
+     ((N) * (YYSIZEOF (yy_state_t) + YYSIZEOF (YYSTYPE) \
+             + YYSIZEOF (YYLTYPE)) \
       + 2 * YYSTACK_GAP_MAXIMUM)
 
 # define YYCOPY_NEEDED 1
@@ -482,11 +743,11 @@ union yyalloc
 # define YYSTACK_RELOCATE(Stack_alloc, Stack)                           \
     do                                                                  \
       {                                                                 \
-        YYSIZE_T yynewbytes;                                            \
+        YYPTRDIFF_T yynewbytes;                                         \
         YYCOPY (&yyptr->Stack_alloc, Stack, yysize);                    \
         Stack = &yyptr->Stack_alloc;                                    \
-        yynewbytes = yystacksize * sizeof (*Stack) + YYSTACK_GAP_MAXIMUM; \
-        yyptr += yynewbytes / sizeof (*yyptr);                          \
+        yynewbytes = yystacksize * YYSIZEOF (*Stack) + YYSTACK_GAP_MAXIMUM; \
+        yyptr += yynewbytes / YYSIZEOF (*yyptr);                        \
       }                                                                 \
     while (0)
 
@@ -498,12 +759,12 @@ union yyalloc
 # ifndef YYCOPY
 #  if defined __GNUC__ && 1 < __GNUC__
 #   define YYCOPY(Dst, Src, Count) \
-      __builtin_memcpy (Dst, Src, (Count) * sizeof (*(Src)))
+      __builtin_memcpy (Dst, Src, YY_CAST (YYSIZE_T, (Count)) * sizeof (*(Src)))
 #  else
 #   define YYCOPY(Dst, Src, Count)              \
       do                                        \
         {                                       \
-          YYSIZE_T yyi;                         \
+          YYPTRDIFF_T yyi;                      \
           for (yyi = 0; yyi < (Count); yyi++)   \
             (Dst)[yyi] = (Src)[yyi];            \
         }                                       \
@@ -526,17 +787,20 @@ union yyalloc
 /* YYNSTATES -- Number of states.  */
 #define YYNSTATES  215
 
-/* YYTRANSLATE[YYX] -- Symbol number corresponding to YYX as returned
-   by yylex, with out-of-bounds checking.  */
-#define YYUNDEFTOK  2
+/* YYMAXUTOK -- Last valid token kind.  */
 #define YYMAXUTOK   297
 
-#define YYTRANSLATE(YYX)                                                \
-  ((unsigned int) (YYX) <= YYMAXUTOK ? yytranslate[YYX] : YYUNDEFTOK)
+
+/* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex, with out-of-bounds checking.  */
+#define YYTRANSLATE(YYX)                                \
+  (0 <= (YYX) && (YYX) <= YYMAXUTOK                     \
+   ? YY_CAST (yysymbol_kind_t, yytranslate[YYX])        \
+   : YYSYMBOL_YYUNDEF)
 
 /* YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to TOKEN-NUM
-   as returned by yylex, without out-of-bounds checking.  */
-static const yytype_uint8 yytranslate[] =
+   as returned by yylex.  */
+static const yytype_int8 yytranslate[] =
 {
        0,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
@@ -571,78 +835,77 @@ static const yytype_uint8 yytranslate[] =
 };
 
 #if YYDEBUG
-  /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
-static const yytype_uint16 yyrline[] =
+/* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
+static const yytype_int16 yyrline[] =
 {
-       0,   157,   157,   169,   170,   172,   173,   174,   175,   178,
-     181,   185,   186,   187,   188,   189,   190,   193,   196,   198,
-     202,   203,   206,   208,   211,   215,   216,   219,   220,   223,
-     225,   228,   229,   232,   233,   236,   240,   241,   244,   248,
-     249,   252,   253,   256,   257,   258,   259,   260,   261,   262,
-     263,   264,   267,   268,   271,   272,   275,   278,   281,   285,
-     288,   291,   294,   298,   299,   302,   303,   306,   309,   312,
-     313,   316,   317,   318,   319,   320,   321,   322,   323,   324,
-     325,   326,   327,   328,   329,   330,   333,   334,   337,   340,
-     341,   342,   343,   344,   345,   348,   349,   350,   351,   354,
-     355,   356,   359,   360,   363,   364,   365,   368,   369,   372,
-     373,   376,   377,   378,   379,   380
+       0,   199,   199,   211,   212,   214,   215,   216,   217,   220,
+     223,   227,   228,   229,   230,   231,   232,   235,   238,   240,
+     244,   245,   248,   250,   253,   257,   258,   261,   262,   265,
+     267,   270,   271,   274,   275,   278,   282,   283,   286,   290,
+     291,   294,   295,   298,   299,   300,   301,   302,   303,   304,
+     305,   306,   309,   310,   313,   314,   317,   320,   323,   327,
+     330,   333,   336,   340,   341,   344,   345,   348,   351,   354,
+     355,   358,   359,   360,   361,   362,   363,   364,   365,   366,
+     367,   368,   369,   370,   371,   372,   375,   376,   379,   382,
+     383,   384,   385,   386,   387,   390,   391,   392,   393,   396,
+     397,   398,   401,   402,   405,   406,   407,   410,   411,   414,
+     415,   418,   419,   420,   421,   422
 };
 #endif
 
-#if YYDEBUG || YYERROR_VERBOSE || 0
+/** Accessing symbol of state STATE.  */
+#define YY_ACCESSING_SYMBOL(State) YY_CAST (yysymbol_kind_t, yystos[State])
+
+#if YYDEBUG || 0
+/* The user-facing name of the symbol whose (internal) number is
+   YYSYMBOL.  No bounds checking.  */
+static const char *yysymbol_name (yysymbol_kind_t yysymbol) YY_ATTRIBUTE_UNUSED;
+
 /* YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
    First, the terminals, then, starting at YYNTOKENS, nonterminals.  */
 static const char *const yytname[] =
 {
-  "$end", "error", "$undefined", "T_Void", "T_Bool", "T_Int", "T_Double",
-  "T_String", "T_Class", "T_LessEqual", "T_GreaterEqual", "T_Equal",
-  "T_NotEqual", "T_Dims", "T_And", "T_Or", "T_Null", "T_Extends", "T_This",
-  "T_Interface", "T_Implements", "T_While", "T_For", "T_If", "T_Else",
-  "T_Return", "T_Break", "T_New", "T_NewArray", "T_Print", "T_ReadInteger",
-  "T_ReadLine", "T_Increment", "T_Decrement", "T_Switch", "T_Case",
-  "T_Default", "T_Identifier", "T_StringConstant", "T_IntConstant",
-  "T_DoubleConstant", "T_BoolConstant", "'='", "'.'", "'['", "'!'", "'{'",
-  "'<'", "'>'", "'+'", "'-'", "'*'", "'/'", "'%'", "ELSECHECK", "';'",
-  "'('", "')'", "','", "'}'", "':'", "']'", "$accept", "Program",
-  "DeclList", "Decl", "VarDecl", "Variable", "Type", "FnDecl", "FnHeader",
-  "Formals", "FormalList", "ClassDecl", "ExtendsClause", "ImplementBlock",
-  "IdentifierList", "FieldList", "Field", "InterfaceDecl", "PrototypeList",
-  "StmtBlock", "VarDecls", "StmtList", "Stmt", "OptionalExpr", "IfStmt",
-  "ElseStmt", "WhileStmt", "ForStmt", "ReturnStmt", "BreakStmt",
-  "PrintStmt", "SwitchStmt", "SwitchBlock", "CaseBlock", "CaseStmt",
-  "Default", "ExprList", "Expr", "PostfixExpr", "AssignExpr",
-  "ArithmeticExpr", "RelationalExpr", "LogicalExpr", "EqualityExpr",
-  "LValue", "Call", "Actuals", "Constant", YY_NULLPTR
+  "\"end of file\"", "error", "\"invalid token\"", "T_Void", "T_Bool",
+  "T_Int", "T_Double", "T_String", "T_Class", "T_LessEqual",
+  "T_GreaterEqual", "T_Equal", "T_NotEqual", "T_Dims", "T_And", "T_Or",
+  "T_Null", "T_Extends", "T_This", "T_Interface", "T_Implements",
+  "T_While", "T_For", "T_If", "T_Else", "T_Return", "T_Break", "T_New",
+  "T_NewArray", "T_Print", "T_ReadInteger", "T_ReadLine", "T_Increment",
+  "T_Decrement", "T_Switch", "T_Case", "T_Default", "T_Identifier",
+  "T_StringConstant", "T_IntConstant", "T_DoubleConstant",
+  "T_BoolConstant", "'='", "'.'", "'['", "'!'", "'{'", "'<'", "'>'", "'+'",
+  "'-'", "'*'", "'/'", "'%'", "ELSECHECK", "';'", "'('", "')'", "','",
+  "'}'", "':'", "']'", "$accept", "Program", "DeclList", "Decl", "VarDecl",
+  "Variable", "Type", "FnDecl", "FnHeader", "Formals", "FormalList",
+  "ClassDecl", "ExtendsClause", "ImplementBlock", "IdentifierList",
+  "FieldList", "Field", "InterfaceDecl", "PrototypeList", "StmtBlock",
+  "VarDecls", "StmtList", "Stmt", "OptionalExpr", "IfStmt", "ElseStmt",
+  "WhileStmt", "ForStmt", "ReturnStmt", "BreakStmt", "PrintStmt",
+  "SwitchStmt", "SwitchBlock", "CaseBlock", "CaseStmt", "Default",
+  "ExprList", "Expr", "PostfixExpr", "AssignExpr", "ArithmeticExpr",
+  "RelationalExpr", "LogicalExpr", "EqualityExpr", "LValue", "Call",
+  "Actuals", "Constant", YY_NULLPTR
 };
-#endif
 
-# ifdef YYPRINT
-/* YYTOKNUM[NUM] -- (External) token number corresponding to the
-   (internal) symbol number NUM (which must be that of a token).  */
-static const yytype_uint16 yytoknum[] =
+static const char *
+yysymbol_name (yysymbol_kind_t yysymbol)
 {
-       0,   256,   257,   258,   259,   260,   261,   262,   263,   264,
-     265,   266,   267,   268,   269,   270,   271,   272,   273,   274,
-     275,   276,   277,   278,   279,   280,   281,   282,   283,   284,
-     285,   286,   287,   288,   289,   290,   291,   292,   293,   294,
-     295,   296,    61,    46,    91,    33,   123,    60,    62,    43,
-      45,    42,    47,    37,   297,    59,    40,    41,    44,   125,
-      58,    93
-};
-# endif
+  return yytname[yysymbol];
+}
+#endif
 
-#define YYPACT_NINF -156
+#define YYPACT_NINF (-156)
 
-#define yypact_value_is_default(Yystate) \
-  (!!((Yystate) == (-156)))
+#define yypact_value_is_default(Yyn) \
+  ((Yyn) == YYPACT_NINF)
 
-#define YYTABLE_NINF -54
+#define YYTABLE_NINF (-54)
 
-#define yytable_value_is_error(Yytable_value) \
+#define yytable_value_is_error(Yyn) \
   0
 
-  /* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
-     STATE-NUM.  */
+/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
+   STATE-NUM.  */
 static const yytype_int16 yypact[] =
 {
       79,   -28,  -156,  -156,  -156,  -156,    -9,    -7,  -156,    17,
@@ -669,10 +932,10 @@ static const yytype_int16 yypact[] =
      410,   410,  -156,  -156,  -156
 };
 
-  /* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
-     Performed when YYTABLE does not specify something else to do.  Zero
-     means the default is an error.  */
-static const yytype_uint8 yydefact[] =
+/* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
+   Performed when YYTABLE does not specify something else to do.  Zero
+   means the default is an error.  */
+static const yytype_int8 yydefact[] =
 {
        0,     0,    12,    11,    14,    13,     0,     0,    15,     0,
        2,     4,     5,     0,     0,     6,     0,     7,     8,     0,
@@ -698,7 +961,7 @@ static const yytype_uint8 yydefact[] =
       42,    42,    58,    67,    68
 };
 
-  /* YYPGOTO[NTERM-NUM].  */
+/* YYPGOTO[NTERM-NUM].  */
 static const yytype_int16 yypgoto[] =
 {
     -156,  -156,  -156,   213,   -32,   -11,     0,   105,   207,   217,
@@ -708,19 +971,19 @@ static const yytype_int16 yypgoto[] =
     -156,  -156,  -156,  -156,  -156,  -156,    77,  -156
 };
 
-  /* YYDEFGOTO[NTERM-NUM].  */
-static const yytype_int16 yydefgoto[] =
+/* YYDEFGOTO[NTERM-NUM].  */
+static const yytype_uint8 yydefgoto[] =
 {
-      -1,     9,    10,    11,    12,    13,    36,    15,    16,    37,
+       0,     9,    10,    11,    12,    13,    36,    15,    16,    37,
       38,    17,    31,    41,    91,   136,   173,    18,    42,    66,
       34,    67,    68,    69,    70,   195,    71,    72,    73,    74,
       75,    76,   198,   199,   200,   208,   150,    77,    78,    79,
       80,    81,    82,    83,    84,    85,   151,    86
 };
 
-  /* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
-     positive, shift that token.  If negative, reduce the rule whose
-     number is the opposite.  If YYTABLE_NINF, syntax error.  */
+/* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
+   positive, shift that token.  If negative, reduce the rule whose
+   number is the opposite.  If YYTABLE_NINF, syntax error.  */
 static const yytype_int16 yytable[] =
 {
       14,   101,    65,    25,   114,    25,   110,   111,   112,    19,
@@ -831,9 +1094,9 @@ static const yytype_int16 yycheck[] =
       -1,    -1,    56
 };
 
-  /* YYSTOS[STATE-NUM] -- The (internal number of the) accessing
-     symbol of state STATE-NUM.  */
-static const yytype_uint8 yystos[] =
+/* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
+   state STATE-NUM.  */
+static const yytype_int8 yystos[] =
 {
        0,     3,     4,     5,     6,     7,     8,    19,    37,    63,
       64,    65,    66,    67,    68,    69,    70,    73,    79,    37,
@@ -859,8 +1122,8 @@ static const yytype_uint8 yystos[] =
       60,    60,    84,    83,    83
 };
 
-  /* YYR1[YYN] -- Symbol number of symbol that rule YYN derives.  */
-static const yytype_uint8 yyr1[] =
+/* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr1[] =
 {
        0,    62,    63,    64,    64,    65,    65,    65,    65,    66,
       67,    68,    68,    68,    68,    68,    68,    69,    70,    70,
@@ -876,8 +1139,8 @@ static const yytype_uint8 yyr1[] =
      108,   109,   109,   109,   109,   109
 };
 
-  /* YYR2[YYN] -- Number of symbols on the right hand side of rule YYN.  */
-static const yytype_uint8 yyr2[] =
+/* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr2[] =
 {
        0,     2,     1,     2,     1,     1,     1,     1,     1,     2,
        2,     1,     1,     1,     1,     1,     2,     2,     5,     5,
@@ -894,39 +1157,39 @@ static const yytype_uint8 yyr2[] =
 };
 
 
+enum { YYENOMEM = -2 };
+
 #define yyerrok         (yyerrstatus = 0)
 #define yyclearin       (yychar = YYEMPTY)
-#define YYEMPTY         (-2)
-#define YYEOF           0
 
 #define YYACCEPT        goto yyacceptlab
 #define YYABORT         goto yyabortlab
 #define YYERROR         goto yyerrorlab
+#define YYNOMEM         goto yyexhaustedlab
 
 
 #define YYRECOVERING()  (!!yyerrstatus)
 
-#define YYBACKUP(Token, Value)                                  \
-do                                                              \
-  if (yychar == YYEMPTY)                                        \
-    {                                                           \
-      yychar = (Token);                                         \
-      yylval = (Value);                                         \
-      YYPOPSTACK (yylen);                                       \
-      yystate = *yyssp;                                         \
-      goto yybackup;                                            \
-    }                                                           \
-  else                                                          \
-    {                                                           \
-      yyerror (YY_("syntax error: cannot back up")); \
-      YYERROR;                                                  \
-    }                                                           \
-while (0)
-
-/* Error token number */
-#define YYTERROR        1
-#define YYERRCODE       256
-
+#define YYBACKUP(Token, Value)                                    \
+  do                                                              \
+    if (yychar == YYEMPTY)                                        \
+      {                                                           \
+        yychar = (Token);                                         \
+        yylval = (Value);                                         \
+        YYPOPSTACK (yylen);                                       \
+        yystate = *yyssp;                                         \
+        goto yybackup;                                            \
+      }                                                           \
+    else                                                          \
+      {                                                           \
+        yyerror (YY_("syntax error: cannot back up")); \
+        YYERROR;                                                  \
+      }                                                           \
+  while (0)
+
+/* Backward compatibility with an undocumented macro.
+   Use YYerror or YYUNDEF. */
+#define YYERRCODE YYUNDEF
 
 /* YYLLOC_DEFAULT -- Set CURRENT to span from RHS[1] to RHS[N].
    If N is 0, then set CURRENT to the empty location which ends
@@ -970,20 +1233,27 @@ do {                                            \
 } while (0)
 
 
-/* YY_LOCATION_PRINT -- Print the location on the stream.
+/* YYLOCATION_PRINT -- Print the location on the stream.
    This macro was not mandated originally: define only if we know
    we won't break user code: when these are the locations we know.  */
 
-#ifndef YY_LOCATION_PRINT
-# if defined YYLTYPE_IS_TRIVIAL && YYLTYPE_IS_TRIVIAL
+# ifndef YYLOCATION_PRINT
+
+#  if defined YY_LOCATION_PRINT
+
+   /* Temporary convenience wrapper in case some people defined the
+      undocumented and private YY_LOCATION_PRINT macros.  */
+#   define YYLOCATION_PRINT(File, Loc)  YY_LOCATION_PRINT(File, *(Loc))
+
+#  elif defined YYLTYPE_IS_TRIVIAL && YYLTYPE_IS_TRIVIAL
 
 /* Print *YYLOCP on YYO.  Private, do not rely on its existence. */
 
 YY_ATTRIBUTE_UNUSED
-static unsigned
+static int
 yy_location_print_ (FILE *yyo, YYLTYPE const * const yylocp)
 {
-  unsigned res = 0;
+  int res = 0;
   int end_col = 0 != yylocp->last_column ? yylocp->last_column - 1 : 0;
   if (0 <= yylocp->first_line)
     {
@@ -1003,63 +1273,71 @@ yy_location_print_ (FILE *yyo, YYLTYPE const * const yylocp)
         res += YYFPRINTF (yyo, "-%d", end_col);
     }
   return res;
- }
+}
 
-#  define YY_LOCATION_PRINT(File, Loc)          \
-  yy_location_print_ (File, &(Loc))
+#   define YYLOCATION_PRINT  yy_location_print_
 
-# else
-#  define YY_LOCATION_PRINT(File, Loc) ((void) 0)
-# endif
-#endif
+    /* Temporary convenience wrapper in case some people defined the
+       undocumented and private YY_LOCATION_PRINT macros.  */
+#   define YY_LOCATION_PRINT(File, Loc)  YYLOCATION_PRINT(File, &(Loc))
+
+#  else
 
+#   define YYLOCATION_PRINT(File, Loc) ((void) 0)
+    /* Temporary convenience wrapper in case some people defined the
+       undocumented and private YY_LOCATION_PRINT macros.  */
+#   define YY_LOCATION_PRINT  YYLOCATION_PRINT
 
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)                    \
+#  endif
+# endif /* !defined YYLOCATION_PRINT */
+
+
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)                    \
 do {                                                                      \
   if (yydebug)                                                            \
     {                                                                     \
       YYFPRINTF (stderr, "%s ", Title);                                   \
       yy_symbol_print (stderr,                                            \
-                  Type, Value, Location); \
+                  Kind, Value, Location); \
       YYFPRINTF (stderr, "\n");                                           \
     }                                                                     \
 } while (0)
 
 
-/*----------------------------------------.
-| Print this symbol's value on YYOUTPUT.  |
-`----------------------------------------*/
+/*-----------------------------------.
+| Print this symbol's value on YYO.  |
+`-----------------------------------*/
 
 static void
-yy_symbol_value_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp)
+yy_symbol_value_print (FILE *yyo,
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp)
 {
-  FILE *yyo = yyoutput;
-  YYUSE (yyo);
-  YYUSE (yylocationp);
+  FILE *yyoutput = yyo;
+  YY_USE (yyoutput);
+  YY_USE (yylocationp);
   if (!yyvaluep)
     return;
-# ifdef YYPRINT
-  if (yytype < YYNTOKENS)
-    YYPRINT (yyoutput, yytoknum[yytype], *yyvaluep);
-# endif
-  YYUSE (yytype);
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  YY_USE (yykind);
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
 
-/*--------------------------------.
-| Print this symbol on YYOUTPUT.  |
-`--------------------------------*/
+/*---------------------------.
+| Print this symbol on YYO.  |
+`---------------------------*/
 
 static void
-yy_symbol_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp)
+yy_symbol_print (FILE *yyo,
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp)
 {
-  YYFPRINTF (yyoutput, "%s %s (",
-             yytype < YYNTOKENS ? "token" : "nterm", yytname[yytype]);
+  YYFPRINTF (yyo, "%s %s (",
+             yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
 
-  YY_LOCATION_PRINT (yyoutput, *yylocationp);
-  YYFPRINTF (yyoutput, ": ");
-  yy_symbol_value_print (yyoutput, yytype, yyvaluep, yylocationp);
-  YYFPRINTF (yyoutput, ")");
+  YYLOCATION_PRINT (yyo, yylocationp);
+  YYFPRINTF (yyo, ": ");
+  yy_symbol_value_print (yyo, yykind, yyvaluep, yylocationp);
+  YYFPRINTF (yyo, ")");
 }
 
 /*------------------------------------------------------------------.
@@ -1068,7 +1346,7 @@ yy_symbol_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, YYL
 `------------------------------------------------------------------*/
 
 static void
-yy_stack_print (yytype_int16 *yybottom, yytype_int16 *yytop)
+yy_stack_print (yy_state_t *yybottom, yy_state_t *yytop)
 {
   YYFPRINTF (stderr, "Stack now");
   for (; yybottom <= yytop; yybottom++)
@@ -1091,21 +1369,22 @@ do {                                                            \
 `------------------------------------------------*/
 
 static void
-yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp, int yyrule)
+yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp,
+                 int yyrule)
 {
-  unsigned long int yylno = yyrline[yyrule];
+  int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
   int yyi;
-  YYFPRINTF (stderr, "Reducing stack by rule %d (line %lu):\n",
+  YYFPRINTF (stderr, "Reducing stack by rule %d (line %d):\n",
              yyrule - 1, yylno);
   /* The symbols being reduced.  */
   for (yyi = 0; yyi < yynrhs; yyi++)
     {
       YYFPRINTF (stderr, "   $%d = ", yyi + 1);
       yy_symbol_print (stderr,
-                       yystos[yyssp[yyi + 1 - yynrhs]],
-                       &(yyvsp[(yyi + 1) - (yynrhs)])
-                       , &(yylsp[(yyi + 1) - (yynrhs)])                       );
+                       YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
+                       &yyvsp[(yyi + 1) - (yynrhs)],
+                       &(yylsp[(yyi + 1) - (yynrhs)]));
       YYFPRINTF (stderr, "\n");
     }
 }
@@ -1120,8 +1399,8 @@ do {                                    \
    multiple parsers can coexist.  */
 int yydebug;
 #else /* !YYDEBUG */
-# define YYDPRINTF(Args)
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)
+# define YYDPRINTF(Args) ((void) 0)
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)
 # define YY_STACK_PRINT(Bottom, Top)
 # define YY_REDUCE_PRINT(Rule)
 #endif /* !YYDEBUG */
@@ -1144,250 +1423,31 @@ int yydebug;
 #endif
 
 
-#if YYERROR_VERBOSE
 
-# ifndef yystrlen
-#  if defined __GLIBC__ && defined _STRING_H
-#   define yystrlen strlen
-#  else
-/* Return the length of YYSTR.  */
-static YYSIZE_T
-yystrlen (const char *yystr)
-{
-  YYSIZE_T yylen;
-  for (yylen = 0; yystr[yylen]; yylen++)
-    continue;
-  return yylen;
-}
-#  endif
-# endif
 
-# ifndef yystpcpy
-#  if defined __GLIBC__ && defined _STRING_H && defined _GNU_SOURCE
-#   define yystpcpy stpcpy
-#  else
-/* Copy YYSRC to YYDEST, returning the address of the terminating '\0' in
-   YYDEST.  */
-static char *
-yystpcpy (char *yydest, const char *yysrc)
-{
-  char *yyd = yydest;
-  const char *yys = yysrc;
 
-  while ((*yyd++ = *yys++) != '\0')
-    continue;
-
-  return yyd - 1;
-}
-#  endif
-# endif
-
-# ifndef yytnamerr
-/* Copy to YYRES the contents of YYSTR after stripping away unnecessary
-   quotes and backslashes, so that it's suitable for yyerror.  The
-   heuristic is that double-quoting is unnecessary unless the string
-   contains an apostrophe, a comma, or backslash (other than
-   backslash-backslash).  YYSTR is taken from yytname.  If YYRES is
-   null, do not copy; instead, return the length of what the result
-   would have been.  */
-static YYSIZE_T
-yytnamerr (char *yyres, const char *yystr)
-{
-  if (*yystr == '"')
-    {
-      YYSIZE_T yyn = 0;
-      char const *yyp = yystr;
-
-      for (;;)
-        switch (*++yyp)
-          {
-          case '\'':
-          case ',':
-            goto do_not_strip_quotes;
-
-          case '\\':
-            if (*++yyp != '\\')
-              goto do_not_strip_quotes;
-            /* Fall through.  */
-          default:
-            if (yyres)
-              yyres[yyn] = *yyp;
-            yyn++;
-            break;
-
-          case '"':
-            if (yyres)
-              yyres[yyn] = '\0';
-            return yyn;
-          }
-    do_not_strip_quotes: ;
-    }
-
-  if (! yyres)
-    return yystrlen (yystr);
-
-  return yystpcpy (yyres, yystr) - yyres;
-}
-# endif
-
-/* Copy into *YYMSG, which is of size *YYMSG_ALLOC, an error message
-   about the unexpected token YYTOKEN for the state stack whose top is
-   YYSSP.
-
-   Return 0 if *YYMSG was successfully written.  Return 1 if *YYMSG is
-   not large enough to hold the message.  In that case, also set
-   *YYMSG_ALLOC to the required number of bytes.  Return 2 if the
-   required number of bytes is too large to store.  */
-static int
-yysyntax_error (YYSIZE_T *yymsg_alloc, char **yymsg,
-                yytype_int16 *yyssp, int yytoken)
-{
-  YYSIZE_T yysize0 = yytnamerr (YY_NULLPTR, yytname[yytoken]);
-  YYSIZE_T yysize = yysize0;
-  enum { YYERROR_VERBOSE_ARGS_MAXIMUM = 5 };
-  /* Internationalized format string. */
-  const char *yyformat = YY_NULLPTR;
-  /* Arguments of yyformat. */
-  char const *yyarg[YYERROR_VERBOSE_ARGS_MAXIMUM];
-  /* Number of reported tokens (one for the "unexpected", one per
-     "expected"). */
-  int yycount = 0;
-
-  /* There are many possibilities here to consider:
-     - If this state is a consistent state with a default action, then
-       the only way this function was invoked is if the default action
-       is an error action.  In that case, don't check for expected
-       tokens because there are none.
-     - The only way there can be no lookahead present (in yychar) is if
-       this state is a consistent state with a default action.  Thus,
-       detecting the absence of a lookahead is sufficient to determine
-       that there is no unexpected or expected token to report.  In that
-       case, just report a simple "syntax error".
-     - Don't assume there isn't a lookahead just because this state is a
-       consistent state with a default action.  There might have been a
-       previous inconsistent state, consistent state with a non-default
-       action, or user semantic action that manipulated yychar.
-     - Of course, the expected token list depends on states to have
-       correct lookahead information, and it depends on the parser not
-       to perform extra reductions after fetching a lookahead from the
-       scanner and before detecting a syntax error.  Thus, state merging
-       (from LALR or IELR) and default reductions corrupt the expected
-       token list.  However, the list is correct for canonical LR with
-       one exception: it will still contain any token that will not be
-       accepted due to an error action in a later state.
-  */
-  if (yytoken != YYEMPTY)
-    {
-      int yyn = yypact[*yyssp];
-      yyarg[yycount++] = yytname[yytoken];
-      if (!yypact_value_is_default (yyn))
-        {
-          /* Start YYX at -YYN if negative to avoid negative indexes in
-             YYCHECK.  In other words, skip the first -YYN actions for
-             this state because they are default actions.  */
-          int yyxbegin = yyn < 0 ? -yyn : 0;
-          /* Stay within bounds of both yycheck and yytname.  */
-          int yychecklim = YYLAST - yyn + 1;
-          int yyxend = yychecklim < YYNTOKENS ? yychecklim : YYNTOKENS;
-          int yyx;
-
-          for (yyx = yyxbegin; yyx < yyxend; ++yyx)
-            if (yycheck[yyx + yyn] == yyx && yyx != YYTERROR
-                && !yytable_value_is_error (yytable[yyx + yyn]))
-              {
-                if (yycount == YYERROR_VERBOSE_ARGS_MAXIMUM)
-                  {
-                    yycount = 1;
-                    yysize = yysize0;
-                    break;
-                  }
-                yyarg[yycount++] = yytname[yyx];
-                {
-                  YYSIZE_T yysize1 = yysize + yytnamerr (YY_NULLPTR, yytname[yyx]);
-                  if (! (yysize <= yysize1
-                         && yysize1 <= YYSTACK_ALLOC_MAXIMUM))
-                    return 2;
-                  yysize = yysize1;
-                }
-              }
-        }
-    }
-
-  switch (yycount)
-    {
-# define YYCASE_(N, S)                      \
-      case N:                               \
-        yyformat = S;                       \
-      break
-      YYCASE_(0, YY_("syntax error"));
-      YYCASE_(1, YY_("syntax error, unexpected %s"));
-      YYCASE_(2, YY_("syntax error, unexpected %s, expecting %s"));
-      YYCASE_(3, YY_("syntax error, unexpected %s, expecting %s or %s"));
-      YYCASE_(4, YY_("syntax error, unexpected %s, expecting %s or %s or %s"));
-      YYCASE_(5, YY_("syntax error, unexpected %s, expecting %s or %s or %s or %s"));
-# undef YYCASE_
-    }
-
-  {
-    YYSIZE_T yysize1 = yysize + yystrlen (yyformat);
-    if (! (yysize <= yysize1 && yysize1 <= YYSTACK_ALLOC_MAXIMUM))
-      return 2;
-    yysize = yysize1;
-  }
-
-  if (*yymsg_alloc < yysize)
-    {
-      *yymsg_alloc = 2 * yysize;
-      if (! (yysize <= *yymsg_alloc
-             && *yymsg_alloc <= YYSTACK_ALLOC_MAXIMUM))
-        *yymsg_alloc = YYSTACK_ALLOC_MAXIMUM;
-      return 1;
-    }
-
-  /* Avoid sprintf, as that infringes on the user's name space.
-     Don't have undefined behavior even if the translation
-     produced a string with the wrong number of "%s"s.  */
-  {
-    char *yyp = *yymsg;
-    int yyi = 0;
-    while ((*yyp = *yyformat) != '\0')
-      if (*yyp == '%' && yyformat[1] == 's' && yyi < yycount)
-        {
-          yyp += yytnamerr (yyp, yyarg[yyi++]);
-          yyformat += 2;
-        }
-      else
-        {
-          yyp++;
-          yyformat++;
-        }
-  }
-  return 0;
-}
-#endif /* YYERROR_VERBOSE */
 
 /*-----------------------------------------------.
 | Release the memory associated to this symbol.  |
 `-----------------------------------------------*/
 
 static void
-yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, YYLTYPE *yylocationp)
+yydestruct (const char *yymsg,
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, YYLTYPE *yylocationp)
 {
-  YYUSE (yyvaluep);
-  YYUSE (yylocationp);
+  YY_USE (yyvaluep);
+  YY_USE (yylocationp);
   if (!yymsg)
     yymsg = "Deleting";
-  YY_SYMBOL_PRINT (yymsg, yytype, yyvaluep, yylocationp);
+  YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
 
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
-  YYUSE (yytype);
+  YY_USE (yykind);
   YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
 
-
-
-/* The lookahead symbol.  */
+/* Lookahead token kind.  */
 int yychar;
 
 /* The semantic value of the lookahead symbol.  */
@@ -1402,6 +1462,8 @@ YYLTYPE yylloc
 int yynerrs;
 
 
+
+
 /*----------.
 | yyparse.  |
 `----------*/
@@ -1409,53 +1471,45 @@ int yynerrs;
 int
 yyparse (void)
 {
-    int yystate;
+    yy_state_fast_t yystate = 0;
     /* Number of tokens to shift before error messages enabled.  */
-    int yyerrstatus;
+    int yyerrstatus = 0;
 
-    /* The stacks and their tools:
-       'yyss': related to states.
-       'yyvs': related to semantic values.
-       'yyls': related to locations.
-
-       Refer to the stacks through separate pointers, to allow yyoverflow
+    /* Refer to the stacks through separate pointers, to allow yyoverflow
        to reallocate them elsewhere.  */
 
-    /* The state stack.  */
-    yytype_int16 yyssa[YYINITDEPTH];
-    yytype_int16 *yyss;
-    yytype_int16 *yyssp;
+    /* Their size.  */
+    YYPTRDIFF_T yystacksize = YYINITDEPTH;
+
+    /* The state stack: array, bottom, top.  */
+    yy_state_t yyssa[YYINITDEPTH];
+    yy_state_t *yyss = yyssa;
+    yy_state_t *yyssp = yyss;
 
-    /* The semantic value stack.  */
+    /* The semantic value stack: array, bottom, top.  */
     YYSTYPE yyvsa[YYINITDEPTH];
-    YYSTYPE *yyvs;
-    YYSTYPE *yyvsp;
+    YYSTYPE *yyvs = yyvsa;
+    YYSTYPE *yyvsp = yyvs;
 
-    /* The location stack.  */
+    /* The location stack: array, bottom, top.  */
     YYLTYPE yylsa[YYINITDEPTH];
-    YYLTYPE *yyls;
-    YYLTYPE *yylsp;
-
-    /* The locations where the error started and ended.  */
-    YYLTYPE yyerror_range[3];
-
-    YYSIZE_T yystacksize;
+    YYLTYPE *yyls = yylsa;
+    YYLTYPE *yylsp = yyls;
 
   int yyn;
+  /* The return value of yyparse.  */
   int yyresult;
-  /* Lookahead token as an internal (translated) token number.  */
-  int yytoken = 0;
+  /* Lookahead symbol kind.  */
+  yysymbol_kind_t yytoken = YYSYMBOL_YYEMPTY;
   /* The variables used to return semantic value and location from the
      action routines.  */
   YYSTYPE yyval;
   YYLTYPE yyloc;
 
-#if YYERROR_VERBOSE
-  /* Buffer for error messages, and its allocated size.  */
-  char yymsgbuf[128];
-  char *yymsg = yymsgbuf;
-  YYSIZE_T yymsg_alloc = sizeof yymsgbuf;
-#endif
+  /* The locations where the error started and ended.  */
+  YYLTYPE yyerror_range[3];
+
+
 
 #define YYPOPSTACK(N)   (yyvsp -= (N), yyssp -= (N), yylsp -= (N))
 
@@ -1463,43 +1517,49 @@ yyparse (void)
      Keep to zero when no symbol should be popped.  */
   int yylen = 0;
 
-  yyssp = yyss = yyssa;
-  yyvsp = yyvs = yyvsa;
-  yylsp = yyls = yylsa;
-  yystacksize = YYINITDEPTH;
-
   YYDPRINTF ((stderr, "Starting parse\n"));
 
-  yystate = 0;
-  yyerrstatus = 0;
-  yynerrs = 0;
   yychar = YYEMPTY; /* Cause a token to be read.  */
+
   yylsp[0] = yylloc;
   goto yysetstate;
 
+
 /*------------------------------------------------------------.
-| yynewstate -- Push a new state, which is found in yystate.  |
+| yynewstate -- push a new state, which is found in yystate.  |
 `------------------------------------------------------------*/
- yynewstate:
+yynewstate:
   /* In all cases, when you get here, the value and location stacks
      have just been pushed.  So pushing a state here evens the stacks.  */
   yyssp++;
 
- yysetstate:
-  *yyssp = yystate;
+
+/*--------------------------------------------------------------------.
+| yysetstate -- set current state (the top of the stack) to yystate.  |
+`--------------------------------------------------------------------*/
+yysetstate:
+  YYDPRINTF ((stderr, "Entering state %d\n", yystate));
+  YY_ASSERT (0 <= yystate && yystate < YYNSTATES);
+  YY_IGNORE_USELESS_CAST_BEGIN
+  *yyssp = YY_CAST (yy_state_t, yystate);
+  YY_IGNORE_USELESS_CAST_END
+  YY_STACK_PRINT (yyss, yyssp);
 
   if (yyss + yystacksize - 1 <= yyssp)
+#if !defined yyoverflow && !defined YYSTACK_RELOCATE
+    YYNOMEM;
+#else
     {
       /* Get the current used size of the three stacks, in elements.  */
-      YYSIZE_T yysize = yyssp - yyss + 1;
+      YYPTRDIFF_T yysize = yyssp - yyss + 1;
 
-#ifdef yyoverflow
+# if defined yyoverflow
       {
         /* Give user a chance to reallocate the stack.  Use copies of
            these so that the &'s don't force the real ones into
            memory.  */
+        yy_state_t *yyss1 = yyss;
         YYSTYPE *yyvs1 = yyvs;
-        yytype_int16 *yyss1 = yyss;
         YYLTYPE *yyls1 = yyls;
 
         /* Each stack pointer address is followed by the size of the
@@ -1507,32 +1567,29 @@ yyparse (void)
            conditional around just the two extra args, but that might
            be undefined if yyoverflow is a macro.  */
         yyoverflow (YY_("memory exhausted"),
-                    &yyss1, yysize * sizeof (*yyssp),
-                    &yyvs1, yysize * sizeof (*yyvsp),
-                    &yyls1, yysize * sizeof (*yylsp),
+                    &yyss1, yysize * YYSIZEOF (*yyssp),
+                    &yyvs1, yysize * YYSIZEOF (*yyvsp),
+                    &yyls1, yysize * YYSIZEOF (*yylsp),
                     &yystacksize);
-
-        yyls = yyls1;
         yyss = yyss1;
         yyvs = yyvs1;
+        yyls = yyls1;
       }
-#else /* no yyoverflow */
-# ifndef YYSTACK_RELOCATE
-      goto yyexhaustedlab;
-# else
+# else /* defined YYSTACK_RELOCATE */
       /* Extend the stack our own way.  */
       if (YYMAXDEPTH <= yystacksize)
-        goto yyexhaustedlab;
+        YYNOMEM;
       yystacksize *= 2;
       if (YYMAXDEPTH < yystacksize)
         yystacksize = YYMAXDEPTH;
 
       {
-        yytype_int16 *yyss1 = yyss;
+        yy_state_t *yyss1 = yyss;
         union yyalloc *yyptr =
-          (union yyalloc *) YYSTACK_ALLOC (YYSTACK_BYTES (yystacksize));
+          YY_CAST (union yyalloc *,
+                   YYSTACK_ALLOC (YY_CAST (YYSIZE_T, YYSTACK_BYTES (yystacksize))));
         if (! yyptr)
-          goto yyexhaustedlab;
+          YYNOMEM;
         YYSTACK_RELOCATE (yyss_alloc, yyss);
         YYSTACK_RELOCATE (yyvs_alloc, yyvs);
         YYSTACK_RELOCATE (yyls_alloc, yyls);
@@ -1541,31 +1598,32 @@ yyparse (void)
           YYSTACK_FREE (yyss1);
       }
 # endif
-#endif /* no yyoverflow */
 
       yyssp = yyss + yysize - 1;
       yyvsp = yyvs + yysize - 1;
       yylsp = yyls + yysize - 1;
 
-      YYDPRINTF ((stderr, "Stack size increased to %lu\n",
-                  (unsigned long int) yystacksize));
+      YY_IGNORE_USELESS_CAST_BEGIN
+      YYDPRINTF ((stderr, "Stack size increased to %ld\n",
+                  YY_CAST (long, yystacksize)));
+      YY_IGNORE_USELESS_CAST_END
 
       if (yyss + yystacksize - 1 <= yyssp)
         YYABORT;
     }
+#endif /* !defined yyoverflow && !defined YYSTACK_RELOCATE */
 
-  YYDPRINTF ((stderr, "Entering state %d\n", yystate));
 
   if (yystate == YYFINAL)
     YYACCEPT;
 
   goto yybackup;
 
+
 /*-----------.
 | yybackup.  |
 `-----------*/
 yybackup:
-
   /* Do appropriate processing given the current state.  Read a
      lookahead token if we need one and don't already have one.  */
 
@@ -1576,18 +1634,30 @@ yybackup:
 
   /* Not known => get a lookahead token if don't already have one.  */
 
-  /* YYCHAR is either YYEMPTY or YYEOF or a valid lookahead symbol.  */
+  /* YYCHAR is either empty, or end-of-input, or a valid lookahead.  */
   if (yychar == YYEMPTY)
     {
-      YYDPRINTF ((stderr, "Reading a token: "));
+      YYDPRINTF ((stderr, "Reading a token\n"));
       yychar = yylex ();
     }
 
   if (yychar <= YYEOF)
     {
-      yychar = yytoken = YYEOF;
+      yychar = YYEOF;
+      yytoken = YYSYMBOL_YYEOF;
       YYDPRINTF ((stderr, "Now at end of input.\n"));
     }
+  else if (yychar == YYerror)
+    {
+      /* The scanner already issued an error message, process directly
+         to error recovery.  But do not keep the error token as
+         lookahead, it is too special and may lead us to an endless
+         loop in error recovery. */
+      yychar = YYUNDEF;
+      yytoken = YYSYMBOL_YYerror;
+      yyerror_range[1] = yylloc;
+      goto yyerrlab1;
+    }
   else
     {
       yytoken = YYTRANSLATE (yychar);
@@ -1615,15 +1685,14 @@ yybackup:
 
   /* Shift the lookahead token.  */
   YY_SYMBOL_PRINT ("Shifting", yytoken, &yylval, &yylloc);
-
-  /* Discard the shifted token.  */
-  yychar = YYEMPTY;
-
   yystate = yyn;
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
   *++yyvsp = yylval;
   YY_IGNORE_MAYBE_UNINITIALIZED_END
   *++yylsp = yylloc;
+
+  /* Discard the shifted token.  */
+  yychar = YYEMPTY;
   goto yynewstate;
 
 
@@ -1638,7 +1707,7 @@ yydefault:
 
 
 /*-----------------------------.
-| yyreduce -- Do a reduction.  |
+| yyreduce -- do a reduction.  |
 `-----------------------------*/
 yyreduce:
   /* yyn is the number of a rule to reduce with.  */
@@ -1654,706 +1723,708 @@ yyreduce:
      GCC warning that YYVAL may be used uninitialized.  */
   yyval = yyvsp[1-yylen];
 
-  /* Default location.  */
+  /* Default location. */
   YYLLOC_DEFAULT (yyloc, (yylsp - yylen), yylen);
+  yyerror_range[1] = yyloc;
   YY_REDUCE_PRINT (yyn);
   switch (yyn)
     {
-        case 2:
-#line 157 "parser.y" /* yacc.c:1646  */
-    { 
+  case 2: /* Program: DeclList  */
+#line 199 "parser.y"
+                                   { 
                                       (yylsp[0]); 
                                       /* pp2: The @1 is needed to convince 
                                    /    * yacc to set up yylloc. You can remove 
                                        * it once you have other uses of @n*/
-                                      Program *program = new Program((yyvsp[0].declList));
-                                      // if no errors, advance to next phase
-                                      if (ReportError::NumErrors() == 0) 
-                                          program->Print(0);
+                                      // hand the declarations back to the
+                                      // driver, which merges the lists of
+                                      // all input files into one Program
+                                      parsedDecls = (yyvsp[0].declList);
                                     }
-#line 1675 "y.tab.c" /* yacc.c:1646  */
+#line 1745 "y.tab.c"
     break;
 
-  case 3:
-#line 169 "parser.y" /* yacc.c:1646  */
-    { ((yyval.declList)=(yyvsp[-1].declList))->Append((yyvsp[0].decl)); }
-#line 1681 "y.tab.c" /* yacc.c:1646  */
+  case 3: /* DeclList: DeclList Decl  */
+#line 211 "parser.y"
+                                    { ((yyval.declList)=(yyvsp[-1].declList))->Append((yyvsp[0].decl)); }
+#line 1751 "y.tab.c"
     break;
 
-  case 4:
-#line 170 "parser.y" /* yacc.c:1646  */
-    { ((yyval.declList) = new List<Decl*>)->Append((yyvsp[0].decl)); }
-#line 1687 "y.tab.c" /* yacc.c:1646  */
+  case 4: /* DeclList: Decl  */
+#line 212 "parser.y"
+                                    { ((yyval.declList) = new List<Decl*>)->Append((yyvsp[0].decl)); }
+#line 1757 "y.tab.c"
     break;
 
-  case 5:
-#line 172 "parser.y" /* yacc.c:1646  */
-    { (yyval.decl)=(yyvsp[0].var); }
-#line 1693 "y.tab.c" /* yacc.c:1646  */
+  case 5: /* Decl: VarDecl  */
+#line 214 "parser.y"
+                                    { (yyval.decl)=(yyvsp[0].var); TraceReduction((yyval.decl), (yyval.decl)->GetName(), (yylsp[0])); }
+#line 1763 "y.tab.c"
     break;
 
-  case 6:
-#line 173 "parser.y" /* yacc.c:1646  */
-    { (yyval.decl)=(yyvsp[0].fDecl); }
-#line 1699 "y.tab.c" /* yacc.c:1646  */
+  case 6: /* Decl: FnDecl  */
+#line 215 "parser.y"
+                                    { (yyval.decl)=(yyvsp[0].fDecl); TraceReduction((yyval.decl), (yyval.decl)->GetName(), (yylsp[0])); }
+#line 1769 "y.tab.c"
     break;
 
-  case 7:
-#line 174 "parser.y" /* yacc.c:1646  */
-    { (yyval.decl)=(yyvsp[0].cDecl); }
-#line 1705 "y.tab.c" /* yacc.c:1646  */
+  case 7: /* Decl: ClassDecl  */
+#line 216 "parser.y"
+                                    { (yyval.decl)=(yyvsp[0].cDecl); TraceReduction((yyval.decl), (yyval.decl)->GetName(), (yylsp[0])); }
+#line 1775 "y.tab.c"
     break;
 
-  case 8:
-#line 175 "parser.y" /* yacc.c:1646  */
-    { (yyval.decl)=(yyvsp[0].iDecl); }
-#line 1711 "y.tab.c" /* yacc.c:1646  */
+  case 8: /* Decl: InterfaceDecl  */
+#line 217 "parser.y"
+                                    { (yyval.decl)=(yyvsp[0].iDecl); TraceReduction((yyval.decl), (yyval.decl)->GetName(), (yylsp[0])); }
+#line 1781 "y.tab.c"
     break;
 
-  case 9:
-#line 178 "parser.y" /* yacc.c:1646  */
-    { (yyval.var)=(yyvsp[-1].var); }
-#line 1717 "y.tab.c" /* yacc.c:1646  */
+  case 9: /* VarDecl: Variable ';'  */
+#line 220 "parser.y"
+                                    { (yyval.var)=(yyvsp[-1].var); }
+#line 1787 "y.tab.c"
     break;
 
-  case 10:
-#line 181 "parser.y" /* yacc.c:1646  */
-    { (yyval.var) = new VarDecl(new Identifier((yylsp[0]), (yyvsp[0].identifier)), (yyvsp[-1].type)); }
-#line 1723 "y.tab.c" /* yacc.c:1646  */
+  case 10: /* Variable: Type T_Identifier  */
+#line 223 "parser.y"
+                                    { (yyval.var) = new VarDecl(new Identifier((yylsp[0]), (yyvsp[0].identifier)), (yyvsp[-1].type)); }
+#line 1793 "y.tab.c"
     break;
 
-  case 11:
-#line 185 "parser.y" /* yacc.c:1646  */
-    { (yyval.type) = Type::intType; }
-#line 1729 "y.tab.c" /* yacc.c:1646  */
+  case 11: /* Type: T_Int  */
+#line 227 "parser.y"
+                                    { (yyval.type) = Type::intType; }
+#line 1799 "y.tab.c"
     break;
 
-  case 12:
-#line 186 "parser.y" /* yacc.c:1646  */
-    { (yyval.type) = Type::boolType; }
-#line 1735 "y.tab.c" /* yacc.c:1646  */
+  case 12: /* Type: T_Bool  */
+#line 228 "parser.y"
+                                    { (yyval.type) = Type::boolType; }
+#line 1805 "y.tab.c"
     break;
 
-  case 13:
-#line 187 "parser.y" /* yacc.c:1646  */
-    { (yyval.type) = Type::stringType; }
-#line 1741 "y.tab.c" /* yacc.c:1646  */
+  case 13: /* Type: T_String  */
+#line 229 "parser.y"
+                                    { (yyval.type) = Type::stringType; }
+#line 1811 "y.tab.c"
     break;
 
-  case 14:
-#line 188 "parser.y" /* yacc.c:1646  */
-    { (yyval.type) = Type::doubleType; }
-#line 1747 "y.tab.c" /* yacc.c:1646  */
+  case 14: /* Type: T_Double  */
+#line 230 "parser.y"
+                                    { (yyval.type) = Type::doubleType; }
+#line 1817 "y.tab.c"
     break;
 
-  case 15:
-#line 189 "parser.y" /* yacc.c:1646  */
-    { (yyval.type) = new NamedType(new Identifier((yylsp[0]),(yyvsp[0].identifier))); }
-#line 1753 "y.tab.c" /* yacc.c:1646  */
+  case 15: /* Type: T_Identifier  */
+#line 231 "parser.y"
+                               { (yyval.type) = new NamedType(new Identifier((yylsp[0]),(yyvsp[0].identifier))); }
+#line 1823 "y.tab.c"
     break;
 
-  case 16:
-#line 190 "parser.y" /* yacc.c:1646  */
-    { (yyval.type) = new ArrayType(Join((yylsp[-1]), (yylsp[0])), (yyvsp[-1].type)); }
-#line 1759 "y.tab.c" /* yacc.c:1646  */
+  case 16: /* Type: Type T_Dims  */
+#line 232 "parser.y"
+                                    { (yyval.type) = new ArrayType(Join((yylsp[-1]), (yylsp[0])), (yyvsp[-1].type)); }
+#line 1829 "y.tab.c"
     break;
 
-  case 17:
-#line 193 "parser.y" /* yacc.c:1646  */
-    { ((yyval.fDecl)=(yyvsp[-1].fDecl))->SetFunctionBody((yyvsp[0].stmt)); }
-#line 1765 "y.tab.c" /* yacc.c:1646  */
+  case 17: /* FnDecl: FnHeader StmtBlock  */
+#line 235 "parser.y"
+                                    { ((yyval.fDecl)=(yyvsp[-1].fDecl))->SetFunctionBody((yyvsp[0].stmt)); }
+#line 1835 "y.tab.c"
     break;
 
-  case 18:
-#line 197 "parser.y" /* yacc.c:1646  */
-    { (yyval.fDecl) = new FnDecl(new Identifier((yylsp[-3]), (yyvsp[-3].identifier)), (yyvsp[-4].type), (yyvsp[-1].varList)); }
-#line 1771 "y.tab.c" /* yacc.c:1646  */
+  case 18: /* FnHeader: Type T_Identifier '(' Formals ')'  */
+#line 239 "parser.y"
+                                    { (yyval.fDecl) = new FnDecl(new Identifier((yylsp[-3]), (yyvsp[-3].identifier)), (yyvsp[-4].type), (yyvsp[-1].varList)); }
+#line 1841 "y.tab.c"
     break;
 
-  case 19:
-#line 199 "parser.y" /* yacc.c:1646  */
-    { (yyval.fDecl) = new FnDecl(new Identifier((yylsp[-3]), (yyvsp[-3].identifier)), Type::voidType, (yyvsp[-1].varList)); }
-#line 1777 "y.tab.c" /* yacc.c:1646  */
+  case 19: /* FnHeader: T_Void T_Identifier '(' Formals ')'  */
+#line 241 "parser.y"
+                                    { (yyval.fDecl) = new FnDecl(new Identifier((yylsp[-3]), (yyvsp[-3].identifier)), Type::voidType, (yyvsp[-1].varList)); }
+#line 1847 "y.tab.c"
     break;
 
-  case 20:
-#line 202 "parser.y" /* yacc.c:1646  */
-    { (yyval.varList) = (yyvsp[0].varList); }
-#line 1783 "y.tab.c" /* yacc.c:1646  */
+  case 20: /* Formals: FormalList  */
+#line 244 "parser.y"
+                                    { (yyval.varList) = (yyvsp[0].varList); }
+#line 1853 "y.tab.c"
     break;
 
-  case 21:
-#line 203 "parser.y" /* yacc.c:1646  */
-    { (yyval.varList) = new List<VarDecl*>; }
-#line 1789 "y.tab.c" /* yacc.c:1646  */
+  case 21: /* Formals: %empty  */
+#line 245 "parser.y"
+                                    { (yyval.varList) = new List<VarDecl*>; }
+#line 1859 "y.tab.c"
     break;
 
-  case 22:
-#line 207 "parser.y" /* yacc.c:1646  */
-    { ((yyval.varList)=(yyvsp[-2].varList))->Append((yyvsp[0].var)); }
-#line 1795 "y.tab.c" /* yacc.c:1646  */
+  case 22: /* FormalList: FormalList ',' Variable  */
+#line 249 "parser.y"
+                                    { ((yyval.varList)=(yyvsp[-2].varList))->Append((yyvsp[0].var)); }
+#line 1865 "y.tab.c"
     break;
 
-  case 23:
-#line 208 "parser.y" /* yacc.c:1646  */
-    { ((yyval.varList) = new List<VarDecl*>)->Append((yyvsp[0].var)); }
-#line 1801 "y.tab.c" /* yacc.c:1646  */
+  case 23: /* FormalList: Variable  */
+#line 250 "parser.y"
+                                    { ((yyval.varList) = new List<VarDecl*>)->Append((yyvsp[0].var)); }
+#line 1871 "y.tab.c"
     break;
 
-  case 24:
-#line 212 "parser.y" /* yacc.c:1646  */
-    { (yyval.cDecl) = new ClassDecl(new Identifier((yylsp[-5]), (yyvsp[-5].identifier)), (yyvsp[-4].nType), (yyvsp[-3].nTypeList), (yyvsp[-1].declList)); }
-#line 1807 "y.tab.c" /* yacc.c:1646  */
+  case 24: /* ClassDecl: T_Class T_Identifier ExtendsClause ImplementBlock '{' FieldList '}'  */
+#line 254 "parser.y"
+                                    { (yyval.cDecl) = new ClassDecl(new Identifier((yylsp[-5]), (yyvsp[-5].identifier)), (yyvsp[-4].nType), (yyvsp[-3].nTypeList), (yyvsp[-1].declList)); }
+#line 1877 "y.tab.c"
     break;
 
-  case 25:
-#line 215 "parser.y" /* yacc.c:1646  */
-    { (yyval.nType) = new NamedType(new Identifier((yylsp[0]), (yyvsp[0].identifier))); }
-#line 1813 "y.tab.c" /* yacc.c:1646  */
+  case 25: /* ExtendsClause: T_Extends T_Identifier  */
+#line 257 "parser.y"
+                                        { (yyval.nType) = new NamedType(new Identifier((yylsp[0]), (yyvsp[0].identifier))); }
+#line 1883 "y.tab.c"
     break;
 
-  case 26:
-#line 216 "parser.y" /* yacc.c:1646  */
-    { (yyval.nType) = NULL; }
-#line 1819 "y.tab.c" /* yacc.c:1646  */
+  case 26: /* ExtendsClause: %empty  */
+#line 258 "parser.y"
+                                { (yyval.nType) = NULL; }
+#line 1889 "y.tab.c"
     break;
 
-  case 27:
-#line 219 "parser.y" /* yacc.c:1646  */
-    { (yyval.nTypeList) = (yyvsp[0].nTypeList); }
-#line 1825 "y.tab.c" /* yacc.c:1646  */
+  case 27: /* ImplementBlock: T_Implements IdentifierList  */
+#line 261 "parser.y"
+                                                { (yyval.nTypeList) = (yyvsp[0].nTypeList); }
+#line 1895 "y.tab.c"
     break;
 
-  case 28:
-#line 220 "parser.y" /* yacc.c:1646  */
-    { (yyval.nTypeList) = new List<NamedType*>; }
-#line 1831 "y.tab.c" /* yacc.c:1646  */
+  case 28: /* ImplementBlock: %empty  */
+#line 262 "parser.y"
+                                { (yyval.nTypeList) = new List<NamedType*>; }
+#line 1901 "y.tab.c"
     break;
 
-  case 29:
-#line 224 "parser.y" /* yacc.c:1646  */
-    { ((yyval.nTypeList)=(yyvsp[-2].nTypeList))->Append(new NamedType(new Identifier((yylsp[0]), (yyvsp[0].identifier)))); }
-#line 1837 "y.tab.c" /* yacc.c:1646  */
+  case 29: /* IdentifierList: IdentifierList ',' T_Identifier  */
+#line 266 "parser.y"
+                                { ((yyval.nTypeList)=(yyvsp[-2].nTypeList))->Append(new NamedType(new Identifier((yylsp[0]), (yyvsp[0].identifier)))); }
+#line 1907 "y.tab.c"
     break;
 
-  case 30:
-#line 225 "parser.y" /* yacc.c:1646  */
-    { ((yyval.nTypeList) = new List<NamedType*>)->Append(new NamedType(new Identifier((yylsp[0]), (yyvsp[0].identifier)))); }
-#line 1843 "y.tab.c" /* yacc.c:1646  */
+  case 30: /* IdentifierList: T_Identifier  */
+#line 267 "parser.y"
+                                { ((yyval.nTypeList) = new List<NamedType*>)->Append(new NamedType(new Identifier((yylsp[0]), (yyvsp[0].identifier)))); }
+#line 1913 "y.tab.c"
     break;
 
-  case 31:
-#line 228 "parser.y" /* yacc.c:1646  */
-    { ((yyval.declList)=(yyvsp[-1].declList))->Append((yyvsp[0].decl)); }
-#line 1849 "y.tab.c" /* yacc.c:1646  */
+  case 31: /* FieldList: FieldList Field  */
+#line 270 "parser.y"
+                                   { ((yyval.declList)=(yyvsp[-1].declList))->Append((yyvsp[0].decl)); }
+#line 1919 "y.tab.c"
     break;
 
-  case 32:
-#line 229 "parser.y" /* yacc.c:1646  */
-    { (yyval.declList) = new List<Decl*>; }
-#line 1855 "y.tab.c" /* yacc.c:1646  */
+  case 32: /* FieldList: %empty  */
+#line 271 "parser.y"
+                                        { (yyval.declList) = new List<Decl*>; }
+#line 1925 "y.tab.c"
     break;
 
-  case 33:
-#line 232 "parser.y" /* yacc.c:1646  */
-    { (yyval.decl) = (yyvsp[0].var); }
-#line 1861 "y.tab.c" /* yacc.c:1646  */
+  case 33: /* Field: VarDecl  */
+#line 274 "parser.y"
+                                { (yyval.decl) = (yyvsp[0].var); TraceReduction((yyval.decl), (yyval.decl)->GetName(), (yylsp[0])); }
+#line 1931 "y.tab.c"
     break;
 
-  case 34:
-#line 233 "parser.y" /* yacc.c:1646  */
-    { (yyval.decl) = (yyvsp[0].fDecl); }
-#line 1867 "y.tab.c" /* yacc.c:1646  */
+  case 34: /* Field: FnDecl  */
+#line 275 "parser.y"
+                                { (yyval.decl) = (yyvsp[0].fDecl); TraceReduction((yyval.decl), (yyval.decl)->GetName(), (yylsp[0])); }
+#line 1937 "y.tab.c"
     break;
 
-  case 35:
-#line 237 "parser.y" /* yacc.c:1646  */
-    { (yyval.iDecl) = new InterfaceDecl(new Identifier((yylsp[-3]), (yyvsp[-3].identifier)), (yyvsp[-1].declList)); }
-#line 1873 "y.tab.c" /* yacc.c:1646  */
+  case 35: /* InterfaceDecl: T_Interface T_Identifier '{' PrototypeList '}'  */
+#line 279 "parser.y"
+                                { (yyval.iDecl) = new InterfaceDecl(new Identifier((yylsp[-3]), (yyvsp[-3].identifier)), (yyvsp[-1].declList)); }
+#line 1943 "y.tab.c"
     break;
 
-  case 36:
-#line 240 "parser.y" /* yacc.c:1646  */
-    { ((yyval.declList)=(yyvsp[-2].declList))->Append((yyvsp[-1].fDecl)); }
-#line 1879 "y.tab.c" /* yacc.c:1646  */
+  case 36: /* PrototypeList: PrototypeList FnHeader ';'  */
+#line 282 "parser.y"
+                                                { ((yyval.declList)=(yyvsp[-2].declList))->Append((yyvsp[-1].fDecl)); }
+#line 1949 "y.tab.c"
     break;
 
-  case 37:
-#line 241 "parser.y" /* yacc.c:1646  */
-    { (yyval.declList) = new List<Decl*>; }
-#line 1885 "y.tab.c" /* yacc.c:1646  */
+  case 37: /* PrototypeList: %empty  */
+#line 283 "parser.y"
+                                { (yyval.declList) = new List<Decl*>; }
+#line 1955 "y.tab.c"
     break;
 
-  case 38:
-#line 245 "parser.y" /* yacc.c:1646  */
-    { (yyval.stmt) = new StmtBlock((yyvsp[-2].varList), (yyvsp[-1].stmtList)); }
-#line 1891 "y.tab.c" /* yacc.c:1646  */
+  case 38: /* StmtBlock: '{' VarDecls StmtList '}'  */
+#line 287 "parser.y"
+                                    { (yyval.stmt) = new StmtBlock((yyvsp[-2].varList), (yyvsp[-1].stmtList)); }
+#line 1961 "y.tab.c"
     break;
 
-  case 39:
-#line 248 "parser.y" /* yacc.c:1646  */
-    { ((yyval.varList)=(yyvsp[-1].varList))->Append((yyvsp[0].var)); }
-#line 1897 "y.tab.c" /* yacc.c:1646  */
+  case 39: /* VarDecls: VarDecls VarDecl  */
+#line 290 "parser.y"
+                                 { ((yyval.varList)=(yyvsp[-1].varList))->Append((yyvsp[0].var)); }
+#line 1967 "y.tab.c"
     break;
 
-  case 40:
-#line 249 "parser.y" /* yacc.c:1646  */
-    { (yyval.varList) = new List<VarDecl*>; }
-#line 1903 "y.tab.c" /* yacc.c:1646  */
+  case 40: /* VarDecls: %empty  */
+#line 291 "parser.y"
+                                 { (yyval.varList) = new List<VarDecl*>; }
+#line 1973 "y.tab.c"
     break;
 
-  case 41:
-#line 252 "parser.y" /* yacc.c:1646  */
-    { ((yyval.stmtList)=(yyvsp[0].stmtList))->InsertAt((yyvsp[-1].stmt), 0); }
-#line 1909 "y.tab.c" /* yacc.c:1646  */
+  case 41: /* StmtList: Stmt StmtList  */
+#line 294 "parser.y"
+                                { ((yyval.stmtList)=(yyvsp[0].stmtList))->InsertAt((yyvsp[-1].stmt), 0); }
+#line 1979 "y.tab.c"
     break;
 
-  case 42:
-#line 253 "parser.y" /* yacc.c:1646  */
-    { (yyval.stmtList) = new List<Stmt*>; }
-#line 1915 "y.tab.c" /* yacc.c:1646  */
+  case 42: /* StmtList: %empty  */
+#line 295 "parser.y"
+                                { (yyval.stmtList) = new List<Stmt*>; }
+#line 1985 "y.tab.c"
     break;
 
-  case 43:
-#line 256 "parser.y" /* yacc.c:1646  */
-    { (yyval.stmt) = (yyvsp[-1].expr);}
-#line 1921 "y.tab.c" /* yacc.c:1646  */
+  case 43: /* Stmt: OptionalExpr ';'  */
+#line 298 "parser.y"
+                                { (yyval.stmt) = (yyvsp[-1].expr); TraceReduction((yyval.stmt), NULL, (yyloc)); }
+#line 1991 "y.tab.c"
     break;
 
-  case 44:
-#line 257 "parser.y" /* yacc.c:1646  */
-    { (yyval.stmt) = (yyvsp[0].iStmt); }
-#line 1927 "y.tab.c" /* yacc.c:1646  */
+  case 44: /* Stmt: IfStmt  */
+#line 299 "parser.y"
+                        { (yyval.stmt) = (yyvsp[0].iStmt); TraceReduction((yyval.stmt), NULL, (yylsp[0])); }
+#line 1997 "y.tab.c"
     break;
 
-  case 45:
-#line 258 "parser.y" /* yacc.c:1646  */
-    { (yyval.stmt) = (yyvsp[0].wStmt); }
-#line 1933 "y.tab.c" /* yacc.c:1646  */
+  case 45: /* Stmt: WhileStmt  */
+#line 300 "parser.y"
+                                { (yyval.stmt) = (yyvsp[0].wStmt); TraceReduction((yyval.stmt), NULL, (yylsp[0])); }
+#line 2003 "y.tab.c"
     break;
 
-  case 46:
-#line 259 "parser.y" /* yacc.c:1646  */
-    { (yyval.stmt) = (yyvsp[0].fStmt); }
-#line 1939 "y.tab.c" /* yacc.c:1646  */
+  case 46: /* Stmt: ForStmt  */
+#line 301 "parser.y"
+                        { (yyval.stmt) = (yyvsp[0].fStmt); TraceReduction((yyval.stmt), NULL, (yylsp[0])); }
+#line 2009 "y.tab.c"
     break;
 
-  case 47:
-#line 260 "parser.y" /* yacc.c:1646  */
-    { (yyval.stmt) = (yyvsp[0].bStmt); }
-#line 1945 "y.tab.c" /* yacc.c:1646  */
+  case 47: /* Stmt: BreakStmt  */
+#line 302 "parser.y"
+                                { (yyval.stmt) = (yyvsp[0].bStmt); TraceReduction((yyval.stmt), NULL, (yylsp[0])); }
+#line 2015 "y.tab.c"
     break;
 
-  case 48:
-#line 261 "parser.y" /* yacc.c:1646  */
-    { (yyval.stmt) = (yyvsp[0].rStmt); }
-#line 1951 "y.tab.c" /* yacc.c:1646  */
+  case 48: /* Stmt: ReturnStmt  */
+#line 303 "parser.y"
+                                { (yyval.stmt) = (yyvsp[0].rStmt); TraceReduction((yyval.stmt), NULL, (yylsp[0])); }
+#line 2021 "y.tab.c"
     break;
 
-  case 49:
-#line 262 "parser.y" /* yacc.c:1646  */
-    { (yyval.stmt) = (yyvsp[0].pStmt); }
-#line 1957 "y.tab.c" /* yacc.c:1646  */
+  case 49: /* Stmt: PrintStmt  */
+#line 304 "parser.y"
+                                { (yyval.stmt) = (yyvsp[0].pStmt); TraceReduction((yyval.stmt), NULL, (yylsp[0])); }
+#line 2027 "y.tab.c"
     break;
 
-  case 50:
-#line 263 "parser.y" /* yacc.c:1646  */
-    { (yyval.stmt) = (yyvsp[0].stmt); }
-#line 1963 "y.tab.c" /* yacc.c:1646  */
+  case 50: /* Stmt: StmtBlock  */
+#line 305 "parser.y"
+                                { (yyval.stmt) = (yyvsp[0].stmt); TraceReduction((yyval.stmt), NULL, (yylsp[0])); }
+#line 2033 "y.tab.c"
     break;
 
-  case 51:
-#line 264 "parser.y" /* yacc.c:1646  */
-    { (yyval.stmt) = (yyvsp[0].sStmt); }
-#line 1969 "y.tab.c" /* yacc.c:1646  */
+  case 51: /* Stmt: SwitchStmt  */
+#line 306 "parser.y"
+                                { (yyval.stmt) = (yyvsp[0].sStmt); TraceReduction((yyval.stmt), NULL, (yylsp[0])); }
+#line 2039 "y.tab.c"
     break;
 
-  case 52:
-#line 267 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = (yyvsp[0].expr); }
-#line 1975 "y.tab.c" /* yacc.c:1646  */
+  case 52: /* OptionalExpr: Expr  */
+#line 309 "parser.y"
+                        { (yyval.expr) = (yyvsp[0].expr); }
+#line 2045 "y.tab.c"
     break;
 
-  case 53:
-#line 268 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = new EmptyExpr(); }
-#line 1981 "y.tab.c" /* yacc.c:1646  */
+  case 53: /* OptionalExpr: %empty  */
+#line 310 "parser.y"
+                                { (yyval.expr) = new EmptyExpr(); }
+#line 2051 "y.tab.c"
     break;
 
-  case 54:
-#line 271 "parser.y" /* yacc.c:1646  */
-    { (yyval.iStmt) = new IfStmt((yyvsp[-2].expr), (yyvsp[0].stmt), NULL); }
-#line 1987 "y.tab.c" /* yacc.c:1646  */
+  case 54: /* IfStmt: T_If '(' Expr ')' Stmt  */
+#line 313 "parser.y"
+                                                { (yyval.iStmt) = new IfStmt((yyvsp[-2].expr), (yyvsp[0].stmt), NULL); }
+#line 2057 "y.tab.c"
     break;
 
-  case 55:
-#line 272 "parser.y" /* yacc.c:1646  */
-    { (yyval.iStmt) = new IfStmt((yyvsp[-3].expr), (yyvsp[-1].stmt), (yyvsp[0].stmt)); }
-#line 1993 "y.tab.c" /* yacc.c:1646  */
+  case 55: /* IfStmt: T_If '(' Expr ')' Stmt ElseStmt  */
+#line 314 "parser.y"
+                                                { (yyval.iStmt) = new IfStmt((yyvsp[-3].expr), (yyvsp[-1].stmt), (yyvsp[0].stmt)); }
+#line 2063 "y.tab.c"
     break;
 
-  case 56:
-#line 275 "parser.y" /* yacc.c:1646  */
-    { (yyval.stmt) = (yyvsp[0].stmt); }
-#line 1999 "y.tab.c" /* yacc.c:1646  */
+  case 56: /* ElseStmt: T_Else Stmt  */
+#line 317 "parser.y"
+                      { (yyval.stmt) = (yyvsp[0].stmt); }
+#line 2069 "y.tab.c"
     break;
 
-  case 57:
-#line 278 "parser.y" /* yacc.c:1646  */
-    { (yyval.wStmt) = new WhileStmt((yyvsp[-2].expr), (yyvsp[0].stmt)); }
-#line 2005 "y.tab.c" /* yacc.c:1646  */
+  case 57: /* WhileStmt: T_While '(' Expr ')' Stmt  */
+#line 320 "parser.y"
+                                                { (yyval.wStmt) = new WhileStmt((yyvsp[-2].expr), (yyvsp[0].stmt)); }
+#line 2075 "y.tab.c"
     break;
 
-  case 58:
-#line 282 "parser.y" /* yacc.c:1646  */
-    { (yyval.fStmt) = new ForStmt((yyvsp[-6].expr), (yyvsp[-4].expr), (yyvsp[-2].expr), (yyvsp[0].stmt)); }
-#line 2011 "y.tab.c" /* yacc.c:1646  */
+  case 58: /* ForStmt: T_For '(' OptionalExpr ';' Expr ';' OptionalExpr ')' Stmt  */
+#line 324 "parser.y"
+                        { (yyval.fStmt) = new ForStmt((yyvsp[-6].expr), (yyvsp[-4].expr), (yyvsp[-2].expr), (yyvsp[0].stmt)); }
+#line 2081 "y.tab.c"
     break;
 
-  case 59:
-#line 285 "parser.y" /* yacc.c:1646  */
-    { (yyval.rStmt) = new ReturnStmt((yylsp[-2]), (yyvsp[-1].expr)); }
-#line 2017 "y.tab.c" /* yacc.c:1646  */
+  case 59: /* ReturnStmt: T_Return OptionalExpr ';'  */
+#line 327 "parser.y"
+                                                { (yyval.rStmt) = new ReturnStmt((yylsp[-2]), (yyvsp[-1].expr)); }
+#line 2087 "y.tab.c"
     break;
 
-  case 60:
-#line 288 "parser.y" /* yacc.c:1646  */
-    { (yyval.bStmt) = new BreakStmt((yylsp[-1])); }
-#line 2023 "y.tab.c" /* yacc.c:1646  */
+  case 60: /* BreakStmt: T_Break ';'  */
+#line 330 "parser.y"
+                                { (yyval.bStmt) = new BreakStmt((yylsp[-1])); }
+#line 2093 "y.tab.c"
     break;
 
-  case 61:
-#line 291 "parser.y" /* yacc.c:1646  */
-    { (yyval.pStmt) = new PrintStmt((yyvsp[-2].exprList)); }
-#line 2029 "y.tab.c" /* yacc.c:1646  */
+  case 61: /* PrintStmt: T_Print '(' ExprList ')' ';'  */
+#line 333 "parser.y"
+                                                { (yyval.pStmt) = new PrintStmt((yyvsp[-2].exprList)); }
+#line 2099 "y.tab.c"
     break;
 
-  case 62:
-#line 295 "parser.y" /* yacc.c:1646  */
-    { (yyval.sStmt) = new SwitchStmt((yyvsp[-4].expr), (yyvsp[-1].stmtList)); }
-#line 2035 "y.tab.c" /* yacc.c:1646  */
+  case 62: /* SwitchStmt: T_Switch '(' Expr ')' '{' SwitchBlock '}'  */
+#line 337 "parser.y"
+                                { (yyval.sStmt) = new SwitchStmt((yyvsp[-4].expr), (yyvsp[-1].stmtList)); }
+#line 2105 "y.tab.c"
     break;
 
-  case 63:
-#line 298 "parser.y" /* yacc.c:1646  */
-    { ((yyval.stmtList)=(yyvsp[-1].stmtList))->Append((yyvsp[0].deft)); }
-#line 2041 "y.tab.c" /* yacc.c:1646  */
+  case 63: /* SwitchBlock: CaseBlock Default  */
+#line 340 "parser.y"
+                                  { ((yyval.stmtList)=(yyvsp[-1].stmtList))->Append((yyvsp[0].deft)); }
+#line 2111 "y.tab.c"
     break;
 
-  case 64:
-#line 299 "parser.y" /* yacc.c:1646  */
-    { (yyval.stmtList) = (yyvsp[0].stmtList); }
-#line 2047 "y.tab.c" /* yacc.c:1646  */
+  case 64: /* SwitchBlock: CaseBlock  */
+#line 341 "parser.y"
+                                { (yyval.stmtList) = (yyvsp[0].stmtList); }
+#line 2117 "y.tab.c"
     break;
 
-  case 65:
-#line 302 "parser.y" /* yacc.c:1646  */
-    { ((yyval.stmtList) = (yyvsp[-1].stmtList))->Append((yyvsp[0].cast)); }
-#line 2053 "y.tab.c" /* yacc.c:1646  */
+  case 65: /* CaseBlock: CaseBlock CaseStmt  */
+#line 344 "parser.y"
+                                        { ((yyval.stmtList) = (yyvsp[-1].stmtList))->Append((yyvsp[0].cast)); }
+#line 2123 "y.tab.c"
     break;
 
-  case 66:
-#line 303 "parser.y" /* yacc.c:1646  */
-    { ((yyval.stmtList) = new List<Stmt*>)->Append((yyvsp[0].cast)); }
-#line 2059 "y.tab.c" /* yacc.c:1646  */
+  case 66: /* CaseBlock: CaseStmt  */
+#line 345 "parser.y"
+                                { ((yyval.stmtList) = new List<Stmt*>)->Append((yyvsp[0].cast)); }
+#line 2129 "y.tab.c"
     break;
 
-  case 67:
-#line 306 "parser.y" /* yacc.c:1646  */
-    { (yyval.cast) = new CaseStmt(new IntConstant((yylsp[-2]), (yyvsp[-2].integerConstant)), (yyvsp[0].stmtList)); }
-#line 2065 "y.tab.c" /* yacc.c:1646  */
+  case 67: /* CaseStmt: T_Case T_IntConstant ':' StmtList  */
+#line 348 "parser.y"
+                                                { (yyval.cast) = new CaseStmt(new IntConstant((yylsp[-2]), (yyvsp[-2].integerConstant)), (yyvsp[0].stmtList)); }
+#line 2135 "y.tab.c"
     break;
 
-  case 68:
-#line 309 "parser.y" /* yacc.c:1646  */
-    { (yyval.deft) = new Default((yyvsp[0].stmtList)); }
-#line 2071 "y.tab.c" /* yacc.c:1646  */
+  case 68: /* Default: T_Default ':' StmtList  */
+#line 351 "parser.y"
+                                       { (yyval.deft) = new Default((yyvsp[0].stmtList)); }
+#line 2141 "y.tab.c"
     break;
 
-  case 69:
-#line 312 "parser.y" /* yacc.c:1646  */
-    { ((yyval.exprList)=(yyvsp[-2].exprList))->Append((yyvsp[0].expr)); }
-#line 2077 "y.tab.c" /* yacc.c:1646  */
+  case 69: /* ExprList: ExprList ',' Expr  */
+#line 354 "parser.y"
+                                        { ((yyval.exprList)=(yyvsp[-2].exprList))->Append((yyvsp[0].expr)); }
+#line 2147 "y.tab.c"
     break;
 
-  case 70:
-#line 313 "parser.y" /* yacc.c:1646  */
-    { ((yyval.exprList) = new List<Expr*>)->Append((yyvsp[0].expr)); }
-#line 2083 "y.tab.c" /* yacc.c:1646  */
+  case 70: /* ExprList: Expr  */
+#line 355 "parser.y"
+                        { ((yyval.exprList) = new List<Expr*>)->Append((yyvsp[0].expr)); }
+#line 2153 "y.tab.c"
     break;
 
-  case 71:
-#line 316 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = (yyvsp[0].asExpr); }
-#line 2089 "y.tab.c" /* yacc.c:1646  */
+  case 71: /* Expr: AssignExpr  */
+#line 358 "parser.y"
+                                { (yyval.expr) = (yyvsp[0].asExpr); }
+#line 2159 "y.tab.c"
     break;
 
-  case 72:
-#line 317 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = (yyvsp[0].expr); }
-#line 2095 "y.tab.c" /* yacc.c:1646  */
+  case 72: /* Expr: Constant  */
+#line 359 "parser.y"
+                                { (yyval.expr) = (yyvsp[0].expr); }
+#line 2165 "y.tab.c"
     break;
 
-  case 73:
-#line 318 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = (yyvsp[0].lValue); }
-#line 2101 "y.tab.c" /* yacc.c:1646  */
+  case 73: /* Expr: LValue  */
+#line 360 "parser.y"
+                        { (yyval.expr) = (yyvsp[0].lValue); }
+#line 2171 "y.tab.c"
     break;
 
-  case 74:
-#line 319 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = new This((yylsp[0])); }
-#line 2107 "y.tab.c" /* yacc.c:1646  */
+  case 74: /* Expr: T_This  */
+#line 361 "parser.y"
+                        { (yyval.expr) = new This((yylsp[0])); }
+#line 2177 "y.tab.c"
     break;
 
-  case 75:
-#line 320 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = (yyvsp[0].call); }
-#line 2113 "y.tab.c" /* yacc.c:1646  */
+  case 75: /* Expr: Call  */
+#line 362 "parser.y"
+                        { (yyval.expr) = (yyvsp[0].call); }
+#line 2183 "y.tab.c"
     break;
 
-  case 76:
-#line 321 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = (yyvsp[-1].expr); }
-#line 2119 "y.tab.c" /* yacc.c:1646  */
+  case 76: /* Expr: '(' Expr ')'  */
+#line 363 "parser.y"
+                                { (yyval.expr) = (yyvsp[-1].expr); }
+#line 2189 "y.tab.c"
     break;
 
-  case 77:
-#line 322 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = (yyvsp[0].arExpr); }
-#line 2125 "y.tab.c" /* yacc.c:1646  */
+  case 77: /* Expr: ArithmeticExpr  */
+#line 364 "parser.y"
+                               { (yyval.expr) = (yyvsp[0].arExpr); }
+#line 2195 "y.tab.c"
     break;
 
-  case 78:
-#line 323 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = (yyvsp[0].rExpr); }
-#line 2131 "y.tab.c" /* yacc.c:1646  */
+  case 78: /* Expr: RelationalExpr  */
+#line 365 "parser.y"
+                                { (yyval.expr) = (yyvsp[0].rExpr); }
+#line 2201 "y.tab.c"
     break;
 
-  case 79:
-#line 324 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = (yyvsp[0].lExpr); }
-#line 2137 "y.tab.c" /* yacc.c:1646  */
+  case 79: /* Expr: LogicalExpr  */
+#line 366 "parser.y"
+                                { (yyval.expr) = (yyvsp[0].lExpr); }
+#line 2207 "y.tab.c"
     break;
 
-  case 80:
-#line 325 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = (yyvsp[0].eExpr); }
-#line 2143 "y.tab.c" /* yacc.c:1646  */
+  case 80: /* Expr: EqualityExpr  */
+#line 367 "parser.y"
+                                { (yyval.expr) = (yyvsp[0].eExpr); }
+#line 2213 "y.tab.c"
     break;
 
-  case 81:
-#line 326 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = (yyvsp[0].pExpr); }
-#line 2149 "y.tab.c" /* yacc.c:1646  */
+  case 81: /* Expr: PostfixExpr  */
+#line 368 "parser.y"
+                                { (yyval.expr) = (yyvsp[0].pExpr); }
+#line 2219 "y.tab.c"
     break;
 
-  case 82:
-#line 327 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = new ReadIntegerExpr((yylsp[-2])); }
-#line 2155 "y.tab.c" /* yacc.c:1646  */
+  case 82: /* Expr: T_ReadInteger '(' ')'  */
+#line 369 "parser.y"
+                                        { (yyval.expr) = new ReadIntegerExpr((yylsp[-2])); }
+#line 2225 "y.tab.c"
     break;
 
-  case 83:
-#line 328 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = new ReadLineExpr((yylsp[-2])); }
-#line 2161 "y.tab.c" /* yacc.c:1646  */
+  case 83: /* Expr: T_ReadLine '(' ')'  */
+#line 370 "parser.y"
+                                        { (yyval.expr) = new ReadLineExpr((yylsp[-2])); }
+#line 2231 "y.tab.c"
     break;
 
-  case 84:
-#line 329 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = new NewExpr((yylsp[-3]), new NamedType(new Identifier((yylsp[-1]), (yyvsp[-1].identifier)))); }
-#line 2167 "y.tab.c" /* yacc.c:1646  */
+  case 84: /* Expr: T_New '(' T_Identifier ')'  */
+#line 371 "parser.y"
+                                                { (yyval.expr) = new NewExpr((yylsp[-3]), new NamedType(new Identifier((yylsp[-1]), (yyvsp[-1].identifier)))); }
+#line 2237 "y.tab.c"
     break;
 
-  case 85:
-#line 330 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = new NewArrayExpr((yylsp[-5]), (yyvsp[-3].expr), (yyvsp[-1].type)); }
-#line 2173 "y.tab.c" /* yacc.c:1646  */
+  case 85: /* Expr: T_NewArray '(' Expr ',' Type ')'  */
+#line 372 "parser.y"
+                                                        { (yyval.expr) = new NewArrayExpr((yylsp[-5]), (yyvsp[-3].expr), (yyvsp[-1].type)); }
+#line 2243 "y.tab.c"
     break;
 
-  case 86:
-#line 333 "parser.y" /* yacc.c:1646  */
-    { (yyval.pExpr) = new PostfixExpr((yyvsp[-1].expr), new Operator((yylsp[0]), "++"));}
-#line 2179 "y.tab.c" /* yacc.c:1646  */
+  case 86: /* PostfixExpr: Expr T_Increment  */
+#line 375 "parser.y"
+                                 { (yyval.pExpr) = new PostfixExpr((yyvsp[-1].expr), new Operator((yylsp[0]), "++"));}
+#line 2249 "y.tab.c"
     break;
 
-  case 87:
-#line 334 "parser.y" /* yacc.c:1646  */
-    { (yyval.pExpr) = new PostfixExpr((yyvsp[-1].expr), new Operator((yylsp[0]), "--"));}
-#line 2185 "y.tab.c" /* yacc.c:1646  */
+  case 87: /* PostfixExpr: Expr T_Decrement  */
+#line 376 "parser.y"
+                                 { (yyval.pExpr) = new PostfixExpr((yyvsp[-1].expr), new Operator((yylsp[0]), "--"));}
+#line 2255 "y.tab.c"
     break;
 
-  case 88:
-#line 337 "parser.y" /* yacc.c:1646  */
-    { (yyval.asExpr) = new AssignExpr((yyvsp[-2].lValue), new Operator((yylsp[-1]), "="), (yyvsp[0].expr)); }
-#line 2191 "y.tab.c" /* yacc.c:1646  */
+  case 88: /* AssignExpr: LValue '=' Expr  */
+#line 379 "parser.y"
+                                { (yyval.asExpr) = new AssignExpr((yyvsp[-2].lValue), new Operator((yylsp[-1]), "="), (yyvsp[0].expr)); }
+#line 2261 "y.tab.c"
     break;
 
-  case 89:
-#line 340 "parser.y" /* yacc.c:1646  */
-    { (yyval.arExpr) = new ArithmeticExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), "+"), (yyvsp[0].expr)); }
-#line 2197 "y.tab.c" /* yacc.c:1646  */
+  case 89: /* ArithmeticExpr: Expr '+' Expr  */
+#line 382 "parser.y"
+                                { (yyval.arExpr) = new ArithmeticExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), "+"), (yyvsp[0].expr)); }
+#line 2267 "y.tab.c"
     break;
 
-  case 90:
-#line 341 "parser.y" /* yacc.c:1646  */
-    { (yyval.arExpr) = new ArithmeticExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), "-"), (yyvsp[0].expr)); }
-#line 2203 "y.tab.c" /* yacc.c:1646  */
+  case 90: /* ArithmeticExpr: Expr '-' Expr  */
+#line 383 "parser.y"
+                                { (yyval.arExpr) = new ArithmeticExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), "-"), (yyvsp[0].expr)); }
+#line 2273 "y.tab.c"
     break;
 
-  case 91:
-#line 342 "parser.y" /* yacc.c:1646  */
-    { (yyval.arExpr) = new ArithmeticExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), "*"), (yyvsp[0].expr)); }
-#line 2209 "y.tab.c" /* yacc.c:1646  */
+  case 91: /* ArithmeticExpr: Expr '*' Expr  */
+#line 384 "parser.y"
+                                { (yyval.arExpr) = new ArithmeticExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), "*"), (yyvsp[0].expr)); }
+#line 2279 "y.tab.c"
     break;
 
-  case 92:
-#line 343 "parser.y" /* yacc.c:1646  */
-    { (yyval.arExpr) = new ArithmeticExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), "/"), (yyvsp[0].expr)); }
-#line 2215 "y.tab.c" /* yacc.c:1646  */
+  case 92: /* ArithmeticExpr: Expr '/' Expr  */
+#line 385 "parser.y"
+                                { (yyval.arExpr) = new ArithmeticExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), "/"), (yyvsp[0].expr)); }
+#line 2285 "y.tab.c"
     break;
 
-  case 93:
-#line 344 "parser.y" /* yacc.c:1646  */
-    { (yyval.arExpr) = new ArithmeticExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), "%"), (yyvsp[0].expr)); }
-#line 2221 "y.tab.c" /* yacc.c:1646  */
+  case 93: /* ArithmeticExpr: Expr '%' Expr  */
+#line 386 "parser.y"
+                                { (yyval.arExpr) = new ArithmeticExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), "%"), (yyvsp[0].expr)); }
+#line 2291 "y.tab.c"
     break;
 
-  case 94:
-#line 345 "parser.y" /* yacc.c:1646  */
-    { (yyval.arExpr) = new ArithmeticExpr(new Operator((yylsp[-1]), "-"), (yyvsp[0].expr)); }
-#line 2227 "y.tab.c" /* yacc.c:1646  */
+  case 94: /* ArithmeticExpr: '-' Expr  */
+#line 387 "parser.y"
+                                { (yyval.arExpr) = new ArithmeticExpr(new Operator((yylsp[-1]), "-"), (yyvsp[0].expr)); }
+#line 2297 "y.tab.c"
     break;
 
-  case 95:
-#line 348 "parser.y" /* yacc.c:1646  */
-    { (yyval.rExpr) = new RelationalExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), "<"), (yyvsp[0].expr)); }
-#line 2233 "y.tab.c" /* yacc.c:1646  */
+  case 95: /* RelationalExpr: Expr '<' Expr  */
+#line 390 "parser.y"
+                                { (yyval.rExpr) = new RelationalExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), "<"), (yyvsp[0].expr)); }
+#line 2303 "y.tab.c"
     break;
 
-  case 96:
-#line 349 "parser.y" /* yacc.c:1646  */
-    { (yyval.rExpr) = new RelationalExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), "<="), (yyvsp[0].expr)); }
-#line 2239 "y.tab.c" /* yacc.c:1646  */
+  case 96: /* RelationalExpr: Expr T_LessEqual Expr  */
+#line 391 "parser.y"
+                                        { (yyval.rExpr) = new RelationalExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), "<="), (yyvsp[0].expr)); }
+#line 2309 "y.tab.c"
     break;
 
-  case 97:
-#line 350 "parser.y" /* yacc.c:1646  */
-    { (yyval.rExpr) = new RelationalExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), ">"), (yyvsp[0].expr)); }
-#line 2245 "y.tab.c" /* yacc.c:1646  */
+  case 97: /* RelationalExpr: Expr '>' Expr  */
+#line 392 "parser.y"
+                                { (yyval.rExpr) = new RelationalExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), ">"), (yyvsp[0].expr)); }
+#line 2315 "y.tab.c"
     break;
 
-  case 98:
-#line 351 "parser.y" /* yacc.c:1646  */
-    { (yyval.rExpr) = new RelationalExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), ">="), (yyvsp[0].expr)); }
-#line 2251 "y.tab.c" /* yacc.c:1646  */
+  case 98: /* RelationalExpr: Expr T_GreaterEqual Expr  */
+#line 393 "parser.y"
+                                                { (yyval.rExpr) = new RelationalExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), ">="), (yyvsp[0].expr)); }
+#line 2321 "y.tab.c"
     break;
 
-  case 99:
-#line 354 "parser.y" /* yacc.c:1646  */
-    { (yyval.lExpr) = new LogicalExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), "&&"), (yyvsp[0].expr)); }
-#line 2257 "y.tab.c" /* yacc.c:1646  */
+  case 99: /* LogicalExpr: Expr T_And Expr  */
+#line 396 "parser.y"
+                                { (yyval.lExpr) = new LogicalExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), "&&"), (yyvsp[0].expr)); }
+#line 2327 "y.tab.c"
     break;
 
-  case 100:
-#line 355 "parser.y" /* yacc.c:1646  */
-    { (yyval.lExpr) = new LogicalExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), "||"), (yyvsp[0].expr)); }
-#line 2263 "y.tab.c" /* yacc.c:1646  */
+  case 100: /* LogicalExpr: Expr T_Or Expr  */
+#line 397 "parser.y"
+                                { (yyval.lExpr) = new LogicalExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), "||"), (yyvsp[0].expr)); }
+#line 2333 "y.tab.c"
     break;
 
-  case 101:
-#line 356 "parser.y" /* yacc.c:1646  */
-    { (yyval.lExpr) = new LogicalExpr(new Operator((yylsp[-1]), "!"), (yyvsp[0].expr)); }
-#line 2269 "y.tab.c" /* yacc.c:1646  */
+  case 101: /* LogicalExpr: '!' Expr  */
+#line 398 "parser.y"
+                                { (yyval.lExpr) = new LogicalExpr(new Operator((yylsp[-1]), "!"), (yyvsp[0].expr)); }
+#line 2339 "y.tab.c"
     break;
 
-  case 102:
-#line 359 "parser.y" /* yacc.c:1646  */
-    { (yyval.eExpr) = new EqualityExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), "=="), (yyvsp[0].expr)); }
-#line 2275 "y.tab.c" /* yacc.c:1646  */
+  case 102: /* EqualityExpr: Expr T_Equal Expr  */
+#line 401 "parser.y"
+                                        { (yyval.eExpr) = new EqualityExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), "=="), (yyvsp[0].expr)); }
+#line 2345 "y.tab.c"
     break;
 
-  case 103:
-#line 360 "parser.y" /* yacc.c:1646  */
-    { (yyval.eExpr) = new EqualityExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), "!="), (yyvsp[0].expr)); }
-#line 2281 "y.tab.c" /* yacc.c:1646  */
+  case 103: /* EqualityExpr: Expr T_NotEqual Expr  */
+#line 402 "parser.y"
+                                        { (yyval.eExpr) = new EqualityExpr((yyvsp[-2].expr), new Operator((yylsp[-1]), "!="), (yyvsp[0].expr)); }
+#line 2351 "y.tab.c"
     break;
 
-  case 104:
-#line 363 "parser.y" /* yacc.c:1646  */
-    { (yyval.lValue) = new FieldAccess(NULL, new Identifier((yylsp[0]), (yyvsp[0].identifier))); }
-#line 2287 "y.tab.c" /* yacc.c:1646  */
+  case 104: /* LValue: T_Identifier  */
+#line 405 "parser.y"
+                        { (yyval.lValue) = new FieldAccess(NULL, new Identifier((yylsp[0]), (yyvsp[0].identifier))); }
+#line 2357 "y.tab.c"
     break;
 
-  case 105:
-#line 364 "parser.y" /* yacc.c:1646  */
-    { (yyval.lValue) = new FieldAccess((yyvsp[-2].expr), new Identifier((yylsp[0]), (yyvsp[0].identifier))); }
-#line 2293 "y.tab.c" /* yacc.c:1646  */
+  case 105: /* LValue: Expr '.' T_Identifier  */
+#line 406 "parser.y"
+                                        { (yyval.lValue) = new FieldAccess((yyvsp[-2].expr), new Identifier((yylsp[0]), (yyvsp[0].identifier))); }
+#line 2363 "y.tab.c"
     break;
 
-  case 106:
-#line 365 "parser.y" /* yacc.c:1646  */
-    { (yyval.lValue) = new ArrayAccess((yylsp[-3]), (yyvsp[-3].expr), (yyvsp[-1].expr)); }
-#line 2299 "y.tab.c" /* yacc.c:1646  */
+  case 106: /* LValue: Expr '[' Expr ']'  */
+#line 407 "parser.y"
+                                        { (yyval.lValue) = new ArrayAccess((yylsp[-3]), (yyvsp[-3].expr), (yyvsp[-1].expr)); }
+#line 2369 "y.tab.c"
     break;
 
-  case 107:
-#line 368 "parser.y" /* yacc.c:1646  */
-    { (yyval.call) = new Call((yylsp[-3]), NULL, new Identifier((yylsp[-3]), (yyvsp[-3].identifier)), (yyvsp[-1].exprList)); }
-#line 2305 "y.tab.c" /* yacc.c:1646  */
+  case 107: /* Call: T_Identifier '(' Actuals ')'  */
+#line 410 "parser.y"
+                                        { (yyval.call) = new Call((yylsp[-3]), NULL, new Identifier((yylsp[-3]), (yyvsp[-3].identifier)), (yyvsp[-1].exprList)); }
+#line 2375 "y.tab.c"
     break;
 
-  case 108:
-#line 369 "parser.y" /* yacc.c:1646  */
-    { (yyval.call) = new Call((yylsp[-5]), (yyvsp[-5].expr), new Identifier((yylsp[-3]), (yyvsp[-3].identifier)), (yyvsp[-1].exprList)); }
-#line 2311 "y.tab.c" /* yacc.c:1646  */
+  case 108: /* Call: Expr '.' T_Identifier '(' Actuals ')'  */
+#line 411 "parser.y"
+                                                        { (yyval.call) = new Call((yylsp[-5]), (yyvsp[-5].expr), new Identifier((yylsp[-3]), (yyvsp[-3].identifier)), (yyvsp[-1].exprList)); }
+#line 2381 "y.tab.c"
     break;
 
-  case 109:
-#line 372 "parser.y" /* yacc.c:1646  */
-    { (yyval.exprList) = (yyvsp[0].exprList); }
-#line 2317 "y.tab.c" /* yacc.c:1646  */
+  case 109: /* Actuals: ExprList  */
+#line 414 "parser.y"
+                                { (yyval.exprList) = (yyvsp[0].exprList); }
+#line 2387 "y.tab.c"
     break;
 
-  case 110:
-#line 373 "parser.y" /* yacc.c:1646  */
-    { (yyval.exprList) = new List<Expr*>; }
-#line 2323 "y.tab.c" /* yacc.c:1646  */
+  case 110: /* Actuals: %empty  */
+#line 415 "parser.y"
+                                { (yyval.exprList) = new List<Expr*>; }
+#line 2393 "y.tab.c"
     break;
 
-  case 111:
-#line 376 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = new IntConstant((yylsp[0]), (yyvsp[0].integerConstant)); }
-#line 2329 "y.tab.c" /* yacc.c:1646  */
+  case 111: /* Constant: T_IntConstant  */
+#line 418 "parser.y"
+                                { (yyval.expr) = new IntConstant((yylsp[0]), (yyvsp[0].integerConstant)); }
+#line 2399 "y.tab.c"
     break;
 
-  case 112:
-#line 377 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = new DoubleConstant((yylsp[0]), (yyvsp[0].doubleConstant)); }
-#line 2335 "y.tab.c" /* yacc.c:1646  */
+  case 112: /* Constant: T_DoubleConstant  */
+#line 419 "parser.y"
+                                        { (yyval.expr) = new DoubleConstant((yylsp[0]), (yyvsp[0].doubleConstant)); }
+#line 2405 "y.tab.c"
     break;
 
-  case 113:
-#line 378 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = new BoolConstant((yylsp[0]), (yyvsp[0].boolConstant)); }
-#line 2341 "y.tab.c" /* yacc.c:1646  */
+  case 113: /* Constant: T_BoolConstant  */
+#line 420 "parser.y"
+                                { (yyval.expr) = new BoolConstant((yylsp[0]), (yyvsp[0].boolConstant)); }
+#line 2411 "y.tab.c"
     break;
 
-  case 114:
-#line 379 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = new StringConstant((yylsp[0]), (yyvsp[0].stringConstant)); }
-#line 2347 "y.tab.c" /* yacc.c:1646  */
+  case 114: /* Constant: T_StringConstant  */
+#line 421 "parser.y"
+                                        { (yyval.expr) = new StringConstant((yylsp[0]), (yyvsp[0].stringConstant)); }
+#line 2417 "y.tab.c"
     break;
 
-  case 115:
-#line 380 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = new NullConstant((yylsp[0])); }
-#line 2353 "y.tab.c" /* yacc.c:1646  */
+  case 115: /* Constant: T_Null  */
+#line 422 "parser.y"
+                        { (yyval.expr) = new NullConstant((yylsp[0])); }
+#line 2423 "y.tab.c"
     break;
 
 
-#line 2357 "y.tab.c" /* yacc.c:1646  */
+#line 2427 "y.tab.c"
+
       default: break;
     }
   /* User semantic actions sometimes alter yychar, and that requires
@@ -2367,11 +2438,10 @@ yyreduce:
      case of YYERROR or YYBACKUP, subsequent parser actions might lead
      to an incorrect destructor call or verbose syntax error message
      before the lookahead is translated.  */
-  YY_SYMBOL_PRINT ("-> $$ =", yyr1[yyn], &yyval, &yyloc);
+  YY_SYMBOL_PRINT ("-> $$ =", YY_CAST (yysymbol_kind_t, yyr1[yyn]), &yyval, &yyloc);
 
   YYPOPSTACK (yylen);
   yylen = 0;
-  YY_STACK_PRINT (yyss, yyssp);
 
   *++yyvsp = yyval;
   *++yylsp = yyloc;
@@ -2379,14 +2449,13 @@ yyreduce:
   /* Now 'shift' the result of the reduction.  Determine what state
      that goes to, based on the state we popped back to and the rule
      number reduced by.  */
-
-  yyn = yyr1[yyn];
-
-  yystate = yypgoto[yyn - YYNTOKENS] + *yyssp;
-  if (0 <= yystate && yystate <= YYLAST && yycheck[yystate] == *yyssp)
-    yystate = yytable[yystate];
-  else
-    yystate = yydefgoto[yyn - YYNTOKENS];
+  {
+    const int yylhs = yyr1[yyn] - YYNTOKENS;
+    const int yyi = yypgoto[yylhs] + *yyssp;
+    yystate = (0 <= yyi && yyi <= YYLAST && yycheck[yyi] == *yyssp
+               ? yytable[yyi]
+               : yydefgoto[yylhs]);
+  }
 
   goto yynewstate;
 
@@ -2397,50 +2466,15 @@ yyreduce:
 yyerrlab:
   /* Make sure we have latest lookahead translation.  See comments at
      user semantic actions for why this is necessary.  */
-  yytoken = yychar == YYEMPTY ? YYEMPTY : YYTRANSLATE (yychar);
-
+  yytoken = yychar == YYEMPTY ? YYSYMBOL_YYEMPTY : YYTRANSLATE (yychar);
   /* If not already recovering from an error, report this error.  */
   if (!yyerrstatus)
     {
       ++yynerrs;
-#if ! YYERROR_VERBOSE
       yyerror (YY_("syntax error"));
-#else
-# define YYSYNTAX_ERROR yysyntax_error (&yymsg_alloc, &yymsg, \
-                                        yyssp, yytoken)
-      {
-        char const *yymsgp = YY_("syntax error");
-        int yysyntax_error_status;
-        yysyntax_error_status = YYSYNTAX_ERROR;
-        if (yysyntax_error_status == 0)
-          yymsgp = yymsg;
-        else if (yysyntax_error_status == 1)
-          {
-            if (yymsg != yymsgbuf)
-              YYSTACK_FREE (yymsg);
-            yymsg = (char *) YYSTACK_ALLOC (yymsg_alloc);
-            if (!yymsg)
-              {
-                yymsg = yymsgbuf;
-                yymsg_alloc = sizeof yymsgbuf;
-                yysyntax_error_status = 2;
-              }
-            else
-              {
-                yysyntax_error_status = YYSYNTAX_ERROR;
-                yymsgp = yymsg;
-              }
-          }
-        yyerror (yymsgp);
-        if (yysyntax_error_status == 2)
-          goto yyexhaustedlab;
-      }
-# undef YYSYNTAX_ERROR
-#endif
     }
 
   yyerror_range[1] = yylloc;
-
   if (yyerrstatus == 3)
     {
       /* If just tried and failed to reuse lookahead token after an
@@ -2469,14 +2503,12 @@ yyerrlab:
 | yyerrorlab -- error raised explicitly by YYERROR.  |
 `---------------------------------------------------*/
 yyerrorlab:
+  /* Pacify compilers when the user code never invokes YYERROR and the
+     label yyerrorlab therefore never appears in user code.  */
+  if (0)
+    YYERROR;
+  ++yynerrs;
 
-  /* Pacify compilers like GCC when the user code never invokes
-     YYERROR and the label yyerrorlab therefore never appears in user
-     code.  */
-  if (/*CONSTCOND*/ 0)
-     goto yyerrorlab;
-
-  yyerror_range[1] = yylsp[1-yylen];
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYERROR.  */
   YYPOPSTACK (yylen);
@@ -2492,13 +2524,14 @@ yyerrorlab:
 yyerrlab1:
   yyerrstatus = 3;      /* Each real token shifted decrements this.  */
 
+  /* Pop stack until we find a state that shifts the error token.  */
   for (;;)
     {
       yyn = yypact[yystate];
       if (!yypact_value_is_default (yyn))
         {
-          yyn += YYTERROR;
-          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYTERROR)
+          yyn += YYSYMBOL_YYerror;
+          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYSYMBOL_YYerror)
             {
               yyn = yytable[yyn];
               if (0 < yyn)
@@ -2512,7 +2545,7 @@ yyerrlab1:
 
       yyerror_range[1] = *yylsp;
       yydestruct ("Error: popping",
-                  yystos[yystate], yyvsp, yylsp);
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp, yylsp);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
@@ -2523,13 +2556,11 @@ yyerrlab1:
   YY_IGNORE_MAYBE_UNINITIALIZED_END
 
   yyerror_range[2] = yylloc;
-  /* Using YYLLOC is tempting, but would change the location of
-     the lookahead.  YYLOC is available though.  */
-  YYLLOC_DEFAULT (yyloc, yyerror_range, 2);
-  *++yylsp = yyloc;
+  ++yylsp;
+  YYLLOC_DEFAULT (*yylsp, yyerror_range, 2);
 
   /* Shift the error token.  */
-  YY_SYMBOL_PRINT ("Shifting", yystos[yyn], yyvsp, yylsp);
+  YY_SYMBOL_PRINT ("Shifting", YY_ACCESSING_SYMBOL (yyn), yyvsp, yylsp);
 
   yystate = yyn;
   goto yynewstate;
@@ -2540,26 +2571,30 @@ yyerrlab1:
 `-------------------------------------*/
 yyacceptlab:
   yyresult = 0;
-  goto yyreturn;
+  goto yyreturnlab;
+
 
 /*-----------------------------------.
 | yyabortlab -- YYABORT comes here.  |
 `-----------------------------------*/
 yyabortlab:
   yyresult = 1;
-  goto yyreturn;
+  goto yyreturnlab;
+
 
-#if !defined yyoverflow || YYERROR_VERBOSE
-/*-------------------------------------------------.
-| yyexhaustedlab -- memory exhaustion comes here.  |
-`-------------------------------------------------*/
+/*-----------------------------------------------------------.
+| yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
+`-----------------------------------------------------------*/
 yyexhaustedlab:
   yyerror (YY_("memory exhausted"));
   yyresult = 2;
-  /* Fall through.  */
-#endif
+  goto yyreturnlab;
+
 
-yyreturn:
+/*----------------------------------------------------------.
+| yyreturnlab -- parsing is finished, clean up and return.  |
+`----------------------------------------------------------*/
+yyreturnlab:
   if (yychar != YYEMPTY)
     {
       /* Make sure we have latest lookahead translation.  See comments at
@@ -2575,20 +2610,18 @@ yyreturn:
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-                  yystos[*yyssp], yyvsp, yylsp);
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, yylsp);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
   if (yyss != yyssa)
     YYSTACK_FREE (yyss);
 #endif
-#if YYERROR_VERBOSE
-  if (yymsg != yymsgbuf)
-    YYSTACK_FREE (yymsg);
-#endif
+
   return yyresult;
 }
-#line 383 "parser.y" /* yacc.c:1906  */
+
+#line 425 "parser.y"
 
 
 /* The closing %% above marks the end of the Rules section and the beginning
@@ -2597,6 +2630,14 @@ yyreturn:
  * This section is where you put definitions of helper functions.
  */
 
+/* Global variable: parsedDecls
+ * ----------------------------
+ * The declaration list of the last input successfully reduced to a
+ * Program, or NULL if the parse did not get that far.
+ */
+List<Decl*> *parsedDecls;
+
+
 /* Function: InitParser
  * --------------------
  * This function will be called before any calls to yyparse().  It is designed
@@ -2614,4 +2655,5 @@ void InitParser()
 {
    PrintDebug("parser", "Initializing parser");
    yydebug = false;
+   parsedDecls = NULL;
 }
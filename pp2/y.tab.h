@@ -1,8 +1,9 @@
-/* A Bison parser, made by GNU Bison 3.0.2.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison interface for Yacc-like parsers in C
 
-   Copyright (C) 1984, 1989-1990, 2000-2013 Free Software Foundation, Inc.
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
 
    This program is free software: you can redistribute it and/or modify
    it under the terms of the GNU General Public License as published by
@@ -15,7 +16,7 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -30,6 +31,10 @@
    This special exception was added by the Free Software Foundation in
    version 2.2 of Bison.  */
 
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
 #ifndef YY_YY_Y_TAB_H_INCLUDED
 # define YY_YY_Y_TAB_H_INCLUDED
 /* Debug traces.  */
@@ -40,54 +45,63 @@
 extern int yydebug;
 #endif
 
-/* Token type.  */
+/* Token kinds.  */
 #ifndef YYTOKENTYPE
 # define YYTOKENTYPE
   enum yytokentype
   {
-    T_Void = 258,
-    T_Bool = 259,
-    T_Int = 260,
-    T_Double = 261,
-    T_String = 262,
-    T_Class = 263,
-    T_LessEqual = 264,
-    T_GreaterEqual = 265,
-    T_Equal = 266,
-    T_NotEqual = 267,
-    T_Dims = 268,
-    T_And = 269,
-    T_Or = 270,
-    T_Null = 271,
-    T_Extends = 272,
-    T_This = 273,
-    T_Interface = 274,
-    T_Implements = 275,
-    T_While = 276,
-    T_For = 277,
-    T_If = 278,
-    T_Else = 279,
-    T_Return = 280,
-    T_Break = 281,
-    T_New = 282,
-    T_NewArray = 283,
-    T_Print = 284,
-    T_ReadInteger = 285,
-    T_ReadLine = 286,
-    T_Increment = 287,
-    T_Decrement = 288,
-    T_Switch = 289,
-    T_Case = 290,
-    T_Default = 291,
-    T_Identifier = 292,
-    T_StringConstant = 293,
-    T_IntConstant = 294,
-    T_DoubleConstant = 295,
-    T_BoolConstant = 296,
-    ELSECHECK = 297
+    YYEMPTY = -2,
+    YYEOF = 0,                     /* "end of file"  */
+    YYerror = 256,                 /* error  */
+    YYUNDEF = 257,                 /* "invalid token"  */
+    T_Void = 258,                  /* T_Void  */
+    T_Bool = 259,                  /* T_Bool  */
+    T_Int = 260,                   /* T_Int  */
+    T_Double = 261,                /* T_Double  */
+    T_String = 262,                /* T_String  */
+    T_Class = 263,                 /* T_Class  */
+    T_LessEqual = 264,             /* T_LessEqual  */
+    T_GreaterEqual = 265,          /* T_GreaterEqual  */
+    T_Equal = 266,                 /* T_Equal  */
+    T_NotEqual = 267,              /* T_NotEqual  */
+    T_Dims = 268,                  /* T_Dims  */
+    T_And = 269,                   /* T_And  */
+    T_Or = 270,                    /* T_Or  */
+    T_Null = 271,                  /* T_Null  */
+    T_Extends = 272,               /* T_Extends  */
+    T_This = 273,                  /* T_This  */
+    T_Interface = 274,             /* T_Interface  */
+    T_Implements = 275,            /* T_Implements  */
+    T_While = 276,                 /* T_While  */
+    T_For = 277,                   /* T_For  */
+    T_If = 278,                    /* T_If  */
+    T_Else = 279,                  /* T_Else  */
+    T_Return = 280,                /* T_Return  */
+    T_Break = 281,                 /* T_Break  */
+    T_New = 282,                   /* T_New  */
+    T_NewArray = 283,              /* T_NewArray  */
+    T_Print = 284,                 /* T_Print  */
+    T_ReadInteger = 285,           /* T_ReadInteger  */
+    T_ReadLine = 286,              /* T_ReadLine  */
+    T_Increment = 287,             /* T_Increment  */
+    T_Decrement = 288,             /* T_Decrement  */
+    T_Switch = 289,                /* T_Switch  */
+    T_Case = 290,                  /* T_Case  */
+    T_Default = 291,               /* T_Default  */
+    T_Identifier = 292,            /* T_Identifier  */
+    T_StringConstant = 293,        /* T_StringConstant  */
+    T_IntConstant = 294,           /* T_IntConstant  */
+    T_DoubleConstant = 295,        /* T_DoubleConstant  */
+    T_BoolConstant = 296,          /* T_BoolConstant  */
+    ELSECHECK = 297                /* ELSECHECK  */
   };
+  typedef enum yytokentype yytoken_kind_t;
 #endif
-/* Tokens.  */
+/* Token kinds.  */
+#define YYEMPTY -2
+#define YYEOF 0
+#define YYerror 256
+#define YYUNDEF 257
 #define T_Void 258
 #define T_Bool 259
 #define T_Int 260
@@ -131,10 +145,9 @@ extern int yydebug;
 
 /* Value type.  */
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
-typedef union YYSTYPE YYSTYPE;
 union YYSTYPE
 {
-#line 41 "parser.y" /* yacc.c:1909  */
+#line 83 "parser.y"
 
     int integerConstant;
     bool boolConstant;
@@ -174,8 +187,10 @@ union YYSTYPE
 	CaseStmt *cast;
 	Default *deft;
 
-#line 178 "y.tab.h" /* yacc.c:1909  */
+#line 191 "y.tab.h"
+
 };
+typedef union YYSTYPE YYSTYPE;
 # define YYSTYPE_IS_TRIVIAL 1
 # define YYSTYPE_IS_DECLARED 1
 #endif
@@ -197,6 +212,8 @@ struct YYLTYPE
 
 extern YYSTYPE yylval;
 extern YYLTYPE yylloc;
+
 int yyparse (void);
 
+
 #endif /* !YY_YY_Y_TAB_H_INCLUDED  */